@@ -0,0 +1,116 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+// Compression benchmark: CPU time against bytes saved for every content coding and level, on the bodies that
+// CompressionInterceptor compresses the most: a JSON listing, the NDJSON export and a MessagePack listing.
+//
+// Usage: Task_For_NTEC_compression_bench [contacts] [rounds]
+// Prints per body, coding and level the compressed size, its share of the original, and the mean time and input
+// throughput of one compression, fed in 16 KB blocks as while a streamed response is sent.
+// A cached body (CompressedResponseCache) costs none of this, so the level mostly matters for the first request
+// after each write and for responses that can't be cached.
+
+#include "codec/ContactMessagePack.hpp"
+#include "codec/HttpCompression.hpp"
+#include "dto/ContactDto.hpp"
+#include "stream/CompressingStream.hpp"
+#include <oatpp/core/base/Environment.hpp>
+#include <oatpp/parser/json/mapping/ObjectMapper.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace {
+
+const char* const kFirstNames[] = {"Ivan", "Maria", "Alexey", "Olga", "Dmitry", "Anna", "Sergey", "Elena"};
+const char* const kLastNames[] = {"Ivanov", "Petrova", "Sidorov", "Smirnova", "Kuznetsov", "Popova", "Vasiliev"};
+const char* const kCities[] = {"Moscow", "Saint Petersburg", "Kazan", "Novosibirsk", "Yekaterinburg", "Samara"};
+
+template<typename T, size_t N>
+const T& pick(const T (&values)[N], std::mt19937_64& random) {
+    return values[random() % N];
+}
+
+oatpp::Object<ContactDto> makeContact(std::mt19937_64& random, int64_t id) {
+    auto contact = ContactDto::createShared();
+    contact->id = id;
+    contact->name = std::string(pick(kFirstNames, random)) + " " + pick(kLastNames, random);
+    contact->phone = "+7" + std::to_string(9000000000ull + random() % 1000000000ull);
+    contact->address = std::string(pick(kCities, random)) + ", Lenin St., " + std::to_string(1 + random() % 200);
+    return contact;
+}
+
+// The body compressed in blocks of the size CompressingStream reads from its source
+size_t compressInBlocks(std::string_view body, ContentCoding coding, int level) {
+    HttpCompression::Encoder encoder(coding, level);
+    std::string out;
+    size_t total = 0;
+    for (size_t offset = 0; offset < body.size(); offset += CompressingStream::kInputBlock) {
+        encoder.write(body.substr(offset, CompressingStream::kInputBlock), out);
+        total += out.size();
+        out.clear();
+    }
+    encoder.finish(out);
+    return total + out.size();
+}
+
+void measure(const char* title, const std::string& body, size_t rounds) {
+    std::printf("%s: %zu B (mean of %zu rounds)\n", title, body.size(), rounds);
+    std::printf("  %-8s %5s %12s %8s %12s %10s\n", "coding", "level", "bytes", "ratio", "time, ms", "MB/s");
+    for (auto coding : {ContentCoding::Gzip, ContentCoding::Deflate, ContentCoding::Zstd}) {
+        if (!HttpCompression::isSupported(coding)) {
+            std::printf("  %-8s not supported by this build\n", HttpCompression::nameOf(coding));
+            continue;
+        }
+        for (int level = HttpCompression::kMinLevel; level <= HttpCompression::kMaxLevel; ++level) {
+            size_t size = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < rounds; ++i) {
+                size = compressInBlocks(body, coding, level);
+            }
+            auto millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() /
+                          rounds;
+            std::printf("  %-8s %5d %12zu %7.1f%% %12.3f %10.1f\n", HttpCompression::nameOf(coding), level, size,
+                        100.0 * size / body.size(), millis, body.size() / millis / 1000.0);
+        }
+    }
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    oatpp::base::Environment::init();
+
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5;
+    if (count == 0 || rounds == 0) {
+        std::fprintf(stderr, "Usage: %s [contacts] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    std::mt19937_64 random(42);
+
+    auto list = oatpp::List<oatpp::Object<ContactDto>>::createShared();
+    std::string lines;
+    for (size_t i = 0; i < count; ++i) {
+        auto contact = makeContact(random, static_cast<int64_t>(i + 1));
+        list->push_back(contact);
+        lines += *objectMapper->writeToString(contact);
+        lines += '\n';
+    }
+
+    measure(("JSON listing of " + std::to_string(count) + " contacts").c_str(), *objectMapper->writeToString(list),
+            rounds);
+    measure(("NDJSON export of " + std::to_string(count) + " contacts").c_str(), lines, rounds);
+    measure(("MessagePack listing of " + std::to_string(count) + " contacts").c_str(),
+            *ContactMessagePack::encode(list), rounds);
+
+    oatpp::base::Environment::destroy();
+    return 0;
+}
@@ -0,0 +1,134 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+// Error path benchmark: cost of answering a 404 (unknown id) and a 400 (invalid contact)
+// with typed ServiceResult errors, against the previous exception-based path.
+//
+// Usage: Task_For_NTEC_error_path_bench [requests] [contacts]
+// The previous path is reproduced as it was: the service failure is thrown as std::runtime_error,
+// caught at the top and classified by ApiErrorHandler::determineStatus. Both paths build and
+// serialize the same ErrorDto, so the difference is the cost of the exceptions and the classification.
+
+#include "dto/ContactDto.hpp"
+#include "exception/ExceptionHandler.hpp"
+#include "repository/ContactRepository.hpp"
+#include "service/ContactService.hpp"
+#include <oatpp/core/base/Environment.hpp>
+#include <oatpp/parser/json/mapping/ObjectMapper.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using Status = oatpp::web::protocol::http::Status;
+
+struct Measurement {
+    double nanoseconds = 0;
+    int status = 0;
+};
+
+// Mean time of one request; the status of the last one is kept to check both paths agree
+Measurement measure(size_t requests, const std::function<int()>& request) {
+    Measurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < requests; ++i) {
+        measurement.status = request();
+    }
+    measurement.nanoseconds =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / requests;
+    return measurement;
+}
+
+template<typename T>
+T valueOrThrow(ServiceResult<T> result) {
+    return std::move(result.value());
+}
+
+void compare(const char* title, size_t requests, const std::function<int()>& typed,
+             const std::function<int()>& exceptions) {
+    // Warm up both paths before measuring
+    measure(requests / 10 + 1, typed);
+    measure(requests / 10 + 1, exceptions);
+
+    auto before = measure(requests, exceptions);
+    auto after = measure(requests, typed);
+    std::printf("%s (mean of %zu requests)\n", title, requests);
+    std::printf("  %-28s %8.0f ns  status %d\n", "before: exceptions", before.nanoseconds, before.status);
+    std::printf("  %-28s %8.0f ns  status %d\n", "after: typed errors", after.nanoseconds, after.status);
+    std::printf("  %.2fx faster\n", before.nanoseconds / after.nanoseconds);
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    oatpp::base::Environment::init();
+
+    size_t requests = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t contacts = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 100000;
+    if (requests == 0) {
+        std::fprintf(stderr, "Usage: %s [requests] [contacts]\n", argv[0]);
+        return 1;
+    }
+
+    auto service = std::make_shared<ContactService>(std::make_shared<ContactRepository>());
+    for (size_t i = 0; i < contacts; ++i) {
+        auto contact = ContactDto::createShared();
+        contact->name = "Contact " + std::to_string(i);
+        contact->phone = "+7" + std::to_string(9000000000ull + i);
+        contact->address = "Moscow";
+        service->createContact(contact);
+    }
+    auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    auto respond = [&](const Status& status, const std::string& message) {
+        objectMapper->writeToString(ApiErrorHandler::createError(status, message));
+        return status.code;
+    };
+
+    // Ids past the last one, as a scanner would try them
+    int64_t missingId = static_cast<int64_t>(contacts) + 1;
+    compare("404 Not Found: GET /contacts/{unknown id}", requests,
+            [&] {
+                auto contact = service->getContactById(missingId);
+                if (!contact) {
+                    return respond(ApiErrorHandler::statusOf(contact.error().code), contact.error().message);
+                }
+                return 200;
+            },
+            [&] {
+                try {
+                    valueOrThrow(service->getContactById(missingId));
+                    return 200;
+                } catch (const std::runtime_error& e) {
+                    return respond(ApiErrorHandler::determineStatus(e.what()), e.what());
+                }
+            });
+
+    auto invalid = ContactDto::createShared();
+    invalid->phone = "+79990000000";
+    invalid->address = "Moscow";
+    compare("400 Bad Request: POST /contacts without a name", requests,
+            [&] {
+                auto contact = service->createContact(invalid);
+                if (!contact) {
+                    return respond(ApiErrorHandler::statusOf(contact.error().code), contact.error().message);
+                }
+                return 201;
+            },
+            [&] {
+                try {
+                    valueOrThrow(service->createContact(invalid));
+                    return 201;
+                } catch (const std::runtime_error& e) {
+                    return respond(ApiErrorHandler::determineStatus(e.what()), e.what());
+                }
+            });
+
+    oatpp::base::Environment::destroy();
+    return 0;
+}
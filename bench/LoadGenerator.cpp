@@ -0,0 +1,441 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+// End-to-end HTTP load generator: drives the /contacts API over keep-alive connections with the oatpp client
+// and reports throughput and latency percentiles per request kind.
+//
+// Usage: Task_For_NTEC_load [--server=inprocess|host:port] [--network=tcp|virtual] [--port=8000]
+//                           [--connections=16] [--rate=0] [--duration=10] [--warmup=2] [--contacts=10000]
+//                           [--mix=get:70,list:5,create:10,update:10,delete:5]
+//
+// --server=inprocess (default) starts the server inside this process from ContactComponent, so CONTACTS_*
+// variables configure it as they would the real one (CONTACTS_PORT is taken from --port). With
+// --network=virtual client and server talk over oatpp's in-memory virtual network instead of kernel TCP,
+// which isolates the cost of request handling; the TCP listener is still opened but stays idle.
+//
+// --rate is the total target in requests per second, spread evenly over the connections (open loop):
+// requests are sent on a fixed schedule whether or not earlier ones have completed, and latency is measured
+// from the scheduled time, so a stalled server shows up as latency instead of a lower request rate.
+// --rate=0 runs closed loop: every connection sends its next request as soon as the previous one returns.
+
+#include "appComponent/ContactComponent.hpp"
+#include "dto/BatchDto.hpp"
+#include "dto/ContactDto.hpp"
+#include "metrics/LatencyHistogram.hpp"
+#include "swagger/SwaggerComponent.hpp"
+#include <oatpp/network/tcp/client/ConnectionProvider.hpp>
+#include <oatpp/network/virtual_/Interface.hpp>
+#include <oatpp/network/virtual_/client/ConnectionProvider.hpp>
+#include <oatpp/network/virtual_/server/ConnectionProvider.hpp>
+#include <oatpp/parser/json/mapping/ObjectMapper.hpp>
+#include <oatpp/web/client/HttpRequestExecutor.hpp>
+#include <oatpp/web/protocol/http/outgoing/BufferBody.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Executor = oatpp::web::client::HttpRequestExecutor;
+
+enum Operation {
+    Get,
+    List,
+    Create,
+    Update,
+    Delete,
+    kOperationCount
+};
+
+const char* const kOperationNames[kOperationCount] = {"get", "list", "create", "update", "delete"};
+
+struct Options {
+    bool inProcess = true;
+    std::string host = "127.0.0.1";
+    uint16_t port = 8000;
+    bool virtualNetwork = false;
+    size_t connections = 16;
+    double rate = 0;
+    double duration = 10;
+    double warmup = 2;
+    size_t contacts = 10000;
+    std::array<double, kOperationCount> mix = {70, 5, 10, 10, 5};
+};
+
+// What one connection saw during the measured part of the run
+struct Tally {
+    std::array<std::unique_ptr<LatencyHistogram>, kOperationCount> latency;
+    // Responses by status class: 1xx .. 5xx
+    std::array<uint64_t, 5> statuses{};
+    // Requests that failed at the transport level (the connection is replaced)
+    uint64_t transportErrors = 0;
+
+    Tally() {
+        for (auto& histogram : latency) {
+            histogram = std::make_unique<LatencyHistogram>();
+        }
+    }
+};
+
+std::string contactJson(uint64_t number) {
+    return "{\"name\":\"Load Contact " + std::to_string(number) + "\",\"phone\":\"+7" +
+           std::to_string(9000000000ull + number % 1000000000ull) + "\",\"address\":\"Moscow, Lenin St., " +
+           std::to_string(1 + number % 200) + "\"}";
+}
+
+std::shared_ptr<oatpp::web::protocol::http::outgoing::Body> jsonBody(const std::string& json) {
+    return oatpp::web::protocol::http::outgoing::BufferBody::createShared(json, "application/json");
+}
+
+// One keep-alive connection that is replaced when a request fails
+class Connection {
+public:
+    explicit Connection(const std::shared_ptr<oatpp::network::ClientConnectionProvider>& provider)
+        : executor_(Executor::createShared(provider)) {}
+
+    // Status code and body, or status 0 on a transport error
+    std::pair<int, oatpp::String> send(const char* method, const std::string& path, const std::string& json = {}) {
+        try {
+            if (!handle_) {
+                handle_ = executor_->getConnection();
+            }
+            auto response = executor_->execute(method, path, Executor::Headers(),
+                                               json.empty() ? nullptr : jsonBody(json), handle_);
+            // The body is always read so the connection can carry the next request
+            auto body = response->readBodyToString();
+            return {response->getStatusCode(), body};
+        } catch (const std::exception&) {
+            if (handle_) {
+                executor_->invalidateConnection(handle_);
+                handle_.reset();
+            }
+            return {0, nullptr};
+        }
+    }
+
+private:
+    std::shared_ptr<Executor> executor_;
+    std::shared_ptr<oatpp::web::client::RequestExecutor::ConnectionHandle> handle_;
+};
+
+// Creates contacts through POST /contacts/batch and returns their ids; falls back to the first page of
+// GET /contacts when nothing was created (an external server with --contacts=0)
+std::vector<int64_t> preload(Connection& connection, size_t contacts,
+                             const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& mapper) {
+    constexpr size_t kBatch = 1000;
+    std::vector<int64_t> ids;
+    for (size_t first = 0; first < contacts; first += kBatch) {
+        std::string json = "[";
+        for (size_t i = first; i < std::min(contacts, first + kBatch); ++i) {
+            json += (i == first ? "" : ",") + contactJson(i);
+        }
+        json += "]";
+        auto [status, body] = connection.send("POST", "/contacts/batch", json);
+        if (status != 200) {
+            throw std::runtime_error("Preload failed with status " + std::to_string(status));
+        }
+        auto result = mapper->readFromString<oatpp::Object<BatchResultDto>>(body);
+        for (const auto& item : *result->items) {
+            if (item->status == 201 && item->id) {
+                ids.push_back(*item->id);
+            }
+        }
+    }
+    if (ids.empty()) {
+        auto [status, body] = connection.send("GET", "/contacts?limit=1000");
+        if (status == 200) {
+            auto page = mapper->readFromString<oatpp::List<oatpp::Object<ContactDto>>>(body);
+            for (const auto& contact : *page) {
+                ids.push_back(*contact->id);
+            }
+        }
+    }
+    if (ids.empty()) {
+        throw std::runtime_error("No contacts to read: the server has none and none could be created");
+    }
+    return ids;
+}
+
+// Sends requests on one connection until end; only requests sent (or scheduled, in open loop) at or after
+// measureFrom are counted
+void runConnection(size_t index, const Options& options,
+                   const std::shared_ptr<oatpp::network::ClientConnectionProvider>& provider,
+                   const std::vector<int64_t>& ids, const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& mapper,
+                   Clock::time_point measureFrom, Clock::time_point end, Tally& tally) {
+    Connection connection(provider);
+    std::mt19937_64 random(index + 1);
+    std::discrete_distribution<int> pick(options.mix.begin(), options.mix.end());
+    // Contacts this connection created, deleted again by its Delete requests
+    std::deque<int64_t> created;
+    // Phones of created contacts start past the preloaded ones and differ between connections
+    uint64_t nextNumber = options.contacts + (index + 1) * 100000000ull;
+
+    auto interval = options.rate > 0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.connections / options.rate))
+        : Clock::duration::zero();
+    // Connections start spread over one interval so that they do not fire in bursts
+    auto scheduled = Clock::now() + interval * index / options.connections;
+
+    while (true) {
+        auto sendAt = Clock::now();
+        if (options.rate > 0) {
+            std::this_thread::sleep_until(scheduled);
+            sendAt = scheduled;
+            scheduled += interval;
+        }
+        if (sendAt >= end) {
+            break;
+        }
+
+        auto operation = static_cast<Operation>(pick(random));
+        if (operation == Delete && created.empty()) {
+            operation = Create;
+        }
+        auto id = ids[random() % ids.size()];
+        std::pair<int, oatpp::String> response;
+        switch (operation) {
+            case Get:
+                response = connection.send("GET", "/contacts/" + std::to_string(id));
+                break;
+            case List:
+                response = connection.send("GET", "/contacts?limit=50");
+                break;
+            case Create:
+                response = connection.send("POST", "/contacts", contactJson(nextNumber++));
+                if (response.first == 201) {
+                    created.push_back(*mapper->readFromString<oatpp::Object<ContactDto>>(response.second)->id);
+                }
+                break;
+            case Update:
+                response = connection.send("PUT", "/contacts/" + std::to_string(id), contactJson(static_cast<uint64_t>(id)));
+                break;
+            case Delete:
+                response = connection.send("DELETE", "/contacts/" + std::to_string(created.front()));
+                created.pop_front();
+                break;
+            default:
+                break;
+        }
+        auto done = Clock::now();
+
+        if (sendAt < measureFrom) {
+            continue;
+        }
+        if (response.first == 0) {
+            ++tally.transportErrors;
+            continue;
+        }
+        tally.latency[operation]->record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(done - sendAt).count()));
+        auto statusClass = std::clamp(response.first / 100, 1, 5) - 1;
+        ++tally.statuses[statusClass];
+    }
+}
+
+void printRow(const char* name, const HistogramSnapshot& latency, double seconds) {
+    std::printf("  %-8s %10llu %12.0f %10.3f %10.3f %10.3f %10.3f\n", name,
+                static_cast<unsigned long long>(latency.count), latency.count / seconds,
+                latency.quantile(0.5) / 1e6, latency.quantile(0.99) / 1e6, latency.quantile(0.999) / 1e6,
+                latency.count ? static_cast<double>(latency.sum) / latency.count / 1e6 : 0.0);
+}
+
+bool parseMix(const std::string& text, std::array<double, kOperationCount>& mix) {
+    mix.fill(0);
+    size_t position = 0;
+    while (position < text.size()) {
+        auto end = text.find(',', position);
+        auto item = text.substr(position, end == std::string::npos ? std::string::npos : end - position);
+        auto colon = item.find(':');
+        if (colon == std::string::npos) {
+            return false;
+        }
+        auto name = item.substr(0, colon);
+        auto found = std::find_if(std::begin(kOperationNames), std::end(kOperationNames),
+                                  [&name](const char* operation) { return name == operation; });
+        if (found == std::end(kOperationNames)) {
+            return false;
+        }
+        mix[found - std::begin(kOperationNames)] = std::strtod(item.c_str() + colon + 1, nullptr);
+        position = end == std::string::npos ? text.size() : end + 1;
+    }
+    return std::any_of(mix.begin(), mix.end(), [](double weight) { return weight > 0; }) &&
+           std::none_of(mix.begin(), mix.end(), [](double weight) { return weight < 0; });
+}
+
+bool parseOptions(int argc, const char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto equals = arg.find('=');
+        if (equals == std::string::npos) {
+            return false;
+        }
+        auto name = arg.substr(0, equals);
+        auto value = arg.substr(equals + 1);
+        if (name == "--server") {
+            options.inProcess = value == "inprocess";
+            if (!options.inProcess) {
+                auto colon = value.rfind(':');
+                if (colon == std::string::npos) {
+                    return false;
+                }
+                options.host = value.substr(0, colon);
+                options.port = static_cast<uint16_t>(std::strtoul(value.c_str() + colon + 1, nullptr, 10));
+            }
+        } else if (name == "--network" && (value == "tcp" || value == "virtual")) {
+            options.virtualNetwork = value == "virtual";
+        } else if (name == "--port") {
+            options.port = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (name == "--connections") {
+            options.connections = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--rate") {
+            options.rate = std::strtod(value.c_str(), nullptr);
+        } else if (name == "--duration") {
+            options.duration = std::strtod(value.c_str(), nullptr);
+        } else if (name == "--warmup") {
+            options.warmup = std::strtod(value.c_str(), nullptr);
+        } else if (name == "--contacts") {
+            options.contacts = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--mix") {
+            if (!parseMix(value, options.mix)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    return options.port > 0 && options.connections > 0 && options.rate >= 0 && options.duration > 0 &&
+           options.warmup >= 0 && !(options.virtualNetwork && !options.inProcess);
+}
+
+void runLoad(const Options& options, const std::shared_ptr<oatpp::network::ClientConnectionProvider>& provider) {
+    auto mapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    std::vector<int64_t> ids;
+    {
+        Connection setup(provider);
+        std::fprintf(stderr, "Preloading %zu contacts\n", options.contacts);
+        ids = preload(setup, options.contacts, mapper);
+    }
+
+    std::vector<std::unique_ptr<Tally>> tallies;
+    for (size_t i = 0; i < options.connections; ++i) {
+        tallies.push_back(std::make_unique<Tally>());
+    }
+    auto start = Clock::now();
+    auto measureFrom = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmup));
+    auto end = measureFrom + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+    std::fprintf(stderr, "Running %zu connections for %.1f s after %.1f s of warm-up\n",
+                 options.connections, options.duration, options.warmup);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < options.connections; ++i) {
+        threads.emplace_back([&, i] {
+            runConnection(i, options, provider, ids, mapper, measureFrom, end, *tallies[i]);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    // In open loop a connection that fell behind its schedule keeps sending after the end until it catches up
+    auto seconds = std::max(options.duration, std::chrono::duration<double>(Clock::now() - measureFrom).count());
+
+    std::array<HistogramSnapshot, kOperationCount> latency;
+    HistogramSnapshot total;
+    std::array<uint64_t, 5> statuses{};
+    uint64_t transportErrors = 0;
+    for (const auto& tally : tallies) {
+        for (size_t op = 0; op < kOperationCount; ++op) {
+            tally->latency[op]->addTo(latency[op]);
+            tally->latency[op]->addTo(total);
+        }
+        for (size_t i = 0; i < statuses.size(); ++i) {
+            statuses[i] += tally->statuses[i];
+        }
+        transportErrors += tally->transportErrors;
+    }
+
+    std::printf("%s server, %s, %zu connections, %s, %.1f s measured\n",
+                options.inProcess ? "In-process" : (options.host + ":" + std::to_string(options.port)).c_str(),
+                options.virtualNetwork ? "virtual network" : "TCP", options.connections,
+                options.rate > 0 ? ("open loop at " + std::to_string(static_cast<uint64_t>(options.rate)) +
+                                    " req/s").c_str() : "closed loop", options.duration);
+    std::printf("  %-8s %10s %12s %10s %10s %10s %10s\n", "request", "count", "req/s", "p50 ms", "p99 ms",
+                "p99.9 ms", "mean ms");
+    for (size_t op = 0; op < kOperationCount; ++op) {
+        if (latency[op].count > 0) {
+            printRow(kOperationNames[op], latency[op], seconds);
+        }
+    }
+    printRow("total", total, seconds);
+    std::printf("  responses: 1xx %llu, 2xx %llu, 3xx %llu, 4xx %llu, 5xx %llu; transport errors %llu\n",
+                static_cast<unsigned long long>(statuses[0]), static_cast<unsigned long long>(statuses[1]),
+                static_cast<unsigned long long>(statuses[2]), static_cast<unsigned long long>(statuses[3]),
+                static_cast<unsigned long long>(statuses[4]), static_cast<unsigned long long>(transportErrors));
+    if (options.rate > 0 && seconds > options.duration * 1.05) {
+        std::printf("  target rate not sustained: the scheduled requests took %.1f s to send instead of %.1f s\n",
+                    seconds, options.duration);
+    }
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--server=inprocess|host:port] [--network=tcp|virtual] [--port=8000] "
+                             "[--connections=16] [--rate=0] [--duration=10] [--warmup=2] [--contacts=10000] "
+                             "[--mix=get:70,list:5,create:10,update:10,delete:5]\n", argv[0]);
+        return 1;
+    }
+
+    oatpp::base::Environment::init();
+    try {
+        if (!options.inProcess) {
+            runLoad(options, oatpp::network::tcp::client::ConnectionProvider::createShared(
+                {options.host, options.port, oatpp::network::Address::IP_4}));
+        } else {
+            ::setenv("CONTACTS_PORT", std::to_string(options.port).c_str(), 1);
+            SwaggerComponent swaggerComponent;
+            ContactComponent component;
+            OATPP_COMPONENT(std::shared_ptr<AcceptorGroup>, tcpAcceptors);
+            OATPP_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>, connectionHandler);
+
+            std::shared_ptr<AcceptorGroup> acceptors = tcpAcceptors;
+            std::shared_ptr<oatpp::network::ClientConnectionProvider> clientProvider;
+            if (options.virtualNetwork) {
+                auto interface = oatpp::network::virtual_::Interface::obtainShared("contacts-load");
+                acceptors = std::make_shared<AcceptorGroup>(
+                    std::vector<std::shared_ptr<oatpp::network::ServerConnectionProvider>>{
+                        oatpp::network::virtual_::server::ConnectionProvider::createShared(interface)},
+                    connectionHandler);
+                clientProvider = oatpp::network::virtual_::client::ConnectionProvider::createShared(interface);
+            } else {
+                clientProvider = oatpp::network::tcp::client::ConnectionProvider::createShared(
+                    {"127.0.0.1", options.port, oatpp::network::Address::IP_4});
+            }
+
+            std::thread serverThread([acceptors] {
+                acceptors->run();
+            });
+            runLoad(options, clientProvider);
+            acceptors->stop();
+            connectionHandler->stop();
+            serverThread.join();
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        oatpp::base::Environment::destroy();
+        return 1;
+    }
+    oatpp::base::Environment::destroy();
+    return 0;
+}
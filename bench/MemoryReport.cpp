@@ -0,0 +1,151 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+// Memory-per-contact report: the compact repository storage against the previous layout
+// (std::unordered_map of oatpp::Object<ContactDto>), filled with the same synthetic contacts.
+//
+// Usage: Task_For_NTEC_memory_report [contacts] [--compact-only]
+// Heap usage is measured with mallinfo2() where glibc provides it; elsewhere only the
+// repository's own estimate (ContactRepository::memoryStats) is printed.
+
+#include "dto/ContactDto.hpp"
+#include "repository/ContactRepository.hpp"
+#include <oatpp/core/base/Environment.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+const char* const kFirstNames[] = {"Ivan", "Maria", "Alexey", "Olga", "Dmitry", "Anna", "Sergey", "Elena",
+                                   "Pavel", "Natalia", "Mikhail", "Tatiana", "Andrey", "Irina", "Nikolay", "Svetlana"};
+const char* const kLastNames[] = {"Ivanov", "Petrova", "Sidorov", "Smirnova", "Kuznetsov", "Popova", "Vasiliev",
+                                  "Sokolova", "Mikhailov", "Novikova", "Fedorov", "Morozova", "Volkov", "Alekseeva"};
+const char* const kCities[] = {"Moscow", "Saint Petersburg", "Kazan", "Novosibirsk", "Yekaterinburg",
+                               "Nizhny Novgorod", "Samara", "Omsk", "Rostov-on-Don", "Ufa", "Krasnoyarsk", "Perm"};
+const char* const kStreets[] = {"Lenin St.", "Nevsky Ave.", "Bauman St.", "Gagarin St.", "Mira Ave.", "Sadovaya St.",
+                                "Pushkin St.", "Sovetskaya St.", "Tverskaya St.", "Lesnaya St.", "Shkolnaya St."};
+
+template<typename T, size_t N>
+const T& pick(const T (&values)[N], std::mt19937_64& random) {
+    return values[random() % N];
+}
+
+// Deterministic synthetic contact number i: names and streets repeat, house numbers and phones do not
+oatpp::Object<ContactDto> makeContact(std::mt19937_64& random) {
+    auto contact = ContactDto::createShared();
+    contact->name = std::string(pick(kFirstNames, random)) + " " + pick(kLastNames, random);
+    contact->phone = "+7" + std::to_string(9000000000ull + random() % 1000000000ull);
+    contact->address = std::string(pick(kCities, random)) + ", " + pick(kStreets, random) + ", " +
+                       std::to_string(1 + random() % 200);
+    return contact;
+}
+
+size_t heapInUse() {
+#if defined(__GLIBC__)
+    auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+void printLine(const char* label, size_t bytes, size_t contacts) {
+    std::printf("  %-28s %10.1f MB  %8.1f B/contact\n",
+                label, bytes / (1024.0 * 1024.0), contacts ? static_cast<double>(bytes) / contacts : 0.0);
+}
+
+struct CompactResult {
+    size_t storage = 0;
+    size_t total = 0;
+};
+
+CompactResult measureCompact(size_t count) {
+    std::mt19937_64 random(42);
+    auto heapBefore = heapInUse();
+    auto start = std::chrono::steady_clock::now();
+
+    auto repository = std::make_unique<ContactRepository>();
+    for (size_t i = 0; i < count; ++i) {
+        repository->create(makeContact(random));
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto heap = heapInUse() - heapBefore;
+    auto stats = repository->memoryStats();
+    auto contacts = stats.contacts;
+
+    std::printf("Compact storage (%zu contacts, filled in %.1f s)\n", contacts, elapsed);
+    printLine("records", stats.records, contacts);
+    printLine("id index", stats.idIndex, contacts);
+    printLine("strings", stats.strings, contacts);
+    printLine("address dictionary", stats.dictionary, contacts);
+    printLine("storage total", stats.storage(), contacts);
+    printLine("name index", stats.nameIndex, contacts);
+    printLine("trigram index", stats.trigramIndex, contacts);
+    printLine("phone index", stats.phoneIndex, contacts);
+    printLine("estimated total", stats.total(), contacts);
+    if (heap > 0) {
+        printLine("measured heap", heap, contacts);
+    }
+    return {stats.storage(), heap > 0 ? heap : stats.total()};
+}
+
+size_t measureLegacy(size_t count) {
+    std::mt19937_64 random(42);
+    auto heapBefore = heapInUse();
+    auto start = std::chrono::steady_clock::now();
+
+    auto storage = std::make_unique<std::unordered_map<int64_t, oatpp::Object<ContactDto>>>();
+    for (size_t i = 0; i < count; ++i) {
+        auto contact = makeContact(random);
+        contact->id = static_cast<int64_t>(i + 1);
+        storage->emplace(static_cast<int64_t>(i + 1), contact);
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    auto heap = heapInUse() - heapBefore;
+
+    std::printf("Previous layout: unordered_map<int64, Object<ContactDto>>, no secondary indexes "
+                "(%zu contacts, filled in %.1f s)\n", storage->size(), elapsed);
+    printLine("measured heap", heap, storage->size());
+    return heap;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    oatpp::base::Environment::init();
+
+    size_t count = 10000000;
+    bool compactOnly = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--compact-only") == 0) {
+            compactOnly = true;
+        } else {
+            count = std::strtoull(argv[i], nullptr, 10);
+        }
+    }
+
+    auto compact = measureCompact(count);
+    if (!compactOnly) {
+        auto legacy = measureLegacy(count);
+        if (legacy > 0) {
+            std::printf("Compact storage alone: %.1f%% of the previous layout; with name and phone indexes: %.1f%%\n",
+                        100.0 * compact.storage / legacy, 100.0 * compact.total / legacy);
+        }
+    }
+
+    oatpp::base::Environment::destroy();
+    return 0;
+}
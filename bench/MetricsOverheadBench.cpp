@@ -0,0 +1,150 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+// Metrics overhead benchmark: service throughput with and without request and lock metrics.
+//
+// Usage: Task_For_NTEC_metrics_overhead_bench [threads] [seconds]
+// Each thread runs a read-mostly mix (9 GET /contacts/{id} to 1 PUT /contacts/{id}) against the service.
+// The instrumented run does per request what MetricsInterceptor does (start time boxed as bundle data,
+// endpoint classified from the request line, latency and status recorded) on a repository with shard
+// lock metrics enabled. The HTTP stack itself is left out, so the reported overhead is an upper bound
+// of what a served request sees.
+
+#include "dto/ContactDto.hpp"
+#include "metrics/HttpMetrics.hpp"
+#include "metrics/MetricsExporter.hpp"
+#include "repository/ContactRepository.hpp"
+#include "service/ContactService.hpp"
+#include <oatpp/core/base/Environment.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int64_t kContacts = 100000;
+constexpr int kRounds = 5;
+
+std::shared_ptr<ContactService> createService(const std::shared_ptr<ContactRepository>& repository) {
+    auto service = std::make_shared<ContactService>(repository);
+    for (int64_t i = 0; i < kContacts; ++i) {
+        auto contact = ContactDto::createShared();
+        contact->name = "Contact " + std::to_string(i);
+        contact->phone = "+7" + std::to_string(9000000000ll + i);
+        contact->address = "Moscow";
+        service->createContact(contact);
+    }
+    return service;
+}
+
+uint64_t now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Requests per second over all threads
+double run(ContactService& service, HttpMetrics* metrics, size_t threadCount, double seconds) {
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 random(t + 1);
+            uint64_t requests = 0;
+            std::string path;
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto id = static_cast<int64_t>(random() % kContacts) + 1;
+                bool write = requests % 10 == 9;
+                // The request line a server parses for both runs
+                path = "/contacts/" + std::to_string(id);
+                oatpp::UInt64 start;
+                if (metrics) {
+                    start = now();
+                }
+
+                int status;
+                if (write) {
+                    auto contact = ContactDto::createShared();
+                    contact->id = id;
+                    contact->name = "Updated " + std::to_string(id);
+                    contact->phone = "+7" + std::to_string(9000000000ll + id);
+                    contact->address = "Kazan";
+                    status = service.updateContact(contact) ? 200 : 400;
+                } else {
+                    status = service.getContactById(id) ? 200 : 404;
+                }
+
+                if (metrics) {
+                    auto endpoint = HttpMetrics::classify(write ? "PUT" : "GET", path);
+                    metrics->record(endpoint, status, now() - *start);
+                }
+                ++requests;
+            }
+            total.fetch_add(requests);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return static_cast<double>(total.load()) / seconds;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    oatpp::base::Environment::init();
+
+    size_t threads = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+    double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 5;
+    if (threads == 0 || seconds <= 0) {
+        std::fprintf(stderr, "Usage: %s [threads] [seconds]\n", argv[0]);
+        return 1;
+    }
+
+    auto plain = createService(std::make_shared<ContactRepository>());
+    auto meteredRepository = std::make_shared<ContactRepository>();
+    meteredRepository->enableLockMetrics();
+    auto metered = createService(meteredRepository);
+    auto metrics = std::make_shared<HttpMetrics>();
+
+    // Warm up both services before measuring
+    run(*plain, nullptr, threads, seconds / kRounds);
+    run(*metered, metrics.get(), threads, seconds / kRounds);
+
+    // Short alternating runs, best of each, so that a noisy neighbour does not decide the comparison
+    double before = 0;
+    double after = 0;
+    for (int round = 0; round < kRounds; ++round) {
+        before = std::max(before, run(*plain, nullptr, threads, seconds / kRounds));
+        after = std::max(after, run(*metered, metrics.get(), threads, seconds / kRounds));
+    }
+    std::printf("GET/PUT /contacts/{id} 9:1, %zu threads, %.1f s per variant\n", threads, seconds);
+    std::printf("  %-28s %12.0f req/s\n", "without metrics", before);
+    std::printf("  %-28s %12.0f req/s\n", "with metrics", after);
+    std::printf("  overhead %.2f%%\n", (before - after) / before * 100);
+
+    auto latency = metrics->latency(HttpMetrics::Endpoint::GetContactById);
+    std::printf("  GET latency p50 %llu ns, p99 %llu ns, p99.9 %llu ns\n",
+                static_cast<unsigned long long>(latency.quantile(0.5)),
+                static_cast<unsigned long long>(latency.quantile(0.99)),
+                static_cast<unsigned long long>(latency.quantile(0.999)));
+
+    // Cost of one scrape, which merges every stripe
+    MetricsExporter exporter(metrics, meteredRepository, nullptr);
+    auto scrapeStart = now();
+    auto text = exporter.render();
+    std::printf("  scrape of %zu bytes took %.1f us\n", text.size(), static_cast<double>(now() - scrapeStart) / 1000);
+
+    oatpp::base::Environment::destroy();
+    return 0;
+}
@@ -0,0 +1,457 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+// Repository and service microbenchmarks: create / getById / getAll / update / remove at several directory
+// sizes, single-threaded, and a mixed getById / update load at several thread counts and read ratios.
+// pageAfterUpdate is an update followed by the first page (20 contacts) of the id listing, which takes a
+// fresh snapshot every time.
+// The repository layer also times a fuzzy name search against a vocabulary of that many words.
+//
+// Usage: Task_For_NTEC_micro_bench [--sizes=1000,100000,1000000] [--threads=1,4,8] [--reads=0.5,0.9,0.99]
+//                                  [--ops=100000] [--seconds=1] [--layer=repository|service|all]
+//                                  [--baseline=previous.jsonl] [--tolerance=0.1]
+// Results go to stdout as JSON Lines, one object per measurement; progress goes to stderr. With --baseline
+// every measurement is compared with the same one of an earlier run, and the exit code is 2 if any
+// throughput dropped by more than the tolerance. Latencies are per call and include one clock read
+// (tens of nanoseconds), which matters only for the fastest calls; ops_per_sec is taken over wall time.
+
+#include "dto/ContactDto.hpp"
+#include "metrics/LatencyHistogram.hpp"
+#include "repository/ContactRepository.hpp"
+#include "repository/TrigramIndex.hpp"
+#include "service/ContactService.hpp"
+#include <oatpp/core/base/Environment.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::vector<size_t> sizes = {1000, 10000, 100000, 1000000};
+    std::vector<size_t> threads;
+    std::vector<double> reads = {0.5, 0.9, 0.99};
+    size_t ops = 100000;
+    double seconds = 1;
+    bool repository = true;
+    bool service = true;
+    const char* baseline = nullptr;
+    double tolerance = 0.1;
+};
+
+// One measurement, written as a JSON Lines record
+struct Result {
+    const char* layer;
+    const char* op;
+    size_t contacts;
+    size_t threads = 1;
+    // Share of getById in a mixed run, negative for single-operation runs
+    double readRatio = -1;
+    uint64_t ops = 0;
+    double seconds = 0;
+    HistogramSnapshot latency;
+};
+
+uint64_t now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+const char* const kNames[] = {"Ivan Ivanov", "Maria Petrova", "Alexey Sidorov", "Olga Smirnova", "Dmitry Kuznetsov",
+                              "Anna Popova", "Sergey Vasiliev", "Elena Sokolova"};
+const char* const kCities[] = {"Moscow", "Saint Petersburg", "Kazan", "Novosibirsk", "Yekaterinburg", "Samara"};
+
+// Contact number i; phones are unique, names and addresses repeat
+oatpp::Object<ContactDto> makeContact(uint64_t i) {
+    auto contact = ContactDto::createShared();
+    contact->name = kNames[i % 8];
+    contact->phone = "+7" + std::to_string(9000000000ull + i);
+    contact->address = std::string(kCities[i % 6]) + ", Lenin St., " + std::to_string(1 + i % 200);
+    return contact;
+}
+
+// The calls under test, through the repository directly or through the service and its validation
+struct RepositoryLayer {
+    static constexpr const char* kName = "repository";
+    std::shared_ptr<ContactRepository> repository;
+
+    int64_t create(const oatpp::Object<ContactDto>& contact) {
+        auto created = repository->create(contact);
+        return created ? *created->id : 0;
+    }
+    bool get(int64_t id) {
+        return repository->getById(id) != nullptr;
+    }
+    size_t getAll() {
+        return repository->getAll().size();
+    }
+    size_t page(size_t limit) {
+        auto snapshot = repository->snapshot();
+        ContactSnapshot::Cursor cursor(*snapshot, 0);
+        size_t count = 0;
+        while (count < limit && cursor.next()) {
+            ++count;
+        }
+        return count;
+    }
+    bool update(const oatpp::Object<ContactDto>& contact) {
+        return repository->update(contact) != nullptr;
+    }
+    bool remove(int64_t id) {
+        return repository->remove(id);
+    }
+};
+
+struct ServiceLayer {
+    static constexpr const char* kName = "service";
+    std::shared_ptr<ContactService> service;
+
+    int64_t create(const oatpp::Object<ContactDto>& contact) {
+        auto created = service->createContact(contact);
+        return created ? *(*created)->id : 0;
+    }
+    bool get(int64_t id) {
+        return service->getContactById(id).ok();
+    }
+    size_t getAll() {
+        return service->getAllContacts().size();
+    }
+    size_t page(size_t limit) {
+        auto page = service->getContactsPage(nullptr, static_cast<int64_t>(limit)).value();
+        ContactSnapshot::Cursor cursor(*page.snapshot, page.afterId, page.descending);
+        size_t count = 0;
+        while (count < page.limit && cursor.next()) {
+            ++count;
+        }
+        return count;
+    }
+    bool update(const oatpp::Object<ContactDto>& contact) {
+        return service->updateContact(contact).ok();
+    }
+    bool remove(int64_t id) {
+        return service->deleteContact(id).ok();
+    }
+};
+
+// Writes results and compares them with a baseline run (the JSON Lines output of an earlier run)
+// A measurement is matched by layer, op, contacts, threads and read ratio; it regresses when its
+// throughput is more than tolerance below the baseline's.
+class Reporter {
+public:
+    Reporter(std::unordered_map<std::string, double> baseline, double tolerance)
+        : baseline_(std::move(baseline))
+        , tolerance_(tolerance) {}
+
+    static bool loadBaseline(const char* path, std::unordered_map<std::string, double>& baseline) {
+        std::ifstream file(path);
+        if (!file) {
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            auto keyEnd = line.find(kKeyEnd);
+            auto rate = line.find(kRate);
+            if (keyEnd != std::string::npos && rate != std::string::npos) {
+                baseline[line.substr(0, keyEnd)] = std::strtod(line.c_str() + rate + std::strlen(kRate), nullptr);
+            }
+        }
+        return true;
+    }
+
+    void report(const Result& result) {
+        char ratio[32] = "null";
+        if (result.readRatio >= 0) {
+            std::snprintf(ratio, sizeof(ratio), "%g", result.readRatio);
+        }
+        char key[256];
+        std::snprintf(key, sizeof(key), "{\"layer\":\"%s\",\"op\":\"%s\",\"contacts\":%zu,\"threads\":%zu,\"read_ratio\":%s",
+                      result.layer, result.op, result.contacts, result.threads, ratio);
+        auto opsPerSec = result.seconds > 0 ? static_cast<double>(result.ops) / result.seconds : 0.0;
+        std::printf("%s%s%llu,\"seconds\":%.6f%s%.0f,"
+                    "\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"mean_ns\":%.0f}\n",
+                    key, kKeyEnd, static_cast<unsigned long long>(result.ops), result.seconds, kRate, opsPerSec,
+                    static_cast<unsigned long long>(result.latency.quantile(0.5)),
+                    static_cast<unsigned long long>(result.latency.quantile(0.9)),
+                    static_cast<unsigned long long>(result.latency.quantile(0.99)),
+                    static_cast<unsigned long long>(result.latency.quantile(0.999)),
+                    result.latency.count ? static_cast<double>(result.latency.sum) / result.latency.count : 0.0);
+        std::fflush(stdout);
+
+        auto base = baseline_.find(key);
+        if (base != baseline_.end() && opsPerSec < base->second * (1 - tolerance_)) {
+            std::fprintf(stderr, "REGRESSION %s: %.0f ops/s, baseline %.0f ops/s (%.1f%%)\n", key + 1, opsPerSec,
+                         base->second, (opsPerSec / base->second - 1) * 100);
+            ++regressions_;
+        }
+    }
+
+    size_t regressions() const {
+        return regressions_;
+    }
+
+private:
+    static constexpr const char* kKeyEnd = ",\"ops\":";
+    static constexpr const char* kRate = ",\"ops_per_sec\":";
+
+    std::unordered_map<std::string, double> baseline_;
+    double tolerance_;
+    size_t regressions_ = 0;
+};
+
+// Times call(i) for i in [0, count) on the calling thread
+template<typename Call>
+Result measure(const char* layer, const char* op, size_t contacts, size_t count, Call&& call) {
+    LatencyHistogram histogram;
+    auto start = now();
+    auto last = start;
+    for (size_t i = 0; i < count; ++i) {
+        call(i);
+        auto current = now();
+        histogram.record(current - last);
+        last = current;
+    }
+    Result result{layer, op, contacts};
+    result.ops = count;
+    result.seconds = static_cast<double>(last - start) / 1e9;
+    result.latency = histogram.snapshot();
+    return result;
+}
+
+// Getters and updates of random existing contacts on threads threads for seconds seconds
+template<typename Layer>
+Result measureMixed(Layer& layer, const std::vector<int64_t>& ids, size_t threadCount, double readRatio,
+                    double seconds) {
+    std::vector<std::unique_ptr<LatencyHistogram>> histograms;
+    for (size_t t = 0; t < threadCount; ++t) {
+        histograms.push_back(std::make_unique<LatencyHistogram>());
+    }
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> threads;
+    auto readThreshold = static_cast<uint64_t>(readRatio * 1000000);
+    auto start = now();
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 random(t + 1);
+            auto& histogram = *histograms[t];
+            uint64_t ops = 0;
+            auto last = now();
+            while (!stop.load(std::memory_order_relaxed)) {
+                auto id = ids[random() % ids.size()];
+                if (random() % 1000000 < readThreshold) {
+                    layer.get(id);
+                } else {
+                    auto contact = makeContact(static_cast<uint64_t>(id));
+                    contact->id = id;
+                    layer.update(contact);
+                }
+                auto current = now();
+                histogram.record(current - last);
+                last = current;
+                ++ops;
+            }
+            total.fetch_add(ops);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    Result result{Layer::kName, "mixed", ids.size(), threadCount, readRatio};
+    result.ops = total.load();
+    result.seconds = static_cast<double>(now() - start) / 1e9;
+    for (const auto& histogram : histograms) {
+        histogram->addTo(result.latency);
+    }
+    return result;
+}
+
+template<typename Layer>
+void runLayer(Layer layer, size_t size, const Options& options, Reporter& reporter) {
+    std::fprintf(stderr, "%s: filling %zu contacts\n", Layer::kName, size);
+    std::vector<int64_t> ids;
+    ids.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        ids.push_back(layer.create(makeContact(i)));
+    }
+
+    std::mt19937_64 random(42);
+    auto ops = options.ops;
+
+    reporter.report(measure(Layer::kName, "getById", size, ops, [&](size_t) {
+        layer.get(ids[random() % ids.size()]);
+    }));
+    // Every getAll copies the whole directory: as many rounds as fit in --seconds, at least 3
+    auto getAllStart = now();
+    auto getAll = measure(Layer::kName, "getAll", size, 3, [&](size_t) {
+        layer.getAll();
+    });
+    auto roundTime = static_cast<double>(now() - getAllStart) / 1e9 / 3;
+    auto rounds = static_cast<size_t>(std::clamp(options.seconds / roundTime, 3.0, 1000.0));
+    if (rounds > 3) {
+        getAll = measure(Layer::kName, "getAll", size, rounds, [&](size_t) {
+            layer.getAll();
+        });
+    }
+    reporter.report(getAll);
+    std::vector<oatpp::Object<ContactDto>> updates(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        auto id = ids[random() % ids.size()];
+        updates[i] = makeContact(static_cast<uint64_t>(id) + 1);
+        updates[i]->id = id;
+    }
+    reporter.report(measure(Layer::kName, "update", size, ops, [&](size_t i) {
+        layer.update(updates[i]);
+    }));
+    // Every page sees a write before it, so no snapshot is reused
+    for (auto& update : updates) {
+        auto id = *update->id;
+        update = makeContact(static_cast<uint64_t>(id) + 2);
+        update->id = id;
+    }
+    reporter.report(measure(Layer::kName, "pageAfterUpdate", size, ops, [&](size_t i) {
+        layer.update(updates[i]);
+        layer.page(20);
+    }));
+    // New contacts on top of the filled directory, removed again right after, so the size stays the same
+    std::vector<int64_t> created(ops);
+    reporter.report(measure(Layer::kName, "create", size, ops, [&](size_t i) {
+        created[i] = layer.create(makeContact(size + i));
+    }));
+    reporter.report(measure(Layer::kName, "remove", size, ops, [&](size_t i) {
+        layer.remove(created[i]);
+    }));
+
+    for (auto threadCount : options.threads) {
+        for (auto readRatio : options.reads) {
+            std::fprintf(stderr, "%s: %zu contacts, %zu threads, %g reads\n", Layer::kName, size, threadCount, readRatio);
+            reporter.report(measureMixed(layer, ids, threadCount, readRatio, options.seconds));
+        }
+    }
+}
+
+// Fuzzy search of one name word in a trigram index whose vocabulary has size other words
+// The other words are spelled without the letters of the query, so they share none of its trigrams: the
+// candidates stay the same at every size, and so should the time per search.
+void runFuzzy(size_t size, const Options& options, Reporter& reporter) {
+    std::fprintf(stderr, "trigram: filling %zu words\n", size);
+    const char kLetters[] = "abcdghijklmnsuwxyz";
+    const size_t kLetterCount = sizeof(kLetters) - 1;
+    TrigramIndex index;
+    for (size_t i = 0; i < size; ++i) {
+        std::string word;
+        for (auto n = i + kLetterCount * kLetterCount; n > 0; n /= kLetterCount) {
+            word += kLetters[n % kLetterCount];
+        }
+        index.insert(word, static_cast<int64_t>(i));
+    }
+    for (size_t i = 0; i < 8; ++i) {
+        index.insert(kNames[i], static_cast<int64_t>(size + i));
+    }
+
+    auto query = TrigramIndex::compile("Petrof");
+    reporter.report(measure("trigram", "fuzzySearch", size, options.ops, [&](size_t) {
+        index.search(query, 20);
+    }));
+}
+
+// Comma-separated numbers; empty on a malformed list
+template<typename T>
+std::vector<T> parseList(const char* text) {
+    std::vector<T> values;
+    while (*text) {
+        char* end = nullptr;
+        auto value = std::strtod(text, &end);
+        if (end == text || (*end != ',' && *end != '\0')) {
+            return {};
+        }
+        values.push_back(static_cast<T>(value));
+        text = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+bool parseOptions(int argc, const char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = arg.find('=') == std::string::npos ? "" : argv[i] + arg.find('=') + 1;
+        if (arg.rfind("--sizes=", 0) == 0) {
+            options.sizes = parseList<size_t>(value);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            options.threads = parseList<size_t>(value);
+        } else if (arg.rfind("--reads=", 0) == 0) {
+            options.reads = parseList<double>(value);
+        } else if (arg.rfind("--ops=", 0) == 0) {
+            options.ops = std::strtoull(value, nullptr, 10);
+        } else if (arg.rfind("--seconds=", 0) == 0) {
+            options.seconds = std::strtod(value, nullptr);
+        } else if (arg.rfind("--baseline=", 0) == 0) {
+            options.baseline = value;
+        } else if (arg.rfind("--tolerance=", 0) == 0) {
+            options.tolerance = std::strtod(value, nullptr);
+        } else if (arg == "--layer=repository" || arg == "--layer=service" || arg == "--layer=all") {
+            options.repository = arg != "--layer=service";
+            options.service = arg != "--layer=repository";
+        } else {
+            return false;
+        }
+    }
+    auto positive = [](auto value) { return value > 0; };
+    return !options.sizes.empty() && std::all_of(options.sizes.begin(), options.sizes.end(), positive) &&
+           std::all_of(options.threads.begin(), options.threads.end(), positive) &&
+           std::all_of(options.reads.begin(), options.reads.end(), [](double r) { return r >= 0 && r <= 1; }) &&
+           options.ops > 0 && options.seconds > 0 && options.tolerance >= 0 && options.tolerance < 1;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    oatpp::base::Environment::init();
+
+    Options options;
+    size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+    options.threads = {1, std::max<size_t>(cpus / 2, 2), cpus * 2};
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--sizes=1000,100000,1000000] [--threads=1,4,8] [--reads=0.5,0.9,0.99] "
+                             "[--ops=100000] [--seconds=1] [--layer=repository|service|all] "
+                             "[--baseline=previous.jsonl] [--tolerance=0.1]\n", argv[0]);
+        return 1;
+    }
+    std::unordered_map<std::string, double> baseline;
+    if (options.baseline && !Reporter::loadBaseline(options.baseline, baseline)) {
+        std::fprintf(stderr, "Cannot read baseline %s\n", options.baseline);
+        return 1;
+    }
+    Reporter reporter(std::move(baseline), options.tolerance);
+    std::sort(options.threads.begin(), options.threads.end());
+    options.threads.erase(std::unique(options.threads.begin(), options.threads.end()), options.threads.end());
+
+    for (auto size : options.sizes) {
+        // A fresh directory per size and layer; the repository's demo contacts are not counted
+        if (options.repository) {
+            runLayer(RepositoryLayer{std::make_shared<ContactRepository>()}, size, options, reporter);
+            runFuzzy(size, options, reporter);
+        }
+        if (options.service) {
+            runLayer(ServiceLayer{std::make_shared<ContactService>(std::make_shared<ContactRepository>())}, size, options,
+                     reporter);
+        }
+    }
+
+    oatpp::base::Environment::destroy();
+    // Non-zero when a measurement fell behind the baseline, so a CI job can fail on it
+    return reporter.regressions() > 0 ? 2 : 0;
+}
@@ -0,0 +1,104 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+// Wire format benchmark: JSON (oatpp ObjectMapper) against MessagePack (ContactMessagePack)
+// for the payloads the API exchanges most: single contacts and lists of contacts.
+//
+// Usage: Task_For_NTEC_wire_format_bench [contacts] [rounds]
+// Prints encoded size and encode / decode throughput of both formats for a single contact
+// and for one list of all the contacts (a batch request or a listing page).
+
+#include "codec/ContactMessagePack.hpp"
+#include "dto/ContactDto.hpp"
+#include <oatpp/core/base/Environment.hpp>
+#include <oatpp/parser/json/mapping/ObjectMapper.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+
+namespace {
+
+const char* const kFirstNames[] = {"Ivan", "Maria", "Alexey", "Olga", "Dmitry", "Anna", "Sergey", "Elena"};
+const char* const kLastNames[] = {"Ivanov", "Petrova", "Sidorov", "Smirnova", "Kuznetsov", "Popova", "Vasiliev"};
+const char* const kCities[] = {"Moscow", "Saint Petersburg", "Kazan", "Novosibirsk", "Yekaterinburg", "Samara"};
+
+template<typename T, size_t N>
+const T& pick(const T (&values)[N], std::mt19937_64& random) {
+    return values[random() % N];
+}
+
+oatpp::Object<ContactDto> makeContact(std::mt19937_64& random, int64_t id) {
+    auto contact = ContactDto::createShared();
+    contact->id = id;
+    contact->name = std::string(pick(kFirstNames, random)) + " " + pick(kLastNames, random);
+    contact->phone = "+7" + std::to_string(9000000000ull + random() % 1000000000ull);
+    contact->address = std::string(pick(kCities, random)) + ", Lenin St., " + std::to_string(1 + random() % 200);
+    return contact;
+}
+
+// Runs body `rounds` times and returns the mean time of one run in microseconds
+double measure(size_t rounds, const std::function<void()>& body) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i) {
+        body();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+}
+
+void printRow(const char* format, size_t bytes, double encodeUs, double decodeUs) {
+    std::printf("  %-12s %12zu B  encode %10.2f us  decode %10.2f us\n", format, bytes, encodeUs, decodeUs);
+}
+
+template<typename T>
+void compare(const char* title, const T& value, size_t rounds,
+             const std::shared_ptr<oatpp::parser::json::mapping::ObjectMapper>& objectMapper,
+             const std::function<T(const oatpp::String&)>& decodeMessagePack) {
+    oatpp::String json;
+    auto jsonEncode = measure(rounds, [&] { json = objectMapper->writeToString(value); });
+    auto jsonDecode = measure(rounds, [&] { objectMapper->readFromString<T>(json); });
+
+    oatpp::String messagePack;
+    auto messagePackEncode = measure(rounds, [&] { messagePack = ContactMessagePack::encode(value); });
+    auto messagePackDecode = measure(rounds, [&] { decodeMessagePack(messagePack); });
+
+    std::printf("%s (mean of %zu rounds)\n", title, rounds);
+    printRow("JSON", json->size(), jsonEncode, jsonDecode);
+    printRow("MessagePack", messagePack->size(), messagePackEncode, messagePackDecode);
+    std::printf("  MessagePack: %.1f%% of the JSON size, encode x%.2f, decode x%.2f\n",
+                100.0 * messagePack->size() / json->size(),
+                jsonEncode / messagePackEncode, jsonDecode / messagePackDecode);
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    oatpp::base::Environment::init();
+
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    size_t rounds = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 20;
+    if (count == 0 || rounds == 0) {
+        std::fprintf(stderr, "Usage: %s [contacts] [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+    std::mt19937_64 random(42);
+
+    auto list = oatpp::List<oatpp::Object<ContactDto>>::createShared();
+    for (size_t i = 0; i < count; ++i) {
+        list->push_back(makeContact(random, static_cast<int64_t>(i + 1)));
+    }
+
+    compare<oatpp::Object<ContactDto>>("Single contact", list->front(), rounds * 1000, objectMapper,
+                                       ContactMessagePack::decodeContact);
+    compare<oatpp::List<oatpp::Object<ContactDto>>>(("List of " + std::to_string(count) + " contacts").c_str(),
+                                                    list, rounds, objectMapper,
+                                                    ContactMessagePack::decodeContactList);
+
+    oatpp::base::Environment::destroy();
+    return 0;
+}
@@ -4,25 +4,52 @@
 
 #pragma once
 
+#include "cache/CompressedResponseCache.hpp"
+#include "cache/ContactJsonCache.hpp"
+#include "config/AppConfig.hpp"
 #include "dto/ContactDto.hpp"
+#include "repository/ChangeLog.hpp"
+#include "repository/Checkpointer.hpp"
 #include "repository/ContactRepository.hpp"
+#include "storage/SnapshotFile.hpp"
+#include "storage/WriteAheadLog.hpp"
 #include "service/ContactService.hpp"
+#include "controller/AsyncContactController.hpp"
 #include "controller/ContactController.hpp"
 #include "exception/ExceptionHandler.hpp"
+#include "metrics/HttpMetrics.hpp"
+#include "metrics/MetricsExporter.hpp"
+#include "metrics/MetricsInterceptor.hpp"
+#include "network/AcceptorGroup.hpp"
+#include "network/BlockingTaskPool.hpp"
+#include "network/CompressionInterceptor.hpp"
+#include "network/ReusePortConnectionProvider.hpp"
 #include "swagger/SwaggerComponent.hpp"
 #include <oatpp/web/server/handler/ErrorHandler.hpp>
 #include <oatpp/core/macro/component.hpp>
 #include <oatpp/web/server/HttpRouter.hpp>
 #include <oatpp/parser/json/mapping/ObjectMapper.hpp>
+#include <oatpp/web/server/AsyncHttpConnectionHandler.hpp>
 #include <oatpp/web/server/HttpConnectionHandler.hpp>
-#include <oatpp/network/tcp/server/ConnectionProvider.hpp>
+#include <oatpp/core/async/Executor.hpp>
+#include <oatpp-swagger/AsyncController.hpp>
 #include <oatpp-swagger/Controller.hpp>
 #include <oatpp-swagger/Model.hpp>
+#include <chrono>
+#include <filesystem>
 
 // Component for registering all application components
 class ContactComponent {
 public:
 
+    // Settings from environment variables (see AppConfig)
+    OATPP_CREATE_COMPONENT(
+        std::shared_ptr<AppConfig>,
+        appConfig
+    )([] {
+        return std::make_shared<AppConfig>(AppConfig::fromEnvironment());
+    }());
+
     // ObjectMapper for JSON serialization/deserialization
     OATPP_CREATE_COMPONENT(
         std::shared_ptr<oatpp::data::mapping::ObjectMapper>,
@@ -33,12 +60,118 @@ public:
         return mapper;
     }());
 
-    // Repository - create one instance
+    // Repository - create one instance; with a data directory it starts from the last snapshot file
+    // plus the journal tail and journals every change
     OATPP_CREATE_COMPONENT(
         std::shared_ptr<ContactRepository>,
         contactRepository
     )([] {
-        return std::make_shared<ContactRepository>();
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        std::shared_ptr<WriteAheadLog> log;
+        std::shared_ptr<const SnapshotFile> base;
+        if (config->persistent()) {
+            std::filesystem::create_directories(config->dataDir);
+            base = SnapshotFile::open(config->snapshotPath());
+            log = std::make_shared<WriteAheadLog>(config->journalPath(), config->durability);
+        }
+        auto repository = std::make_shared<ContactRepository>(config->shardCount, config->uniquePhones, log, base);
+        repository->setMaxTombstones(config->tombstones);
+        if (config->metricsEnabled) {
+            repository->enableLockMetrics();
+        }
+        return repository;
+    }());
+
+    // Serialized contact cache - nullptr when disabled; kept current through repository change notifications
+    OATPP_CREATE_COMPONENT(
+        std::shared_ptr<ContactJsonCache>,
+        contactJsonCache
+    )([] {
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        OATPP_COMPONENT(std::shared_ptr<ContactRepository>, repository);
+        if (config->jsonCacheEntries == 0) {
+            return std::shared_ptr<ContactJsonCache>();
+        }
+        auto cache = std::make_shared<ContactJsonCache>(config->jsonCacheEntries);
+        repository->addChangeListener([cache](const ContactRepository::ContactChange& change) {
+            cache->invalidate(change.id);
+        });
+        return cache;
+    }());
+
+    // Compressed bodies of unchanged listings - nullptr when compression or the cache is disabled
+    OATPP_CREATE_COMPONENT(
+        std::shared_ptr<CompressedResponseCache>,
+        compressedResponseCache
+    )([] {
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        if (!config->compressionEnabled || config->compressionCacheMegabytes == 0) {
+            return std::shared_ptr<CompressedResponseCache>();
+        }
+        return std::make_shared<CompressedResponseCache>(config->compressionCacheMegabytes << 20);
+    }());
+
+    // Recent changes for the change feed - nullptr when disabled; appended to by a repository change listener
+    OATPP_CREATE_COMPONENT(
+        std::shared_ptr<ChangeLog>,
+        changeLog
+    )([] {
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        OATPP_COMPONENT(std::shared_ptr<ContactRepository>, repository);
+        if (config->changeLogEntries == 0) {
+            return std::shared_ptr<ChangeLog>();
+        }
+        auto changeLog = std::make_shared<ChangeLog>(config->changeLogEntries);
+        repository->addChangeListener([changeLog](const ContactRepository::ContactChange& change) {
+            changeLog->append(change);
+        });
+        return changeLog;
+    }());
+
+    // Checkpointer - background snapshot files, only for a persistent repository
+    OATPP_CREATE_COMPONENT(
+        std::shared_ptr<Checkpointer>,
+        checkpointer
+    )([] {
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        OATPP_COMPONENT(std::shared_ptr<ContactRepository>, repository);
+        if (!config->persistent()) {
+            return std::shared_ptr<Checkpointer>();
+        }
+        auto checkpointer = std::make_shared<Checkpointer>(
+            repository,
+            config->snapshotPath(),
+            std::chrono::seconds(config->snapshotIntervalSeconds),
+            static_cast<uint64_t>(config->snapshotJournalMegabytes) << 20);
+        checkpointer->start();
+        return checkpointer;
+    }());
+
+    // Request metrics - nullptr when disabled; filled by MetricsInterceptor on the connection handler
+    OATPP_CREATE_COMPONENT(
+        std::shared_ptr<HttpMetrics>,
+        httpMetrics
+    )([] {
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        if (!config->metricsEnabled) {
+            return std::shared_ptr<HttpMetrics>();
+        }
+        return std::make_shared<HttpMetrics>();
+    }());
+
+    // Metrics exporter for GET /metrics - nullptr when disabled
+    OATPP_CREATE_COMPONENT(
+        std::shared_ptr<MetricsExporter>,
+        metricsExporter
+    )([] {
+        OATPP_COMPONENT(std::shared_ptr<HttpMetrics>, metrics);
+        OATPP_COMPONENT(std::shared_ptr<ContactRepository>, repository);
+        OATPP_COMPONENT(std::shared_ptr<ContactJsonCache>, cache);
+        OATPP_COMPONENT(std::shared_ptr<CompressedResponseCache>, compressedCache);
+        if (!metrics) {
+            return std::shared_ptr<MetricsExporter>();
+        }
+        return std::make_shared<MetricsExporter>(metrics, repository, cache, compressedCache);
     }());
 
     // Service - depends on Repository
@@ -59,34 +192,56 @@ public:
         return std::make_shared<ApiErrorHandler>(objectMapper);
     }());
 
-    // Controller - depends on ObjectMapper and Service
+    // Contacts API controller for the configured serving mode - depends on ObjectMapper and Service
+    // Threaded mode: ContactController, errors go through the controller's error handler
+    // Async mode: AsyncContactController, errors go through the connection handler's error handler; calls that
+    // block run on a BlockingTaskPool of CONTACTS_BLOCKING_THREADS threads
     OATPP_CREATE_COMPONENT(
-        std::shared_ptr<ContactController>,
+        std::shared_ptr<oatpp::web::server::api::ApiController>,
         contactController
     )([] {
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
         OATPP_COMPONENT(std::shared_ptr<oatpp::data::mapping::ObjectMapper>, objectMapper);
         OATPP_COMPONENT(std::shared_ptr<ContactService>, service);
+        OATPP_COMPONENT(std::shared_ptr<ContactJsonCache>, cache);
+        OATPP_COMPONENT(std::shared_ptr<MetricsExporter>, metrics);
+        OATPP_COMPONENT(std::shared_ptr<ChangeLog>, changeLog);
         OATPP_COMPONENT(std::shared_ptr<ApiErrorHandler>, errorHandler);
-        auto controller = std::make_shared<ContactController>(objectMapper, service);
+        std::shared_ptr<oatpp::web::server::api::ApiController> controller;
+        if (config->serverMode == AppConfig::ServerMode::Async) {
+            auto blockingPool = std::make_shared<BlockingTaskPool>(config->blockingThreads);
+            controller = std::make_shared<AsyncContactController>(objectMapper, service, cache, metrics, changeLog,
+                                                                  blockingPool);
+        } else {
+            controller = std::make_shared<ContactController>(objectMapper, service, cache, metrics, changeLog);
+        }
         controller->setErrorHandler(errorHandler);
         return controller;
     }());
 
     // Swagger Controller - depends on Controller, DocumentInfo and Resources
-    // Must be created after contactController is registered
+    // Must be created after contactController is registered; async mode needs the async variant
     OATPP_CREATE_COMPONENT(
-        std::shared_ptr<oatpp::swagger::Controller>,
-        swaggerController
+        std::shared_ptr<oatpp::web::server::api::ApiController>,
+        swaggerController,
+        "swaggerController"
     )([] {
-        OATPP_COMPONENT(std::shared_ptr<ContactController>, controller);
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        OATPP_COMPONENT(std::shared_ptr<oatpp::web::server::api::ApiController>, controller);
         OATPP_COMPONENT(std::shared_ptr<oatpp::swagger::DocumentInfo>, documentInfo);
         OATPP_COMPONENT(std::shared_ptr<oatpp::swagger::Resources>, resources);
-        
+
         // Get endpoints from controller
         oatpp::web::server::api::Endpoints docEndpoints;
         docEndpoints.append(controller->getEndpoints());
-        
-        return oatpp::swagger::Controller::createShared(docEndpoints, documentInfo, resources);
+
+        std::shared_ptr<oatpp::web::server::api::ApiController> swaggerController;
+        if (config->serverMode == AppConfig::ServerMode::Async) {
+            swaggerController = oatpp::swagger::AsyncController::createShared(docEndpoints, documentInfo, resources);
+        } else {
+            swaggerController = oatpp::swagger::Controller::createShared(docEndpoints, documentInfo, resources);
+        }
+        return swaggerController;
     }());
 
     // HTTP Router - for registering endpoints
@@ -97,11 +252,11 @@ public:
         auto router = oatpp::web::server::HttpRouter::createShared();
     
         // Register Contact Controller in Router
-        OATPP_COMPONENT(std::shared_ptr<ContactController>, controller);
+        OATPP_COMPONENT(std::shared_ptr<oatpp::web::server::api::ApiController>, controller);
         router->addController(controller);
         
         // Register Swagger Controller in Router
-        OATPP_COMPONENT(std::shared_ptr<oatpp::swagger::Controller>, swaggerController);
+        OATPP_COMPONENT(std::shared_ptr<oatpp::web::server::api::ApiController>, swaggerController, "swaggerController");
         router->addController(swaggerController);
         
         return router;
@@ -116,24 +271,61 @@ public:
     }());
 
     // Connection Handler - handles HTTP connections
+    // Threaded mode starts a thread per connection; async mode multiplexes all connections
+    // over a fixed executor (processing threads + one I/O and one timer worker)
+    // With metrics enabled every request is timed by the MetricsInterceptor pair
+    // With compression enabled bodies are compressed first, so a buffered body's compression is timed too
     OATPP_CREATE_COMPONENT(
         std::shared_ptr<oatpp::network::ConnectionHandler>,
         connectionHandler
     )([] {
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
         OATPP_COMPONENT(std::shared_ptr<oatpp::web::server::HttpRouter>, httpRouter);
         OATPP_COMPONENT(std::shared_ptr<ExceptionHandler>, exceptionHandler);
+        OATPP_COMPONENT(std::shared_ptr<ApiErrorHandler>, errorHandler);
+        OATPP_COMPONENT(std::shared_ptr<HttpMetrics>, metrics);
+        OATPP_COMPONENT(std::shared_ptr<CompressedResponseCache>, compressedCache);
+        auto setUp = [&](auto& handler) {
+            handler->setErrorHandler(errorHandler);
+            if (config->compressionEnabled) {
+                handler->addResponseInterceptor(std::make_shared<CompressionInterceptor>(
+                    config->compressionMinBytes, static_cast<int>(config->compressionLevel), compressedCache));
+            }
+            if (metrics) {
+                handler->addRequestInterceptor(std::make_shared<MetricsInterceptor::Request>());
+                handler->addResponseInterceptor(std::make_shared<MetricsInterceptor::Response>(metrics));
+            }
+            handler->addRequestInterceptor(exceptionHandler);
+        };
+        if (config->serverMode == AppConfig::ServerMode::Async) {
+            auto executor = std::make_shared<oatpp::async::Executor>(
+                static_cast<v_int32>(config->asyncThreads), 1, 1);
+            auto handler = oatpp::web::server::AsyncHttpConnectionHandler::createShared(httpRouter, executor);
+            setUp(handler);
+            return std::static_pointer_cast<oatpp::network::ConnectionHandler>(handler);
+        }
         auto handler = oatpp::web::server::HttpConnectionHandler::createShared(httpRouter);
-        handler->addRequestInterceptor(exceptionHandler);
-        return handler;
+        setUp(handler);
+        return std::static_pointer_cast<oatpp::network::ConnectionHandler>(handler);
     }());
 
-    // Server Connection Provider - TCP server
+    // Acceptors - a listening socket and accept loop per CONTACTS_ACCEPTORS on the configured address,
+    // all feeding the connection handler; more than one share the port through SO_REUSEPORT
     OATPP_CREATE_COMPONENT(
-        std::shared_ptr<oatpp::network::ServerConnectionProvider>,
-        serverConnectionProvider
+        std::shared_ptr<AcceptorGroup>,
+        acceptorGroup
     )([] {
-        return oatpp::network::tcp::server::ConnectionProvider::createShared(
-            {"0.0.0.0", 8000}, 
-            oatpp::network::Address::IP_4);
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        OATPP_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>, connectionHandler);
+        ReusePortConnectionProvider::Options options;
+        options.host = config->host;
+        options.port = static_cast<uint16_t>(config->port);
+        options.backlog = static_cast<int>(config->backlog);
+        options.reusePort = config->acceptors > 1;
+        std::vector<std::shared_ptr<oatpp::network::ServerConnectionProvider>> providers;
+        for (size_t i = 0; i < config->acceptors; ++i) {
+            providers.push_back(ReusePortConnectionProvider::createShared(options));
+        }
+        return std::make_shared<AcceptorGroup>(std::move(providers), connectionHandler);
     }());
 };
\ No newline at end of file
@@ -0,0 +1,112 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <oatpp/core/Types.hpp>
+
+// Compressed bodies of GET responses, keyed by content coding, request target and the response's ETag
+// Collection responses are tagged with the directory version, so an entry is only found again while the
+// repository is unchanged; after a write the new tag misses and the stale entry ages out of the LRU.
+// Bounded by the total size of the bodies; one body may take at most half of the capacity.
+class CompressedResponseCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    // capacity - maximum total size of the cached bodies, in bytes
+    explicit CompressedResponseCache(size_t capacity)
+        : capacity_(capacity) {}
+
+    CompressedResponseCache(const CompressedResponseCache&) = delete;
+    CompressedResponseCache& operator=(const CompressedResponseCache&) = delete;
+
+    static std::string keyOf(const char* coding, const std::string& target, const std::string& entityTag) {
+        std::string key(coding);
+        key += ' ';
+        key += entityTag;
+        key += ' ';
+        key += target;
+        return key;
+    }
+
+    // nullptr on a miss; the body is shared, not copied
+    oatpp::String find(const std::string& key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = index_.find(key);
+            if (it != index_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second->body;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // Whether a body of this size would be kept, so callers can stop collecting one that won't
+    bool fits(size_t size) const {
+        return size <= capacity_ / 2;
+    }
+
+    void put(const std::string& key, const oatpp::String& body) {
+        if (!fits(body->size())) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            eraseLocked(it->second);
+        }
+        lru_.push_front(Entry{key, body});
+        index_.emplace(key, lru_.begin());
+        bytes_ += body->size();
+        while (bytes_ > capacity_) {
+            eraseLocked(std::prev(lru_.end()));
+        }
+    }
+
+    Stats stats() {
+        Stats stats;
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.entries = lru_.size();
+        stats.bytes = bytes_;
+        return stats;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        oatpp::String body;
+    };
+
+    size_t capacity_;
+    std::mutex mutex_;
+    // Most recently used first
+    std::list<Entry> lru_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t bytes_ = 0;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    void eraseLocked(std::list<Entry>::iterator entry) {
+        bytes_ -= entry->body->size();
+        index_.erase(entry->key);
+        lru_.erase(entry);
+    }
+};
@@ -0,0 +1,136 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <oatpp/core/Types.hpp>
+
+// Serialized JSON bodies of single contacts, keyed by id and contact version (see ContactRepository::versionOf)
+// An entry is only returned for the exact version it was encoded from, so a stale entry can never be served;
+// entries of changed or removed contacts are also dropped eagerly through invalidate().
+// Split into independently locked stripes, each evicting its least recently used entries past capacity.
+class ContactJsonCache {
+public:
+    static constexpr size_t kStripeCount = 16;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytes = 0;
+    };
+
+    // capacity - maximum number of cached contacts
+    explicit ContactJsonCache(size_t capacity)
+        : stripeCapacity_(std::max<size_t>(1, (capacity + kStripeCount - 1) / kStripeCount))
+        , stripes_(kStripeCount) {}
+
+    ContactJsonCache(const ContactJsonCache&) = delete;
+    ContactJsonCache& operator=(const ContactJsonCache&) = delete;
+
+    // nullptr on a miss; the body is shared, not copied
+    oatpp::String find(int64_t id, uint64_t version) {
+        auto& stripe = stripeFor(id);
+        {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            auto it = stripe.index.find(id);
+            if (it != stripe.index.end() && it->second->version == version) {
+                stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second->json;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // An entry encoded from an older version than the cached one is ignored
+    void put(int64_t id, uint64_t version, const oatpp::String& json) {
+        auto& stripe = stripeFor(id);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.index.find(id);
+        if (it != stripe.index.end()) {
+            auto& entry = *it->second;
+            if (entry.version > version) {
+                return;
+            }
+            stripe.bytes = stripe.bytes - entry.json->size() + json->size();
+            entry.version = version;
+            entry.json = json;
+            stripe.lru.splice(stripe.lru.begin(), stripe.lru, it->second);
+            return;
+        }
+
+        stripe.lru.push_front(Entry{id, version, json});
+        stripe.index.emplace(id, stripe.lru.begin());
+        stripe.bytes += json->size();
+        while (stripe.lru.size() > stripeCapacity_) {
+            eraseLocked(stripe, std::prev(stripe.lru.end()));
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void invalidate(int64_t id) {
+        auto& stripe = stripeFor(id);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.index.find(id);
+        if (it != stripe.index.end()) {
+            eraseLocked(stripe, it->second);
+        }
+    }
+
+    Stats stats() {
+        Stats stats;
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        stats.evictions = evictions_.load(std::memory_order_relaxed);
+        for (auto& stripe : stripes_) {
+            std::lock_guard<std::mutex> lock(stripe.mutex);
+            stats.entries += stripe.lru.size();
+            stats.bytes += stripe.bytes;
+        }
+        return stats;
+    }
+
+private:
+    struct Entry {
+        int64_t id;
+        uint64_t version;
+        oatpp::String json;
+    };
+
+    struct Stripe {
+        std::mutex mutex;
+        // Most recently used first
+        std::list<Entry> lru;
+        std::unordered_map<int64_t, std::list<Entry>::iterator> index;
+        size_t bytes = 0;
+    };
+
+    size_t stripeCapacity_;
+    std::vector<Stripe> stripes_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+
+    Stripe& stripeFor(int64_t id) {
+        return stripes_[static_cast<uint64_t>(id) % kStripeCount];
+    }
+
+    static void eraseLocked(Stripe& stripe, std::list<Entry>::iterator entry) {
+        stripe.bytes -= entry->json->size();
+        stripe.index.erase(entry->id);
+        stripe.lru.erase(entry);
+    }
+};
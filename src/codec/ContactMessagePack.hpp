@@ -0,0 +1,283 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "codec/MessagePack.hpp"
+#include "dto/BatchDto.hpp"
+#include "dto/ChangeDto.hpp"
+#include "dto/ContactDto.hpp"
+#include "dto/ErrorDto.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <oatpp/core/Types.hpp>
+
+// MessagePack encoding of the API's DTOs, the binary alternative to the JSON ObjectMapper
+// Objects are maps keyed by the same field names as in JSON, missing values are nil.
+// Decoding is as strict as the JSON mapper: unknown fields and wrong value types are rejected.
+class ContactMessagePack {
+public:
+    static constexpr const char* kContentType = "application/msgpack";
+
+    // Content-Type of a request body; "application/x-msgpack" is accepted as well, parameters are ignored
+    static bool isMediaType(const oatpp::String& contentType) {
+        return contentType && isMessagePackType(mediaTypeOf(*contentType));
+    }
+
+    // Whether an Accept header asks for MessagePack rather than JSON: it needs a higher quality,
+    // or the same quality and an earlier position than application/json. Wildcards select JSON,
+    // which also stays the answer to a missing header.
+    static bool isAccepted(const oatpp::String& accept) {
+        if (!accept) {
+            return false;
+        }
+        double messagePackQuality = 0;
+        double jsonQuality = 0;
+        bool explicitJsonFirst = false;
+        bool messagePackSeen = false;
+        std::string_view header(*accept);
+        while (!header.empty()) {
+            auto comma = header.find(',');
+            auto range = header.substr(0, comma);
+            header = comma == std::string_view::npos ? std::string_view() : header.substr(comma + 1);
+
+            auto type = mediaTypeOf(range);
+            auto quality = qualityOf(range);
+            if (isMessagePackType(type)) {
+                messagePackQuality = std::max(messagePackQuality, quality);
+                messagePackSeen = true;
+            } else if (type == "application/json" || type == "*/*" || type == "application/*") {
+                if (type == "application/json" && !messagePackSeen && quality > 0) {
+                    explicitJsonFirst = true;
+                }
+                jsonQuality = std::max(jsonQuality, quality);
+            }
+        }
+        if (messagePackQuality <= 0) {
+            return false;
+        }
+        return messagePackQuality > jsonQuality || (messagePackQuality == jsonQuality && !explicitJsonFirst);
+    }
+
+    template<typename T>
+    static oatpp::String encode(const T& value) {
+        std::string out;
+        MessagePackWriter writer(out);
+        write(writer, value);
+        return oatpp::String(std::move(out));
+    }
+
+    static void write(MessagePackWriter& writer, const oatpp::Object<ContactDto>& contact) {
+        if (!contact) {
+            writer.writeNil();
+            return;
+        }
+        writer.writeMapHeader(4);
+        writeField(writer, "id", contact->id);
+        writeField(writer, "name", contact->name);
+        writeField(writer, "phone", contact->phone);
+        writeField(writer, "address", contact->address);
+    }
+
+    static void write(MessagePackWriter& writer, const oatpp::Object<ErrorDto>& error) {
+        writer.writeMapHeader(3);
+        writeField(writer, "status", error->status);
+        writeField(writer, "message", error->message);
+        writeField(writer, "details", error->details);
+    }
+
+    static void write(MessagePackWriter& writer, const oatpp::Object<BatchItemDto>& item) {
+        writer.writeMapHeader(5);
+        writeField(writer, "index", item->index);
+        writeField(writer, "status", item->status);
+        writeField(writer, "id", item->id);
+        writer.writeString("contact");
+        write(writer, item->contact);
+        writeField(writer, "error", item->error);
+    }
+
+    static void write(MessagePackWriter& writer, const oatpp::Object<BatchResultDto>& result) {
+        writer.writeMapHeader(3);
+        writeField(writer, "succeeded", result->succeeded);
+        writeField(writer, "failed", result->failed);
+        writer.writeString("items");
+        write(writer, result->items);
+    }
+
+    static void write(MessagePackWriter& writer, const oatpp::Object<ContactDeltaDto>& delta) {
+        writer.writeMapHeader(4);
+        writer.writeString("contacts");
+        write(writer, delta->contacts);
+        writer.writeString("removed");
+        write(writer, delta->removed);
+        writeField(writer, "next", delta->next);
+        writer.writeString("more");
+        if (delta->more) {
+            writer.writeBool(*delta->more);
+        } else {
+            writer.writeNil();
+        }
+    }
+
+    static void write(MessagePackWriter& writer, const oatpp::Int64& value) {
+        if (value) {
+            writer.writeInt(*value);
+        } else {
+            writer.writeNil();
+        }
+    }
+
+    template<typename T>
+    static void write(MessagePackWriter& writer, const oatpp::List<T>& list) {
+        if (!list) {
+            writer.writeNil();
+            return;
+        }
+        writer.writeArrayHeader(list->size());
+        for (const auto& item : *list) {
+            write(writer, item);
+        }
+    }
+
+    static oatpp::Object<ContactDto> readContact(MessagePackReader& reader) {
+        if (reader.readNil()) {
+            return nullptr;
+        }
+        auto contact = ContactDto::createShared();
+        auto fields = reader.readMapHeader();
+        for (size_t i = 0; i < fields; ++i) {
+            auto key = reader.readString();
+            if (key == "id") {
+                contact->id = readInt64(reader);
+            } else if (key == "name") {
+                contact->name = readString(reader);
+            } else if (key == "phone") {
+                contact->phone = readString(reader);
+            } else if (key == "address") {
+                contact->address = readString(reader);
+            } else {
+                MessagePackReader::fail("unknown field '" + std::string(key) + "'");
+            }
+        }
+        return contact;
+    }
+
+    // A whole request body holding one contact
+    static oatpp::Object<ContactDto> decodeContact(const oatpp::String& body) {
+        return decodeWhole(body, [](MessagePackReader& reader) {
+            return readContact(reader);
+        });
+    }
+
+    static oatpp::List<oatpp::Object<ContactDto>> decodeContactList(const oatpp::String& body) {
+        return decodeWhole(body, [](MessagePackReader& reader) {
+            auto list = oatpp::List<oatpp::Object<ContactDto>>::createShared();
+            auto size = reader.readArrayHeader();
+            for (size_t i = 0; i < size; ++i) {
+                list->push_back(readContact(reader));
+            }
+            return list;
+        });
+    }
+
+    static oatpp::List<oatpp::Int64> decodeIdList(const oatpp::String& body) {
+        return decodeWhole(body, [](MessagePackReader& reader) {
+            auto list = oatpp::List<oatpp::Int64>::createShared();
+            auto size = reader.readArrayHeader();
+            for (size_t i = 0; i < size; ++i) {
+                list->push_back(readInt64(reader));
+            }
+            return list;
+        });
+    }
+
+private:
+    static bool isMessagePackType(const std::string& type) {
+        return type == "application/msgpack" || type == "application/x-msgpack";
+    }
+
+    // Lower-cased type of a media range, without parameters and surrounding whitespace
+    static std::string mediaTypeOf(std::string_view range) {
+        range = trim(range.substr(0, range.find(';')));
+        std::string type(range);
+        for (auto& c : type) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return type;
+    }
+
+    // The q parameter of a media range, 1 when absent
+    static double qualityOf(std::string_view range) {
+        auto position = range.find(';');
+        while (position != std::string_view::npos) {
+            range.remove_prefix(position + 1);
+            position = range.find(';');
+            auto parameter = trim(range.substr(0, position));
+            if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+                return std::strtod(std::string(parameter.substr(2)).c_str(), nullptr);
+            }
+        }
+        return 1;
+    }
+
+    static std::string_view trim(std::string_view value) {
+        auto first = value.find_first_not_of(" \t");
+        if (first == std::string_view::npos) {
+            return {};
+        }
+        auto last = value.find_last_not_of(" \t");
+        return value.substr(first, last - first + 1);
+    }
+
+    static void writeField(MessagePackWriter& writer, const char* name, const oatpp::String& value) {
+        writer.writeString(name);
+        if (value) {
+            writer.writeString(*value);
+        } else {
+            writer.writeNil();
+        }
+    }
+
+    template<typename T>
+    static void writeField(MessagePackWriter& writer, const char* name, const T& value) {
+        writer.writeString(name);
+        if (value) {
+            writer.writeInt(static_cast<int64_t>(*value));
+        } else {
+            writer.writeNil();
+        }
+    }
+
+    static oatpp::Int64 readInt64(MessagePackReader& reader) {
+        if (reader.readNil()) {
+            return nullptr;
+        }
+        return reader.readInt();
+    }
+
+    static oatpp::String readString(MessagePackReader& reader) {
+        if (reader.readNil()) {
+            return nullptr;
+        }
+        auto value = reader.readString();
+        return oatpp::String(value.data(), static_cast<v_buff_size>(value.size()));
+    }
+
+    template<typename Decoder>
+    static std::invoke_result_t<Decoder, MessagePackReader&> decodeWhole(const oatpp::String& body, Decoder decoder) {
+        if (!body || body->empty()) {
+            MessagePackReader::fail("empty body");
+        }
+        MessagePackReader reader(body->data(), body->size());
+        auto value = decoder(reader);
+        if (!reader.atEnd()) {
+            MessagePackReader::fail("trailing data after the value");
+        }
+        return value;
+    }
+};
@@ -0,0 +1,245 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <zlib.h>
+#ifdef CONTACTS_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+// HTTP content codings of response bodies (Content-Encoding)
+// gzip and deflate come from zlib; zstd is available when the build found libzstd (CONTACTS_WITH_ZSTD).
+enum class ContentCoding {
+    Identity,
+    Gzip,
+    Deflate,
+    Zstd
+};
+
+class HttpCompression {
+public:
+    static constexpr int kMinLevel = 1;
+    static constexpr int kMaxLevel = 9;
+
+    static const char* nameOf(ContentCoding coding) {
+        switch (coding) {
+            case ContentCoding::Gzip:
+                return "gzip";
+            case ContentCoding::Deflate:
+                return "deflate";
+            case ContentCoding::Zstd:
+                return "zstd";
+            case ContentCoding::Identity:
+                break;
+        }
+        return "identity";
+    }
+
+    static bool isSupported(ContentCoding coding) {
+#ifdef CONTACTS_WITH_ZSTD
+        return true;
+#else
+        return coding != ContentCoding::Zstd;
+#endif
+    }
+
+    // The coding the client accepts with the highest quality; among equal ones zstd, then gzip, then deflate
+    // Identity when Accept-Encoding is absent or accepts none of the supported codings
+    static ContentCoding negotiate(std::string_view acceptEncoding) {
+        constexpr ContentCoding preference[] = {ContentCoding::Zstd, ContentCoding::Gzip, ContentCoding::Deflate};
+        auto best = ContentCoding::Identity;
+        double bestQuality = 0;
+        for (auto coding : preference) {
+            if (!isSupported(coding)) {
+                continue;
+            }
+            auto quality = qualityOf(acceptEncoding, nameOf(coding));
+            if (quality > bestQuality) {
+                best = coding;
+                bestQuality = quality;
+            }
+        }
+        return best;
+    }
+
+    // ETag of the representation compressed with coding: its name goes inside the quotes ("1-2" -> "1-2-gzip",
+    // W/"1-2" -> W/"1-2-gzip"), since a strong tag identifies the exact bytes and these differ per coding
+    static std::string entityTagOf(std::string_view tag, ContentCoding coding) {
+        if (coding == ContentCoding::Identity || tag.size() < 2 || tag.back() != '"') {
+            return std::string(tag);
+        }
+        std::string result(tag.substr(0, tag.size() - 1));
+        result += '-';
+        result += nameOf(coding);
+        result += '"';
+        return result;
+    }
+
+    // The tag a coding-specific one was made from by entityTagOf; any other tag is returned as it is
+    static std::string identityTagOf(std::string_view tag) {
+        for (auto coding : {ContentCoding::Gzip, ContentCoding::Deflate, ContentCoding::Zstd}) {
+            std::string suffix = std::string("-") + nameOf(coding) + '"';
+            if (tag.size() > suffix.size() + 1 && tag.substr(tag.size() - suffix.size()) == suffix) {
+                return std::string(tag.substr(0, tag.size() - suffix.size())) + '"';
+            }
+        }
+        return std::string(tag);
+    }
+
+    static std::string compress(std::string_view data, ContentCoding coding, int level) {
+        std::string out;
+        Encoder encoder(coding, level);
+        encoder.write(data, out);
+        encoder.finish(out);
+        return out;
+    }
+
+    // Incremental compression of one body: write() as the data arrives, finish() once at the end
+    // Output is appended to the caller's string; write() may produce nothing until enough input was buffered.
+    class Encoder {
+    public:
+        Encoder(ContentCoding coding, int level)
+            : coding_(coding) {
+            level = std::clamp(level, kMinLevel, kMaxLevel);
+            if (coding == ContentCoding::Zstd) {
+#ifdef CONTACTS_WITH_ZSTD
+                zstd_ = ZSTD_createCCtx();
+                if (!zstd_) {
+                    throw std::runtime_error("Failed to create a zstd context");
+                }
+                // zstd levels go further (up to 19), 1-9 cover the same speed range as zlib's
+                ZSTD_CCtx_setParameter(zstd_, ZSTD_c_compressionLevel, level);
+                return;
+#else
+                throw std::invalid_argument("zstd is not supported by this build");
+#endif
+            }
+            if (coding == ContentCoding::Identity) {
+                throw std::invalid_argument("Identity coding has no encoder");
+            }
+            // Window bits 15 + 16 writes the gzip wrapper, plain 15 the zlib one that HTTP calls deflate
+            auto windowBits = coding == ContentCoding::Gzip ? 15 + 16 : 15;
+            if (deflateInit2(&zlib_, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("Failed to initialize zlib");
+            }
+        }
+
+        ~Encoder() {
+#ifdef CONTACTS_WITH_ZSTD
+            if (coding_ == ContentCoding::Zstd) {
+                ZSTD_freeCCtx(zstd_);
+                return;
+            }
+#endif
+            deflateEnd(&zlib_);
+        }
+
+        Encoder(const Encoder&) = delete;
+        Encoder& operator=(const Encoder&) = delete;
+
+        void write(std::string_view data, std::string& out) {
+            run(data, out, false);
+        }
+
+        void finish(std::string& out) {
+            run({}, out, true);
+        }
+
+    private:
+        static constexpr size_t kOutputChunk = 16 * 1024;
+
+        ContentCoding coding_;
+        z_stream zlib_{};
+#ifdef CONTACTS_WITH_ZSTD
+        ZSTD_CCtx* zstd_ = nullptr;
+#endif
+
+        void run(std::string_view data, std::string& out, bool last) {
+#ifdef CONTACTS_WITH_ZSTD
+            if (coding_ == ContentCoding::Zstd) {
+                ZSTD_inBuffer input{data.data(), data.size(), 0};
+                size_t remaining = 0;
+                do {
+                    auto size = out.size();
+                    out.resize(size + kOutputChunk);
+                    ZSTD_outBuffer output{out.data() + size, kOutputChunk, 0};
+                    remaining = ZSTD_compressStream2(zstd_, &output, &input, last ? ZSTD_e_end : ZSTD_e_continue);
+                    if (ZSTD_isError(remaining)) {
+                        throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(remaining));
+                    }
+                    out.resize(size + output.pos);
+                } while (last ? remaining != 0 : input.pos < input.size);
+                return;
+            }
+#endif
+            zlib_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+            zlib_.avail_in = static_cast<uInt>(data.size());
+            int status = Z_OK;
+            do {
+                auto size = out.size();
+                out.resize(size + kOutputChunk);
+                zlib_.next_out = reinterpret_cast<Bytef*>(out.data() + size);
+                zlib_.avail_out = static_cast<uInt>(kOutputChunk);
+                status = deflate(&zlib_, last ? Z_FINISH : Z_NO_FLUSH);
+                if (status == Z_STREAM_ERROR) {
+                    throw std::runtime_error("zlib compression failed");
+                }
+                out.resize(size + kOutputChunk - zlib_.avail_out);
+            } while (last ? status != Z_STREAM_END : zlib_.avail_out == 0 || zlib_.avail_in > 0);
+        }
+    };
+
+private:
+    // q of the coding in Accept-Encoding: its own entry, else "*", else 0
+    static double qualityOf(std::string_view header, std::string_view coding) {
+        double wildcard = 0;
+        bool named = false;
+        double quality = 0;
+        size_t start = 0;
+        while (start <= header.size()) {
+            auto end = std::min(header.find(',', start), header.size());
+            auto entry = header.substr(start, end - start);
+            auto semicolon = entry.find(';');
+            auto token = trim(entry.substr(0, semicolon));
+            double q = 1;
+            if (semicolon != std::string_view::npos) {
+                auto parameter = trim(entry.substr(semicolon + 1));
+                if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+                    q = std::strtod(std::string(parameter.substr(2)).c_str(), nullptr);
+                }
+            }
+            if (equalsIgnoreCase(token, coding)) {
+                named = true;
+                quality = q;
+            } else if (token == "*") {
+                wildcard = q;
+            }
+            start = end + 1;
+        }
+        return named ? quality : wildcard;
+    }
+
+    static std::string_view trim(std::string_view value) {
+        auto first = value.find_first_not_of(" \t");
+        if (first == std::string_view::npos) {
+            return {};
+        }
+        auto last = value.find_last_not_of(" \t");
+        return value.substr(first, last - first + 1);
+    }
+
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+            return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+        });
+    }
+};
@@ -0,0 +1,236 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Minimal MessagePack (https://msgpack.org/) encoder and decoder for the value kinds the API uses:
+// nil, booleans, integers, UTF-8 strings, arrays and maps. Integers are written in the shortest form.
+
+class MessagePackWriter {
+public:
+    explicit MessagePackWriter(std::string& out)
+        : out_(out) {}
+
+    void writeNil() {
+        out_ += static_cast<char>(0xc0);
+    }
+
+    void writeBool(bool value) {
+        out_ += static_cast<char>(value ? 0xc3 : 0xc2);
+    }
+
+    void writeInt(int64_t value) {
+        if (value >= 0) {
+            auto unsignedValue = static_cast<uint64_t>(value);
+            if (unsignedValue < 0x80) {
+                out_ += static_cast<char>(unsignedValue);
+            } else if (unsignedValue <= 0xff) {
+                out_ += static_cast<char>(0xcc);
+                writeBigEndian(unsignedValue, 1);
+            } else if (unsignedValue <= 0xffff) {
+                out_ += static_cast<char>(0xcd);
+                writeBigEndian(unsignedValue, 2);
+            } else if (unsignedValue <= 0xffffffffull) {
+                out_ += static_cast<char>(0xce);
+                writeBigEndian(unsignedValue, 4);
+            } else {
+                out_ += static_cast<char>(0xcf);
+                writeBigEndian(unsignedValue, 8);
+            }
+            return;
+        }
+        if (value >= -32) {
+            out_ += static_cast<char>(value);
+        } else if (value >= INT8_MIN) {
+            out_ += static_cast<char>(0xd0);
+            writeBigEndian(static_cast<uint64_t>(value), 1);
+        } else if (value >= INT16_MIN) {
+            out_ += static_cast<char>(0xd1);
+            writeBigEndian(static_cast<uint64_t>(value), 2);
+        } else if (value >= INT32_MIN) {
+            out_ += static_cast<char>(0xd2);
+            writeBigEndian(static_cast<uint64_t>(value), 4);
+        } else {
+            out_ += static_cast<char>(0xd3);
+            writeBigEndian(static_cast<uint64_t>(value), 8);
+        }
+    }
+
+    void writeString(std::string_view value) {
+        auto size = value.size();
+        if (size < 32) {
+            out_ += static_cast<char>(0xa0 | size);
+        } else if (size <= 0xff) {
+            out_ += static_cast<char>(0xd9);
+            writeBigEndian(size, 1);
+        } else if (size <= 0xffff) {
+            out_ += static_cast<char>(0xda);
+            writeBigEndian(size, 2);
+        } else {
+            out_ += static_cast<char>(0xdb);
+            writeBigEndian(size, 4);
+        }
+        out_.append(value.data(), size);
+    }
+
+    void writeArrayHeader(size_t size) {
+        writeContainerHeader(size, 0x90, 0xdc, 0xdd);
+    }
+
+    void writeMapHeader(size_t size) {
+        writeContainerHeader(size, 0x80, 0xde, 0xdf);
+    }
+
+private:
+    std::string& out_;
+
+    void writeBigEndian(uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; --i) {
+            out_ += static_cast<char>((value >> (i * 8)) & 0xff);
+        }
+    }
+
+    void writeContainerHeader(size_t size, uint8_t fix, uint8_t code16, uint8_t code32) {
+        if (size < 16) {
+            out_ += static_cast<char>(fix | size);
+        } else if (size <= 0xffff) {
+            out_ += static_cast<char>(code16);
+            writeBigEndian(size, 2);
+        } else {
+            out_ += static_cast<char>(code32);
+            writeBigEndian(size, 4);
+        }
+    }
+};
+
+// Reads values in document order; every malformed or unexpected input throws "Invalid MessagePack: ..."
+class MessagePackReader {
+public:
+    MessagePackReader(const char* data, size_t size)
+        : data_(reinterpret_cast<const uint8_t*>(data))
+        , size_(size) {}
+
+    bool atEnd() const {
+        return position_ == size_;
+    }
+
+    // Consumes a nil if it is next
+    bool readNil() {
+        if (peek() == 0xc0) {
+            ++position_;
+            return true;
+        }
+        return false;
+    }
+
+    int64_t readInt() {
+        auto code = take();
+        if (code < 0x80) {
+            return code;
+        }
+        if (code >= 0xe0) {
+            return static_cast<int8_t>(code);
+        }
+        switch (code) {
+            case 0xcc: return static_cast<int64_t>(readBigEndian(1));
+            case 0xcd: return static_cast<int64_t>(readBigEndian(2));
+            case 0xce: return static_cast<int64_t>(readBigEndian(4));
+            case 0xcf: {
+                auto value = readBigEndian(8);
+                if (value > static_cast<uint64_t>(INT64_MAX)) {
+                    fail("integer out of range");
+                }
+                return static_cast<int64_t>(value);
+            }
+            case 0xd0: return static_cast<int8_t>(readBigEndian(1));
+            case 0xd1: return static_cast<int16_t>(readBigEndian(2));
+            case 0xd2: return static_cast<int32_t>(readBigEndian(4));
+            case 0xd3: return static_cast<int64_t>(readBigEndian(8));
+            default: fail("expected an integer");
+        }
+        return 0;
+    }
+
+    std::string_view readString() {
+        auto code = take();
+        size_t size;
+        if ((code & 0xe0) == 0xa0) {
+            size = code & 0x1f;
+        } else if (code == 0xd9) {
+            size = readBigEndian(1);
+        } else if (code == 0xda) {
+            size = readBigEndian(2);
+        } else if (code == 0xdb) {
+            size = readBigEndian(4);
+        } else {
+            fail("expected a string");
+        }
+        require(size);
+        std::string_view value(reinterpret_cast<const char*>(data_ + position_), size);
+        position_ += size;
+        return value;
+    }
+
+    size_t readArrayHeader() {
+        return readContainerHeader(0x90, 0xdc, 0xdd, "expected an array");
+    }
+
+    size_t readMapHeader() {
+        return readContainerHeader(0x80, 0xde, 0xdf, "expected a map");
+    }
+
+    [[noreturn]] static void fail(const std::string& reason) {
+        throw std::runtime_error("Invalid MessagePack: " + reason);
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t position_ = 0;
+
+    void require(size_t bytes) const {
+        if (size_ - position_ < bytes) {
+            fail("unexpected end of data");
+        }
+    }
+
+    uint8_t peek() const {
+        require(1);
+        return data_[position_];
+    }
+
+    uint8_t take() {
+        require(1);
+        return data_[position_++];
+    }
+
+    uint64_t readBigEndian(size_t bytes) {
+        require(bytes);
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value = (value << 8) | data_[position_++];
+        }
+        return value;
+    }
+
+    size_t readContainerHeader(uint8_t fix, uint8_t code16, uint8_t code32, const char* expected) {
+        auto code = take();
+        if ((code & 0xf0) == fix) {
+            return code & 0x0f;
+        }
+        if (code == code16) {
+            return readBigEndian(2);
+        }
+        if (code == code32) {
+            return readBigEndian(4);
+        }
+        fail(expected);
+    }
+};
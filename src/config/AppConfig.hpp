@@ -0,0 +1,164 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "storage/WriteAheadLog.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Application settings, read from environment variables at startup
+//
+// CONTACTS_DATA_DIR            directory for the journal and snapshot; unset or empty keeps data in memory only
+// CONTACTS_DURABILITY          none | batched | per-write (default batched)
+// CONTACTS_UNIQUE_PHONES       1 to reject a phone number that another contact already has (default 0)
+// CONTACTS_SHARDS              repository shard count (default 16)
+// CONTACTS_SNAPSHOT_INTERVAL   seconds between snapshot files, 0 to only write them by journal size (default 300)
+// CONTACTS_SNAPSHOT_JOURNAL_MB journal size that triggers a snapshot file early, 0 to disable (default 64)
+// CONTACTS_HOST                address or host name the server listens on (default 0.0.0.0)
+// CONTACTS_PORT                TCP port the server listens on (default 8000)
+// CONTACTS_BACKLOG             pending connections queued before they are accepted (default 4096)
+// CONTACTS_ACCEPTORS           listening sockets sharing the port via SO_REUSEPORT, each accepted on its own thread (default 1)
+// CONTACTS_SERVER_MODE         threaded (a thread per connection) | async (coroutines on an executor), default threaded
+// CONTACTS_ASYNC_THREADS       executor threads processing coroutines in async mode (default: number of CPUs)
+// CONTACTS_BLOCKING_THREADS    threads running the calls that block (writes, listing, import) in async mode (default 64)
+// CONTACTS_JSON_CACHE_ENTRIES  contacts kept as serialized JSON for GET /contacts/{id}, 0 to disable (default 100000)
+// CONTACTS_METRICS             1 to time requests and shard locks and serve GET /metrics, 0 to disable (default 1)
+// CONTACTS_CHANGE_LOG_ENTRIES  recent changes kept for GET /contacts/changes/stream, 0 to disable it (default 65536)
+// CONTACTS_TOMBSTONES          removals kept for delta sync (GET /contacts?since=); older sync tokens expire (default 1000000)
+// CONTACTS_COMPRESSION         1 to gzip / deflate / zstd responses for clients that accept it, 0 to disable (default 1)
+// CONTACTS_COMPRESSION_LEVEL   compression level, 1 (fastest) to 9 (smallest) (default 5)
+// CONTACTS_COMPRESSION_MIN_BYTES  smallest response body worth compressing (default 1024)
+// CONTACTS_COMPRESSION_CACHE_MB   compressed bodies of unchanged listings kept for reuse, 0 to disable (default 64)
+struct AppConfig {
+    enum class ServerMode {
+        Threaded,
+        Async
+    };
+
+    std::string dataDir;
+    Durability durability = Durability::Batched;
+    bool uniquePhones = false;
+    size_t shardCount = 16;
+    size_t snapshotIntervalSeconds = 300;
+    size_t snapshotJournalMegabytes = 64;
+    std::string host = "0.0.0.0";
+    size_t port = 8000;
+    size_t backlog = 4096;
+    size_t acceptors = 1;
+    ServerMode serverMode = ServerMode::Threaded;
+    size_t asyncThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t blockingThreads = 64;
+    size_t jsonCacheEntries = 100000;
+    bool metricsEnabled = true;
+    size_t changeLogEntries = 65536;
+    size_t tombstones = 1000000;
+    bool compressionEnabled = true;
+    size_t compressionLevel = 5;
+    size_t compressionMinBytes = 1024;
+    size_t compressionCacheMegabytes = 64;
+
+    bool persistent() const {
+        return !dataDir.empty();
+    }
+
+    std::string journalPath() const {
+        return dataDir + "/contacts.wal";
+    }
+
+    std::string snapshotPath() const {
+        return dataDir + "/contacts.snap";
+    }
+
+    static AppConfig fromEnvironment() {
+        AppConfig config;
+        config.dataDir = readVariable("CONTACTS_DATA_DIR");
+
+        auto durability = readVariable("CONTACTS_DURABILITY");
+        if (!durability.empty()) {
+            auto parsed = parseDurability(durability);
+            if (!parsed) {
+                throw std::runtime_error("Invalid CONTACTS_DURABILITY: expected none, batched or per-write");
+            }
+            config.durability = *parsed;
+        }
+
+        auto uniquePhones = readVariable("CONTACTS_UNIQUE_PHONES");
+        if (!uniquePhones.empty()) {
+            if (uniquePhones != "0" && uniquePhones != "1") {
+                throw std::runtime_error("Invalid CONTACTS_UNIQUE_PHONES: expected 0 or 1");
+            }
+            config.uniquePhones = uniquePhones == "1";
+        }
+
+        readNumber("CONTACTS_SHARDS", 1, 4096, config.shardCount);
+        readNumber("CONTACTS_SNAPSHOT_INTERVAL", 0, 86400, config.snapshotIntervalSeconds);
+        readNumber("CONTACTS_SNAPSHOT_JOURNAL_MB", 0, 1 << 20, config.snapshotJournalMegabytes);
+
+        auto host = readVariable("CONTACTS_HOST");
+        if (!host.empty()) {
+            config.host = host;
+        }
+        readNumber("CONTACTS_PORT", 1, 65535, config.port);
+        readNumber("CONTACTS_BACKLOG", 1, 65535, config.backlog);
+        readNumber("CONTACTS_ACCEPTORS", 1, 256, config.acceptors);
+
+        auto serverMode = readVariable("CONTACTS_SERVER_MODE");
+        if (!serverMode.empty()) {
+            if (serverMode != "threaded" && serverMode != "async") {
+                throw std::runtime_error("Invalid CONTACTS_SERVER_MODE: expected threaded or async");
+            }
+            config.serverMode = serverMode == "async" ? ServerMode::Async : ServerMode::Threaded;
+        }
+        readNumber("CONTACTS_ASYNC_THREADS", 1, 1024, config.asyncThreads);
+        readNumber("CONTACTS_BLOCKING_THREADS", 1, 4096, config.blockingThreads);
+        readNumber("CONTACTS_JSON_CACHE_ENTRIES", 0, 100000000, config.jsonCacheEntries);
+
+        auto metrics = readVariable("CONTACTS_METRICS");
+        if (!metrics.empty()) {
+            if (metrics != "0" && metrics != "1") {
+                throw std::runtime_error("Invalid CONTACTS_METRICS: expected 0 or 1");
+            }
+            config.metricsEnabled = metrics == "1";
+        }
+        readNumber("CONTACTS_CHANGE_LOG_ENTRIES", 0, 100000000, config.changeLogEntries);
+        readNumber("CONTACTS_TOMBSTONES", 0, 1000000000, config.tombstones);
+
+        auto compression = readVariable("CONTACTS_COMPRESSION");
+        if (!compression.empty()) {
+            if (compression != "0" && compression != "1") {
+                throw std::runtime_error("Invalid CONTACTS_COMPRESSION: expected 0 or 1");
+            }
+            config.compressionEnabled = compression == "1";
+        }
+        readNumber("CONTACTS_COMPRESSION_LEVEL", 1, 9, config.compressionLevel);
+        readNumber("CONTACTS_COMPRESSION_MIN_BYTES", 0, 1 << 30, config.compressionMinBytes);
+        readNumber("CONTACTS_COMPRESSION_CACHE_MB", 0, 1 << 20, config.compressionCacheMegabytes);
+        return config;
+    }
+
+private:
+    static std::string readVariable(const char* name) {
+        const char* value = std::getenv(name);
+        return value ? std::string(value) : std::string();
+    }
+
+    // Leaves target unchanged if the variable is not set
+    static void readNumber(const char* name, size_t min, size_t max, size_t& target) {
+        auto text = readVariable(name);
+        if (text.empty()) {
+            return;
+        }
+        char* end = nullptr;
+        auto value = std::strtoull(text.c_str(), &end, 10);
+        if (*end != '\0' || value < min || value > max) {
+            throw std::runtime_error(std::string("Invalid ") + name + ": expected a number between " +
+                                     std::to_string(min) + " and " + std::to_string(max));
+        }
+        target = static_cast<size_t>(value);
+    }
+};
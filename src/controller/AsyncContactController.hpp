@@ -0,0 +1,392 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "cache/ContactJsonCache.hpp"
+#include "controller/ContactApiDocs.hpp"
+#include "controller/ContactHandlers.hpp"
+#include "dto/ContactDto.hpp"
+#include "metrics/MetricsExporter.hpp"
+#include "network/BlockingTaskPool.hpp"
+#include "repository/ChangeLog.hpp"
+#include "service/ContactService.hpp"
+#include <functional>
+#include <memory>
+#include <oatpp/web/server/api/ApiController.hpp>
+
+#include OATPP_CODEGEN_BEGIN(ApiController)
+
+// Coroutine-based controller for the async serving mode (AsyncHttpConnectionHandler)
+// Serves the same API as ContactController through the shared ContactHandlers. Request bodies are
+// read without blocking. Handler calls that can block - every write (journal fsync), listing, search and
+// export (hydration), import batches - run on a BlockingTaskPool while the coroutine waits, so that the
+// executor threads keep serving other connections; point reads, the change feed and metrics run inline.
+// Unexpected exceptions thrown in act() or in a blocking call reach the connection handler's error handler
+// (ApiErrorHandler).
+class AsyncContactController: public oatpp::web::server::api::ApiController {
+public:
+    static constexpr size_t kDefaultBlockingThreads = 64;
+
+    // blockingPool may be nullptr, then the controller starts its own with kDefaultBlockingThreads
+    explicit AsyncContactController(const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+                                    const std::shared_ptr<ContactService>& service,
+                                    const std::shared_ptr<ContactJsonCache>& cache = nullptr,
+                                    const std::shared_ptr<MetricsExporter>& metrics = nullptr,
+                                    const std::shared_ptr<ChangeLog>& changeLog = nullptr,
+                                    const std::shared_ptr<BlockingTaskPool>& blockingPool = nullptr)
+    : ApiController(objectMapper)
+    , handlers_(objectMapper, service, cache, metrics, changeLog)
+    , blockingPool_(blockingPool ? blockingPool : std::make_shared<BlockingTaskPool>(kDefaultBlockingThreads)) {}
+
+    // Runs a handler call on the BlockingTaskPool and returns its response to the calling coroutine
+    class BlockingCall
+        : public oatpp::async::CoroutineWithResult<BlockingCall, const std::shared_ptr<OutgoingResponse>&> {
+    public:
+        BlockingCall(std::shared_ptr<BlockingTaskPool> pool, std::function<std::shared_ptr<OutgoingResponse>()> call)
+            : pool_(std::move(pool))
+            , call_(std::move(call))
+            , response_(std::make_shared<std::shared_ptr<OutgoingResponse>>()) {}
+
+        Action act() override {
+            task_ = pool_->submit([call = std::move(call_), response = response_] {
+                *response = call();
+            });
+            return yieldTo(&BlockingCall::onDone);
+        }
+
+        Action onDone() {
+            if (!task_->done()) {
+                return task_->wait();
+            }
+            task_->rethrow();
+            return _return(*response_);
+        }
+
+    private:
+        std::shared_ptr<BlockingTaskPool> pool_;
+        std::function<std::shared_ptr<OutgoingResponse>()> call_;
+        // Shared with the call, which may outlive the coroutine if the connection goes away
+        std::shared_ptr<std::shared_ptr<OutgoingResponse>> response_;
+        std::shared_ptr<BlockingTaskPool::Task> task_;
+    };
+
+    ENDPOINT_INFO(CreateContact) {
+        ContactApiDocs::createContact(info);
+    }
+    ENDPOINT_ASYNC("POST", "contacts", CreateContact) {
+        ENDPOINT_ASYNC_INIT(CreateContact)
+
+        Action act() override {
+            return request->readBodyToStringAsync().callbackTo(&CreateContact::onBody);
+        }
+
+        Action onBody(const oatpp::String& body) {
+            auto formats = ContactHandlers::formatsOf(request);
+            return controller->blocking([handlers = &controller->handlers_, body, formats] {
+                return handlers->createContact(body, formats);
+            }).callbackTo(&CreateContact::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(SearchContacts) {
+        ContactApiDocs::searchContacts(info);
+    }
+    // Registered before contacts/{id} so that "search" is not taken for an id
+    ENDPOINT_ASYNC("GET", "contacts/search", SearchContacts) {
+        ENDPOINT_ASYNC_INIT(SearchContacts)
+
+        Action act() override {
+            ContactHandlers::SearchQuery query;
+            query.namePrefix = request->getQueryParameter("name_prefix");
+            query.q = request->getQueryParameter("q");
+            query.fuzzy = request->getQueryParameter("fuzzy");
+            query.limit = request->getQueryParameter("limit");
+            auto formats = ContactHandlers::formatsOf(request);
+            return controller->blocking([handlers = &controller->handlers_, query, formats] {
+                return handlers->searchContacts(query, formats);
+            }).callbackTo(&SearchContacts::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(CreateContacts) {
+        ContactApiDocs::createContacts(info);
+    }
+    ENDPOINT_ASYNC("POST", "contacts/batch", CreateContacts) {
+        ENDPOINT_ASYNC_INIT(CreateContacts)
+
+        Action act() override {
+            return request->readBodyToStringAsync().callbackTo(&CreateContacts::onBody);
+        }
+
+        Action onBody(const oatpp::String& body) {
+            auto formats = ContactHandlers::formatsOf(request);
+            return controller->blocking([handlers = &controller->handlers_, body, formats] {
+                return handlers->createContacts(body, formats);
+            }).callbackTo(&CreateContacts::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(UpdateContacts) {
+        ContactApiDocs::updateContacts(info);
+    }
+    // Batch routes are registered before contacts/{id} as well
+    ENDPOINT_ASYNC("PUT", "contacts/batch", UpdateContacts) {
+        ENDPOINT_ASYNC_INIT(UpdateContacts)
+
+        Action act() override {
+            return request->readBodyToStringAsync().callbackTo(&UpdateContacts::onBody);
+        }
+
+        Action onBody(const oatpp::String& body) {
+            auto formats = ContactHandlers::formatsOf(request);
+            return controller->blocking([handlers = &controller->handlers_, body, formats] {
+                return handlers->updateContacts(body, formats);
+            }).callbackTo(&UpdateContacts::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(DeleteContacts) {
+        ContactApiDocs::deleteContacts(info);
+    }
+    ENDPOINT_ASYNC("DELETE", "contacts/batch", DeleteContacts) {
+        ENDPOINT_ASYNC_INIT(DeleteContacts)
+
+        Action act() override {
+            return request->readBodyToStringAsync().callbackTo(&DeleteContacts::onBody);
+        }
+
+        Action onBody(const oatpp::String& body) {
+            auto formats = ContactHandlers::formatsOf(request);
+            return controller->blocking([handlers = &controller->handlers_, body, formats] {
+                return handlers->deleteContacts(body, formats);
+            }).callbackTo(&DeleteContacts::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(ExportContacts) {
+        ContactApiDocs::exportContacts(info);
+    }
+    ENDPOINT_ASYNC("GET", "contacts/export", ExportContacts) {
+        ENDPOINT_ASYNC_INIT(ExportContacts)
+
+        Action act() override {
+            return controller->blocking([handlers = &controller->handlers_] {
+                return handlers->exportContacts();
+            }).callbackTo(&ExportContacts::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(ImportContacts) {
+        ContactApiDocs::importContacts(info);
+    }
+    ENDPOINT_ASYNC("POST", "contacts/import", ImportContacts) {
+        ENDPOINT_ASYNC_INIT(ImportContacts)
+
+        std::shared_ptr<ContactImporter> importer;
+
+        Action act() override {
+            importer = controller->handlers_.createImporter(controller->blockingPool_);
+            return request->transferBodyAsync(importer).next(yieldTo(&ImportContacts::onBody));
+        }
+
+        Action onBody() {
+            return controller->blocking([handlers = &controller->handlers_, importer = importer] {
+                return handlers->importResult(*importer);
+            }).callbackTo(&ImportContacts::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(ChangeStream) {
+        ContactApiDocs::changeStream(info);
+    }
+    ENDPOINT_ASYNC("GET", "contacts/changes/stream", ChangeStream) {
+        ENDPOINT_ASYNC_INIT(ChangeStream)
+
+        Action act() override {
+            auto lastEventId = request->getHeader(ContactHandlers::kLastEventId);
+            if (!lastEventId) {
+                lastEventId = request->getQueryParameter("last_event_id");
+            }
+            return _return(controller->handlers_.changeStream(lastEventId, ChangeEventStream::Mode::Polling));
+        }
+    };
+
+    ENDPOINT_INFO(GetContactById) {
+        ContactApiDocs::getContactById(info);
+    }
+    ENDPOINT_ASYNC("GET", "contacts/{id}", GetContactById) {
+        ENDPOINT_ASYNC_INIT(GetContactById)
+
+        Action act() override {
+            auto formats = ContactHandlers::formatsOf(request);
+            auto id = ContactHandlers::parseId(request->getPathVariable("id"));
+            if (!id) {
+                return _return(controller->handlers_.errorResponse(id.error(), formats));
+            }
+            return _return(controller->handlers_.getContactById(
+                *id, request->getHeader(ContactHandlers::kIfNoneMatch), formats));
+        }
+    };
+
+    ENDPOINT_INFO(GetAllContacts) {
+        ContactApiDocs::getAllContacts(info);
+    }
+    ENDPOINT_ASYNC("GET", "contacts", GetAllContacts) {
+        ENDPOINT_ASYNC_INIT(GetAllContacts)
+
+        Action act() override {
+            ContactHandlers::ListQuery query;
+            query.limit = request->getQueryParameter("limit");
+            query.cursor = request->getQueryParameter("cursor");
+            query.phone = request->getQueryParameter("phone");
+            query.phonePrefix = request->getQueryParameter("phone_prefix");
+            query.ids = request->getQueryParameter("ids");
+            query.since = request->getQueryParameter("since");
+            query.sort = request->getQueryParameter("sort");
+            query.order = request->getQueryParameter("order");
+            query.offset = request->getQueryParameter("offset");
+            auto ifNoneMatch = request->getHeader(ContactHandlers::kIfNoneMatch);
+            auto formats = ContactHandlers::formatsOf(request);
+            return controller->blocking([handlers = &controller->handlers_, query, ifNoneMatch, formats] {
+                return handlers->getAllContacts(query, ifNoneMatch, formats);
+            }).callbackTo(&GetAllContacts::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(UpdateContact) {
+        ContactApiDocs::updateContact(info);
+    }
+    ENDPOINT_ASYNC("PUT", "contacts/{id}", UpdateContact) {
+        ENDPOINT_ASYNC_INIT(UpdateContact)
+
+        oatpp::Int64 id;
+
+        Action act() override {
+            auto parsed = ContactHandlers::parseId(request->getPathVariable("id"));
+            if (!parsed) {
+                return _return(controller->handlers_.errorResponse(parsed.error(), ContactHandlers::formatsOf(request)));
+            }
+            id = *parsed;
+            return request->readBodyToStringAsync().callbackTo(&UpdateContact::onBody);
+        }
+
+        Action onBody(const oatpp::String& body) {
+            auto formats = ContactHandlers::formatsOf(request);
+            return controller->blocking([handlers = &controller->handlers_, id = id, body, formats] {
+                return handlers->updateContact(id, body, formats);
+            }).callbackTo(&UpdateContact::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(PatchContact) {
+        ContactApiDocs::patchContact(info);
+    }
+    ENDPOINT_ASYNC("PATCH", "contacts/{id}", PatchContact) {
+        ENDPOINT_ASYNC_INIT(PatchContact)
+
+        oatpp::Int64 id;
+
+        Action act() override {
+            auto parsed = ContactHandlers::parseId(request->getPathVariable("id"));
+            if (!parsed) {
+                return _return(controller->handlers_.errorResponse(parsed.error(), ContactHandlers::formatsOf(request)));
+            }
+            id = *parsed;
+            return request->readBodyToStringAsync().callbackTo(&PatchContact::onBody);
+        }
+
+        Action onBody(const oatpp::String& body) {
+            auto ifMatch = request->getHeader(ContactHandlers::kIfMatch);
+            auto formats = ContactHandlers::formatsOf(request);
+            return controller->blocking([handlers = &controller->handlers_, id = id, body, ifMatch, formats] {
+                return handlers->patchContact(id, body, ifMatch, formats);
+            }).callbackTo(&PatchContact::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(DeleteContact) {
+        ContactApiDocs::deleteContact(info);
+    }
+    ENDPOINT_ASYNC("DELETE", "contacts/{id}", DeleteContact) {
+        ENDPOINT_ASYNC_INIT(DeleteContact)
+
+        Action act() override {
+            auto formats = ContactHandlers::formatsOf(request);
+            auto id = ContactHandlers::parseId(request->getPathVariable("id"));
+            if (!id) {
+                return _return(controller->handlers_.errorResponse(id.error(), formats));
+            }
+            return controller->blocking([handlers = &controller->handlers_, id = *id, formats] {
+                return handlers->deleteContact(id, formats);
+            }).callbackTo(&DeleteContact::onResponse);
+        }
+
+        Action onResponse(const std::shared_ptr<OutgoingResponse>& response) {
+            return _return(response);
+        }
+    };
+
+    ENDPOINT_INFO(Metrics) {
+        ContactApiDocs::metrics(info);
+    }
+    ENDPOINT_ASYNC("GET", "metrics", Metrics) {
+        ENDPOINT_ASYNC_INIT(Metrics)
+
+        Action act() override {
+            return _return(controller->handlers_.metrics());
+        }
+    };
+
+private:
+    ContactHandlers handlers_;
+    std::shared_ptr<BlockingTaskPool> blockingPool_;
+
+    oatpp::async::CoroutineStarterForResult<const std::shared_ptr<OutgoingResponse>&> blocking(
+        std::function<std::shared_ptr<OutgoingResponse>()> call) {
+        return BlockingCall::startForResult(blockingPool_, std::move(call));
+    }
+};
+
+#include OATPP_CODEGEN_END(ApiController)
@@ -0,0 +1,225 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/BatchDto.hpp"
+#include "dto/ChangeDto.hpp"
+#include "dto/ContactDto.hpp"
+#include "dto/ErrorDto.hpp"
+#include "dto/ImportDto.hpp"
+#include <memory>
+#include <oatpp/web/server/api/Endpoint.hpp>
+
+// Swagger descriptions of the contact endpoints
+// Shared by ContactController and AsyncContactController, which serve the same API
+// Only the JSON responses are listed; every contact endpoint except export and import answers
+// with the same bodies in MessagePack when the Accept header asks for application/msgpack
+class ContactApiDocs {
+public:
+    using Info = std::shared_ptr<oatpp::web::server::api::Endpoint::Info>;
+    using Status = oatpp::web::protocol::http::Status;
+
+    static void createContact(const Info& info) {
+        info->summary = "Create a new contact";
+        info->description = "Create a new contact in the phone directory";
+        info->addConsumes<oatpp::Object<ContactDto>>("application/json");
+        info->addConsumes<oatpp::Object<ContactDto>>("application/msgpack");
+        info->addResponse<oatpp::Object<ContactDto>>(Status::CODE_201, "application/json", "Contact created successfully");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void searchContacts(const Info& info) {
+        info->summary = "Search contacts by name";
+        info->description = "Case-insensitive name prefix search served from an ordered name index, results are "
+                            "ordered by name. With fuzzy=true the query words are matched against the words of "
+                            "the name with typos (none in words of up to 2 letters, 1 up to 5, 2 beyond), served "
+                            "from a trigram index; results are ordered by the number of edits, best first";
+        auto& namePrefix = info->queryParams.add<oatpp::String>("name_prefix");
+        namePrefix.description = "Beginning of the contact name";
+        namePrefix.required = false;
+        auto& q = info->queryParams.add<oatpp::String>("q");
+        q.description = "Search term, same as name_prefix; exactly one of them is required";
+        q.required = false;
+        auto& fuzzy = info->queryParams.add<oatpp::Boolean>("fuzzy");
+        fuzzy.description = "Typo-tolerant search (true/false), false if omitted";
+        fuzzy.required = false;
+        auto& limit = info->queryParams.add<oatpp::Int64>("limit");
+        limit.description = "Maximum number of contacts to return (1-1000), 20 if omitted";
+        limit.required = false;
+        info->addResponse<oatpp::List<oatpp::Object<ContactDto>>>(Status::CODE_200, "application/json", "Matching contacts");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void changeStream(const Info& info) {
+        info->summary = "Stream of contact changes";
+        info->description = "Server-Sent Events with one ChangeEventDto per create, update and delete, in the order "
+                            "they were applied. A subscriber resumes after the event given by Last-Event-ID "
+                            "(or last_event_id); a \"reset\" event means changes were missed and the directory "
+                            "should be read again. Only the most recent changes are kept (CONTACTS_CHANGE_LOG_ENTRIES)";
+        auto& lastEventId = info->headers.add<oatpp::String>("Last-Event-ID");
+        lastEventId.description = "Id of the last event received";
+        lastEventId.required = false;
+        auto& query = info->queryParams.add<oatpp::String>("last_event_id");
+        query.description = "Same as the Last-Event-ID header, for clients that cannot set headers";
+        query.required = false;
+        info->addResponse<oatpp::Object<ChangeEventDto>>(Status::CODE_200, "text/event-stream", "Change events");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Change feed is disabled");
+    }
+
+    static void getContactById(const Info& info) {
+        info->summary = "Get contact by ID";
+        info->description = "Retrieve a contact from the phone directory by its ID";
+        info->pathParams["id"].description = "Contact identifier";
+        addConditionalGet(info);
+        info->addResponse<oatpp::Object<ContactDto>>(Status::CODE_200, "application/json", "Contact found");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Contact not found");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void getAllContacts(const Info& info) {
+        info->summary = "Get all contacts";
+        info->description = "Retrieve contacts from the phone directory ordered by ID, or by name or phone with sort. "
+                            "When limit is given, the X-Next-Cursor response header of an ID-ordered listing holds "
+                            "the cursor of the next page; name and phone orders are paged with offset";
+        auto& limit = info->queryParams.add<oatpp::Int64>("limit");
+        limit.description = "Maximum number of contacts in the page (1-1000), all contacts if omitted";
+        limit.required = false;
+        auto& cursor = info->queryParams.add<oatpp::String>("cursor");
+        cursor.description = "Opaque cursor from the X-Next-Cursor header of the previous page";
+        cursor.required = false;
+        auto& sort = info->queryParams.add<oatpp::String>("sort");
+        sort.description = "Order of the listing: id (default), name (case-insensitive) or phone (by number). "
+                           "Name and phone orders return at most 1000 contacts per request";
+        sort.required = false;
+        auto& order = info->queryParams.add<oatpp::String>("order");
+        order.description = "asc (default) or desc";
+        order.required = false;
+        auto& offset = info->queryParams.add<oatpp::Int64>("offset");
+        offset.description = "Number of contacts to skip, after the cursor if one is given";
+        offset.required = false;
+        auto& phone = info->queryParams.add<oatpp::String>("phone");
+        phone.description = "Return only contacts with exactly this phone number (any notation)";
+        phone.required = false;
+        auto& phonePrefix = info->queryParams.add<oatpp::String>("phone_prefix");
+        phonePrefix.description = "Return only contacts whose phone starts with these digits (country / area code), "
+                                  "ordered by number";
+        phonePrefix.required = false;
+        auto& ids = info->queryParams.add<oatpp::String>("ids");
+        ids.description = "Comma-separated contact IDs to fetch in one request (up to 10000); unknown IDs are skipped";
+        ids.required = false;
+        auto& since = info->queryParams.add<oatpp::String>("since");
+        since.description = "Delta sync: 0 for every contact, or the next token of the previous delta for only the contacts "
+                            "changed and removed since then. Answered with a ContactDeltaDto instead of a list; "
+                            "limit caps the changes of one delta";
+        since.required = false;
+        addConditionalGet(info);
+        info->addResponse<oatpp::List<oatpp::Object<ContactDto>>>(Status::CODE_200, "application/json", "List of contacts");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_410, "application/json",
+                                                   "Sync token expired, start over with since=0");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_500, "application/json", "Internal Server Error");
+    }
+
+    static void createContacts(const Info& info) {
+        info->summary = "Create contacts in a batch";
+        info->description = "Create up to 10000 contacts in one request. Items are validated and stored independently: "
+                            "each result item holds the status the item would have got from POST /contacts";
+        info->addConsumes<oatpp::List<oatpp::Object<ContactDto>>>("application/json");
+        info->addConsumes<oatpp::List<oatpp::Object<ContactDto>>>("application/msgpack");
+        info->addResponse<oatpp::Object<BatchResultDto>>(Status::CODE_200, "application/json", "Per-item results");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void updateContacts(const Info& info) {
+        info->summary = "Update contacts in a batch";
+        info->description = "Update up to 10000 contacts, identified by the id field of each item. "
+                            "Each result item holds the status the item would have got from PUT /contacts/{id}";
+        info->addConsumes<oatpp::List<oatpp::Object<ContactDto>>>("application/json");
+        info->addConsumes<oatpp::List<oatpp::Object<ContactDto>>>("application/msgpack");
+        info->addResponse<oatpp::Object<BatchResultDto>>(Status::CODE_200, "application/json", "Per-item results");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void deleteContacts(const Info& info) {
+        info->summary = "Delete contacts in a batch";
+        info->description = "Delete up to 10000 contacts given as a JSON array of IDs. "
+                            "Each result item holds the status the item would have got from DELETE /contacts/{id}";
+        info->addConsumes<oatpp::List<oatpp::Int64>>("application/json");
+        info->addConsumes<oatpp::List<oatpp::Int64>>("application/msgpack");
+        info->addResponse<oatpp::Object<BatchResultDto>>(Status::CODE_200, "application/json", "Per-item results");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void exportContacts(const Info& info) {
+        info->summary = "Export all contacts as NDJSON";
+        info->description = "Stream every contact as one JSON object per line, ordered by ID, "
+                            "from a consistent point-in-time view of the directory";
+        info->addResponse<oatpp::String>(Status::CODE_200, "application/x-ndjson", "One contact per line");
+    }
+
+    static void importContacts(const Info& info) {
+        info->summary = "Import contacts from NDJSON";
+        info->description = "Create contacts from a body with one JSON contact object per line. The body is processed "
+                            "while it is received and stored in batches; each line is validated like POST /contacts "
+                            "(an id, if given, is kept) and failed lines are reported without stopping the import";
+        info->addConsumes<oatpp::String>("application/x-ndjson");
+        info->addResponse<oatpp::Object<ImportResultDto>>(Status::CODE_200, "application/json", "Import totals");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_500, "application/json", "Internal Server Error");
+    }
+
+    static void updateContact(const Info& info) {
+        info->summary = "Update contact by ID";
+        info->description = "Update an existing contact in the phone directory";
+        info->pathParams["id"].description = "Contact identifier";
+        info->addConsumes<oatpp::Object<ContactDto>>("application/json");
+        info->addConsumes<oatpp::Object<ContactDto>>("application/msgpack");
+        info->addResponse<oatpp::Object<ContactDto>>(Status::CODE_200, "application/json", "Contact updated successfully");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Contact not found");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void patchContact(const Info& info) {
+        info->summary = "Partially update contact by ID";
+        info->description = "Change only the fields present in the body (name, phone, address); an id in the body "
+                            "is ignored. With If-Match the change is applied only if the contact still has the "
+                            "tagged version. The response carries the ETag of the new version";
+        info->pathParams["id"].description = "Contact identifier";
+        auto& ifMatch = info->headers.add<oatpp::String>("If-Match");
+        ifMatch.description = "ETag the change is based on, or * for any version";
+        ifMatch.required = false;
+        info->addConsumes<oatpp::Object<ContactDto>>("application/json");
+        info->addConsumes<oatpp::Object<ContactDto>>("application/msgpack");
+        info->addResponse<oatpp::Object<ContactDto>>(Status::CODE_200, "application/json", "Contact updated successfully");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Contact not found");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_412, "application/json",
+                                                   "Contact was modified after the If-Match version");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void deleteContact(const Info& info) {
+        info->summary = "Delete contact by ID";
+        info->description = "Delete a contact from the phone directory by its ID";
+        info->pathParams["id"].description = "Contact identifier";
+        info->addResponse<oatpp::String>(Status::CODE_204, "text/plain", "Contact deleted successfully");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Contact not found");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+    }
+
+    static void metrics(const Info& info) {
+        info->summary = "Service metrics";
+        info->description = "Request counts and latency histograms per endpoint, repository lock wait and hold times, "
+                            "repository size and memory and JSON cache statistics in the Prometheus text format";
+        info->addResponse<oatpp::String>(Status::CODE_200, "text/plain", "Metrics");
+        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Metrics are disabled");
+    }
+
+private:
+    static void addConditionalGet(const Info& info) {
+        auto& ifNoneMatch = info->headers.add<oatpp::String>("If-None-Match");
+        ifNoneMatch.description = "ETag of a previous response; 304 is returned if it is still current";
+        ifNoneMatch.required = false;
+        info->addResponse<oatpp::String>(Status::CODE_304, "text/plain", "Not modified since the given ETag");
+    }
+};
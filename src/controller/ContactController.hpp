@@ -4,11 +4,15 @@
 
 #pragma once
 
+#include "cache/ContactJsonCache.hpp"
+#include "controller/ContactApiDocs.hpp"
+#include "controller/ContactHandlers.hpp"
 #include "dto/ContactDto.hpp"
+#include "metrics/MetricsExporter.hpp"
+#include "repository/ChangeLog.hpp"
 #include "dto/ErrorDto.hpp"
 #include "service/ContactService.hpp"
 #include <memory>
-#include <stdexcept>
 #include <oatpp/web/server/api/ApiController.hpp>
 #include <oatpp/parser/json/mapping/ObjectMapper.hpp>
 #include <oatpp-swagger/Model.hpp>
@@ -20,91 +24,169 @@
 // Here mapping of requests and responses between API and Service layers occurs
 // Here data validation also occurs before passing them to the Service layer
 // And mapping data from Service layer to API responses
+//
+// Threaded serving mode (HttpConnectionHandler); AsyncContactController serves the same API
+// with coroutines. Both delegate to ContactHandlers.
 class ContactController: public oatpp::web::server::api::ApiController {
 public:
     explicit ContactController(const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
-                               const std::shared_ptr<ContactService>& service)
+                               const std::shared_ptr<ContactService>& service,
+                               const std::shared_ptr<ContactJsonCache>& cache = nullptr,
+                               const std::shared_ptr<MetricsExporter>& metrics = nullptr,
+                               const std::shared_ptr<ChangeLog>& changeLog = nullptr)
     : ApiController(objectMapper)
-    , service_(service) {}
+    , handlers_(objectMapper, service, cache, metrics, changeLog) {}
 
     ENDPOINT_INFO(createContact) {
-        info->summary = "Create a new contact";
-        info->description = "Create a new contact in the phone directory";
-        info->addConsumes<oatpp::Object<ContactDto>>("application/json");
-        info->addResponse<oatpp::Object<ContactDto>>(Status::CODE_201, "application/json", "Contact created successfully");
-        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+        ContactApiDocs::createContact(info);
     }
     ENDPOINT("POST", "contacts", createContact,
-         BODY_DTO(oatpp::Object<ContactDto>, contactDto)) {
-        auto contact = service_->createContact(contactDto);
-        return createDtoResponse(Status::CODE_201, contact);
+             BODY_STRING(String, body),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        return handlers_.createContact(body, ContactHandlers::formatsOf(request));
+    }
+
+    ENDPOINT_INFO(searchContacts) {
+        ContactApiDocs::searchContacts(info);
+    }
+    // Registered before contacts/{id} so that "search" is not taken for an id
+    ENDPOINT("GET", "contacts/search", searchContacts,
+             QUERIES(QueryParams, queryParams),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        ContactHandlers::SearchQuery query;
+        query.namePrefix = queryParams.get("name_prefix");
+        query.q = queryParams.get("q");
+        query.fuzzy = queryParams.get("fuzzy");
+        query.limit = queryParams.get("limit");
+        return handlers_.searchContacts(query, ContactHandlers::formatsOf(request));
+    }
+
+    ENDPOINT_INFO(createContacts) {
+        ContactApiDocs::createContacts(info);
+    }
+    ENDPOINT("POST", "contacts/batch", createContacts,
+             BODY_STRING(String, body),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        return handlers_.createContacts(body, ContactHandlers::formatsOf(request));
+    }
+
+    ENDPOINT_INFO(updateContacts) {
+        ContactApiDocs::updateContacts(info);
+    }
+    // Batch routes are registered before contacts/{id} as well
+    ENDPOINT("PUT", "contacts/batch", updateContacts,
+             BODY_STRING(String, body),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        return handlers_.updateContacts(body, ContactHandlers::formatsOf(request));
+    }
+
+    ENDPOINT_INFO(deleteContacts) {
+        ContactApiDocs::deleteContacts(info);
+    }
+    ENDPOINT("DELETE", "contacts/batch", deleteContacts,
+             BODY_STRING(String, body),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        return handlers_.deleteContacts(body, ContactHandlers::formatsOf(request));
+    }
+
+    ENDPOINT_INFO(exportContacts) {
+        ContactApiDocs::exportContacts(info);
+    }
+    ENDPOINT("GET", "contacts/export", exportContacts) {
+        return handlers_.exportContacts();
+    }
+
+    ENDPOINT_INFO(importContacts) {
+        ContactApiDocs::importContacts(info);
+    }
+    ENDPOINT("POST", "contacts/import", importContacts,
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        auto importer = handlers_.createImporter();
+        request->transferBody(importer);
+        return handlers_.importResult(*importer);
+    }
+
+    ENDPOINT_INFO(changeStream) {
+        ContactApiDocs::changeStream(info);
+    }
+    // Holds a server thread while the subscriber is connected
+    ENDPOINT("GET", "contacts/changes/stream", changeStream,
+             QUERIES(QueryParams, queryParams),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        auto lastEventId = request->getHeader(ContactHandlers::kLastEventId);
+        return handlers_.changeStream(lastEventId ? lastEventId : queryParams.get("last_event_id"),
+                                      ChangeEventStream::Mode::Blocking);
     }
 
     ENDPOINT_INFO(getContactById) {
-        info->summary = "Get contact by ID";
-        info->description = "Retrieve a contact from the phone directory by its ID";
-        info->pathParams["id"].description = "Contact identifier";
-        info->addResponse<oatpp::Object<ContactDto>>(Status::CODE_200, "application/json", "Contact found");
-        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Contact not found");
-        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+        ContactApiDocs::getContactById(info);
     }
     ENDPOINT("GET", "contacts/{id}", getContactById,
-             PATH(oatpp::Int64, id)) {
-        auto contact = service_->getContactById(id);
-        return createDtoResponse(Status::CODE_200, contact);
+             PATH(oatpp::Int64, id),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        return handlers_.getContactById(id, request->getHeader(ContactHandlers::kIfNoneMatch),
+                                        ContactHandlers::formatsOf(request));
     }
 
     ENDPOINT_INFO(getAllContacts) {
-        info->summary = "Get all contacts";
-        info->description = "Retrieve all contacts from the phone directory";
-        info->addResponse<oatpp::List<oatpp::Object<ContactDto>>>(Status::CODE_200, "application/json", "List of contacts");
-        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_500, "application/json", "Internal Server Error");
+        ContactApiDocs::getAllContacts(info);
     }
-    ENDPOINT("GET", "contacts", getAllContacts) {
-        auto contacts = service_->getAllContacts();
-        auto response = oatpp::List<oatpp::Object<ContactDto>>::createShared();
-        for (const auto& contact : contacts) {
-            response->push_back(std::move(contact));
-        }
-        return createDtoResponse(Status::CODE_200, response);
+    ENDPOINT("GET", "contacts", getAllContacts,
+             QUERIES(QueryParams, queryParams),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        ContactHandlers::ListQuery query;
+        query.limit = queryParams.get("limit");
+        query.cursor = queryParams.get("cursor");
+        query.phone = queryParams.get("phone");
+        query.phonePrefix = queryParams.get("phone_prefix");
+        query.ids = queryParams.get("ids");
+        query.since = queryParams.get("since");
+        query.sort = queryParams.get("sort");
+        query.order = queryParams.get("order");
+        query.offset = queryParams.get("offset");
+        return handlers_.getAllContacts(query, request->getHeader(ContactHandlers::kIfNoneMatch),
+                                        ContactHandlers::formatsOf(request));
     }
 
     ENDPOINT_INFO(updateContact) {
-        info->summary = "Update contact by ID";
-        info->description = "Update an existing contact in the phone directory";
-        info->pathParams["id"].description = "Contact identifier";
-        info->addConsumes<oatpp::Object<ContactDto>>("application/json");
-        info->addResponse<oatpp::Object<ContactDto>>(Status::CODE_200, "application/json", "Contact updated successfully");
-        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Contact not found");
-        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+        ContactApiDocs::updateContact(info);
     }
     ENDPOINT("PUT", "contacts/{id}", updateContact,
              PATH(oatpp::Int64, id),
-             BODY_DTO(oatpp::Object<ContactDto>, contactDto)) {
-        contactDto->id = id;
-        auto contact = service_->updateContact(contactDto);
-        return createDtoResponse(Status::CODE_200, contact);
+             BODY_STRING(String, body),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        return handlers_.updateContact(id, body, ContactHandlers::formatsOf(request));
+    }
+
+    ENDPOINT_INFO(patchContact) {
+        ContactApiDocs::patchContact(info);
+    }
+    ENDPOINT("PATCH", "contacts/{id}", patchContact,
+             PATH(oatpp::Int64, id),
+             BODY_STRING(String, body),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        return handlers_.patchContact(id, body, request->getHeader(ContactHandlers::kIfMatch),
+                                      ContactHandlers::formatsOf(request));
     }
 
     ENDPOINT_INFO(deleteContact) {
-        info->summary = "Delete contact by ID";
-        info->description = "Delete a contact from the phone directory by its ID";
-        info->pathParams["id"].description = "Contact identifier";
-        info->addResponse<String>(Status::CODE_204, "text/plain", "Contact deleted successfully");
-        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_404, "application/json", "Contact not found");
-        info->addResponse<oatpp::Object<ErrorDto>>(Status::CODE_400, "application/json", "Bad Request");
+        ContactApiDocs::deleteContact(info);
     }
     ENDPOINT("DELETE", "contacts/{id}", deleteContact,
-             PATH(oatpp::Int64, id)) {
-        bool deleted = service_->deleteContact(id);
-        if (!deleted) {
-            throw std::runtime_error("Contact not found");
-        }
-        return createResponse(Status::CODE_204, "");
+             PATH(oatpp::Int64, id),
+             REQUEST(std::shared_ptr<IncomingRequest>, request)) {
+        return handlers_.deleteContact(id, ContactHandlers::formatsOf(request));
+    }
+
+    ENDPOINT_INFO(metrics) {
+        ContactApiDocs::metrics(info);
+    }
+    ENDPOINT("GET", "metrics", metrics) {
+        return handlers_.metrics();
     }
 
 private:
-    std::shared_ptr<ContactService> service_;
+    ContactHandlers handlers_;
 };
 
 #include OATPP_CODEGEN_END(ApiController)
\ No newline at end of file
@@ -0,0 +1,725 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "cache/ContactJsonCache.hpp"
+#include "codec/ContactMessagePack.hpp"
+#include "codec/HttpCompression.hpp"
+#include "dto/BatchDto.hpp"
+#include "dto/ChangeDto.hpp"
+#include "dto/ContactDto.hpp"
+#include "dto/ImportDto.hpp"
+#include "exception/ExceptionHandler.hpp"
+#include "metrics/MetricsExporter.hpp"
+#include "service/ContactService.hpp"
+#include "service/HexNumber.hpp"
+#include "stream/ChangeEventStream.hpp"
+#include "stream/ContactImporter.hpp"
+#include "stream/ContactJsonStream.hpp"
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <oatpp/core/utils/ConversionUtils.hpp>
+#include <oatpp/web/protocol/http/incoming/Request.hpp>
+#include <oatpp/web/protocol/http/outgoing/BufferBody.hpp>
+#include <oatpp/web/protocol/http/outgoing/Response.hpp>
+#include <oatpp/web/protocol/http/outgoing/ResponseFactory.hpp>
+#include <oatpp/web/protocol/http/outgoing/StreamingBody.hpp>
+
+// Request handling shared by the threaded (ContactController) and the async (AsyncContactController) API
+// Controllers only extract parameters and the body; mapping to the Service layer and building
+// responses happens here, so both serving modes behave identically. Expected failures come back from
+// the Service as ServiceResult errors and are answered by errorResponse without throwing; unexpected
+// exceptions still reach ApiErrorHandler.
+//
+// Bodies are JSON or MessagePack, chosen by Content-Type for requests and by Accept for responses.
+// Errors of requests that accept MessagePack are encoded here instead, with the same status and fields.
+class ContactHandlers {
+public:
+    using OutgoingResponse = oatpp::web::protocol::http::outgoing::Response;
+    using ResponseFactory = oatpp::web::protocol::http::outgoing::ResponseFactory;
+    using Status = oatpp::web::protocol::http::Status;
+    using Header = oatpp::web::protocol::http::Header;
+
+    static constexpr const char* kETag = "ETag";
+    static constexpr const char* kIfNoneMatch = "If-None-Match";
+    static constexpr const char* kIfMatch = "If-Match";
+    static constexpr const char* kLastEventId = "Last-Event-ID";
+    static constexpr const char* kVary = "Vary";
+
+    // Raw query parameters of GET /contacts
+    struct ListQuery {
+        oatpp::String limit;
+        oatpp::String cursor;
+        oatpp::String phone;
+        oatpp::String phonePrefix;
+        oatpp::String ids;
+        oatpp::String since;
+        oatpp::String sort;
+        oatpp::String order;
+        oatpp::String offset;
+    };
+
+    // Raw query parameters of GET /contacts/search
+    struct SearchQuery {
+        oatpp::String namePrefix;
+        oatpp::String q;
+        oatpp::String fuzzy;
+        oatpp::String limit;
+    };
+
+    enum class WireFormat {
+        Json,
+        MessagePack
+    };
+
+    // Wire formats of one request: of its body (Content-Type) and of its response (Accept)
+    struct Formats {
+        WireFormat body = WireFormat::Json;
+        WireFormat response = WireFormat::Json;
+    };
+
+    static Formats formatsOf(const oatpp::String& contentType, const oatpp::String& accept) {
+        Formats formats;
+        if (ContactMessagePack::isMediaType(contentType)) {
+            formats.body = WireFormat::MessagePack;
+        }
+        if (ContactMessagePack::isAccepted(accept)) {
+            formats.response = WireFormat::MessagePack;
+        }
+        return formats;
+    }
+
+    static Formats formatsOf(const std::shared_ptr<oatpp::web::protocol::http::incoming::Request>& request) {
+        return formatsOf(request->getHeader(Header::CONTENT_TYPE), request->getHeader(Header::ACCEPT));
+    }
+
+    // cache may be nullptr, then every contact is serialized on each request;
+    // metrics may be nullptr, then GET /metrics answers 404, and so does the change feed without changeLog
+    ContactHandlers(const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper,
+                    const std::shared_ptr<ContactService>& service,
+                    const std::shared_ptr<ContactJsonCache>& cache = nullptr,
+                    const std::shared_ptr<MetricsExporter>& metrics = nullptr,
+                    const std::shared_ptr<ChangeLog>& changeLog = nullptr)
+        : objectMapper_(objectMapper)
+        , service_(service)
+        , cache_(cache)
+        , metrics_(metrics)
+        , changeLog_(changeLog) {}
+
+    std::shared_ptr<OutgoingResponse> createContact(const oatpp::String& body, const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto contactDto = readContact(body, formats);
+            if (!contactDto) {
+                return errorResponse(contactDto.error(), formats);
+            }
+            auto contact = service_->createContact(*contactDto);
+            if (!contact) {
+                return errorResponse(contact.error(), formats);
+            }
+            return respond(Status::CODE_201, *contact, formats);
+        });
+    }
+
+    // q and name_prefix are the same search term; by default it is a name prefix, with fuzzy=true the words
+    // of the name are matched with typos (ContactService::searchByNameFuzzy)
+    std::shared_ptr<OutgoingResponse> searchContacts(const SearchQuery& query, const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto searchLimit = parseLimit(query.limit);
+            if (!searchLimit) {
+                return errorResponse(searchLimit.error(), formats);
+            }
+            auto fuzzy = parseFlag(query.fuzzy, "fuzzy");
+            if (!fuzzy) {
+                return errorResponse(fuzzy.error(), formats);
+            }
+            if (query.q && query.namePrefix) {
+                return errorResponse(ServiceError::invalid("Use either q or name_prefix"), formats);
+            }
+            const auto& term = query.q ? query.q : query.namePrefix;
+            auto contacts = *fuzzy ? service_->searchByNameFuzzy(term, *searchLimit)
+                                   : service_->searchByNamePrefix(term, *searchLimit);
+            if (!contacts) {
+                return errorResponse(contacts.error(), formats);
+            }
+            return listResponse(std::move(*contacts), formats);
+        });
+    }
+
+    // A matching If-None-Match is answered from the stored version alone, before the contact is materialized;
+    // otherwise the body of a JSON response comes from the JSON cache when it holds the current version
+    std::shared_ptr<OutgoingResponse> getContactById(const oatpp::Int64& id, const oatpp::String& ifNoneMatch,
+                                                     const Formats& formats) {
+        return withErrors(formats, [&] {
+            bool cached = cache_ && formats.response == WireFormat::Json;
+            if (ifNoneMatch || cached) {
+                auto version = service_->getContactVersion(id);
+                if (version && ifNoneMatch && matchesEntityTag(*ifNoneMatch, entityTag(*version, formats))) {
+                    return notModified(entityTag(*version, formats));
+                }
+                if (version && cached) {
+                    if (auto json = cache_->find(*id, *version)) {
+                        return jsonResponse(json, *version);
+                    }
+                }
+            }
+
+            uint64_t version = 0;
+            auto contact = service_->getContactById(id, &version);
+            if (!contact) {
+                return errorResponse(contact.error(), formats);
+            }
+            if (formats.response == WireFormat::MessagePack) {
+                auto response = respond(Status::CODE_200, *contact, formats);
+                response->putHeader(kETag, entityTag(version, formats));
+                return response;
+            }
+            auto json = objectMapper_->writeToString(*contact);
+            if (cache_) {
+                cache_->put(*id, version, json);
+            }
+            return jsonResponse(json, version);
+        });
+    }
+
+    // Any write changes every listing, so all of them are tagged with the directory version
+    // The version is read before the contacts, so a tag is never newer than the contents it is sent with.
+    // If-None-Match is compared only once the whole query is known to be valid: a malformed request is a 400
+    // whatever the client has cached. Listings are checked up front and answered before anything is read;
+    // the since, ids and phone filters are checked by the service call itself, so they are compared after it.
+    std::shared_ptr<OutgoingResponse> getAllContacts(const ListQuery& query, const oatpp::String& ifNoneMatch,
+                                                     const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto version = service_->getDirectoryVersion();
+            auto tag = entityTag(version, formats);
+            auto unchanged = [&] {
+                return ifNoneMatch && matchesEntityTag(*ifNoneMatch, tag);
+            };
+
+            auto limit = parseLimit(query.limit);
+            if (!limit) {
+                return errorResponse(limit.error(), formats);
+            }
+            auto offset = parseOffset(query.offset);
+            if (!offset) {
+                return errorResponse(offset.error(), formats);
+            }
+            bool ordered = query.sort || query.order || query.offset;
+
+            if (query.since) {
+                if (query.cursor || query.ids || query.phone || query.phonePrefix || ordered) {
+                    return errorResponse(ServiceError::invalid("Since can't be combined with other filters"), formats);
+                }
+                auto delta = service_->getChangesSince(query.since, *limit);
+                if (!delta) {
+                    return errorResponse(delta.error(), formats);
+                }
+                if (unchanged()) {
+                    return notModified(tag);
+                }
+                auto response = respond(Status::CODE_200, deltaOf(*delta), formats);
+                response->putHeader(kETag, tag);
+                return response;
+            }
+
+            if (query.ids || query.phone || query.phonePrefix) {
+                if (ordered) {
+                    return errorResponse(ServiceError::invalid("Sort and offset apply to the whole listing only"),
+                                         formats);
+                }
+                auto contacts = query.ids ? service_->getContactsByIds(query.ids)
+                              : query.phone ? service_->findByPhone(query.phone, *limit)
+                              : service_->findByPhonePrefix(query.phonePrefix, *limit);
+                if (!contacts) {
+                    return errorResponse(contacts.error(), formats);
+                }
+                if (unchanged()) {
+                    return notModified(tag);
+                }
+                auto list = listResponse(std::move(*contacts), formats);
+                list->putHeader(kETag, tag);
+                return list;
+            }
+
+            auto order = ContactService::parseListOrder(query.sort, query.order);
+            if (!order) {
+                return errorResponse(order.error(), formats);
+            }
+            if (query.cursor && order->key != ContactRepository::SortKey::Id) {
+                return errorResponse(ServiceError::invalid("Cursor applies to sort=id only, use offset"), formats);
+            }
+            if (auto error = ContactService::validatePage(query.cursor, *limit, *offset, order->descending)) {
+                return errorResponse(*error, formats);
+            }
+            if (unchanged()) {
+                return notModified(tag);
+            }
+
+            // Name and phone orders come from the repository's ordered indexes a page at a time
+            if (order->key != ContactRepository::SortKey::Id) {
+                auto contacts = service_->getSortedContacts(*order, *offset, *limit);
+                if (!contacts) {
+                    return errorResponse(contacts.error(), formats);
+                }
+                auto list = listResponse(std::move(*contacts), formats);
+                list->putHeader(kETag, tag);
+                return list;
+            }
+
+            auto page = service_->getContactsPage(query.cursor, *limit, *offset, order->descending);
+            if (!page) {
+                return errorResponse(page.error(), formats);
+            }
+            bool messagePack = formats.response == WireFormat::MessagePack;
+
+            // Serialized incrementally from the snapshot while the response is being sent
+            auto body = std::make_shared<oatpp::web::protocol::http::outgoing::StreamingBody>(
+                std::make_shared<ContactJsonStream>(page->snapshot, page->afterId, page->limit, objectMapper_,
+                                                    messagePack ? ContactJsonStream::Format::MessagePack
+                                                                : ContactJsonStream::Format::Array,
+                                                    page->descending));
+            auto response = OutgoingResponse::createShared(Status::CODE_200, body);
+            response->putHeader(Header::CONTENT_TYPE, messagePack ? ContactMessagePack::kContentType : "application/json");
+            response->putHeader(kVary, "Accept");
+            response->putHeader(kETag, entityTag(page->snapshot->version(), formats));
+            if (page->nextCursor) {
+                response->putHeader("X-Next-Cursor", page->nextCursor);
+            }
+            return response;
+        });
+    }
+
+    // Whole directory as NDJSON, streamed from one snapshot
+    std::shared_ptr<OutgoingResponse> exportContacts() {
+        auto page = service_->getContactsPage(nullptr, nullptr).value();
+        auto body = std::make_shared<oatpp::web::protocol::http::outgoing::StreamingBody>(
+            std::make_shared<ContactJsonStream>(page.snapshot, page.afterId, page.limit, objectMapper_,
+                                                ContactJsonStream::Format::Lines));
+        auto response = OutgoingResponse::createShared(Status::CODE_200, body);
+        response->putHeader(Header::CONTENT_TYPE, "application/x-ndjson");
+        return response;
+    }
+
+    // Server-Sent Events of every change from now on, or after lastEventId when the subscriber resumes
+    std::shared_ptr<OutgoingResponse> changeStream(const oatpp::String& lastEventId, ChangeEventStream::Mode mode) {
+        if (!changeLog_) {
+            return errorResponse(ServiceError::notFound("Change feed is disabled"), Formats());
+        }
+        auto body = std::make_shared<oatpp::web::protocol::http::outgoing::StreamingBody>(
+            std::make_shared<ChangeEventStream>(changeLog_, service_->getVersionEpoch(), lastEventId,
+                                                objectMapper_, mode));
+        auto response = OutgoingResponse::createShared(Status::CODE_200, body);
+        response->putHeader(Header::CONTENT_TYPE, "text/event-stream");
+        response->putHeader("Cache-Control", "no-cache");
+        return response;
+    }
+
+    // The controller transfers the request body into the importer, then builds the response with importResult
+    // The async controller passes its BlockingTaskPool, and calls importResult from there
+    std::shared_ptr<ContactImporter> createImporter(std::shared_ptr<BlockingTaskPool> pool = nullptr) {
+        return std::make_shared<ContactImporter>(service_, objectMapper_, std::move(pool));
+    }
+
+    std::shared_ptr<OutgoingResponse> importResult(ContactImporter& importer) {
+        auto summary = importer.finish();
+        auto result = ImportResultDto::createShared();
+        result->imported = static_cast<int64_t>(summary.imported);
+        result->failed = static_cast<int64_t>(summary.failed);
+        result->errors = oatpp::List<oatpp::Object<ImportErrorDto>>::createShared();
+        for (auto& lineError : summary.errors) {
+            auto error = ImportErrorDto::createShared();
+            error->line = static_cast<int64_t>(lineError.line);
+            error->error = lineError.message;
+            result->errors->push_back(error);
+        }
+        return ResponseFactory::createResponse(Status::CODE_200, result, objectMapper_);
+    }
+
+    std::shared_ptr<OutgoingResponse> updateContact(const oatpp::Int64& id, const oatpp::String& body,
+                                                    const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto contactDto = readContact(body, formats);
+            if (!contactDto) {
+                return errorResponse(contactDto.error(), formats);
+            }
+            (*contactDto)->id = id;
+            auto contact = service_->updateContact(*contactDto);
+            if (!contact) {
+                return errorResponse(contact.error(), formats);
+            }
+            return respond(Status::CODE_200, *contact, formats);
+        });
+    }
+
+    // Partial update: the body holds only the fields to change
+    // If-Match makes it conditional on the contact still having the tagged version (412 otherwise), which
+    // the repository checks and applies atomically; the response carries the ETag of the new version
+    std::shared_ptr<OutgoingResponse> patchContact(const oatpp::Int64& id, const oatpp::String& body,
+                                                   const oatpp::String& ifMatch, const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto expectedVersion = parseIfMatch(ifMatch);
+            if (!expectedVersion) {
+                return errorResponse(expectedVersion.error(), formats);
+            }
+            auto changes = readContact(body, formats);
+            if (!changes) {
+                return errorResponse(changes.error(), formats);
+            }
+            uint64_t version = 0;
+            auto contact = service_->patchContact(id, *changes, *expectedVersion, &version);
+            if (!contact) {
+                return errorResponse(contact.error(), formats);
+            }
+            auto response = respond(Status::CODE_200, *contact, formats);
+            response->putHeader(kETag, entityTag(version, formats));
+            return response;
+        });
+    }
+
+    std::shared_ptr<OutgoingResponse> deleteContact(const oatpp::Int64& id, const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto deleted = service_->deleteContact(id);
+            if (!deleted) {
+                return errorResponse(deleted.error(), formats);
+            }
+            return ResponseFactory::createResponse(Status::CODE_204, oatpp::String(""));
+        });
+    }
+
+    std::shared_ptr<OutgoingResponse> createContacts(const oatpp::String& body, const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto contacts = readContacts(body, formats);
+            if (!contacts) {
+                return errorResponse(contacts.error(), formats);
+            }
+            auto outcomes = service_->createContacts(*contacts);
+            if (!outcomes) {
+                return errorResponse(outcomes.error(), formats);
+            }
+            return batchResponse(*outcomes, Status::CODE_201, formats);
+        });
+    }
+
+    std::shared_ptr<OutgoingResponse> updateContacts(const oatpp::String& body, const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto contacts = readContacts(body, formats);
+            if (!contacts) {
+                return errorResponse(contacts.error(), formats);
+            }
+            auto outcomes = service_->updateContacts(*contacts);
+            if (!outcomes) {
+                return errorResponse(outcomes.error(), formats);
+            }
+            return batchResponse(*outcomes, Status::CODE_200, formats);
+        });
+    }
+
+    std::shared_ptr<OutgoingResponse> deleteContacts(const oatpp::String& body, const Formats& formats) {
+        return withErrors(formats, [&] {
+            auto ids = formats.body == WireFormat::MessagePack
+                ? decodeMessagePack(body, ContactMessagePack::decodeIdList)
+                : readJson<oatpp::List<oatpp::Int64>>(body);
+            if (!ids) {
+                return errorResponse(ids.error(), formats);
+            }
+            auto outcomes = service_->deleteContacts(itemsOf(*ids));
+            if (!outcomes) {
+                return errorResponse(outcomes.error(), formats);
+            }
+            return batchResponse(*outcomes, Status::CODE_204, formats);
+        });
+    }
+
+    // Error response with the status of the error's code, as JSON or as MessagePack
+    std::shared_ptr<OutgoingResponse> errorResponse(const ServiceError& error, const Formats& formats) {
+        auto status = ApiErrorHandler::statusOf(error.code);
+        return respond(status, ApiErrorHandler::createError(status, error.message), formats);
+    }
+
+    // Prometheus text exposition of the collected metrics
+    std::shared_ptr<OutgoingResponse> metrics() {
+        if (!metrics_) {
+            return errorResponse(ServiceError::notFound("Metrics are disabled"), Formats());
+        }
+        auto body = oatpp::web::protocol::http::outgoing::BufferBody::createShared(
+            metrics_->render(), MetricsExporter::kContentType);
+        return OutgoingResponse::createShared(Status::CODE_200, body);
+    }
+
+    // Path variable as a number; the threaded controller gets it converted by PATH(oatpp::Int64, ...)
+    static ServiceResult<oatpp::Int64> parseId(const oatpp::String& value) {
+        bool success = false;
+        auto id = value ? oatpp::utils::conversion::strToInt64(value, success) : 0;
+        if (!success) {
+            return ServiceError::invalid("Invalid ID: must be a number");
+        }
+        return oatpp::Int64(id);
+    }
+
+    static ServiceResult<oatpp::Int64> parseLimit(const oatpp::String& value) {
+        if (!value) {
+            return oatpp::Int64(nullptr);
+        }
+        bool success = false;
+        auto limit = oatpp::utils::conversion::strToInt64(value, success);
+        if (!success) {
+            return ServiceError::invalid("Invalid limit: must be a number");
+        }
+        return oatpp::Int64(limit);
+    }
+
+    static ServiceResult<oatpp::Int64> parseOffset(const oatpp::String& value) {
+        if (!value) {
+            return oatpp::Int64(nullptr);
+        }
+        bool success = false;
+        auto offset = oatpp::utils::conversion::strToInt64(value, success);
+        if (!success) {
+            return ServiceError::invalid("Invalid offset: must be a number");
+        }
+        return oatpp::Int64(offset);
+    }
+
+    // Boolean query parameter: true/1 or false/0, false when absent
+    static ServiceResult<bool> parseFlag(const oatpp::String& value, const char* name) {
+        if (!value || *value == "false" || *value == "0") {
+            return false;
+        }
+        if (*value == "true" || *value == "1") {
+            return true;
+        }
+        return ServiceError::invalid(std::string("Invalid ") + name + ": must be true or false");
+    }
+
+private:
+    std::shared_ptr<oatpp::data::mapping::ObjectMapper> objectMapper_;
+    std::shared_ptr<ContactService> service_;
+    std::shared_ptr<ContactJsonCache> cache_;
+    std::shared_ptr<MetricsExporter> metrics_;
+    std::shared_ptr<ChangeLog> changeLog_;
+
+    std::shared_ptr<OutgoingResponse> jsonResponse(const oatpp::String& json, uint64_t version) {
+        auto body = oatpp::web::protocol::http::outgoing::BufferBody::createShared(json, "application/json");
+        auto response = OutgoingResponse::createShared(Status::CODE_200, body);
+        response->putHeader(kVary, "Accept");
+        response->putHeader(kETag, entityTag(version, Formats()));
+        return response;
+    }
+
+    template<typename T>
+    std::shared_ptr<OutgoingResponse> respond(const Status& status, const T& value, const Formats& formats) {
+        if (formats.response == WireFormat::Json) {
+            auto response = ResponseFactory::createResponse(status, value, objectMapper_);
+            response->putHeader(kVary, "Accept");
+            return response;
+        }
+        auto body = oatpp::web::protocol::http::outgoing::BufferBody::createShared(
+            ContactMessagePack::encode(value), ContactMessagePack::kContentType);
+        auto response = OutgoingResponse::createShared(status, body);
+        response->putHeader(kVary, "Accept");
+        return response;
+    }
+
+    // Expected failures arrive as ServiceResult errors (see errorResponse); this only covers unexpected
+    // exceptions such as a failed journal write. JSON ones propagate to ApiErrorHandler, a MessagePack
+    // client gets the same ErrorDto as MessagePack
+    template<typename Handler>
+    std::shared_ptr<OutgoingResponse> withErrors(const Formats& formats, Handler&& handler) {
+        if (formats.response == WireFormat::Json) {
+            return handler();
+        }
+        try {
+            return handler();
+        } catch (const std::runtime_error& e) {
+            auto status = ApiErrorHandler::determineStatus(e.what());
+            return respond(status, ApiErrorHandler::createError(status, e.what()), formats);
+        }
+    }
+
+    ServiceResult<oatpp::Object<ContactDto>> readContact(const oatpp::String& body, const Formats& formats) {
+        auto contact = formats.body == WireFormat::MessagePack
+            ? decodeMessagePack(body, ContactMessagePack::decodeContact)
+            : readJson<oatpp::Object<ContactDto>>(body);
+        if (contact && !*contact) {
+            return ServiceError::invalid("Invalid body: expected a contact object");
+        }
+        return contact;
+    }
+
+    ServiceResult<std::vector<oatpp::Object<ContactDto>>> readContacts(const oatpp::String& body,
+                                                                       const Formats& formats) {
+        auto contacts = formats.body == WireFormat::MessagePack
+            ? decodeMessagePack(body, ContactMessagePack::decodeContactList)
+            : readJson<oatpp::List<oatpp::Object<ContactDto>>>(body);
+        if (!contacts) {
+            return contacts.error();
+        }
+        return itemsOf(*contacts);
+    }
+
+    // Both decoders report malformed input by throwing; that is the only place exceptions are caught
+    // on the way to an expected 400, and it is not reached by well-formed bodies
+    template<typename T>
+    ServiceResult<T> readJson(const oatpp::String& body) {
+        if (!body || body->empty()) {
+            return ServiceError::invalid("Invalid JSON: empty body");
+        }
+        try {
+            return objectMapper_->readFromString<T>(body);
+        } catch (const std::exception& e) {
+            return ServiceError::invalid(std::string("Invalid JSON: ") + e.what());
+        }
+    }
+
+    template<typename T>
+    static ServiceResult<T> decodeMessagePack(const oatpp::String& body, T (*decoder)(const oatpp::String&)) {
+        try {
+            return decoder(body);
+        } catch (const std::runtime_error& e) {
+            return ServiceError::invalid(e.what());
+        }
+    }
+
+    // "<epoch>-<version>": versions start over when the server restarts, the epoch tells them apart
+    // MessagePack representations get a "-mp" suffix, as a strong tag identifies the exact bytes
+    oatpp::String entityTag(uint64_t version, const Formats& formats) {
+        char buffer[48];
+        std::snprintf(buffer, sizeof(buffer), "\"%llx-%llx%s\"",
+                      static_cast<unsigned long long>(service_->getVersionEpoch()),
+                      static_cast<unsigned long long>(version),
+                      formats.response == WireFormat::MessagePack ? "-mp" : "");
+        return oatpp::String(buffer);
+    }
+
+    // If-None-Match holds "*" or a comma-separated list of tags, compared weakly as GET requires
+    // The tag of a compressed copy (see CompressionInterceptor) matches as well, it names the same contents
+    static bool matchesEntityTag(const std::string& header, const std::string& tag) {
+        size_t start = 0;
+        while (start < header.size()) {
+            auto end = header.find(',', start);
+            if (end == std::string::npos) {
+                end = header.size();
+            }
+            auto first = header.find_first_not_of(" \t", start);
+            auto last = header.find_last_not_of(" \t", end - 1);
+            if (first != std::string::npos && first < end && last >= first) {
+                auto item = std::string_view(header).substr(first, last - first + 1);
+                if (item.substr(0, 2) == "W/") {
+                    item.remove_prefix(2);
+                }
+                if (item == "*" || HttpCompression::identityTagOf(item) == tag) {
+                    return true;
+                }
+            }
+            start = end + 1;
+        }
+        return false;
+    }
+
+    // Version an If-Match header asks for, nullopt when absent or "*" (the contact only has to exist)
+    // A tag of another epoch or a weak one can never match, as If-Match compares strongly; the JSON and
+    // MessagePack tags of a version, plain or of a compressed copy, name the same contents here, so any is accepted.
+    // One tag per request: a compare-and-swap is against a single version
+    ServiceResult<std::optional<uint64_t>> parseIfMatch(const oatpp::String& header) {
+        if (!header) {
+            return std::optional<uint64_t>();
+        }
+        std::string_view value(*header);
+        auto first = value.find_first_not_of(" \t");
+        auto last = value.find_last_not_of(" \t");
+        value = first == std::string_view::npos ? std::string_view() : value.substr(first, last - first + 1);
+        if (value == "*") {
+            return std::optional<uint64_t>();
+        }
+        if (value.empty() || value.find(',') != std::string_view::npos) {
+            return ServiceError::invalid("Invalid If-Match: expected one entity tag or *");
+        }
+        if (value.size() < 2 || value.front() != '"' || value.back() != '"') {
+            return ServiceError::preconditionFailed();
+        }
+        auto identityTag = HttpCompression::identityTagOf(value);
+        value = std::string_view(identityTag).substr(1, identityTag.size() - 2);
+        if (value.size() > 3 && value.substr(value.size() - 3) == "-mp") {
+            value.remove_suffix(3);
+        }
+        auto dash = value.find('-');
+        uint64_t epoch = 0;
+        uint64_t version = 0;
+        if (dash == std::string_view::npos || !HexNumber::parse(value.substr(0, dash), epoch) ||
+            !HexNumber::parse(value.substr(dash + 1), version) || epoch != service_->getVersionEpoch()) {
+            return ServiceError::preconditionFailed();
+        }
+        return std::optional<uint64_t>(version);
+    }
+
+    static std::shared_ptr<OutgoingResponse> notModified(const oatpp::String& tag) {
+        auto response = ResponseFactory::createResponse(Status::CODE_304);
+        response->putHeader(kETag, tag);
+        return response;
+    }
+
+    // A null list (JSON null, MessagePack nil) is passed on as an empty batch, which the service rejects
+    template<typename T>
+    static std::vector<T> itemsOf(const oatpp::List<T>& list) {
+        if (!list) {
+            return {};
+        }
+        return std::vector<T>(list->begin(), list->end());
+    }
+
+    // The batch itself succeeds (200) as soon as it is well-formed; each item carries the status
+    // its single-item request would have got
+    std::shared_ptr<OutgoingResponse> batchResponse(const std::vector<BatchOutcome>& outcomes, const Status& success,
+                                                    const Formats& formats) {
+        auto result = BatchResultDto::createShared();
+        result->items = oatpp::List<oatpp::Object<BatchItemDto>>::createShared();
+        int32_t succeeded = 0;
+        for (size_t i = 0; i < outcomes.size(); ++i) {
+            const auto& outcome = outcomes[i];
+            auto item = BatchItemDto::createShared();
+            item->index = static_cast<int32_t>(i);
+            item->id = outcome.id;
+            if (outcome.ok()) {
+                item->status = success.code;
+                item->contact = outcome.contact;
+                ++succeeded;
+            } else {
+                item->status = ApiErrorHandler::statusOf(outcome.error->code).code;
+                item->error = outcome.error->message;
+            }
+            result->items->push_back(item);
+        }
+        result->succeeded = succeeded;
+        result->failed = static_cast<int32_t>(outcomes.size()) - succeeded;
+        return respond(Status::CODE_200, result, formats);
+    }
+
+    static oatpp::Object<ContactDeltaDto> deltaOf(ContactDelta& delta) {
+        auto dto = ContactDeltaDto::createShared();
+        dto->contacts = oatpp::List<oatpp::Object<ContactDto>>::createShared();
+        for (auto& contact : delta.changes.contacts) {
+            dto->contacts->push_back(std::move(contact));
+        }
+        dto->removed = oatpp::List<oatpp::Int64>::createShared();
+        for (auto id : delta.changes.removed) {
+            dto->removed->push_back(id);
+        }
+        dto->next = delta.next;
+        dto->more = delta.changes.more;
+        return dto;
+    }
+
+    std::shared_ptr<OutgoingResponse> listResponse(std::vector<oatpp::Object<ContactDto>> contacts,
+                                                   const Formats& formats) {
+        auto response = oatpp::List<oatpp::Object<ContactDto>>::createShared();
+        for (auto& contact : contacts) {
+            response->push_back(std::move(contact));
+        }
+        return respond(Status::CODE_200, response, formats);
+    }
+};
@@ -0,0 +1,34 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ContactDto.hpp"
+#include <oatpp/core/Types.hpp>
+#include <oatpp/core/macro/codegen.hpp>
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+// Result of one item of a batch request
+// status is the HTTP status the item would have got as a single request
+class BatchItemDto: public oatpp::DTO {
+    DTO_INIT(BatchItemDto, DTO);
+
+    DTO_FIELD(Int32,  index, "index");
+    DTO_FIELD(Int32,  status, "status");
+    DTO_FIELD(Int64,  id, "id");
+    DTO_FIELD(Object<ContactDto>, contact, "contact");
+    DTO_FIELD(String, error, "error");
+};
+
+// Response of a batch request, items are in request order
+class BatchResultDto: public oatpp::DTO {
+    DTO_INIT(BatchResultDto, DTO);
+
+    DTO_FIELD(Int32, succeeded, "succeeded");
+    DTO_FIELD(Int32, failed, "failed");
+    DTO_FIELD(List<Object<BatchItemDto>>, items, "items");
+};
+
+#include OATPP_CODEGEN_END(DTO)
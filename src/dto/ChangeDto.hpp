@@ -0,0 +1,38 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ContactDto.hpp"
+#include <oatpp/core/Types.hpp>
+#include <oatpp/core/macro/codegen.hpp>
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+// One event of the change feed (GET /contacts/changes/stream)
+// type is "put" (created or updated, contact holds the new contents), "remove" (contact is null)
+// or "reset": events were missed, the subscriber should re-read the directory
+class ChangeEventDto: public oatpp::DTO {
+    DTO_INIT(ChangeEventDto, DTO);
+
+    DTO_FIELD(UInt64, sequence, "sequence");
+    DTO_FIELD(String, type, "type");
+    DTO_FIELD(Int64,  id, "id");
+    DTO_FIELD(UInt64, version, "version");
+    DTO_FIELD(Object<ContactDto>, contact, "contact");
+};
+
+// Response of a delta sync (GET /contacts?since=)
+// contacts were created or updated and removed were deleted after since; next is the since of the following
+// delta. With more set the limit cut the delta short, and the following one returns the rest right away.
+class ContactDeltaDto: public oatpp::DTO {
+    DTO_INIT(ContactDeltaDto, DTO);
+
+    DTO_FIELD(List<Object<ContactDto>>, contacts, "contacts");
+    DTO_FIELD(List<Int64>, removed, "removed");
+    DTO_FIELD(String, next, "next");
+    DTO_FIELD(Boolean, more, "more");
+};
+
+#include OATPP_CODEGEN_END(DTO)
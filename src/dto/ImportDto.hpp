@@ -0,0 +1,29 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <oatpp/core/Types.hpp>
+#include <oatpp/core/macro/codegen.hpp>
+
+#include OATPP_CODEGEN_BEGIN(DTO)
+
+// A line of an NDJSON import that was not imported
+class ImportErrorDto: public oatpp::DTO {
+    DTO_INIT(ImportErrorDto, DTO);
+
+    DTO_FIELD(Int64,  line, "line");
+    DTO_FIELD(String, error, "error");
+};
+
+// Totals of an NDJSON import; errors lists at most the first 100 failed lines
+class ImportResultDto: public oatpp::DTO {
+    DTO_INIT(ImportResultDto, DTO);
+
+    DTO_FIELD(Int64, imported, "imported");
+    DTO_FIELD(Int64, failed, "failed");
+    DTO_FIELD(List<Object<ImportErrorDto>>, errors, "errors");
+};
+
+#include OATPP_CODEGEN_END(DTO)
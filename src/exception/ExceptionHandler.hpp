@@ -5,6 +5,7 @@
 #pragma once
 
 #include "dto/ErrorDto.hpp"
+#include "service/ServiceResult.hpp"
 #include <oatpp/web/server/interceptor/RequestInterceptor.hpp>
 #include <oatpp/web/server/handler/ErrorHandler.hpp>
 #include <oatpp/web/protocol/http/outgoing/ResponseFactory.hpp>
@@ -19,24 +20,15 @@ class ApiErrorHandler : public oatpp::web::server::handler::ErrorHandler {
 private:
     std::shared_ptr<oatpp::data::mapping::ObjectMapper> objectMapper_;
 
-    oatpp::web::protocol::http::Status determineStatus(const std::string& message) {
-        if (message == "Contact not found") {
-            return oatpp::web::protocol::http::Status::CODE_404;
-        } else if (message.find("Invalid ID") != std::string::npos ||
-                   message.find("required") != std::string::npos ||
-                   message.find("Failed to create") != std::string::npos ||
-                   message.find("ID already exists") != std::string::npos ||
-                   message.find("must be positive") != std::string::npos) {
-            return oatpp::web::protocol::http::Status::CODE_400;
-        }
-        return oatpp::web::protocol::http::Status::CODE_500;
-    }
-
-    std::string getStatusMessage(const oatpp::web::protocol::http::Status& status) {
+    static std::string getStatusMessage(const oatpp::web::protocol::http::Status& status) {
         if (status.code == 404) {
             return "Not Found";
         } else if (status.code == 400) {
             return "Bad Request";
+        } else if (status.code == 410) {
+            return "Gone";
+        } else if (status.code == 412) {
+            return "Precondition Failed";
         }
         return "Internal Server Error";
     }
@@ -45,24 +37,61 @@ public:
     explicit ApiErrorHandler(const std::shared_ptr<oatpp::data::mapping::ObjectMapper>& objectMapper)
         : objectMapper_(objectMapper) {}
 
+    // Status of an expected failure reported by the Service
+    // Also used for the per-item statuses of batch requests
+    static oatpp::web::protocol::http::Status statusOf(ErrorCode code) {
+        switch (code) {
+            case ErrorCode::NotFound:
+                return oatpp::web::protocol::http::Status::CODE_404;
+            case ErrorCode::InvalidArgument:
+            case ErrorCode::Conflict:
+                return oatpp::web::protocol::http::Status::CODE_400;
+            case ErrorCode::PreconditionFailed:
+                return oatpp::web::protocol::http::Status::CODE_412;
+            case ErrorCode::Gone:
+                return oatpp::web::protocol::http::Status::CODE_410;
+        }
+        return oatpp::web::protocol::http::Status::CODE_500;
+    }
+
+    // Status of an exception that reached handleError, classified by its message
+    // Expected failures no longer get here (see statusOf); this covers oatpp's own errors and unexpected ones
+    static oatpp::web::protocol::http::Status determineStatus(const std::string& message) {
+        if (message == "Contact not found") {
+            return oatpp::web::protocol::http::Status::CODE_404;
+        } else if (message.rfind("Invalid", 0) == 0 ||
+                   message.find("required") != std::string::npos ||
+                   message.find("Failed to create") != std::string::npos ||
+                   message.find("Failed to update") != std::string::npos ||
+                   message.find("already exists") != std::string::npos ||
+                   message.find("must be positive") != std::string::npos) {
+            return oatpp::web::protocol::http::Status::CODE_400;
+        }
+        return oatpp::web::protocol::http::Status::CODE_500;
+    }
+
+    // Body of an error response; also encoded as MessagePack by ContactHandlers
+    static oatpp::Object<ErrorDto> createError(const oatpp::web::protocol::http::Status& status,
+                                               const std::string& details) {
+        auto error = ErrorDto::createShared();
+        error->status = status.code;
+        error->message = getStatusMessage(status);
+        error->details = details.empty() ? "Unknown error" : details;
+        return error;
+    }
+
     std::shared_ptr<oatpp::web::protocol::http::outgoing::Response>
     handleError(const oatpp::web::protocol::http::Status& status,
                 const oatpp::String& message,
                 const Headers& headers) override {
-        auto error = ErrorDto::createShared();
-        
         std::string messageStr = message ? message->c_str() : "";
         auto determinedStatus = determineStatus(messageStr);
         
         // Use determined status from message if provided status is generic (500), otherwise use provided
         auto finalStatus = (status.code == 500) ? determinedStatus : status;
         
-        error->status = finalStatus.code;
-        error->message = getStatusMessage(finalStatus);
-        error->details = messageStr.empty() ? "Unknown error" : messageStr;
-
         return oatpp::web::protocol::http::outgoing::ResponseFactory::createResponse(
-            finalStatus, error, objectMapper_);
+            finalStatus, createError(finalStatus, messageStr), objectMapper_);
     }
 };
 
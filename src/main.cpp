@@ -4,7 +4,6 @@
 
 #include "appComponent/ContactComponent.hpp"
 #include "swagger/SwaggerComponent.hpp"
-#include <oatpp/network/Server.hpp>
 #include <iostream>
 
 int main() {
@@ -17,12 +16,26 @@ int main() {
         // Then register main application components
         ContactComponent component;
 
-        OATPP_COMPONENT(std::shared_ptr<oatpp::network::ServerConnectionProvider>, serverConnectionProvider);
-        OATPP_COMPONENT(std::shared_ptr<oatpp::network::ConnectionHandler>, connectionHandler);
+        OATPP_COMPONENT(std::shared_ptr<ContactRepository>, repository);
+        if (repository->log()) {
+            std::cout << "Journal: " << repository->log()->path()
+                      << (repository->hydrated() ? "" : ", loading snapshot in the background") << '\n';
+        } else {
+            std::cout << "Journal: disabled, data is kept in memory only" << '\n';
+        }
 
-        auto server = oatpp::network::Server::createShared(serverConnectionProvider, connectionHandler);
-        std::cout << "Server running on port 8000" << '\n';
-        server->run();
+        OATPP_COMPONENT(std::shared_ptr<AppConfig>, config);
+        if (config->serverMode == AppConfig::ServerMode::Async) {
+            std::cout << "Server mode: async, " << config->asyncThreads << " executor threads, "
+                      << config->blockingThreads << " blocking call threads" << '\n';
+        } else {
+            std::cout << "Server mode: threaded" << '\n';
+        }
+
+        OATPP_COMPONENT(std::shared_ptr<AcceptorGroup>, acceptors);
+        std::cout << "Server running on " << config->host << ':' << config->port << ", "
+                  << acceptors->size() << (acceptors->size() == 1 ? " acceptor" : " acceptors") << '\n';
+        acceptors->run();
 
         oatpp::base::Environment::destroy();
     } catch (const std::exception& e) {
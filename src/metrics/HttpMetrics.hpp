@@ -0,0 +1,133 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "metrics/LatencyHistogram.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+// Request counts and latency histograms per API endpoint
+// Endpoints are told apart by method and path the way the router does it, so labels stay a fixed,
+// small set no matter which ids or query strings clients send.
+class HttpMetrics {
+public:
+    enum class Endpoint {
+        CreateContact,
+        SearchContacts,
+        CreateContacts,
+        UpdateContacts,
+        DeleteContacts,
+        ExportContacts,
+        ImportContacts,
+        ChangeStream,
+        GetContactById,
+        GetAllContacts,
+        UpdateContact,
+        PatchContact,
+        DeleteContact,
+        Metrics,
+        // Swagger UI, unknown routes and methods
+        Other
+    };
+
+    static constexpr size_t kEndpointCount = static_cast<size_t>(Endpoint::Other) + 1;
+    // Responses are counted by status class: 1xx .. 5xx
+    static constexpr size_t kStatusClasses = 5;
+
+    // Names match the controller's endpoint names
+    static const char* nameOf(Endpoint endpoint) {
+        static constexpr std::array<const char*, kEndpointCount> kNames = {
+            "createContact", "searchContacts", "createContacts", "updateContacts", "deleteContacts",
+            "exportContacts", "importContacts", "changeStream", "getContactById", "getAllContacts",
+            "updateContact", "patchContact", "deleteContact", "metrics", "other"
+        };
+        return kNames[static_cast<size_t>(endpoint)];
+    }
+
+    // Route of a request line; path may carry a query string
+    static Endpoint classify(std::string_view method, std::string_view path) {
+        path = path.substr(0, path.find('?'));
+        while (path.size() > 1 && path.back() == '/') {
+            path.remove_suffix(1);
+        }
+        if (path == "/metrics") {
+            return method == "GET" ? Endpoint::Metrics : Endpoint::Other;
+        }
+        if (path == "/contacts") {
+            if (method == "GET") {
+                return Endpoint::GetAllContacts;
+            }
+            return method == "POST" ? Endpoint::CreateContact : Endpoint::Other;
+        }
+        constexpr std::string_view kPrefix = "/contacts/";
+        if (path.substr(0, kPrefix.size()) != kPrefix || path.size() == kPrefix.size()) {
+            return Endpoint::Other;
+        }
+        auto segment = path.substr(kPrefix.size());
+        if (segment == "changes/stream") {
+            return method == "GET" ? Endpoint::ChangeStream : Endpoint::Other;
+        }
+        if (segment.find('/') != std::string_view::npos) {
+            return Endpoint::Other;
+        }
+        // Same order as the router: fixed segments are matched before {id}
+        if (segment == "search") {
+            return method == "GET" ? Endpoint::SearchContacts : Endpoint::Other;
+        }
+        if (segment == "batch") {
+            if (method == "POST") {
+                return Endpoint::CreateContacts;
+            }
+            if (method == "PUT") {
+                return Endpoint::UpdateContacts;
+            }
+            return method == "DELETE" ? Endpoint::DeleteContacts : Endpoint::Other;
+        }
+        if (segment == "export") {
+            return method == "GET" ? Endpoint::ExportContacts : Endpoint::Other;
+        }
+        if (segment == "import") {
+            return method == "POST" ? Endpoint::ImportContacts : Endpoint::Other;
+        }
+        if (method == "GET") {
+            return Endpoint::GetContactById;
+        }
+        if (method == "PUT") {
+            return Endpoint::UpdateContact;
+        }
+        if (method == "PATCH") {
+            return Endpoint::PatchContact;
+        }
+        return method == "DELETE" ? Endpoint::DeleteContact : Endpoint::Other;
+    }
+
+    // latency is in nanoseconds, from the request head being parsed to the response being ready
+    // (a streamed body is still being produced after that)
+    void record(Endpoint endpoint, int status, uint64_t latency) {
+        auto& stats = endpoints_[static_cast<size_t>(endpoint)];
+        stats.latency.record(latency);
+        auto statusClass = status >= 100 && status < 600 ? static_cast<size_t>(status / 100 - 1) : kStatusClasses - 1;
+        stats.responses[statusClass].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot latency(Endpoint endpoint) const {
+        return endpoints_[static_cast<size_t>(endpoint)].latency.snapshot();
+    }
+
+    // Responses of the endpoint with a status in [100 * (statusClass + 1), 100 * (statusClass + 2))
+    uint64_t responses(Endpoint endpoint, size_t statusClass) const {
+        return endpoints_[static_cast<size_t>(endpoint)].responses[statusClass].load(std::memory_order_relaxed);
+    }
+
+private:
+    struct EndpointStats {
+        StripedHistogram latency;
+        std::array<std::atomic<uint64_t>, kStatusClasses> responses{};
+    };
+
+    std::array<EndpointStats, kEndpointCount> endpoints_;
+};
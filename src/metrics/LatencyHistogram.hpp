@@ -0,0 +1,159 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Merged contents of one or more LatencyHistograms, taken when metrics are scraped
+struct HistogramSnapshot {
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    // Sum of the recorded values
+    uint64_t sum = 0;
+
+    // Number of values recorded at or below value; exact at bucket bounds, otherwise within a bucket
+    uint64_t countAtOrBelow(uint64_t value) const;
+
+    // Smallest recorded-bucket upper bound with at least q of the values at or below it (0 when empty)
+    uint64_t quantile(double q) const;
+};
+
+// HDR-style log-linear histogram of non-negative integers (nanoseconds here)
+// Values below 16 have a bucket each; above, every power of two is split into 16 linear buckets,
+// so a value is reported with at most 1/16 (6.25%) relative error. Values from 2^40 (about 18 minutes
+// in nanoseconds) up land in the last bucket. Counters are relaxed atomics: recording is a couple of
+// uncontended increments and readers see a consistent enough picture for monitoring.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr uint64_t kSubBuckets = 1ull << kSubBucketBits;
+    static constexpr unsigned kMaxMagnitude = 40;
+    static constexpr size_t kBucketCount = kSubBuckets + (kMaxMagnitude - kSubBucketBits) * kSubBuckets;
+
+    LatencyHistogram()
+        : buckets_(new std::atomic<uint64_t>[kBucketCount]) {
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            buckets_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record(uint64_t value) {
+        buckets_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void addTo(HistogramSnapshot& snapshot) const {
+        snapshot.buckets.resize(kBucketCount);
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            auto count = buckets_[i].load(std::memory_order_relaxed);
+            snapshot.buckets[i] += count;
+            snapshot.count += count;
+        }
+        snapshot.sum += sum_.load(std::memory_order_relaxed);
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot result;
+        addTo(result);
+        return result;
+    }
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < kSubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        unsigned magnitude = 63u - static_cast<unsigned>(__builtin_clzll(value));
+        if (magnitude >= kMaxMagnitude) {
+            return kBucketCount - 1;
+        }
+        auto shift = magnitude - kSubBucketBits;
+        auto subBucket = (value >> shift) & (kSubBuckets - 1);
+        return static_cast<size_t>(kSubBuckets + shift * kSubBuckets + subBucket);
+    }
+
+    // Largest value that falls into the bucket
+    static uint64_t upperBoundOf(size_t bucket) {
+        if (bucket < kSubBuckets) {
+            return bucket;
+        }
+        auto shift = (bucket - kSubBuckets) / kSubBuckets;
+        auto subBucket = (bucket - kSubBuckets) % kSubBuckets;
+        return ((kSubBuckets + subBucket + 1) << shift) - 1;
+    }
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+    std::atomic<uint64_t> sum_{0};
+};
+
+inline uint64_t HistogramSnapshot::countAtOrBelow(uint64_t value) const {
+    uint64_t result = 0;
+    for (size_t i = 0; i < buckets.size() && LatencyHistogram::upperBoundOf(i) <= value; ++i) {
+        result += buckets[i];
+    }
+    return result;
+}
+
+inline uint64_t HistogramSnapshot::quantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto rank = static_cast<uint64_t>(q * static_cast<double>(count));
+    rank = std::clamp<uint64_t>(rank, 1, count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return LatencyHistogram::upperBoundOf(i);
+        }
+    }
+    return LatencyHistogram::upperBoundOf(buckets.size() - 1);
+}
+
+// A LatencyHistogram per stripe; each thread records into its own stripe and the stripes are merged
+// when read. Threads are spread over the stripes round-robin, so with no more threads than stripes
+// every thread has a histogram to itself and no cache line is written by two threads.
+// A fixed stripe count (instead of one histogram per thread) keeps memory bounded in the threaded
+// server mode, which starts a thread per connection.
+class StripedHistogram {
+public:
+    explicit StripedHistogram(size_t stripes = defaultStripeCount())
+        : stripes_(std::max<size_t>(stripes, 1)) {}
+
+    void record(uint64_t value) {
+        stripes_[threadIndex() % stripes_.size()].histogram.record(value);
+    }
+
+    HistogramSnapshot snapshot() const {
+        HistogramSnapshot result;
+        for (const auto& stripe : stripes_) {
+            stripe.histogram.addTo(result);
+        }
+        return result;
+    }
+
+    static size_t defaultStripeCount() {
+        return std::clamp<size_t>(std::thread::hardware_concurrency(), 4, 64);
+    }
+
+    // Stable small number of the calling thread
+    static size_t threadIndex() {
+        static std::atomic<size_t> next{0};
+        thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+private:
+    struct alignas(64) Stripe {
+        LatencyHistogram histogram;
+    };
+
+    std::vector<Stripe> stripes_;
+};
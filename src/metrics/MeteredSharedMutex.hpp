@@ -0,0 +1,95 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "metrics/LatencyHistogram.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <shared_mutex>
+
+// Wait and hold times of a group of locks, in nanoseconds
+struct LockTimes {
+    StripedHistogram wait;
+    // Exclusive locks only: a shared lock has many holders and no single hold time
+    StripedHistogram hold;
+};
+
+// std::shared_mutex that can report how long its callers wait for it and hold it
+// Works with std::unique_lock / std::shared_lock like the mutex it wraps. Timing is off until
+// setTimes() is called and then sampled: one acquisition in kSampleEvery per thread pays for the
+// clock reads, which keeps the cost on hot read paths to a fraction of a nanosecond on average.
+class MeteredSharedMutex {
+public:
+    static constexpr uint32_t kSampleEvery = 16;
+
+    // Safe while the mutex is in use; times must outlive it
+    void setTimes(LockTimes* times) {
+        times_.store(times, std::memory_order_release);
+    }
+
+    void lock() {
+        auto* times = times_.load(std::memory_order_acquire);
+        if (!times || !sampled()) {
+            mutex_.lock();
+            acquiredAt_ = 0;
+            return;
+        }
+        auto start = now();
+        mutex_.lock();
+        acquiredAt_ = now();
+        times->wait.record(acquiredAt_ - start);
+    }
+
+    bool try_lock() {
+        if (!mutex_.try_lock()) {
+            return false;
+        }
+        acquiredAt_ = 0;
+        return true;
+    }
+
+    void unlock() {
+        // Only the holder reads acquiredAt_, it was written by the same thread in lock()
+        if (acquiredAt_ != 0) {
+            times_.load(std::memory_order_acquire)->hold.record(now() - acquiredAt_);
+        }
+        mutex_.unlock();
+    }
+
+    void lock_shared() {
+        auto* times = times_.load(std::memory_order_acquire);
+        if (!times || !sampled()) {
+            mutex_.lock_shared();
+            return;
+        }
+        auto start = now();
+        mutex_.lock_shared();
+        times->wait.record(now() - start);
+    }
+
+    bool try_lock_shared() {
+        return mutex_.try_lock_shared();
+    }
+
+    void unlock_shared() {
+        mutex_.unlock_shared();
+    }
+
+private:
+    std::shared_mutex mutex_;
+    std::atomic<LockTimes*> times_{nullptr};
+    uint64_t acquiredAt_ = 0;
+
+    static bool sampled() {
+        thread_local uint32_t tick = 0;
+        return ++tick % kSampleEvery == 0;
+    }
+
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+};
@@ -0,0 +1,202 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "cache/CompressedResponseCache.hpp"
+#include "cache/ContactJsonCache.hpp"
+#include "metrics/HttpMetrics.hpp"
+#include "repository/ContactRepository.hpp"
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// Renders the collected metrics in the Prometheus text exposition format (GET /metrics)
+// Histograms are merged from their stripes only here, so the cost of a scrape never lands on requests.
+class MetricsExporter {
+public:
+    static constexpr const char* kContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+    // cache may be nullptr when the JSON cache is disabled, compressedCache when the compressed body cache is
+    MetricsExporter(std::shared_ptr<HttpMetrics> http,
+                    std::shared_ptr<ContactRepository> repository,
+                    std::shared_ptr<ContactJsonCache> cache,
+                    std::shared_ptr<CompressedResponseCache> compressedCache = nullptr)
+        : http_(std::move(http))
+        , repository_(std::move(repository))
+        , cache_(std::move(cache))
+        , compressedCache_(std::move(compressedCache)) {}
+
+    std::string render() const {
+        std::string out;
+        out.reserve(32 * 1024);
+        renderHttp(out);
+        renderLocks(out);
+        renderRepository(out);
+        renderCache(out);
+        renderCompressedCache(out);
+        return out;
+    }
+
+private:
+    // Bucket bounds in seconds
+    static constexpr std::array<double, 14> kRequestBuckets = {
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5
+    };
+    static constexpr std::array<double, 7> kLockBuckets = {
+        0.000001, 0.00001, 0.0001, 0.001, 0.01, 0.1, 1
+    };
+    static constexpr std::array<double, 4> kQuantiles = {0.5, 0.9, 0.99, 0.999};
+
+    std::shared_ptr<HttpMetrics> http_;
+    std::shared_ptr<ContactRepository> repository_;
+    std::shared_ptr<ContactJsonCache> cache_;
+    std::shared_ptr<CompressedResponseCache> compressedCache_;
+
+    void renderHttp(std::string& out) const {
+        out += "# HELP contacts_http_requests_total Responses sent, by endpoint and status class.\n";
+        out += "# TYPE contacts_http_requests_total counter\n";
+        for (size_t i = 0; i < HttpMetrics::kEndpointCount; ++i) {
+            auto endpoint = static_cast<HttpMetrics::Endpoint>(i);
+            for (size_t statusClass = 0; statusClass < HttpMetrics::kStatusClasses; ++statusClass) {
+                auto count = http_->responses(endpoint, statusClass);
+                if (count == 0) {
+                    continue;
+                }
+                out += "contacts_http_requests_total{endpoint=\"";
+                out += HttpMetrics::nameOf(endpoint);
+                out += "\",status=\"" + std::to_string(statusClass + 1) + "xx\"} ";
+                out += std::to_string(count) + "\n";
+            }
+        }
+
+        std::array<HistogramSnapshot, HttpMetrics::kEndpointCount> latencies;
+        for (size_t i = 0; i < HttpMetrics::kEndpointCount; ++i) {
+            latencies[i] = http_->latency(static_cast<HttpMetrics::Endpoint>(i));
+        }
+
+        out += "# HELP contacts_http_request_duration_seconds Time from a parsed request to its response.\n";
+        out += "# TYPE contacts_http_request_duration_seconds histogram\n";
+        for (size_t i = 0; i < HttpMetrics::kEndpointCount; ++i) {
+            std::string labels = "endpoint=\"" + std::string(HttpMetrics::nameOf(static_cast<HttpMetrics::Endpoint>(i))) + "\"";
+            renderHistogram(out, "contacts_http_request_duration_seconds", labels, latencies[i], kRequestBuckets);
+        }
+
+        out += "# HELP contacts_http_request_duration_quantile_seconds Request duration quantiles since startup.\n";
+        out += "# TYPE contacts_http_request_duration_quantile_seconds gauge\n";
+        for (size_t i = 0; i < HttpMetrics::kEndpointCount; ++i) {
+            if (latencies[i].count == 0) {
+                continue;
+            }
+            std::string endpoint = HttpMetrics::nameOf(static_cast<HttpMetrics::Endpoint>(i));
+            for (auto q : kQuantiles) {
+                out += "contacts_http_request_duration_quantile_seconds{endpoint=\"" + endpoint +
+                       "\",quantile=\"" + formatNumber(q) + "\"} ";
+                out += formatSeconds(latencies[i].quantile(q)) + "\n";
+            }
+        }
+    }
+
+    void renderLocks(std::string& out) const {
+        const auto* times = repository_->lockTimes();
+        if (!times) {
+            return;
+        }
+        out += "# HELP contacts_repository_lock_wait_seconds Time spent waiting for a shard lock (sampled).\n";
+        out += "# TYPE contacts_repository_lock_wait_seconds histogram\n";
+        renderHistogram(out, "contacts_repository_lock_wait_seconds", "", times->wait.snapshot(), kLockBuckets);
+        out += "# HELP contacts_repository_lock_hold_seconds Time a shard lock is held exclusively (sampled).\n";
+        out += "# TYPE contacts_repository_lock_hold_seconds histogram\n";
+        renderHistogram(out, "contacts_repository_lock_hold_seconds", "", times->hold.snapshot(), kLockBuckets);
+    }
+
+    void renderRepository(std::string& out) const {
+        auto memory = repository_->memoryStats();
+        out += "# HELP contacts_repository_contacts Contacts stored.\n";
+        out += "# TYPE contacts_repository_contacts gauge\n";
+        out += "contacts_repository_contacts " + std::to_string(memory.contacts) + "\n";
+        out += "# HELP contacts_repository_memory_bytes Approximate heap footprint of the repository.\n";
+        out += "# TYPE contacts_repository_memory_bytes gauge\n";
+        renderComponent(out, "records", memory.records);
+        renderComponent(out, "id_index", memory.idIndex);
+        renderComponent(out, "strings", memory.strings);
+        renderComponent(out, "dictionary", memory.dictionary);
+        renderComponent(out, "name_index", memory.nameIndex);
+        renderComponent(out, "trigram_index", memory.trigramIndex);
+        renderComponent(out, "phone_index", memory.phoneIndex);
+        renderComponent(out, "modification_log", memory.modifications);
+    }
+
+    void renderCache(std::string& out) const {
+        if (!cache_) {
+            return;
+        }
+        auto stats = cache_->stats();
+        out += "# HELP contacts_json_cache_requests_total Serialized contact cache lookups, by result.\n";
+        out += "# TYPE contacts_json_cache_requests_total counter\n";
+        out += "contacts_json_cache_requests_total{result=\"hit\"} " + std::to_string(stats.hits) + "\n";
+        out += "contacts_json_cache_requests_total{result=\"miss\"} " + std::to_string(stats.misses) + "\n";
+        out += "# HELP contacts_json_cache_evictions_total Entries evicted to stay within capacity.\n";
+        out += "# TYPE contacts_json_cache_evictions_total counter\n";
+        out += "contacts_json_cache_evictions_total " + std::to_string(stats.evictions) + "\n";
+        out += "# HELP contacts_json_cache_entries Contacts currently cached.\n";
+        out += "# TYPE contacts_json_cache_entries gauge\n";
+        out += "contacts_json_cache_entries " + std::to_string(stats.entries) + "\n";
+        out += "# HELP contacts_json_cache_bytes Size of the cached bodies.\n";
+        out += "# TYPE contacts_json_cache_bytes gauge\n";
+        out += "contacts_json_cache_bytes " + std::to_string(stats.bytes) + "\n";
+    }
+
+    void renderCompressedCache(std::string& out) const {
+        if (!compressedCache_) {
+            return;
+        }
+        auto stats = compressedCache_->stats();
+        out += "# HELP contacts_compressed_cache_requests_total Compressed response body lookups, by result.\n";
+        out += "# TYPE contacts_compressed_cache_requests_total counter\n";
+        out += "contacts_compressed_cache_requests_total{result=\"hit\"} " + std::to_string(stats.hits) + "\n";
+        out += "contacts_compressed_cache_requests_total{result=\"miss\"} " + std::to_string(stats.misses) + "\n";
+        out += "# HELP contacts_compressed_cache_entries Compressed response bodies currently cached.\n";
+        out += "# TYPE contacts_compressed_cache_entries gauge\n";
+        out += "contacts_compressed_cache_entries " + std::to_string(stats.entries) + "\n";
+        out += "# HELP contacts_compressed_cache_bytes Size of the cached compressed bodies.\n";
+        out += "# TYPE contacts_compressed_cache_bytes gauge\n";
+        out += "contacts_compressed_cache_bytes " + std::to_string(stats.bytes) + "\n";
+    }
+
+    static void renderComponent(std::string& out, const char* component, size_t bytes) {
+        out += "contacts_repository_memory_bytes{component=\"";
+        out += component;
+        out += "\"} " + std::to_string(bytes) + "\n";
+    }
+
+    // Cumulative buckets of a nanosecond histogram, with bounds in seconds
+    template<size_t N>
+    static void renderHistogram(std::string& out, const char* name, const std::string& labels,
+                                const HistogramSnapshot& histogram, const std::array<double, N>& bounds) {
+        auto prefix = labels.empty() ? std::string() : labels + ",";
+        for (auto bound : bounds) {
+            auto nanoseconds = static_cast<uint64_t>(bound * 1e9 + 0.5);
+            out += std::string(name) + "_bucket{" + prefix + "le=\"" + formatNumber(bound) + "\"} ";
+            out += std::to_string(histogram.countAtOrBelow(nanoseconds)) + "\n";
+        }
+        out += std::string(name) + "_bucket{" + prefix + "le=\"+Inf\"} " + std::to_string(histogram.count) + "\n";
+        auto braces = labels.empty() ? std::string() : "{" + labels + "}";
+        out += std::string(name) + "_sum" + braces + " " + formatSeconds(histogram.sum) + "\n";
+        out += std::string(name) + "_count" + braces + " " + std::to_string(histogram.count) + "\n";
+    }
+
+    static std::string formatNumber(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%g", value);
+        return buffer;
+    }
+
+    static std::string formatSeconds(uint64_t nanoseconds) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(nanoseconds) / 1e9);
+        return buffer;
+    }
+};
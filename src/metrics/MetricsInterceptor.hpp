@@ -0,0 +1,62 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "metrics/HttpMetrics.hpp"
+#include <oatpp/web/server/interceptor/RequestInterceptor.hpp>
+#include <oatpp/web/server/interceptor/ResponseInterceptor.hpp>
+#include <chrono>
+#include <memory>
+#include <string_view>
+
+// Request and response interceptors that time every request into HttpMetrics
+// Registered on the connection handler, so both server modes and every route are covered.
+// The start time travels with the request as bundle data; the endpoint is classified
+// once the response is ready, from the same request line the router matched.
+class MetricsInterceptor {
+public:
+    static constexpr const char* kStartKey = "metrics.start";
+
+    class Request : public oatpp::web::server::interceptor::RequestInterceptor {
+    public:
+        std::shared_ptr<OutgoingResponse> intercept(const std::shared_ptr<IncomingRequest>& request) override {
+            request->putBundleData(kStartKey, oatpp::UInt64(now()));
+            return nullptr;
+        }
+    };
+
+    class Response : public oatpp::web::server::interceptor::ResponseInterceptor {
+    public:
+        explicit Response(std::shared_ptr<HttpMetrics> metrics)
+            : metrics_(std::move(metrics)) {}
+
+        std::shared_ptr<OutgoingResponse> intercept(const std::shared_ptr<IncomingRequest>& request,
+                                                    const std::shared_ptr<OutgoingResponse>& response) override {
+            // Requests rejected before the request interceptors ran carry no start time
+            auto start = request ? request->getBundleData<oatpp::UInt64>(kStartKey) : oatpp::UInt64();
+            if (!start || !response) {
+                return response;
+            }
+            const auto& line = request->getStartingLine();
+            auto endpoint = HttpMetrics::classify(view(line.method), view(line.path));
+            metrics_->record(endpoint, response->getStatus().code, now() - *start);
+            return response;
+        }
+
+    private:
+        std::shared_ptr<HttpMetrics> metrics_;
+    };
+
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+private:
+    template<typename Label>
+    static std::string_view view(const Label& label) {
+        return {static_cast<const char*>(label.getData()), static_cast<size_t>(label.getSize())};
+    }
+};
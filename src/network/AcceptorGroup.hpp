@@ -0,0 +1,63 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <oatpp/network/ConnectionHandler.hpp>
+#include <oatpp/network/ConnectionProvider.hpp>
+#include <oatpp/network/Server.hpp>
+
+// A Server per listening socket, all handing their connections to one connection handler (and so one router)
+// A single accept loop caps how fast connections are taken during a reconnect storm; with several sockets sharing
+// the port (see ReusePortConnectionProvider) every loop accepts on its own thread.
+class AcceptorGroup {
+public:
+    AcceptorGroup(std::vector<std::shared_ptr<oatpp::network::ServerConnectionProvider>> providers,
+                  std::shared_ptr<oatpp::network::ConnectionHandler> connectionHandler)
+        : providers_(std::move(providers)) {
+        for (const auto& provider : providers_) {
+            servers_.push_back(oatpp::network::Server::createShared(provider, connectionHandler));
+        }
+    }
+
+    AcceptorGroup(const AcceptorGroup&) = delete;
+    AcceptorGroup& operator=(const AcceptorGroup&) = delete;
+
+    // Runs every accept loop, the last one on the calling thread, until stop()
+    void run() {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i + 1 < servers_.size(); ++i) {
+            threads.emplace_back([server = servers_[i]] {
+                server->run();
+            });
+        }
+        if (!servers_.empty()) {
+            servers_.back()->run();
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // Stops accepting; connections already accepted belong to the connection handler, which is stopped separately
+    void stop() {
+        for (auto& server : servers_) {
+            server->stop();
+        }
+        for (auto& provider : providers_) {
+            provider->stop();
+        }
+    }
+
+    size_t size() const {
+        return servers_.size();
+    }
+
+private:
+    std::vector<std::shared_ptr<oatpp::network::ServerConnectionProvider>> providers_;
+    std::vector<std::shared_ptr<oatpp::network::Server>> servers_;
+};
@@ -0,0 +1,132 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <oatpp/core/async/Coroutine.hpp>
+#include <oatpp/core/async/CoroutineWaitList.hpp>
+
+// Threads for calls that block, used by the async serving mode
+// The executor multiplexes every connection on a few threads, so a coroutine must not wait there for a journal
+// fsync, for hydration or for a whole import batch: a handful of slow writes would stall all connections.
+// Such calls are submitted here instead, and the coroutine waits on the returned Task until the call is done.
+class BlockingTaskPool {
+public:
+    // Completion of one submitted call
+    class Task : public oatpp::async::CoroutineWaitList::Listener {
+    public:
+        Task() {
+            waitList_.setListener(this);
+        }
+
+        bool done() const {
+            return done_.load();
+        }
+
+        // Action that parks the coroutine until the call is done, then repeats the current step
+        oatpp::async::Action wait() {
+            return oatpp::async::Action::createWaitListAction(&waitList_);
+        }
+
+        // Throws what the call threw, if anything; only valid once done
+        void rethrow() const {
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+        }
+
+        // A coroutine that starts waiting after the call is done is woken right away
+        void onNewItem(oatpp::async::CoroutineWaitList& list) override {
+            if (done()) {
+                list.notifyAll();
+            }
+        }
+
+    private:
+        friend class BlockingTaskPool;
+
+        std::atomic<bool> done_{false};
+        std::exception_ptr error_;
+        oatpp::async::CoroutineWaitList waitList_;
+
+        void complete(std::exception_ptr error) {
+            error_ = std::move(error);
+            done_.store(true);
+            waitList_.notifyAll();
+        }
+    };
+
+    explicit BlockingTaskPool(size_t threads) {
+        threads_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back([this] { run(); });
+        }
+    }
+
+    ~BlockingTaskPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        available_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    BlockingTaskPool(const BlockingTaskPool&) = delete;
+    BlockingTaskPool& operator=(const BlockingTaskPool&) = delete;
+
+    std::shared_ptr<Task> submit(std::function<void()> call) {
+        auto task = std::make_shared<Task>();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.emplace_back(std::move(call), task);
+        }
+        available_.notify_one();
+        return task;
+    }
+
+    size_t threadCount() const {
+        return threads_.size();
+    }
+
+private:
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::deque<std::pair<std::function<void()>, std::shared_ptr<Task>>> queue_;
+    bool stopping_ = false;
+
+    void run() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            available_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            // Calls still queued at shutdown are run, their coroutines are waiting for them
+            if (queue_.empty()) {
+                return;
+            }
+            auto [call, task] = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                call();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            task->complete(std::move(error));
+        }
+    }
+};
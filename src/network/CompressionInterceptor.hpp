@@ -0,0 +1,145 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "cache/CompressedResponseCache.hpp"
+#include "codec/HttpCompression.hpp"
+#include "stream/CompressingStream.hpp"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <oatpp/web/protocol/http/outgoing/BufferBody.hpp>
+#include <oatpp/web/protocol/http/outgoing/StreamingBody.hpp>
+#include <oatpp/web/server/interceptor/ResponseInterceptor.hpp>
+
+// Response interceptor that compresses 200 responses for clients that send Accept-Encoding
+// Registered on the connection handler, so both server modes and every route are covered. Bodies of known size
+// below minBytes stay as they are; bodies of unknown size are the streamed listings and exports and are always
+// compressed, while being sent. The change feed is left alone, its events must not wait in the encoder.
+// GET responses with an ETag are also served from the CompressedResponseCache: an unchanged listing is compressed
+// once per coding, and later requests get the stored bytes instead of a new serialization.
+// A compressed response carries a coding-specific ETag (see HttpCompression::entityTagOf), and a 304 answering
+// a conditional request for such a tag repeats it; the handlers accept either form in If-None-Match and If-Match.
+class CompressionInterceptor : public oatpp::web::server::interceptor::ResponseInterceptor {
+public:
+    static constexpr const char* kAcceptEncoding = "Accept-Encoding";
+    static constexpr const char* kContentEncoding = "Content-Encoding";
+
+    // cache may be nullptr, then every response is compressed on its own
+    CompressionInterceptor(size_t minBytes, int level, std::shared_ptr<CompressedResponseCache> cache = nullptr)
+        : minBytes_(minBytes)
+        , level_(level)
+        , cache_(std::move(cache)) {}
+
+    std::shared_ptr<OutgoingResponse> intercept(const std::shared_ptr<IncomingRequest>& request,
+                                                const std::shared_ptr<OutgoingResponse>& response) override {
+        if (request && response && response->getStatus().code == 304) {
+            return notModified(request, response);
+        }
+        if (!request || !response || response->getStatus().code != 200 || !response->getBody() ||
+            response->getHeader(kContentEncoding)) {
+            return response;
+        }
+        auto contentType = response->getHeader(oatpp::web::protocol::http::Header::CONTENT_TYPE);
+        if (contentType && std::string_view(*contentType).rfind("text/event-stream", 0) == 0) {
+            return response;
+        }
+        auto body = response->getBody();
+        auto knownSize = body->getKnownSize();
+        if (knownSize >= 0 && (static_cast<size_t>(knownSize) < minBytes_ || !body->getKnownData())) {
+            return response;
+        }
+        // The representation depends on Accept-Encoding from here on, compressed or not
+        response->putHeader("Vary", kAcceptEncoding);
+        auto acceptEncoding = request->getHeader(kAcceptEncoding);
+        auto coding = acceptEncoding ? HttpCompression::negotiate(*acceptEncoding) : ContentCoding::Identity;
+        if (coding == ContentCoding::Identity) {
+            return response;
+        }
+
+        std::string cacheKey;
+        auto entityTag = response->getHeader("ETag");
+        const auto& line = request->getStartingLine();
+        if (cache_ && entityTag && line.method.toString() == "GET") {
+            cacheKey = CompressedResponseCache::keyOf(HttpCompression::nameOf(coding), line.path.toString(),
+                                                      *entityTag);
+            if (auto cached = cache_->find(cacheKey)) {
+                return withBody(response, oatpp::web::protocol::http::outgoing::BufferBody::createShared(cached), coding);
+            }
+        }
+
+        if (knownSize >= 0) {
+            auto compressed = oatpp::String(HttpCompression::compress(
+                {static_cast<const char*>(body->getKnownData()), static_cast<size_t>(knownSize)}, coding, level_));
+            if (!cacheKey.empty()) {
+                cache_->put(cacheKey, compressed);
+            }
+            return withBody(response, oatpp::web::protocol::http::outgoing::BufferBody::createShared(compressed), coding);
+        }
+        auto stream = std::make_shared<CompressingStream>(body, coding, level_, cacheKey.empty() ? nullptr : cache_,
+                                                          std::move(cacheKey));
+        return withBody(response, std::make_shared<oatpp::web::protocol::http::outgoing::StreamingBody>(stream), coding);
+    }
+
+private:
+    size_t minBytes_;
+    int level_;
+    std::shared_ptr<CompressedResponseCache> cache_;
+
+    // The handlers tag a 304 with the identity tag; when the client's cached copy was a compressed one, it sent
+    // that copy's tag, which is what the 304 has to name for the copy to be reused
+    static std::shared_ptr<OutgoingResponse> notModified(const std::shared_ptr<IncomingRequest>& request,
+                                                         const std::shared_ptr<OutgoingResponse>& response) {
+        auto entityTag = response->getHeader("ETag");
+        auto ifNoneMatch = request->getHeader("If-None-Match");
+        auto acceptEncoding = request->getHeader(kAcceptEncoding);
+        if (!entityTag || !ifNoneMatch || !acceptEncoding) {
+            return response;
+        }
+        auto coding = HttpCompression::negotiate(*acceptEncoding);
+        auto codedTag = HttpCompression::entityTagOf(*entityTag, coding);
+        if (coding == ContentCoding::Identity || std::string_view(*ifNoneMatch).find(codedTag) == std::string_view::npos) {
+            return response;
+        }
+        auto result = withHeaders(response, response->getBody(), codedTag);
+        result->putHeader("Vary", kAcceptEncoding);
+        return result;
+    }
+
+    // A response with the same status and headers as the original one, the new body, its Content-Encoding and
+    // the coding-specific ETag
+    static std::shared_ptr<OutgoingResponse> withBody(
+        const std::shared_ptr<OutgoingResponse>& original,
+        const std::shared_ptr<oatpp::web::protocol::http::outgoing::Body>& body,
+        ContentCoding coding) {
+        auto entityTag = original->getHeader("ETag");
+        auto response = withHeaders(original, body,
+                                    entityTag ? HttpCompression::entityTagOf(*entityTag, coding) : std::string());
+        response->putHeader(kContentEncoding, HttpCompression::nameOf(coding));
+        return response;
+    }
+
+    // A copy of original with another body and, unless entityTag is empty, another ETag
+    // Headers the original body would declare when sent (its Content-Type) are carried over first
+    static std::shared_ptr<OutgoingResponse> withHeaders(
+        const std::shared_ptr<OutgoingResponse>& original,
+        const std::shared_ptr<oatpp::web::protocol::http::outgoing::Body>& body,
+        const std::string& entityTag) {
+        auto response = OutgoingResponse::createShared(original->getStatus(), body);
+        if (original->getBody()) {
+            original->getBody()->declareHeaders(original->getHeaders());
+        }
+        for (const auto& header : original->getHeaders().getAll()) {
+            auto name = header.first.toString();
+            if (entityTag.empty() || name != "ETag") {
+                response->putHeader(name, header.second.toString());
+            }
+        }
+        if (!entityTag.empty()) {
+            response->putHeader("ETag", entityTag);
+        }
+        return response;
+    }
+};
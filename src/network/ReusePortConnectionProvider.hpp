@@ -0,0 +1,152 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <oatpp/network/ConnectionProvider.hpp>
+#include <oatpp/network/tcp/Connection.hpp>
+
+// TCP listening socket for one accept loop (see AcceptorGroup)
+// oatpp's tcp::server::ConnectionProvider binds 0.0.0.0-style addresses only with a fixed backlog and without
+// SO_REUSEPORT, so several of them can't share a port. With reusePort every socket of the group is bound to the same
+// address and the kernel spreads incoming connections among them, each accepted by its own thread.
+// The host may be a name or an IPv4 / IPv6 address.
+class ReusePortConnectionProvider : public oatpp::network::ServerConnectionProvider {
+public:
+    struct Options {
+        std::string host = "0.0.0.0";
+        uint16_t port = 8000;
+        // Pending connections the kernel queues before accept, capped by net.core.somaxconn
+        int backlog = 4096;
+        // Lets other sockets with the option bind the same address; required for more than one acceptor
+        bool reusePort = false;
+    };
+
+    // How long get() waits for a connection before it returns to let the Server check whether it was stopped
+    static constexpr int kAcceptTimeoutMillis = 1000;
+
+    explicit ReusePortConnectionProvider(const Options& options)
+        : handle_(openListener(options)) {
+        setProperty(PROPERTY_HOST, options.host);
+        setProperty(PROPERTY_PORT, std::to_string(options.port));
+    }
+
+    ~ReusePortConnectionProvider() override {
+        stop();
+        ::close(handle_);
+    }
+
+    static std::shared_ptr<ReusePortConnectionProvider> createShared(const Options& options) {
+        return std::make_shared<ReusePortConnectionProvider>(options);
+    }
+
+    // The next accepted connection, nullptr on timeout, failure or once stopped
+    oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream> get() override {
+        if (closed_) {
+            return nullptr;
+        }
+        pollfd listener{handle_, POLLIN, 0};
+        if (::poll(&listener, 1, kAcceptTimeoutMillis) <= 0 || closed_) {
+            return nullptr;
+        }
+        auto client = ::accept(handle_, nullptr, nullptr);
+        if (client < 0) {
+            return nullptr;
+        }
+#ifdef SO_NOSIGPIPE
+        int yes = 1;
+        ::setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+        return oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>(
+            std::make_shared<oatpp::network::tcp::Connection>(client), invalidator_);
+    }
+
+    // Both serving modes accept through get() on the Server's thread
+    oatpp::async::CoroutineStarterForResult<const oatpp::provider::ResourceHandle<oatpp::data::stream::IOStream>&>
+    getAsync() override {
+        throw std::runtime_error("ReusePortConnectionProvider::getAsync() is not supported");
+    }
+
+    // Wakes up a get() in progress; the socket is closed with the provider, so its descriptor can't be reused
+    // by another file while get() still polls it
+    void stop() override {
+        if (!closed_.exchange(true)) {
+            ::shutdown(handle_, SHUT_RDWR);
+        }
+    }
+
+private:
+    // Shuts a connection down when the connection handler gives up on it; the descriptor is closed by the
+    // Connection's destructor
+    class ConnectionInvalidator : public oatpp::provider::Invalidator<oatpp::data::stream::IOStream> {
+    public:
+        void invalidate(const std::shared_ptr<oatpp::data::stream::IOStream>& connection) override {
+            auto tcp = std::static_pointer_cast<oatpp::network::tcp::Connection>(connection);
+            ::shutdown(tcp->getHandle(), SHUT_RDWR);
+        }
+    };
+
+    int handle_;
+    std::atomic<bool> closed_{false};
+    std::shared_ptr<ConnectionInvalidator> invalidator_ = std::make_shared<ConnectionInvalidator>();
+
+    static int openListener(const Options& options) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_flags = AI_PASSIVE;
+        addrinfo* addresses = nullptr;
+        auto port = std::to_string(options.port);
+        auto name = options.host + ":" + port;
+        if (auto status = ::getaddrinfo(options.host.c_str(), port.c_str(), &hints, &addresses); status != 0) {
+            throw std::runtime_error("Failed to resolve " + name + ": " + ::gai_strerror(status));
+        }
+
+        // The first address that can be listened on wins, as with oatpp's provider
+        std::string error = "no address";
+        int handle = -1;
+        for (auto* address = addresses; address && handle < 0; address = address->ai_next) {
+            handle = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (handle < 0) {
+                error = std::strerror(errno);
+                continue;
+            }
+            int yes = 1;
+            bool ready = ::setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) == 0;
+            if (ready && options.reusePort) {
+#ifdef SO_REUSEPORT
+                ready = ::setsockopt(handle, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes)) == 0;
+#else
+                ::close(handle);
+                ::freeaddrinfo(addresses);
+                throw std::runtime_error("Failed to listen on " + name + ": SO_REUSEPORT is not supported");
+#endif
+            }
+            ready = ready && ::bind(handle, address->ai_addr, address->ai_addrlen) == 0 &&
+                    ::listen(handle, options.backlog) == 0;
+            if (!ready) {
+                error = std::strerror(errno);
+                ::close(handle);
+                handle = -1;
+            }
+        }
+        ::freeaddrinfo(addresses);
+        if (handle < 0) {
+            throw std::runtime_error("Failed to listen on " + name + ": " + error);
+        }
+        return handle;
+    }
+};
@@ -0,0 +1,114 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ContactDto.hpp"
+#include "repository/ContactRepository.hpp"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// The most recent repository changes, numbered by a sequence that only grows
+// Fed by a repository change listener, so the changes of one contact are in the order they were applied.
+// Kept in a ring buffer of fixed capacity: past it the oldest events are overwritten, and a reader that
+// asks for events which are gone is told that it lagged behind (see Read) instead of silently missing them.
+// Sequences start over with the process, like contact versions (see ContactRepository::epoch).
+class ChangeLog {
+public:
+    struct Event {
+        uint64_t sequence = 0;
+        ContactRepository::ContactChange change;
+    };
+
+    struct Read {
+        std::vector<Event> events;
+        // Some of the requested events were overwritten or never existed; events is empty then and the
+        // reader continues after last, having re-read the directory
+        bool lagged = false;
+        // Newest sequence at the time of the read
+        uint64_t last = 0;
+    };
+
+    // capacity - number of events kept
+    explicit ChangeLog(size_t capacity)
+        : events_(std::max<size_t>(1, capacity)) {}
+
+    ChangeLog(const ChangeLog&) = delete;
+    ChangeLog& operator=(const ChangeLog&) = delete;
+
+    // Called from the repository under the changed contact's shard lock
+    // The contact is copied: the repository hands out the caller's DTO, which the caller may reuse
+    void append(const ContactRepository::ContactChange& change) {
+        Event event{0, change};
+        if (change.contact) {
+            auto contact = ContactDto::createShared();
+            contact->id = change.contact->id;
+            contact->name = change.contact->name;
+            contact->phone = change.contact->phone;
+            contact->address = change.contact->address;
+            event.change.contact = contact;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            event.sequence = ++last_;
+            events_[event.sequence % events_.size()] = std::move(event);
+        }
+        appended_.notify_all();
+    }
+
+    // Up to maxEvents events with a sequence above after, oldest first
+    Read readAfter(uint64_t after, size_t maxEvents) const {
+        Read read;
+        std::lock_guard<std::mutex> lock(mutex_);
+        read.last = last_;
+        if (after > last_ || after + 1 < firstLocked()) {
+            read.lagged = true;
+            return read;
+        }
+        auto end = std::min(last_, after + maxEvents);
+        read.events.reserve(static_cast<size_t>(end - after));
+        for (auto sequence = after + 1; sequence <= end; ++sequence) {
+            read.events.push_back(events_[sequence % events_.size()]);
+        }
+        return read;
+    }
+
+    // Blocks until an event with a sequence above after is appended; false if timeout expires first
+    template<typename Rep, typename Period>
+    bool waitAfter(uint64_t after, std::chrono::duration<Rep, Period> timeout) const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return appended_.wait_for(lock, timeout, [this, after] {
+            return last_ != after;
+        });
+    }
+
+    uint64_t lastSequence() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_;
+    }
+
+    // Oldest sequence still kept, lastSequence() + 1 while the log is empty
+    uint64_t firstSequence() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return firstLocked();
+    }
+
+    size_t capacity() const {
+        return events_.size();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    mutable std::condition_variable appended_;
+    std::vector<Event> events_;
+    uint64_t last_ = 0;
+
+    uint64_t firstLocked() const {
+        return last_ >= events_.size() ? last_ - events_.size() + 1 : 1;
+    }
+};
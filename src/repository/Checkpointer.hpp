@@ -0,0 +1,124 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "repository/ContactRepository.hpp"
+#include "storage/SnapshotFile.hpp"
+#include <oatpp/core/base/Environment.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Writes repository snapshot files in the background and drops the journal records they cover
+// A checkpoint is taken when the interval has passed since the last one, or earlier when the journal
+// grows past a size limit; it works on a published ContactSnapshot, so writers are not blocked.
+class Checkpointer {
+public:
+    Checkpointer(std::shared_ptr<ContactRepository> repository,
+                 std::string path,
+                 std::chrono::seconds interval,
+                 uint64_t journalLimit)
+        : repository_(std::move(repository))
+        , path_(std::move(path))
+        , interval_(interval)
+        , journalLimit_(journalLimit)
+        , lastSequence_(repository_->baseJournalSequence()) {}
+
+    ~Checkpointer() {
+        stop();
+    }
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) {
+            thread_ = std::thread([this] { run(); });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeUp_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    // Writes a snapshot file unless nothing was journaled since the last one (or since the file the
+    // repository started from); returns true if a file was written
+    bool checkpoint() {
+        std::lock_guard<std::mutex> lock(checkpointMutex_);
+        auto snapshot = repository_->snapshot();
+        auto sequence = snapshot->journalSequence();
+        if (sequence == lastSequence_) {
+            return false;
+        }
+        // The file must only hold durable changes: wait for the records it covers, this throws after
+        // a journal error, when the snapshot may hold a change that was never journaled
+        if (repository_->log()) {
+            repository_->log()->sync(sequence);
+        }
+        SnapshotFile::write(path_, *snapshot, sequence);
+        if (repository_->log()) {
+            repository_->log()->discardThrough(sequence);
+        }
+        lastSequence_ = sequence;
+        return true;
+    }
+
+private:
+    static constexpr auto kPollInterval = std::chrono::seconds(1);
+
+    std::shared_ptr<ContactRepository> repository_;
+    std::string path_;
+    std::chrono::seconds interval_;
+    uint64_t journalLimit_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    std::thread thread_;
+    bool stopping_ = false;
+
+    // Serializes checkpoints between the background thread and direct calls
+    std::mutex checkpointMutex_;
+    uint64_t lastSequence_;
+
+    bool due(std::chrono::steady_clock::time_point lastCheckpoint) const {
+        auto& log = repository_->log();
+        if (log && journalLimit_ > 0 && log->size() >= journalLimit_) {
+            return true;
+        }
+        return interval_.count() > 0 && std::chrono::steady_clock::now() - lastCheckpoint >= interval_;
+    }
+
+    void run() {
+        auto lastCheckpoint = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            wakeUp_.wait_for(lock, kPollInterval, [this] { return stopping_; });
+            if (stopping_ || !due(lastCheckpoint)) {
+                continue;
+            }
+            lock.unlock();
+            try {
+                checkpoint();
+            } catch (const std::exception& e) {
+                OATPP_LOGE("Checkpointer", "Checkpoint failed: %s", e.what());
+            }
+            lastCheckpoint = std::chrono::steady_clock::now();
+            lock.lock();
+        }
+    }
+};
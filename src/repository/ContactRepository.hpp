@@ -5,104 +5,1258 @@
 #pragma once
 
 #include "dto/ContactDto.hpp"
+#include "metrics/MeteredSharedMutex.hpp"
+#include "repository/ContactSnapshot.hpp"
+#include "repository/ModificationLog.hpp"
+#include "repository/NameIndex.hpp"
+#include "repository/PhoneIndex.hpp"
+#include "repository/TrigramIndex.hpp"
+#include "storage/CompactContactStore.hpp"
+#include "storage/SnapshotFile.hpp"
+#include "storage/StringPool.hpp"
+#include "storage/WriteAheadLog.hpp"
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
 #include <vector>
-#include <unordered_map>
 #include <oatpp/core/Types.hpp>
 
 // Repository for working with contacts in memory (basic CRUD operations)
 // First layer for working with data before Service level
 // Could use a database, but for a test task this is sufficient
+//
+// Storage is split into independently locked shards keyed by id, so point reads
+// on different (or the same) ids run in parallel and only writers to the same shard
+// serialize. Shard count is rounded up to a power of two.
+// Each shard keeps its contacts in a CompactContactStore (fixed-width records in copy-on-write id-ordered
+// pages, packed strings, dictionary-encoded addresses); DTOs are materialized only when a contact leaves the repository.
+// List reads work on a published ContactSnapshot instead of holding locks while copying.
+//
+// Secondary indexes (name, name trigrams, phone) are updated under the shard lock of the changed contact;
+// lock order is always shard -> index.
+//
+// With a WriteAheadLog attached, every change is journaled while its shard lock is held (so records
+// of one contact are in change order) and the write returns once the record is durable; waiting
+// happens after the shard lock is released, which lets concurrent writers share one fsync.
+// Durability covers the acknowledgement, not visibility: a change is seen by readers, listeners and
+// snapshots as soon as it is applied. If the journal write fails, the writer gets the error while the
+// change stays in memory; the failed log then rejects every later write, so the repository is read-only
+// until restarted, and the Checkpointer writes no more snapshot files, so the change is never persisted.
+// On construction the journal is replayed; test data is only seeded into an empty journal.
+//
+// Startup from a SnapshotFile: the memory-mapped file is the base layer and only the journal tail
+// (records after the snapshot's sequence) is replayed, so point reads are served right away.
+// A background thread then copies the base records into the shards ("hydration"). Until a shard is
+// hydrated, a contact missing from its store is looked up in the file, and a write first promotes
+// the file's copy into the store and marks the id overridden so that hydration leaves it alone.
+// Listing, search and the phone uniqueness check need complete indexes and wait for hydration.
 class ContactRepository {
 public:
-    ContactRepository(): nextId_(1) {
-        seedTestData();
+    static constexpr size_t kDefaultShardCount = 16;
+
+    // Reason of a failed create/update/patch
+    enum class Conflict {
+        None,
+        NotFound,
+        DuplicateId,
+        DuplicatePhone,
+        // The contact's version is not the one a patch was based on
+        VersionMismatch
+    };
+
+    // Orders of the listing, each served by an ordered structure the repository maintains:
+    // id by the shards' id-ordered record pages (read through a snapshot), name by NameIndex, phone by PhoneIndex
+    enum class SortKey {
+        Id,
+        Name,
+        Phone
+    };
+
+    // Outcome of one item of a batch create/update: the stored contact, or nullptr and the reason
+    struct BatchResult {
+        oatpp::Object<ContactDto> contact;
+        Conflict conflict = Conflict::None;
+    };
+
+    // A committed change of one contact
+    // contact is the new contents of a put (nullptr for a remove); listeners must not modify it
+    struct ContactChange {
+        enum class Kind {
+            Put,
+            Remove
+        };
+
+        Kind kind;
+        int64_t id;
+        uint64_t version;
+        oatpp::Object<ContactDto> contact;
+    };
+
+    // Called while the changed contact's shard lock is held, so changes of one contact arrive in order;
+    // a listener must be quick and must not call back into the repository
+    using ChangeListener = std::function<void(const ContactChange&)>;
+
+    // Approximate heap footprint by component, in bytes
+    struct MemoryStats {
+        size_t contacts = 0;
+        size_t records = 0;
+        size_t idIndex = 0;
+        size_t strings = 0;
+        size_t dictionary = 0;
+        size_t nameIndex = 0;
+        size_t trigramIndex = 0;
+        size_t phoneIndex = 0;
+        size_t modifications = 0;
+
+        size_t storage() const {
+            return records + idIndex + strings + dictionary;
+        }
+
+        size_t total() const {
+            return storage() + nameIndex + trigramIndex + phoneIndex + modifications;
+        }
+    };
+
+    // Result of changesSince
+    struct ChangeSet {
+        // Created or updated contacts, oldest change first
+        std::vector<oatpp::Object<ContactDto>> contacts;
+        std::vector<int64_t> removed;
+        // Repository version the changes are complete up to, where the next delta starts
+        uint64_t version = 0;
+        // The limit was reached: the next delta, from version, returns the rest
+        bool more = false;
+    };
+
+    explicit ContactRepository(size_t shardCount = kDefaultShardCount,
+                               bool uniquePhones = false,
+                               std::shared_ptr<WriteAheadLog> log = nullptr,
+                               std::shared_ptr<const SnapshotFile> base = nullptr)
+        : pool_(std::make_shared<StringPool>())
+        , shardMask_(roundUpToPowerOfTwo(shardCount) - 1)
+        , nextId_(1)
+        , version_(0)
+        , epoch_(generateEpoch())
+        , phoneIndex_(uniquePhones) {
+        for (size_t i = 0; i <= shardMask_; ++i) {
+            shards_.push_back(std::make_unique<Shard>(pool_));
+        }
+        log_ = std::move(log);
+        base_ = std::move(base);
+
+        if (base_) {
+            baseJournalSequence_ = base_->journalSequence();
+            hydrating_ = true;
+            for (auto& shard : shards_) {
+                shard->hydrated = false;
+            }
+            raiseNextId(base_->maxId() + 1);
+        }
+
+        size_t replayed = 0;
+        if (log_) {
+            replayed = log_->replay([this](const LogEntry& entry) {
+                if (entry.sequence > baseJournalSequence_) {
+                    applyLogged(entry);
+                }
+            });
+            log_->advanceSequence(baseJournalSequence_);
+        }
+
+        if (base_) {
+            hydrator_ = std::thread([this] { hydrate(); });
+        } else if (replayed == 0) {
+            seedTestData();
+        }
     }
 
-    // oatpp::Object<ContactDto> <=> std::shared_ptr<ContactDto>
-    oatpp::Object<ContactDto> create(const oatpp::Object<ContactDto>& contact) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    ~ContactRepository() {
+        stopping_ = true;
+        if (hydrator_.joinable()) {
+            hydrator_.join();
+        }
+    }
+
+    ContactRepository(const ContactRepository&) = delete;
+    ContactRepository& operator=(const ContactRepository&) = delete;
 
+    // oatpp::Object<ContactDto> <=> std::shared_ptr<ContactDto>
+    // Returns nullptr on failure, the reason is reported through conflict if given
+    oatpp::Object<ContactDto> create(const oatpp::Object<ContactDto>& contact, Conflict* conflict = nullptr) {
+        setConflict(conflict, Conflict::None);
+        checkWritable();
+        if (phoneIndex_.isUnique()) {
+            waitHydrated();
+        }
         auto newContact = ContactDto::createShared();
         newContact->name = contact->name;
         newContact->phone = contact->phone;
         newContact->address = contact->address;
 
         if (!contact->id || *contact->id == 0) {
-            newContact->id = ++nextId_;
-        } else {
-            auto idValue = *contact->id;
-            if (storage_.contains(idValue)) {
+            // An explicit id may be inserted between allocation and locking the shard,
+            // so keep allocating until a free id is claimed
+            while (true) {
+                int64_t idValue = ++nextId_;
+                auto& shard = shardFor(idValue);
+                uint64_t sequence;
+                {
+                    std::unique_lock lock(shard.mutex);
+                    promoteLocked(shard, idValue);
+                    if (shard.store.contains(idValue)) {
+                        continue;
+                    }
+                    newContact->id = idValue;
+                    if (!insertLocked(shard, newContact)) {
+                        setConflict(conflict, Conflict::DuplicatePhone);
+                        return nullptr;
+                    }
+                    sequence = logPut(newContact);
+                }
+                awaitDurable(sequence);
+                return newContact;
+            }
+        }
+
+        auto idValue = *contact->id;
+        auto& shard = shardFor(idValue);
+        uint64_t sequence;
+        {
+            std::unique_lock lock(shard.mutex);
+            promoteLocked(shard, idValue);
+            if (shard.store.contains(idValue)) {
+                setConflict(conflict, Conflict::DuplicateId);
                 return nullptr;
             }
             newContact->id = idValue;
-            nextId_ = std::max(nextId_.load(), idValue + 1);
+            if (!insertLocked(shard, newContact)) {
+                setConflict(conflict, Conflict::DuplicatePhone);
+                return nullptr;
+            }
+            sequence = logPut(newContact);
         }
-
-        storage_[newContact->id] = newContact;
+        raiseNextId(idValue + 1);
+        awaitDurable(sequence);
         return newContact;
     }
 
-    oatpp::Object<ContactDto> getById(oatpp::Int64 id) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (storage_.contains(id)) {
-            auto contact = ContactDto::createShared();
-            contact->id = id;
-            contact->name = storage_[id]->name;
-            contact->phone = storage_[id]->phone;
-            contact->address = storage_[id]->address;
-            return contact;
+    // The contact's version is reported through version if given
+    oatpp::Object<ContactDto> getById(oatpp::Int64 id, uint64_t* version = nullptr) {
+        if (!id) {
+            return nullptr;
+        }
+        auto& shard = shardFor(*id);
+        std::shared_lock lock(shard.mutex);
+        auto* record = shard.store.find(*id);
+        if (record) {
+            if (version) {
+                *version = record->version;
+            }
+            return shard.store.materialize(*record);
+        }
+        if (auto* baseRecord = baseRecordLocked(shard, *id)) {
+            if (version) {
+                *version = 0;
+            }
+            return base_->materialize(*baseRecord);
         }
         return nullptr;
     }
 
+    // Version of the contact's current contents without building a DTO, nullopt if it doesn't exist
+    // Changes whenever the contact is created, updated or re-created after a delete
+    std::optional<uint64_t> versionOf(int64_t id) {
+        auto& shard = shardFor(id);
+        std::shared_lock lock(shard.mutex);
+        if (auto* record = shard.store.find(id)) {
+            return record->version;
+        }
+        if (baseRecordLocked(shard, id)) {
+            return 0;
+        }
+        return std::nullopt;
+    }
+
     std::vector<oatpp::Object<ContactDto>> getAll() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        auto view = snapshot();
         std::vector<oatpp::Object<ContactDto>> result;
-        result.reserve(storage_.size());
+        result.reserve(view->size());
+
+        view->forEach([&result](const oatpp::Object<ContactDto>& contact) {
+            result.push_back(contact);
+        });
 
-        for (const auto& pair : storage_) {
-            auto contact = ContactDto::createShared();
-            contact->id = pair.second->id;
-            contact->name = pair.second->name;
-            contact->phone = pair.second->phone;
-            contact->address = pair.second->address;
-            result.push_back(std::move(contact));
+        return result;
+    }
+
+    // Returns a consistent point-in-time view of all contacts
+    // Repeated calls without intervening writes return the same published snapshot without locking
+    // shards while a reader still holds it; otherwise every shard's records and strings are captured by
+    // pointer under shared locks. Writers copy the pages they change afterwards (see RecordPages), so the
+    // capture costs O(shards) whatever the directory size, and writers are held up only that long.
+    std::shared_ptr<const ContactSnapshot> snapshot() {
+        waitHydrated();
+        auto current = publishedSnapshot();
+        if (current && current->version() == version_.load()) {
+            return current;
+        }
+
+        // One rebuild at a time, concurrent readers reuse its result
+        std::lock_guard<std::mutex> rebuildLock(rebuildMutex_);
+        current = publishedSnapshot();
+        if (current && current->version() == version_.load()) {
+            return current;
         }
 
+        // Allocated before the locks are taken, only pointers are copied under them
+        std::vector<std::shared_ptr<ContactShardView>> captured(shards_.size());
+        for (auto& view : captured) {
+            view = std::make_shared<ContactShardView>();
+        }
+        uint64_t version;
+        uint64_t journalSequence;
+        std::shared_ptr<const void> poolPin;
+        {
+            // Holding every shard lock at once gives a cut no writer is in the middle of
+            std::vector<std::shared_lock<MeteredSharedMutex>> locks;
+            locks.reserve(shards_.size());
+            for (auto& shard : shards_) {
+                locks.emplace_back(shard->mutex);
+            }
+            version = version_.load();
+            // Journal records are appended under a shard lock, so none is in flight here
+            journalSequence = log_ ? log_->lastSequence() : 0;
+            // Address components are released under a shard lock too, so the captured ones are all live
+            poolPin = pool_->pin();
+
+            for (size_t i = 0; i < shards_.size(); ++i) {
+                const auto& shard = *shards_[i];
+                captured[i]->version = shard.version;
+                captured[i]->records = shard.store.records();
+                captured[i]->chunks = shard.store.chunks();
+            }
+        }
+
+        std::vector<std::shared_ptr<const ContactShardView>> views(captured.begin(), captured.end());
+        auto result = std::make_shared<const ContactSnapshot>(version, std::move(views), pool_, journalSequence,
+                                                              std::move(poolPin));
+        {
+            std::lock_guard<std::mutex> lock(publishMutex_);
+            published_ = result;
+        }
         return result;
     }
 
-    oatpp::Object<ContactDto> update(const oatpp::Object<ContactDto>& contact) {
-        std::lock_guard<std::mutex> lock(mutex_);
+    // Incremented on every successful write
+    uint64_t version() const {
+        return version_.load();
+    }
 
-        auto it = storage_.find(contact->id);
-        if (it == storage_.end()) {
+    // Listeners are not synchronized with writers: register them before the repository is shared
+    void addChangeListener(ChangeListener listener) {
+        listeners_.push_back(std::move(listener));
+    }
+
+    // Random per-instance value; versions start over on restart, so they are only comparable within one epoch
+    uint64_t epoch() const {
+        return epoch_;
+    }
+
+    oatpp::Object<ContactDto> update(const oatpp::Object<ContactDto>& contact, Conflict* conflict = nullptr) {
+        setConflict(conflict, Conflict::NotFound);
+        if (!contact->id) {
             return nullptr;
         }
+        checkWritable();
+        if (phoneIndex_.isUnique()) {
+            waitHydrated();
+        }
+        auto& shard = shardFor(*contact->id);
+        uint64_t sequence;
+        {
+            std::unique_lock lock(shard.mutex);
+            promoteLocked(shard, *contact->id);
+            auto* record = shard.store.find(*contact->id);
+            if (!record) {
+                return nullptr;
+            }
+            if (!phoneIndex_.replace(shard.store.phoneKeyOf(*record), phoneKeyOf(contact), *contact->id)) {
+                setConflict(conflict, Conflict::DuplicatePhone);
+                return nullptr;
+            }
+            setConflict(conflict, Conflict::None);
 
-        it->second->name = contact->name;
-        it->second->phone = contact->phone;
-        it->second->address = contact->address;
+            reindexNameLocked(shard.store.nameOf(*record), textOf(contact->name), *contact->id);
+            auto version = markModified(shard);
+            shard.store.replace(contact, version);
+            notifyLocked(ContactChange::Kind::Put, *contact->id, version, contact);
+            sequence = logPut(contact);
+        }
+        awaitDurable(sequence);
 
-        auto updated = ContactDto::createShared();
-        updated->id = it->second->id;
-        updated->name = it->second->name;
-        updated->phone = it->second->phone;
-        updated->address = it->second->address;
-        return updated;
+        return copyOf(contact);
+    }
+
+    // Partial update: non-null fields of changes replace the stored ones, the id field is ignored
+    // With expectedVersion the patch is a compare-and-swap: it is applied only if the contact's version
+    // (see versionOf) still equals it, checked under the same shard lock that applies the change.
+    // The stored contact is returned and its new version reported through version if given
+    oatpp::Object<ContactDto> patch(int64_t id, const oatpp::Object<ContactDto>& changes,
+                                    std::optional<uint64_t> expectedVersion, Conflict* conflict = nullptr,
+                                    uint64_t* version = nullptr) {
+        setConflict(conflict, Conflict::NotFound);
+        checkWritable();
+        if (changes->phone && phoneIndex_.isUnique()) {
+            waitHydrated();
+        }
+        auto& shard = shardFor(id);
+        uint64_t sequence;
+        oatpp::Object<ContactDto> contact;
+        {
+            std::unique_lock lock(shard.mutex);
+            promoteLocked(shard, id);
+            auto* record = shard.store.find(id);
+            if (!record) {
+                return nullptr;
+            }
+            if (expectedVersion && record->version != *expectedVersion) {
+                setConflict(conflict, Conflict::VersionMismatch);
+                return nullptr;
+            }
+            contact = shard.store.materialize(*record);
+            if (changes->name) {
+                contact->name = changes->name;
+            }
+            if (changes->phone) {
+                contact->phone = changes->phone;
+            }
+            if (changes->address) {
+                contact->address = changes->address;
+            }
+            if (changes->phone &&
+                !phoneIndex_.replace(shard.store.phoneKeyOf(*record), phoneKeyOf(contact), id)) {
+                setConflict(conflict, Conflict::DuplicatePhone);
+                return nullptr;
+            }
+            setConflict(conflict, Conflict::None);
+
+            if (changes->name) {
+                reindexNameLocked(shard.store.nameOf(*record), textOf(contact->name), id);
+            }
+            auto newVersion = markModified(shard);
+            shard.store.replace(contact, newVersion);
+            notifyLocked(ContactChange::Kind::Put, id, newVersion, contact);
+            sequence = logPut(contact);
+            if (version) {
+                *version = newVersion;
+            }
+        }
+        awaitDurable(sequence);
+
+        return copyOf(contact);
     }
 
     bool remove(oatpp::Int64 id) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return storage_.erase(id) > 0;
+        if (!id) {
+            return false;
+        }
+        checkWritable();
+        auto& shard = shardFor(*id);
+        uint64_t sequence = 0;
+        {
+            std::unique_lock lock(shard.mutex);
+            promoteLocked(shard, *id);
+            auto* record = shard.store.find(*id);
+            if (!record) {
+                return false;
+            }
+            unindexNameLocked(shard.store.nameOf(*record), *id);
+            phoneIndex_.replace(shard.store.phoneKeyOf(*record), std::nullopt, *id);
+            shard.store.erase(*id);
+            notifyLocked(ContactChange::Kind::Remove, *id, markModified(shard), nullptr);
+            if (log_) {
+                sequence = log_->appendRemove(*id);
+            }
+        }
+        awaitDurable(sequence);
+        return true;
+    }
+
+    // Batch operations: items are grouped by shard and each shard is locked once for all of its items;
+    // within a shard items are applied in request order. The batch waits for the journal once, after
+    // the last record, so all of its records share one fsync. Results are in request order.
+    // A batch is not atomic: every item succeeds or fails on its own, as if written by a single call.
+
+    std::vector<BatchResult> createBatch(const std::vector<oatpp::Object<ContactDto>>& contacts) {
+        std::vector<BatchResult> results(contacts.size());
+        if (contacts.empty()) {
+            return results;
+        }
+        checkWritable();
+        if (phoneIndex_.isUnique()) {
+            waitHydrated();
+        }
+
+        std::vector<int64_t> ids(contacts.size());
+        for (size_t i = 0; i < contacts.size(); ++i) {
+            ids[i] = hasExplicitId(contacts[i]) ? *contacts[i]->id : ++nextId_;
+        }
+
+        std::vector<size_t> retry;
+        uint64_t sequence = 0;
+        int64_t maxExplicitId = 0;
+        auto groups = groupByShard(ids);
+        for (size_t s = 0; s < groups.size(); ++s) {
+            if (groups[s].empty()) {
+                continue;
+            }
+            auto& shard = *shards_[s];
+            std::unique_lock lock(shard.mutex);
+            for (auto i : groups[s]) {
+                bool explicitId = hasExplicitId(contacts[i]);
+                promoteLocked(shard, ids[i]);
+                if (shard.store.contains(ids[i])) {
+                    if (explicitId) {
+                        results[i].conflict = Conflict::DuplicateId;
+                    } else {
+                        retry.push_back(i);
+                    }
+                    continue;
+                }
+                auto newContact = copyOf(contacts[i]);
+                newContact->id = ids[i];
+                if (!insertLocked(shard, newContact)) {
+                    results[i].conflict = Conflict::DuplicatePhone;
+                    continue;
+                }
+                sequence = logPut(newContact);
+                results[i].contact = newContact;
+                if (explicitId) {
+                    maxExplicitId = std::max(maxExplicitId, ids[i]);
+                }
+            }
+        }
+        raiseNextId(maxExplicitId + 1);
+        awaitDurable(sequence);
+
+        // An allocated id was claimed by an explicit id in the meantime; allocate again one by one
+        for (auto i : retry) {
+            auto contact = copyOf(contacts[i]);
+            contact->id = nullptr;
+            results[i].contact = create(contact, &results[i].conflict);
+        }
+        return results;
+    }
+
+    std::vector<BatchResult> updateBatch(const std::vector<oatpp::Object<ContactDto>>& contacts) {
+        std::vector<BatchResult> results(contacts.size());
+        if (contacts.empty()) {
+            return results;
+        }
+        checkWritable();
+        if (phoneIndex_.isUnique()) {
+            waitHydrated();
+        }
+
+        std::vector<int64_t> ids(contacts.size());
+        for (size_t i = 0; i < contacts.size(); ++i) {
+            ids[i] = contacts[i]->id ? *contacts[i]->id : 0;
+        }
+
+        uint64_t sequence = 0;
+        auto groups = groupByShard(ids);
+        for (size_t s = 0; s < groups.size(); ++s) {
+            if (groups[s].empty()) {
+                continue;
+            }
+            auto& shard = *shards_[s];
+            std::unique_lock lock(shard.mutex);
+            for (auto i : groups[s]) {
+                const auto& contact = contacts[i];
+                if (!contact->id) {
+                    results[i].conflict = Conflict::NotFound;
+                    continue;
+                }
+                promoteLocked(shard, ids[i]);
+                auto* record = shard.store.find(ids[i]);
+                if (!record) {
+                    results[i].conflict = Conflict::NotFound;
+                    continue;
+                }
+                if (!phoneIndex_.replace(shard.store.phoneKeyOf(*record), phoneKeyOf(contact), ids[i])) {
+                    results[i].conflict = Conflict::DuplicatePhone;
+                    continue;
+                }
+                reindexNameLocked(shard.store.nameOf(*record), textOf(contact->name), ids[i]);
+                auto version = markModified(shard);
+                shard.store.replace(contact, version);
+                notifyLocked(ContactChange::Kind::Put, ids[i], version, contact);
+                sequence = logPut(contact);
+                results[i].contact = copyOf(contact);
+            }
+        }
+        awaitDurable(sequence);
+        return results;
+    }
+
+    // true for every id that was removed
+    std::vector<bool> removeBatch(const std::vector<int64_t>& ids) {
+        std::vector<bool> results(ids.size(), false);
+        if (ids.empty()) {
+            return results;
+        }
+        checkWritable();
+
+        uint64_t sequence = 0;
+        auto groups = groupByShard(ids);
+        for (size_t s = 0; s < groups.size(); ++s) {
+            if (groups[s].empty()) {
+                continue;
+            }
+            auto& shard = *shards_[s];
+            std::unique_lock lock(shard.mutex);
+            for (auto i : groups[s]) {
+                auto id = ids[i];
+                promoteLocked(shard, id);
+                auto* record = shard.store.find(id);
+                if (!record) {
+                    continue;
+                }
+                unindexNameLocked(shard.store.nameOf(*record), id);
+                phoneIndex_.replace(shard.store.phoneKeyOf(*record), std::nullopt, id);
+                shard.store.erase(id);
+                notifyLocked(ContactChange::Kind::Remove, id, markModified(shard), nullptr);
+                if (log_) {
+                    sequence = log_->appendRemove(id);
+                }
+                results[i] = true;
+            }
+        }
+        awaitDurable(sequence);
+        return results;
+    }
+
+    // Point reads of many ids with one shared lock per shard; nullptr for ids that don't exist
+    std::vector<oatpp::Object<ContactDto>> getByIds(const std::vector<int64_t>& ids) {
+        std::vector<oatpp::Object<ContactDto>> results(ids.size());
+        auto groups = groupByShard(ids);
+        for (size_t s = 0; s < groups.size(); ++s) {
+            if (groups[s].empty()) {
+                continue;
+            }
+            auto& shard = *shards_[s];
+            std::shared_lock lock(shard.mutex);
+            for (auto i : groups[s]) {
+                if (auto* record = shard.store.find(ids[i])) {
+                    results[i] = shard.store.materialize(*record);
+                } else if (auto* baseRecord = baseRecordLocked(shard, ids[i])) {
+                    results[i] = base_->materialize(*baseRecord);
+                }
+            }
+        }
+        return results;
+    }
+
+    // Contacts whose name starts with prefix (case-insensitive), ordered by name, served from the name index
+    std::vector<oatpp::Object<ContactDto>> findByNamePrefix(const oatpp::String& prefix, size_t limit) {
+        waitHydrated();
+        std::vector<oatpp::Object<ContactDto>> result;
+        auto key = NameIndex::normalize(*prefix);
+
+        for (auto id : nameIndex_.findByPrefix(*prefix, limit)) {
+            auto contact = getById(id);
+            // The contact may have been renamed or removed after the index was read
+            if (contact && NameIndex::normalize(textOf(contact->name)).compare(0, key.size(), key) == 0) {
+                result.push_back(std::move(contact));
+            }
+        }
+        return result;
+    }
+
+    // Contacts whose name matches every query word with a few typos, best match first (see TrigramIndex)
+    std::vector<oatpp::Object<ContactDto>> findByNameFuzzy(const std::string& text, size_t limit) {
+        waitHydrated();
+        std::vector<oatpp::Object<ContactDto>> result;
+        auto query = TrigramIndex::compile(text);
+        std::vector<int64_t> ids;
+        for (const auto& match : trigramIndex_.search(query, limit)) {
+            ids.push_back(match.id);
+        }
+        for (auto& contact : getByIds(ids)) {
+            // The contact may have been renamed or removed after the index was read
+            if (contact && TrigramIndex::distance(query, textOf(contact->name))) {
+                result.push_back(std::move(contact));
+            }
+        }
+        return result;
+    }
+
+    // One page of the directory in the given order, offset contacts in; no order sorts the directory per request
+    // Id order merges the shards' record pages through a snapshot, which shares them rather than copying, so a
+    // page costs O(shards * log n + offset + limit) even right after a write.
+    // Name and phone orders walk their live index in O(offset + limit); a contact changed while such a page is
+    // read is returned as it is now
+    std::vector<oatpp::Object<ContactDto>> sortedPage(SortKey key, bool descending, size_t offset, size_t limit) {
+        std::vector<oatpp::Object<ContactDto>> result;
+        if (key == SortKey::Id) {
+            auto view = snapshot();
+            ContactSnapshot::Cursor cursor(*view, descending ? std::numeric_limits<int64_t>::max()
+                                                             : std::numeric_limits<int64_t>::min(), descending);
+            for (size_t skipped = 0; skipped < offset; ++skipped) {
+                if (!cursor.nextId()) {
+                    return result;
+                }
+            }
+            while (result.size() < limit) {
+                auto contact = cursor.next();
+                if (!contact) {
+                    break;
+                }
+                result.push_back(std::move(contact));
+            }
+            return result;
+        }
+
+        waitHydrated();
+        return key == SortKey::Name ? indexedPage(nameIndex_, descending, offset, limit)
+                                    : indexedPage(phoneIndex_, descending, offset, limit);
+    }
+
+    // Contacts with exactly this phone number
+    std::vector<oatpp::Object<ContactDto>> findByPhone(const PhoneKey& phone, size_t limit) {
+        waitHydrated();
+        return resolvePhoneMatches(phoneIndex_.findExact(phone, limit), phone, true);
+    }
+
+    // Contacts whose phone number starts with the prefix digits (e.g. country and area code), in numeric order
+    std::vector<oatpp::Object<ContactDto>> findByPhonePrefix(const PhoneKey& prefix, size_t limit) {
+        waitHydrated();
+        return resolvePhoneMatches(phoneIndex_.findByPrefix(prefix, limit), prefix, false);
+    }
+
+    bool uniquePhones() const {
+        return phoneIndex_.isUnique();
+    }
+
+    size_t shardCount() const {
+        return shards_.size();
+    }
+
+    // Blocks until all contacts of the startup snapshot file are in memory; returns at once otherwise
+    void waitHydrated() {
+        std::unique_lock<std::mutex> lock(hydrationMutex_);
+        hydrationDone_.wait(lock, [this] { return !hydrating_; });
+    }
+
+    bool hydrated() {
+        std::lock_guard<std::mutex> lock(hydrationMutex_);
+        return !hydrating_;
+    }
+
+    // nullptr when the repository is not persistent
+    const std::shared_ptr<WriteAheadLog>& log() const {
+        return log_;
+    }
+
+    // Last journal record covered by the snapshot file the repository started from, 0 without one
+    uint64_t baseJournalSequence() const {
+        return baseJournalSequence_;
+    }
+
+    size_t size() {
+        waitHydrated();
+        size_t result = 0;
+        for (auto& shard : shards_) {
+            std::shared_lock lock(shard->mutex);
+            result += shard->store.size();
+        }
+        return result;
+    }
+
+    // Delta sync: the contacts changed and removed after repository version since, up to limit of them
+    // (0 - no limit). since 0 is a full sync, every contact from a snapshot.
+    // nullopt if changes after since may be incomplete: removals that old were compacted away (see
+    // ModificationLog), or since is newer than any version, e.g. taken before a restart; the client then
+    // starts over with a full sync.
+    // Shards are read one at a time. A change made while they are read has a version above the one reported
+    // and is left for the next delta; so is an older change of a contact that changed again meanwhile.
+    std::optional<ChangeSet> changesSince(uint64_t since, size_t limit = 0) {
+        waitHydrated();
+        ChangeSet result;
+        if (since == 0) {
+            auto view = snapshot();
+            result.version = view->version();
+            result.contacts.reserve(view->size());
+            view->forEach([&result](const oatpp::Object<ContactDto>& contact) {
+                result.contacts.push_back(contact);
+            });
+            return result;
+        }
+
+        // Every change up to upTo is applied by the time its shard lock is taken
+        auto upTo = version_.load();
+        if (since > upTo) {
+            return std::nullopt;
+        }
+        struct Found {
+            ModificationLog::Entry entry;
+            ContactRecord record;
+            size_t shard;
+        };
+        std::vector<Found> found;
+        std::vector<std::shared_ptr<const StringChunkList>> chunks(shards_.size());
+        // Taken before any record is copied, so that the address components of all of them stay readable
+        auto poolPin = pool_->pin();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            auto& shard = *shards_[i];
+            std::shared_lock lock(shard.mutex);
+            if (shard.modifications.horizon() > since) {
+                return std::nullopt;
+            }
+            // Each shard's oldest limit changes are enough to pick the oldest limit overall
+            size_t taken = 0;
+            shard.modifications.forEachBetween(since, upTo, [&](const ModificationLog::Entry& entry) {
+                auto* record = shard.store.find(entry.id);
+                if (!isCurrentLocked(entry, record)) {
+                    return true;
+                }
+                found.push_back({entry, record ? *record : ContactRecord{}, i});
+                if (++taken == limit) {
+                    result.more = true;
+                    return false;
+                }
+                return true;
+            });
+            // Records are copied, their strings stay readable through the chunk list
+            chunks[i] = shard.store.chunks();
+        }
+
+        std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) {
+            return a.entry.stamp < b.entry.stamp;
+        });
+        if (limit != 0 && found.size() >= limit) {
+            result.more = result.more || found.size() > limit;
+            found.resize(limit);
+        }
+        result.version = result.more ? found.back().entry.version() : upTo;
+
+        std::unordered_set<int64_t> removed;
+        for (const auto& item : found) {
+            if (!item.entry.removed()) {
+                result.contacts.push_back(
+                    CompactContactStore::materialize(item.record, *chunks[item.shard], *pool_));
+            } else if (removed.insert(item.entry.id).second) {
+                result.removed.push_back(item.entry.id);
+            }
+        }
+        return result;
+    }
+
+    // Removals kept for delta sync, per repository (see ModificationLog); call once, at startup
+    void setMaxTombstones(size_t maxTombstones) {
+        auto perShard = (maxTombstones + shards_.size() - 1) / shards_.size();
+        for (auto& shard : shards_) {
+            shard->modifications.setMaxTombstones(perShard);
+        }
+    }
+
+    // Starts sampling wait and hold times of the shard locks; call once, at startup
+    void enableLockMetrics() {
+        if (!lockTimes_) {
+            lockTimes_ = std::make_unique<LockTimes>();
+            for (auto& shard : shards_) {
+                shard->mutex.setTimes(lockTimes_.get());
+            }
+        }
+    }
+
+    // nullptr unless enableLockMetrics() was called
+    const LockTimes* lockTimes() const {
+        return lockTimes_.get();
+    }
+
+    MemoryStats memoryStats() {
+        waitHydrated();
+        MemoryStats stats;
+        for (auto& shard : shards_) {
+            std::shared_lock lock(shard->mutex);
+            auto usage = shard->store.memoryUsage();
+            stats.contacts += shard->store.size();
+            stats.records += usage.records;
+            stats.idIndex += usage.idIndex;
+            stats.strings += usage.strings;
+            stats.modifications += shard->modifications.memoryUsage();
+        }
+        stats.dictionary = pool_->memoryUsage();
+        stats.nameIndex = nameIndex_.memoryUsage();
+        stats.trigramIndex = trigramIndex_.memoryUsage();
+        stats.phoneIndex = phoneIndex_.memoryUsage();
+        return stats;
     }
 
 private:
-    std::unordered_map<oatpp::Int64, oatpp::Object<ContactDto>> storage_;
-    std::mutex mutex_;
+    // Aligned to a cache line so that locks of neighbouring shards don't false-share
+    struct alignas(64) Shard {
+        explicit Shard(const std::shared_ptr<StringPool>& pool)
+            : store(pool) {}
+
+        MeteredSharedMutex mutex;
+        CompactContactStore store;
+        uint64_t version = 0;
+        // False until the base snapshot file's records of this shard are copied into the store
+        bool hydrated = true;
+        // Ids changed since startup, whose base file records are stale
+        std::unordered_set<int64_t> overridden;
+        // Changes in version order, for delta sync
+        ModificationLog modifications;
+    };
+
+    // Dictionary of address components shared by all shards
+    std::shared_ptr<StringPool> pool_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t shardMask_;
     std::atomic<int64_t> nextId_;
+    std::atomic<uint64_t> version_;
+    const uint64_t epoch_;
+    NameIndex nameIndex_;
+    TrigramIndex trigramIndex_;
+    PhoneIndex phoneIndex_;
+    std::shared_ptr<WriteAheadLog> log_;
+    std::vector<ChangeListener> listeners_;
+
+    std::unique_ptr<LockTimes> lockTimes_;
+
+    std::shared_ptr<const SnapshotFile> base_;
+    // Kept apart from base_, which the hydrator drops once it is done
+    uint64_t baseJournalSequence_ = 0;
+    std::thread hydrator_;
+    std::atomic<bool> stopping_{false};
+    std::mutex hydrationMutex_;
+    std::condition_variable hydrationDone_;
+    bool hydrating_ = false;
+
+    std::mutex rebuildMutex_;
+    // Guards only the copy of the published pointer, never held while iterating
+    std::mutex publishMutex_;
+    // Not owned: an unused old snapshot would pin the StringPool and hold back every entry released after it
+    std::weak_ptr<const ContactSnapshot> published_;
+
+    static uint64_t generateEpoch() {
+        std::random_device device;
+        auto time = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+        return ((static_cast<uint64_t>(device()) << 32) | device()) ^ time;
+    }
+
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    static oatpp::Object<ContactDto> copyOf(const oatpp::Object<ContactDto>& source) {
+        auto contact = ContactDto::createShared();
+        contact->id = source->id;
+        contact->name = source->name;
+        contact->phone = source->phone;
+        contact->address = source->address;
+        return contact;
+    }
+
+    static bool hasExplicitId(const oatpp::Object<ContactDto>& contact) {
+        return contact->id && *contact->id != 0;
+    }
+
+    // Item positions per shard, in item order
+    std::vector<std::vector<size_t>> groupByShard(const std::vector<int64_t>& ids) const {
+        std::vector<std::vector<size_t>> groups(shards_.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            groups[static_cast<uint64_t>(ids[i]) & shardMask_].push_back(i);
+        }
+        return groups;
+    }
+
+    std::shared_ptr<const ContactSnapshot> publishedSnapshot() {
+        std::lock_guard<std::mutex> lock(publishMutex_);
+        return published_.lock();
+    }
+
+    // Name indexes: ordered for prefix search, trigrams for fuzzy search
+    // Must be called with the shard's exclusive lock held
+    void indexNameLocked(const std::string& name, int64_t id) {
+        nameIndex_.insert(name, id);
+        trigramIndex_.insert(name, id);
+    }
+
+    void unindexNameLocked(const std::string& name, int64_t id) {
+        nameIndex_.erase(name, id);
+        trigramIndex_.erase(name, id);
+    }
+
+    // Most updates keep the name, then the indexes are left alone
+    void reindexNameLocked(const std::string& before, const std::string& after, int64_t id) {
+        if (before != after) {
+            unindexNameLocked(before, id);
+            indexNameLocked(after, id);
+        }
+    }
+
+    // Must be called with the shard's exclusive lock held
+    // Fails only on a phone uniqueness violation
+    bool insertLocked(Shard& shard, const oatpp::Object<ContactDto>& contact) {
+        if (!phoneIndex_.replace(std::nullopt, phoneKeyOf(contact), *contact->id)) {
+            return false;
+        }
+        indexNameLocked(textOf(contact->name), *contact->id);
+        auto version = markModified(shard);
+        shard.store.insert(contact, version);
+        notifyLocked(ContactChange::Kind::Put, *contact->id, version, contact);
+        return true;
+    }
+
+    // Must be called with the shard's exclusive lock held, right after the change is applied
+    // Returns the journal sequence number to wait for, 0 without a journal
+    uint64_t logPut(const oatpp::Object<ContactDto>& contact) {
+        return log_ ? log_->appendPut(contact) : 0;
+    }
+
+    // Must be called without shard locks held
+    void awaitDurable(uint64_t sequence) {
+        if (log_) {
+            log_->sync(sequence);
+        }
+    }
+
+    // Rejects a write before it changes anything if the journal can no longer record it
+    void checkWritable() {
+        if (log_) {
+            log_->checkWritable();
+        }
+    }
+
+    // Journal replay: puts are upserts and constraints are not checked, the journal only holds
+    // changes that were accepted when they were made
+    void applyLogged(const LogEntry& entry) {
+        auto& shard = shardFor(entry.id);
+        std::unique_lock lock(shard.mutex);
+        promoteLocked(shard, entry.id);
+        if (auto* record = shard.store.find(entry.id)) {
+            unindexNameLocked(shard.store.nameOf(*record), entry.id);
+            phoneIndex_.replace(shard.store.phoneKeyOf(*record), std::nullopt, entry.id);
+            shard.store.erase(entry.id);
+        }
+        if (entry.op == LogEntry::Op::Put) {
+            insertUncheckedLocked(shard, entry.contact, false);
+        } else {
+            notifyLocked(ContactChange::Kind::Remove, entry.id, markModified(shard), nullptr);
+        }
+        raiseNextId(entry.id + 1);
+    }
+
+    // Must be called with the shard's exclusive lock held
+    // A contact copied from the base file keeps contact version 0, the version it was served with from the file
+    void insertUncheckedLocked(Shard& shard, const oatpp::Object<ContactDto>& contact, bool fromBase) {
+        phoneIndex_.replace(std::nullopt, phoneKeyOf(contact), *contact->id, false);
+        indexNameLocked(textOf(contact->name), *contact->id);
+        auto version = markModified(shard);
+        if (fromBase) {
+            shard.store.insert(contact, 0);
+            return;
+        }
+        shard.store.insert(contact, version);
+        notifyLocked(ContactChange::Kind::Put, *contact->id, version, contact);
+    }
+
+    // Must be called with the shard's lock held
+    // The base file's record of id, if the shard still serves it from the file
+    const SnapshotRecord* baseRecordLocked(Shard& shard, int64_t id) const {
+        if (shard.hydrated || shard.overridden.contains(id)) {
+            return nullptr;
+        }
+        return base_->find(id);
+    }
+
+    // Must be called with the shard's exclusive lock held, before changing id
+    // Moves the base file's record of id into the store, so that the change applies to it
+    // The shard may already hold it: hydration marks a shard hydrated only after its last batch
+    void promoteLocked(Shard& shard, int64_t id) {
+        if (shard.hydrated) {
+            return;
+        }
+        auto* record = baseRecordLocked(shard, id);
+        shard.overridden.insert(id);
+        if (record && !shard.store.contains(id)) {
+            insertUncheckedLocked(shard, base_->materialize(*record), true);
+        }
+    }
+
+    // Background copy of the base file into the shards, in batches so that writers are not blocked for long
+    void hydrate() {
+        static constexpr size_t kBatchSize = 4096;
+        base_->adviseSequential();
+
+        std::vector<std::vector<const SnapshotRecord*>> batches(shards_.size());
+        for (size_t start = 0; start < base_->size(); start += kBatchSize) {
+            if (stopping_) {
+                return;
+            }
+            auto end = std::min(base_->size(), start + kBatchSize);
+            for (size_t ordinal = start; ordinal < end; ++ordinal) {
+                const auto& record = base_->record(ordinal);
+                batches[static_cast<uint64_t>(record.id) & shardMask_].push_back(&record);
+            }
+            for (size_t i = 0; i < shards_.size(); ++i) {
+                if (batches[i].empty()) {
+                    continue;
+                }
+                auto& shard = *shards_[i];
+                std::unique_lock lock(shard.mutex);
+                for (const auto* record : batches[i]) {
+                    if (!shard.overridden.contains(record->id)) {
+                        insertUncheckedLocked(shard, base_->materialize(*record), true);
+                    }
+                }
+                batches[i].clear();
+            }
+        }
+
+        for (auto& shard : shards_) {
+            std::unique_lock lock(shard->mutex);
+            shard->hydrated = true;
+            shard->overridden = {};
+        }
+        // No shard reads the file any more
+        base_.reset();
+
+        std::lock_guard<std::mutex> lock(hydrationMutex_);
+        hydrating_ = false;
+        hydrationDone_.notify_all();
+    }
+
+    static std::optional<PhoneKey> phoneKeyOf(const oatpp::Object<ContactDto>& contact) {
+        if (!contact->phone) {
+            return std::nullopt;
+        }
+        return PhoneKey::parse(*contact->phone);
+    }
+
+    static void setConflict(Conflict* conflict, Conflict value) {
+        if (conflict) {
+            *conflict = value;
+        }
+    }
+
+    // Page of an ordered index (NameIndex or PhoneIndex) resolved to contacts
+    // A contact removed after the index was read leaves a gap, which is filled from the entries after the last
+    // one read, until the page has limit contacts or the index has no more
+    template<typename Index>
+    std::vector<oatpp::Object<ContactDto>> indexedPage(const Index& index, bool descending, size_t offset,
+                                                       size_t limit) {
+        std::vector<oatpp::Object<ContactDto>> result;
+        typename Index::Key last;
+        auto ids = index.page(offset, limit, descending, &last);
+        while (!ids.empty()) {
+            auto requested = limit - result.size();
+            for (auto& contact : getByIds(ids)) {
+                if (contact) {
+                    result.push_back(std::move(contact));
+                }
+            }
+            if (result.size() == limit || ids.size() < requested) {
+                break;
+            }
+            ids = index.pageAfter(last, limit - result.size(), descending, &last);
+        }
+        return result;
+    }
+
+    // Index hits are re-checked against the current record, which may have changed since the index was read
+    std::vector<oatpp::Object<ContactDto>> resolvePhoneMatches(const std::vector<int64_t>& ids,
+                                                               const PhoneKey& prefix,
+                                                               bool exact) {
+        std::vector<oatpp::Object<ContactDto>> result;
+        result.reserve(ids.size());
+        for (auto id : ids) {
+            auto contact = getById(id);
+            if (!contact) {
+                continue;
+            }
+            auto key = phoneKeyOf(contact);
+            if (!key || (exact && key->length != prefix.length)) {
+                continue;
+            }
+            if (key->length >= prefix.length &&
+                key->digits / PhoneKey::pow10(key->length - prefix.length) == prefix.digits) {
+                result.push_back(std::move(contact));
+            }
+        }
+        return result;
+    }
+
+    // Must be called with the shard's exclusive lock held, after the change is applied
+    // Also records the change in the shard's modification log
+    void notifyLocked(ContactChange::Kind kind, int64_t id, uint64_t version, const oatpp::Object<ContactDto>& contact) {
+        auto& shard = shardFor(id);
+        if (kind == ContactChange::Kind::Put) {
+            shard.modifications.put(version, id);
+        } else {
+            shard.modifications.remove(version, id);
+        }
+        shard.modifications.compactIfNeeded([&shard](const ModificationLog::Entry& entry) {
+            return isCurrentLocked(entry, shard.store.find(entry.id));
+        });
+
+        if (listeners_.empty()) {
+            return;
+        }
+        ContactChange change{kind, id, version, contact};
+        for (auto& listener : listeners_) {
+            listener(change);
+        }
+    }
+
+    // Must be called with the shard's lock held; record is the entry's contact as stored now
+    // A put is current while the contact still has its version, a tombstone while the contact doesn't exist
+    static bool isCurrentLocked(const ModificationLog::Entry& entry, const ContactRecord* record) {
+        return entry.removed() ? record == nullptr : record && record->version == entry.version();
+    }
+
+    // Must be called with the shard's exclusive lock held
+    // Returns the new repository version, which becomes the version of the changed contact
+    uint64_t markModified(Shard& shard) {
+        ++shard.version;
+        return ++version_;
+    }
+
+    // Fields are not validated at this level, missing strings are indexed as empty
+    static const std::string& textOf(const oatpp::String& value) {
+        static const std::string empty;
+        return value ? *value : empty;
+    }
+
+    Shard& shardFor(int64_t id) {
+        return *shards_[static_cast<uint64_t>(id) & shardMask_];
+    }
+
+    // Lock-free "nextId_ = max(nextId_, floor)"
+    void raiseNextId(int64_t floor) {
+        auto current = nextId_.load();
+        while (current < floor && !nextId_.compare_exchange_weak(current, floor)) {
+        }
+    }
 
     void seedTestData() {
         auto contact1 = ContactDto::createShared();
@@ -110,22 +1264,29 @@ private:
         contact1->name = oatpp::String("Ivan Ivanov");
         contact1->phone = oatpp::String("+79991234567");
         contact1->address = oatpp::String("Moscow, Lenin St., 1");
-        storage_[1] = contact1;
+        seedContact(contact1);
 
         auto contact2 = ContactDto::createShared();
         contact2->id = 2;
         contact2->name = oatpp::String("Maria Petrova");
         contact2->phone = oatpp::String("+79997654321");
         contact2->address = oatpp::String("Saint Petersburg, Nevsky Ave., 10");
-        storage_[2] = contact2;
+        seedContact(contact2);
 
         auto contact3 = ContactDto::createShared();
         contact3->id = 3;
         contact3->name = oatpp::String("Alexey Sidorov");
         contact3->phone = oatpp::String("+79995555555");
         contact3->address = oatpp::String("Kazan, Bauman St., 5");
-        storage_[3] = contact3;
+        auto sequence = seedContact(contact3);
 
         nextId_ = 4;
+        awaitDurable(sequence);
+    }
+
+    // Seeded contacts are journaled like any other, so they are not re-seeded after a restart
+    uint64_t seedContact(const oatpp::Object<ContactDto>& contact) {
+        insertLocked(shardFor(*contact->id), contact);
+        return logPut(contact);
     }
-};
\ No newline at end of file
+};
@@ -0,0 +1,190 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ContactDto.hpp"
+#include "storage/CompactContactStore.hpp"
+#include "storage/StringArena.hpp"
+#include "storage/StringPool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include <oatpp/core/Types.hpp>
+
+// Immutable contents of one repository shard at a given shard version
+// The records are the shard's own copy-on-write pages, in id order; their strings live in the captured chunk
+// list, which the shard only appends to, so the bytes stay valid for as long as the view holds it.
+struct ContactShardView {
+    uint64_t version = 0;
+    std::shared_ptr<const CompactContactStore::Records> records;
+    std::shared_ptr<const StringChunkList> chunks;
+};
+
+// Immutable point-in-time view of the whole repository
+// Published by ContactRepository::snapshot() and shared between readers; iteration takes no locks
+// and does not block writers. DTOs are materialized from compact records on the way out, one at a time.
+// Memory of an old snapshot is released when the last reader drops its pointer.
+class ContactSnapshot {
+public:
+    ContactSnapshot(uint64_t version,
+                    std::vector<std::shared_ptr<const ContactShardView>> shards,
+                    std::shared_ptr<const StringPool> pool,
+                    uint64_t journalSequence = 0,
+                    std::shared_ptr<const void> poolPin = nullptr)
+        : version_(version)
+        , journalSequence_(journalSequence)
+        , shards_(std::move(shards))
+        , pool_(std::move(pool))
+        , poolPin_(std::move(poolPin))
+        , size_(0) {
+        for (const auto& shard : shards_) {
+            size_ += shard->records->size();
+        }
+    }
+
+    uint64_t version() const {
+        return version_;
+    }
+
+    // Last journal record reflected in the snapshot, 0 for a repository without a journal
+    uint64_t journalSequence() const {
+        return journalSequence_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    // Number of contacts past afterId in walk order: with a greater id, or a smaller one when descending
+    size_t countAfter(int64_t afterId, bool descending = false) const {
+        size_t count = 0;
+        for (const auto& shard : shards_) {
+            const auto& records = *shard->records;
+            if (descending) {
+                count += records.size() - records.countFrom(records.lowerBound(afterId));
+            } else {
+                count += records.countFrom(records.upperBound(afterId));
+            }
+        }
+        return count;
+    }
+
+    const std::shared_ptr<const ContactShardView>& shard(size_t index) const {
+        return shards_[index];
+    }
+
+    size_t shardCount() const {
+        return shards_.size();
+    }
+
+    // Iteration in ascending (or descending) id order, starting after a given id
+    // Shards are individually sorted, so a k-way merge over them gives the global order.
+    // The cursor does not own the snapshot, the caller keeps it alive.
+    class Cursor {
+    public:
+        Cursor(const ContactSnapshot& snapshot, int64_t afterId, bool descending = false)
+            : snapshot_(&snapshot)
+            , descending_(descending)
+            , positions_(snapshot.shards_.size()) {
+            for (size_t i = 0; i < snapshot.shards_.size(); ++i) {
+                const auto& records = *snapshot.shards_[i]->records;
+                // A position is the next record to return; descending, that is the one before the bound
+                if (descending) {
+                    positions_[i] = records.lowerBound(afterId);
+                    if (records.previous(positions_[i])) {
+                        pushHead(i);
+                    }
+                } else {
+                    positions_[i] = records.upperBound(afterId);
+                    if (!records.isEnd(positions_[i])) {
+                        pushHead(i);
+                    }
+                }
+            }
+        }
+
+        // Returns nullptr when the snapshot is exhausted
+        oatpp::Object<ContactDto> next() {
+            auto* record = advance();
+            if (!record) {
+                return nullptr;
+            }
+            const auto& shard = *snapshot_->shards_[lastShard_];
+            return CompactContactStore::materialize(*record, *shard.chunks, *snapshot_->pool_);
+        }
+
+        // Same walk without building DTOs, for callers that only need ids
+        std::optional<int64_t> nextId() {
+            auto* record = advance();
+            if (!record) {
+                return std::nullopt;
+            }
+            return record->id;
+        }
+
+    private:
+        using Head = std::pair<int64_t, size_t>;
+
+        const ContactSnapshot* snapshot_;
+        bool descending_;
+        std::vector<CompactContactStore::Records::Position> positions_;
+        size_t lastShard_ = 0;
+        // Keyed by id, or by the negated id when descending (ids are positive), so the top is always next
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads_;
+
+        void pushHead(size_t shardIndex) {
+            auto id = snapshot_->shards_[shardIndex]->records->at(positions_[shardIndex]).id;
+            heads_.emplace(descending_ ? -id : id, shardIndex);
+        }
+
+        // Pops the next head and moves its shard on; nullptr when every shard is exhausted
+        const ContactRecord* advance() {
+            if (heads_.empty()) {
+                return nullptr;
+            }
+            auto shardIndex = heads_.top().second;
+            heads_.pop();
+
+            const auto& records = *snapshot_->shards_[shardIndex]->records;
+            auto& position = positions_[shardIndex];
+            const auto* record = &records.at(position);
+            bool more;
+            if (descending_) {
+                more = records.previous(position);
+            } else {
+                records.next(position);
+                more = !records.isEnd(position);
+            }
+            if (more) {
+                pushHead(shardIndex);
+            }
+            lastShard_ = shardIndex;
+            return record;
+        }
+    };
+
+    // Visits contacts in ascending id order
+    void forEach(const std::function<void(const oatpp::Object<ContactDto>&)>& visitor) const {
+        Cursor cursor(*this, std::numeric_limits<int64_t>::min());
+        while (auto contact = cursor.next()) {
+            visitor(contact);
+        }
+    }
+
+private:
+    uint64_t version_;
+    uint64_t journalSequence_;
+    std::vector<std::shared_ptr<const ContactShardView>> shards_;
+    std::shared_ptr<const StringPool> pool_;
+    // StringPool::pin() taken when the records were captured, keeps their address components readable
+    std::shared_ptr<const void> poolPin_;
+    size_t size_;
+};
@@ -0,0 +1,123 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+// Changes of one repository shard in version order, for delta sync (see ContactRepository::changesSince)
+// Every put appends the contact's new version and every remove a tombstone, 16 bytes each. An entry that a
+// later change of the same contact supersedes stays behind until the next compaction, which runs once the
+// log has doubled since the previous one, so the log stays proportional to the contacts changed since startup.
+// Tombstones are capped: past the cap the oldest ones are dropped and horizon() rises to the newest dropped
+// version, as a delta from before it could miss a removal. Shard versions only grow under the shard lock,
+// so appending keeps the log sorted.
+// Not thread-safe: the repository shard lock serializes access.
+class ModificationLog {
+public:
+    struct Entry {
+        // version << 1 | removed, so entries order by version
+        uint64_t stamp;
+        int64_t id;
+
+        uint64_t version() const {
+            return stamp >> 1;
+        }
+
+        bool removed() const {
+            return (stamp & 1) != 0;
+        }
+    };
+
+    static constexpr size_t kMinCompaction = 1024;
+
+    explicit ModificationLog(size_t maxTombstones = 1000000)
+        : maxTombstones_(maxTombstones) {}
+
+    void setMaxTombstones(size_t maxTombstones) {
+        maxTombstones_ = maxTombstones;
+    }
+
+    void put(uint64_t version, int64_t id) {
+        entries_.push_back({version << 1, id});
+    }
+
+    void remove(uint64_t version, int64_t id) {
+        entries_.push_back({version << 1 | 1, id});
+        ++tombstones_;
+    }
+
+    // Calls visit for the entries with a version in (after, upTo], oldest first, until it returns false
+    // Superseded entries are included; the caller checks them against the store
+    template<typename Visitor>
+    void forEachBetween(uint64_t after, uint64_t upTo, Visitor&& visit) const {
+        auto it = std::upper_bound(entries_.begin(), entries_.end(), after, [](uint64_t version, const Entry& entry) {
+            return version < entry.version();
+        });
+        for (; it != entries_.end() && it->version() <= upTo; ++it) {
+            if (!visit(*it)) {
+                return;
+            }
+        }
+    }
+
+    // isCurrent(entry) tells whether an entry still describes its contact: a put of the version the contact
+    // has now, or a tombstone of a contact that doesn't exist
+    template<typename IsCurrent>
+    void compactIfNeeded(IsCurrent&& isCurrent) {
+        // Tombstones may exceed the cap by half of it (at least kMinCompaction) between compactions
+        if (entries_.size() < nextCompaction_ &&
+            tombstones_ <= maxTombstones_ + std::max(maxTombstones_ / 2, kMinCompaction)) {
+            return;
+        }
+        // Newest first, so that only the last tombstone of a contact removed several times is kept
+        std::vector<Entry> kept;
+        std::unordered_set<int64_t> removedIds;
+        for (auto it = entries_.rbegin(); it != entries_.rend(); ++it) {
+            if (isCurrent(*it) && (!it->removed() || removedIds.insert(it->id).second)) {
+                kept.push_back(*it);
+            }
+        }
+        std::reverse(kept.begin(), kept.end());
+
+        // The oldest tombstones past the cap are dropped
+        tombstones_ = removedIds.size();
+        auto excess = tombstones_ > maxTombstones_ ? tombstones_ - maxTombstones_ : 0;
+        entries_.clear();
+        for (const auto& entry : kept) {
+            if (excess > 0 && entry.removed()) {
+                horizon_ = std::max(horizon_, entry.version());
+                --excess;
+                --tombstones_;
+                continue;
+            }
+            entries_.push_back(entry);
+        }
+        entries_.shrink_to_fit();
+        nextCompaction_ = std::max(kMinCompaction, entries_.size() * 2);
+    }
+
+    // Newest version of a dropped tombstone, 0 if none was dropped
+    uint64_t horizon() const {
+        return horizon_;
+    }
+
+    size_t size() const {
+        return entries_.size();
+    }
+
+    size_t memoryUsage() const {
+        return entries_.capacity() * sizeof(Entry);
+    }
+
+private:
+    std::vector<Entry> entries_;
+    size_t maxTombstones_;
+    size_t tombstones_ = 0;
+    size_t nextCompaction_ = kMinCompaction;
+    uint64_t horizon_ = 0;
+};
@@ -0,0 +1,143 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Ordered secondary index over normalized contact names
+// Prefix lookups are O(log n + k): one lower_bound to the first candidate, then a forward walk.
+// Kept up to date by ContactRepository while it holds the shard lock of the changed contact.
+class NameIndex {
+public:
+    // Case-insensitive key: ASCII and Cyrillic letters are lowercased, everything else is kept as is
+    static std::string normalize(const std::string& name) {
+        std::string result;
+        result.reserve(name.size());
+        for (size_t i = 0; i < name.size(); ++i) {
+            auto c = static_cast<unsigned char>(name[i]);
+            if (c >= 'A' && c <= 'Z') {
+                result += static_cast<char>(c - 'A' + 'a');
+                continue;
+            }
+            if ((c == 0xD0) && i + 1 < name.size()) {
+                auto next = static_cast<unsigned char>(name[i + 1]);
+                if (next >= 0x90 && next <= 0x9F) {          // А-П -> а-п
+                    result += static_cast<char>(0xD0);
+                    result += static_cast<char>(next + 0x20);
+                    ++i;
+                    continue;
+                }
+                if (next >= 0xA0 && next <= 0xAF) {          // Р-Я -> р-я
+                    result += static_cast<char>(0xD1);
+                    result += static_cast<char>(next - 0x20);
+                    ++i;
+                    continue;
+                }
+                if (next == 0x81) {                          // Ё -> ё
+                    result += static_cast<char>(0xD1);
+                    result += static_cast<char>(0x91);
+                    ++i;
+                    continue;
+                }
+            }
+            result += static_cast<char>(c);
+        }
+        return result;
+    }
+
+    void insert(const std::string& name, int64_t id) {
+        std::unique_lock lock(mutex_);
+        entries_.emplace(normalize(name), id);
+    }
+
+    void erase(const std::string& name, int64_t id) {
+        std::unique_lock lock(mutex_);
+        entries_.erase({normalize(name), id});
+    }
+
+    // Ids of contacts whose normalized name starts with the normalized prefix, ordered by name then id
+    std::vector<int64_t> findByPrefix(const std::string& prefix, size_t limit) const {
+        auto key = normalize(prefix);
+        std::vector<int64_t> result;
+
+        std::shared_lock lock(mutex_);
+        for (auto it = entries_.lower_bound({key, std::numeric_limits<int64_t>::min()});
+             it != entries_.end() && result.size() < limit && it->first.compare(0, key.size(), key) == 0;
+             ++it) {
+            result.push_back(it->second);
+        }
+        return result;
+    }
+
+    // Position in the index: normalized name and id
+    using Key = std::pair<std::string, int64_t>;
+
+    // Ids of the whole index in name order (then id), skipping the first offset of them
+    // Costs O(offset + limit): the first pages are cheap, deep offsets walk past what they skip.
+    // When the page is full, last is set to its last entry, where pageAfter continues
+    std::vector<int64_t> page(size_t offset, size_t limit, bool descending, Key* last = nullptr) const {
+        std::shared_lock lock(mutex_);
+        return descending ? walk(entries_.rbegin(), entries_.rend(), offset, limit, last)
+                          : walk(entries_.begin(), entries_.end(), offset, limit, last);
+    }
+
+    // Ids of the entries after the given one in the same order, as page would continue it
+    // The key need not be in the index any more, so a walk resumes past entries removed in between
+    std::vector<int64_t> pageAfter(const Key& after, size_t limit, bool descending, Key* last = nullptr) const {
+        std::shared_lock lock(mutex_);
+        if (descending) {
+            return walk(std::make_reverse_iterator(entries_.lower_bound(after)), entries_.rend(), 0, limit, last);
+        }
+        return walk(entries_.upper_bound(after), entries_.end(), 0, limit, last);
+    }
+
+    size_t size() const {
+        std::shared_lock lock(mutex_);
+        return entries_.size();
+    }
+
+    // Estimate: one red-black tree node per entry plus heap-allocated keys
+    size_t memoryUsage() const {
+        std::shared_lock lock(mutex_);
+        size_t result = entries_.size() * (sizeof(std::pair<std::string, int64_t>) + kTreeNodeOverhead);
+        for (const auto& entry : entries_) {
+            if (entry.first.capacity() > kInlineCapacity) {
+                result += entry.first.capacity() + 1;
+            }
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t kTreeNodeOverhead = 4 * sizeof(void*);
+    static constexpr size_t kInlineCapacity = 15;
+
+    mutable std::shared_mutex mutex_;
+    std::set<Key> entries_;
+
+    template<typename Iterator>
+    static std::vector<int64_t> walk(Iterator it, Iterator end, size_t offset, size_t limit, Key* last) {
+        std::vector<int64_t> result;
+        while (it != end && offset > 0) {
+            ++it;
+            --offset;
+        }
+        for (; it != end && result.size() < limit; ++it) {
+            result.push_back(it->second);
+            if (last && result.size() == limit) {
+                *last = *it;
+            }
+        }
+        return result;
+    }
+};
@@ -0,0 +1,217 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Compact numeric form of an E.164-style phone number: up to 15 digits and their count
+// The count keeps numbers that differ only in leading zeros apart
+struct PhoneKey {
+    static constexpr size_t kMaxDigits = 15;
+
+    uint64_t digits = 0;
+    uint8_t length = 0;
+
+    // Accepts an optional leading '+', digits and the usual separators (spaces, dashes, dots, parentheses)
+    static std::optional<PhoneKey> parse(const std::string& phone, size_t minDigits = 1) {
+        PhoneKey key;
+        size_t start = (!phone.empty() && phone[0] == '+') ? 1 : 0;
+        for (size_t i = start; i < phone.size(); ++i) {
+            char c = phone[i];
+            if (c >= '0' && c <= '9') {
+                if (key.length == kMaxDigits) {
+                    return std::nullopt;
+                }
+                key.digits = key.digits * 10 + static_cast<uint64_t>(c - '0');
+                ++key.length;
+            } else if (c != ' ' && c != '-' && c != '.' && c != '(' && c != ')') {
+                return std::nullopt;
+            }
+        }
+        if (key.length < minDigits) {
+            return std::nullopt;
+        }
+        return key;
+    }
+
+    // Single 64-bit value for hashing: digit count in the top byte
+    uint64_t packed() const {
+        return (static_cast<uint64_t>(length) << 56) | digits;
+    }
+
+    // Digits left-aligned to kMaxDigits places, so that all numbers starting with
+    // a given prefix form one contiguous range
+    uint64_t aligned() const {
+        return digits * pow10(kMaxDigits - length);
+    }
+
+    // Canonical "+<digits>" form stored in ContactDto::phone
+    std::string toE164() const {
+        std::string result(length + 1, '0');
+        result[0] = '+';
+        auto value = digits;
+        for (size_t i = length; i > 0; --i) {
+            result[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+        return result;
+    }
+
+    bool operator==(const PhoneKey& other) const {
+        return digits == other.digits && length == other.length;
+    }
+
+    static uint64_t pow10(size_t exponent) {
+        uint64_t result = 1;
+        while (exponent-- > 0) {
+            result *= 10;
+        }
+        return result;
+    }
+};
+
+// Secondary indexes over contact phone numbers
+// A hash index answers exact lookups (and the optional uniqueness check) in O(1), an ordered index
+// over left-aligned digits answers prefix / area-code range queries in O(log n + k).
+// Kept up to date by ContactRepository while it holds the shard lock of the changed contact.
+class PhoneIndex {
+public:
+    explicit PhoneIndex(bool unique)
+        : unique_(unique) {}
+
+    bool isUnique() const {
+        return unique_;
+    }
+
+    // Moves contact id from oldKey to newKey (either may be absent)
+    // Fails without changes if the number is taken by another contact and uniqueness is enforced;
+    // checkUnique = false skips the check (journal replay restores state that was already accepted)
+    bool replace(const std::optional<PhoneKey>& oldKey,
+                 const std::optional<PhoneKey>& newKey,
+                 int64_t id,
+                 bool checkUnique = true) {
+        std::unique_lock lock(mutex_);
+        if (newKey && unique_ && checkUnique && takenByOther(*newKey, id)) {
+            return false;
+        }
+        if (oldKey) {
+            eraseLocked(*oldKey, id);
+        }
+        if (newKey) {
+            exact_.emplace(newKey->packed(), id);
+            ordered_.emplace(newKey->aligned(), newKey->length, id);
+        }
+        return true;
+    }
+
+    std::vector<int64_t> findExact(const PhoneKey& key, size_t limit) const {
+        std::vector<int64_t> result;
+        std::shared_lock lock(mutex_);
+        auto range = exact_.equal_range(key.packed());
+        for (auto it = range.first; it != range.second && result.size() < limit; ++it) {
+            result.push_back(it->second);
+        }
+        return result;
+    }
+
+    // Ids of numbers starting with the prefix digits, in numeric order
+    std::vector<int64_t> findByPrefix(const PhoneKey& prefix, size_t limit) const {
+        std::vector<int64_t> result;
+        auto from = prefix.aligned();
+        auto to = from + PhoneKey::pow10(PhoneKey::kMaxDigits - prefix.length);
+
+        std::shared_lock lock(mutex_);
+        for (auto it = ordered_.lower_bound({from, 0, std::numeric_limits<int64_t>::min()});
+             it != ordered_.end() && std::get<0>(*it) < to && result.size() < limit;
+             ++it) {
+            // Numbers shorter than the prefix can fall into the range only because of alignment
+            if (std::get<1>(*it) >= prefix.length) {
+                result.push_back(std::get<2>(*it));
+            }
+        }
+        return result;
+    }
+
+    // Position in the ordered index: left-aligned digits, digit count and id
+    using Key = std::tuple<uint64_t, uint8_t, int64_t>;
+
+    // Ids of all indexed numbers in numeric order (then id), skipping the first offset of them
+    // Costs O(offset + limit) and sets last, as NameIndex::page
+    std::vector<int64_t> page(size_t offset, size_t limit, bool descending, Key* last = nullptr) const {
+        std::shared_lock lock(mutex_);
+        return descending ? walk(ordered_.rbegin(), ordered_.rend(), offset, limit, last)
+                          : walk(ordered_.begin(), ordered_.end(), offset, limit, last);
+    }
+
+    // Continues a page after the given entry, as NameIndex::pageAfter
+    std::vector<int64_t> pageAfter(const Key& after, size_t limit, bool descending, Key* last = nullptr) const {
+        std::shared_lock lock(mutex_);
+        if (descending) {
+            return walk(std::make_reverse_iterator(ordered_.lower_bound(after)), ordered_.rend(), 0, limit, last);
+        }
+        return walk(ordered_.upper_bound(after), ordered_.end(), 0, limit, last);
+    }
+
+    // Estimate: hash nodes and bucket array of the exact index, tree nodes of the ordered one
+    size_t memoryUsage() const {
+        std::shared_lock lock(mutex_);
+        return exact_.size() * (sizeof(std::pair<uint64_t, int64_t>) + 2 * sizeof(void*)) +
+               exact_.bucket_count() * sizeof(void*) +
+               ordered_.size() * (sizeof(Key) + 4 * sizeof(void*));
+    }
+
+private:
+    bool unique_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_multimap<uint64_t, int64_t> exact_;
+    std::set<Key> ordered_;
+
+    template<typename Iterator>
+    static std::vector<int64_t> walk(Iterator it, Iterator end, size_t offset, size_t limit, Key* last) {
+        std::vector<int64_t> result;
+        while (it != end && offset > 0) {
+            ++it;
+            --offset;
+        }
+        for (; it != end && result.size() < limit; ++it) {
+            result.push_back(std::get<2>(*it));
+            if (last && result.size() == limit) {
+                *last = *it;
+            }
+        }
+        return result;
+    }
+
+    bool takenByOther(const PhoneKey& key, int64_t id) const {
+        auto range = exact_.equal_range(key.packed());
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second != id) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void eraseLocked(const PhoneKey& key, int64_t id) {
+        auto range = exact_.equal_range(key.packed());
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == id) {
+                exact_.erase(it);
+                break;
+            }
+        }
+        ordered_.erase({key.aligned(), key.length, id});
+    }
+};
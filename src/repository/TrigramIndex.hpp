@@ -0,0 +1,519 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "repository/NameIndex.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Fuzzy (typo-tolerant) name search: a trigram index over the vocabulary of name words
+// Names are split into normalized words (see NameIndex::normalize); every distinct word is a term with the
+// sorted ids of the contacts whose name has it, and the terms are indexed by their trigrams of code points
+// ("\0\0word\0" padded). One edit changes at most three trigrams of a word, so a term within the allowed
+// distance of a query word shares enough of its trigrams to be found from the rarest posting lists, and the
+// edit distance is computed once per distinct word rather than once per contact.
+// A contact matches when every query word matches one of its words; contacts are found by intersecting the
+// words' posting lists in id order, one total distance at a time, into a heap bounded by the limit.
+// Kept up to date by ContactRepository together with NameIndex, under the shard lock of the changed contact.
+class TrigramIndex {
+public:
+    // Query words and their allowed edit distances
+    struct Query {
+        std::vector<std::u32string> words;
+        std::vector<size_t> maxDistances;
+
+        bool empty() const {
+            return words.empty();
+        }
+    };
+
+    struct Match {
+        int64_t id;
+        // Sum over the query words of the edits to the closest word of the name
+        size_t distance;
+    };
+
+    // Allowed typos per word, as usual for fuzzy search: none in short words, one up to five letters, then two
+    static size_t maxDistanceFor(size_t length) {
+        return length <= 2 ? 0 : length <= 5 ? 1 : 2;
+    }
+
+    static Query compile(const std::string& text) {
+        Query query;
+        query.words = wordsOf(text);
+        for (const auto& word : query.words) {
+            query.maxDistances.push_back(maxDistanceFor(word.size()));
+        }
+        return query;
+    }
+
+    // Match distance of a name, as search computes it; nullopt when some query word matches no word of name
+    static std::optional<size_t> distance(const Query& query, const std::string& name) {
+        auto words = wordsOf(name);
+        size_t total = 0;
+        for (size_t i = 0; i < query.words.size(); ++i) {
+            auto best = query.maxDistances[i] + 1;
+            for (const auto& word : words) {
+                best = std::min(best, boundedLevenshtein(query.words[i], word, best - 1));
+                if (best == 0) {
+                    break;
+                }
+            }
+            if (best > query.maxDistances[i]) {
+                return std::nullopt;
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    void insert(const std::string& name, int64_t id) {
+        auto words = distinctWordsOf(name);
+        std::unique_lock lock(mutex_);
+        for (auto& word : words) {
+            auto term = termOf(std::move(word));
+            auto& ids = terms_[term].ids;
+            // Ids mostly grow, so this is usually an append
+            auto it = std::lower_bound(ids.begin(), ids.end(), id);
+            if (it == ids.end() || *it != id) {
+                ids.insert(it, id);
+            }
+        }
+    }
+
+    void erase(const std::string& name, int64_t id) {
+        auto words = distinctWordsOf(name);
+        std::unique_lock lock(mutex_);
+        for (const auto& word : words) {
+            auto found = vocabulary_.find(word);
+            if (found == vocabulary_.end()) {
+                continue;
+            }
+            auto& ids = terms_[found->second].ids;
+            auto it = std::lower_bound(ids.begin(), ids.end(), id);
+            if (it != ids.end() && *it == id) {
+                ids.erase(it);
+            }
+            if (ids.empty()) {
+                dropTerm(found->second);
+            }
+        }
+    }
+
+    // Contacts matching every query word, best first: fewest edits, then lowest id; at most limit of them
+    // Matches are collected one total distance at a time, from the smallest the query can have: a tier only
+    // uses the terms that can still add up to its distance, and stops as soon as limit matches are known
+    // (see collectTier). Most queries are answered from their first tier after a short walk.
+    std::vector<Match> search(const Query& query, size_t limit) const {
+        std::vector<Match> result;
+        if (query.empty() || limit == 0) {
+            return result;
+        }
+
+        std::shared_lock lock(mutex_);
+        std::vector<std::vector<std::pair<uint32_t, size_t>>> words;
+        size_t lowerBound = 0;
+        size_t upperBound = 0;
+        for (size_t i = 0; i < query.words.size(); ++i) {
+            words.push_back(matchTerms(query.words[i], query.maxDistances[i]));
+            if (words.back().empty()) {
+                return result;
+            }
+            auto [closest, farthest] = std::minmax_element(
+                words.back().begin(), words.back().end(), [](const auto& a, const auto& b) {
+                    return a.second < b.second;
+                });
+            lowerBound += closest->second;
+            upperBound += farthest->second;
+        }
+
+        MatchHeap best(&isBetter);
+        for (auto distance = lowerBound; distance <= upperBound && best.size() < limit; ++distance) {
+            collectTier(words, lowerBound, distance, limit, best);
+        }
+        result.resize(best.size());
+        for (auto i = result.size(); i > 0; --i) {
+            result[i - 1] = best.top();
+            best.pop();
+        }
+        return result;
+    }
+
+    // Distinct name words indexed
+    size_t termCount() const {
+        std::shared_lock lock(mutex_);
+        return vocabulary_.size();
+    }
+
+    // Estimate: vocabulary and trigram hash nodes, term words and the posting vectors
+    size_t memoryUsage() const {
+        std::shared_lock lock(mutex_);
+        size_t result = (vocabulary_.bucket_count() + trigrams_.bucket_count()) * sizeof(void*) +
+                        terms_.capacity() * sizeof(Term) + freeTerms_.capacity() * sizeof(uint32_t);
+        for (const auto& term : terms_) {
+            // The word is held by the term and by its vocabulary key
+            result += 2 * term.word.capacity() * sizeof(char32_t) + term.ids.capacity() * sizeof(int64_t);
+        }
+        result += vocabulary_.size() * (sizeof(std::pair<std::u32string, uint32_t>) + kHashNodeOverhead);
+        for (const auto& posting : trigrams_) {
+            result += sizeof(posting) + kHashNodeOverhead + posting.second.capacity() * sizeof(uint32_t);
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t kHashNodeOverhead = 2 * sizeof(void*);
+    static constexpr unsigned kCodePointBits = 21;
+    static constexpr size_t kRowCapacity = 64;
+
+    struct Term {
+        std::u32string word;
+        // Sorted ids of the contacts whose name has the word; empty for a free slot
+        std::vector<int64_t> ids;
+    };
+
+    // Position in the ids of a term matching a query word
+    struct Cursor {
+        const std::vector<int64_t>* ids;
+        size_t position;
+        size_t distance;
+
+        int64_t current() const {
+            return (*ids)[position];
+        }
+
+        // Moves to the first id not less than id; false when there is none
+        // Gallops (steps of 1, 2, 4, ...) before the binary search, as the next id is usually close
+        bool seek(int64_t id) {
+            if (position >= ids->size() || (*ids)[position] >= id) {
+                return position < ids->size();
+            }
+            size_t low = position;
+            size_t step = 1;
+            while (low + step < ids->size() && (*ids)[low + step] < id) {
+                low += step;
+                step *= 2;
+            }
+            auto high = std::min(low + step + 1, ids->size());
+            position = static_cast<size_t>(std::lower_bound(ids->begin() + static_cast<std::ptrdiff_t>(low + 1),
+                                                            ids->begin() + static_cast<std::ptrdiff_t>(high), id) -
+                                           ids->begin());
+            return position < ids->size();
+        }
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::u32string, uint32_t> vocabulary_;
+    std::vector<Term> terms_;
+    std::vector<uint32_t> freeTerms_;
+    // Trigram -> sorted numbers of the terms having it
+    std::unordered_map<uint64_t, std::vector<uint32_t>> trigrams_;
+
+    uint32_t termOf(std::u32string word) {
+        auto found = vocabulary_.find(word);
+        if (found != vocabulary_.end()) {
+            return found->second;
+        }
+        uint32_t term;
+        if (!freeTerms_.empty()) {
+            term = freeTerms_.back();
+            freeTerms_.pop_back();
+        } else {
+            term = static_cast<uint32_t>(terms_.size());
+            terms_.emplace_back();
+        }
+        for (auto trigram : trigramsOf(word)) {
+            auto& list = trigrams_[trigram];
+            list.insert(std::lower_bound(list.begin(), list.end(), term), term);
+        }
+        terms_[term].word = word;
+        vocabulary_.emplace(std::move(word), term);
+        return term;
+    }
+
+    void dropTerm(uint32_t term) {
+        auto& word = terms_[term].word;
+        for (auto trigram : trigramsOf(word)) {
+            auto posting = trigrams_.find(trigram);
+            auto& list = posting->second;
+            list.erase(std::lower_bound(list.begin(), list.end(), term));
+            if (list.empty()) {
+                trigrams_.erase(posting);
+            }
+        }
+        vocabulary_.erase(word);
+        terms_[term] = Term();
+        freeTerms_.push_back(term);
+    }
+
+    // Terms within maxDistance of word, with their distances
+    // A term missing from all of the rarest (trigrams - minShared + 1) lists can't share minShared trigrams,
+    // so candidates are collected from those lists and counted up in the others by binary search
+    std::vector<std::pair<uint32_t, size_t>> matchTerms(const std::u32string& word, size_t maxDistance) const {
+        auto wordTrigrams = trigramsOf(word);
+        // A padded word has one trigram more than letters, so at least one is left after the allowed edits
+        auto minShared = wordTrigrams.size() - std::min(wordTrigrams.size() - 1, 3 * maxDistance);
+
+        static const std::vector<uint32_t> kNoTerms;
+        std::vector<const std::vector<uint32_t>*> lists;
+        for (auto trigram : wordTrigrams) {
+            auto posting = trigrams_.find(trigram);
+            lists.push_back(posting != trigrams_.end() ? &posting->second : &kNoTerms);
+        }
+        std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+
+        // Only the terms of the seed lists are counted, so a query costs what those lists hold whatever the size
+        // of the vocabulary
+        auto seedLists = lists.size() - minShared + 1;
+        size_t seedTerms = 0;
+        for (size_t i = 0; i < seedLists; ++i) {
+            seedTerms += lists[i]->size();
+        }
+        std::unordered_map<uint32_t, uint16_t> counts;
+        counts.reserve(seedTerms);
+        for (size_t i = 0; i < seedLists; ++i) {
+            for (auto term : *lists[i]) {
+                ++counts[term];
+            }
+        }
+        std::vector<std::pair<uint32_t, size_t>> result;
+        for (auto [term, seeded] : counts) {
+            size_t count = seeded;
+            for (size_t i = seedLists; i < lists.size() && count < minShared && count + (lists.size() - i) >= minShared;
+                 ++i) {
+                if (std::binary_search(lists[i]->begin(), lists[i]->end(), term)) {
+                    ++count;
+                }
+            }
+            if (count < minShared) {
+                continue;
+            }
+            auto distance = boundedLevenshtein(word, terms_[term].word, maxDistance);
+            if (distance <= maxDistance) {
+                result.emplace_back(term, distance);
+            }
+        }
+        return result;
+    }
+
+    static bool isBetter(const Match& a, const Match& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.id < b.id;
+    }
+
+    // Bounded max-heap of the best matches found so far, the worst of them on top
+    using MatchHeap = std::priority_queue<Match, std::vector<Match>, bool (*)(const Match&, const Match&)>;
+
+    // Adds to best the contacts at exactly distance from the query, given that best already holds all closer ones
+    // A word's terms take part if they leave room for the other words' closest terms. The ids of the rarest
+    // word's terms are merged in increasing order and intersected with the other words' terms by leapfrogging
+    // forward-only cursors. Ids only grow, so the walk stops once best is full: later ids can't displace anything.
+    void collectTier(const std::vector<std::vector<std::pair<uint32_t, size_t>>>& words, size_t lowerBound,
+                     size_t distance, size_t limit, MatchHeap& best) const {
+        std::vector<std::vector<Cursor>> cursors(words.size());
+        std::vector<size_t> postings(words.size());
+        for (size_t i = 0; i < words.size(); ++i) {
+            auto closest = std::min_element(words[i].begin(), words[i].end(), [](const auto& a, const auto& b) {
+                return a.second < b.second;
+            })->second;
+            auto allowed = distance - (lowerBound - closest);
+            for (const auto& [term, termDistance] : words[i]) {
+                if (termDistance <= allowed) {
+                    cursors[i].push_back(Cursor{&terms_[term].ids, 0, termDistance});
+                    postings[i] += terms_[term].ids.size();
+                }
+            }
+        }
+        auto rarest = static_cast<size_t>(std::min_element(postings.begin(), postings.end()) - postings.begin());
+
+        // Min-heap of the rarest word's cursors by their current id
+        auto later = [](const Cursor* a, const Cursor* b) {
+            return a->current() > b->current();
+        };
+        std::priority_queue<Cursor*, std::vector<Cursor*>, decltype(later)> merge(later);
+        for (auto& cursor : cursors[rarest]) {
+            merge.push(&cursor);
+        }
+
+        while (!merge.empty() && best.size() < limit) {
+            // Leapfrog to the next id that every word has: other words' cursors jump ahead to it, and the
+            // rarest word's merge skips what lies before it
+            auto id = merge.top()->current();
+            auto target = id;
+            size_t total = 0;
+            bool exhausted = false;
+            for (bool moved = true; moved && !exhausted;) {
+                moved = false;
+                total = 0;
+                for (size_t i = 0; i < cursors.size() && !exhausted; ++i) {
+                    if (i == rarest) {
+                        continue;
+                    }
+                    auto next = advance(cursors[i], target);
+                    exhausted = !next;
+                    if (next && next->first > target) {
+                        target = next->first;
+                        moved = true;
+                    } else if (next) {
+                        total += next->second;
+                    }
+                }
+            }
+            if (exhausted) {
+                return;
+            }
+            if (target > id) {
+                while (!merge.empty() && merge.top()->current() < target) {
+                    auto* cursor = merge.top();
+                    merge.pop();
+                    if (cursor->seek(target)) {
+                        merge.push(cursor);
+                    }
+                }
+                continue;
+            }
+
+            // Every term of the rarest word having the id moves past it; the closest one counts
+            auto closest = merge.top()->distance;
+            while (!merge.empty() && merge.top()->current() == id) {
+                auto* cursor = merge.top();
+                merge.pop();
+                closest = std::min(closest, cursor->distance);
+                if (cursor->seek(id + 1)) {
+                    merge.push(cursor);
+                }
+            }
+            // Closer contacts were found by earlier tiers, farther ones are left to later tiers
+            if (total + closest == distance) {
+                best.push(Match{id, distance});
+            }
+        }
+    }
+
+    // The smallest id at least id that one of a word's terms has, with the distance of the closest term having
+    // it; nullopt once all of them are past their end. Ids are asked for in increasing order, so cursors only
+    // move forward
+    static std::optional<std::pair<int64_t, size_t>> advance(std::vector<Cursor>& terms, int64_t id) {
+        std::optional<std::pair<int64_t, size_t>> next;
+        for (auto& cursor : terms) {
+            if (!cursor.seek(id)) {
+                continue;
+            }
+            auto current = cursor.current();
+            if (!next || current < next->first || (current == next->first && cursor.distance < next->second)) {
+                next.emplace(current, cursor.distance);
+            }
+        }
+        return next;
+    }
+
+    static std::vector<uint64_t> trigramsOf(const std::u32string& word) {
+        // Code point 0 pads the word: two before it, one after
+        std::vector<uint64_t> trigrams;
+        uint64_t previous[2] = {0, 0};
+        for (size_t i = 0; i <= word.size(); ++i) {
+            uint64_t current = i < word.size() ? word[i] : 0;
+            trigrams.push_back(previous[0] << (2 * kCodePointBits) | previous[1] << kCodePointBits | current);
+            previous[0] = previous[1];
+            previous[1] = current;
+        }
+        std::sort(trigrams.begin(), trigrams.end());
+        trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+        return trigrams;
+    }
+
+    static std::vector<std::u32string> distinctWordsOf(const std::string& name) {
+        auto words = wordsOf(name);
+        std::sort(words.begin(), words.end());
+        words.erase(std::unique(words.begin(), words.end()), words.end());
+        return words;
+    }
+
+    // Normalized words of the text as code points; ASCII characters other than letters and digits separate words
+    static std::vector<std::u32string> wordsOf(const std::string& text) {
+        auto normalized = NameIndex::normalize(text);
+        std::vector<std::u32string> words;
+        std::u32string word;
+        for (size_t i = 0; i < normalized.size();) {
+            auto codePoint = decode(normalized, i);
+            bool separator = codePoint < 0x80 && !((codePoint >= 'a' && codePoint <= 'z') ||
+                                                   (codePoint >= '0' && codePoint <= '9'));
+            if (!separator) {
+                word += codePoint;
+            } else if (!word.empty()) {
+                words.push_back(std::move(word));
+                word.clear();
+            }
+        }
+        if (!word.empty()) {
+            words.push_back(std::move(word));
+        }
+        return words;
+    }
+
+    // Next UTF-8 code point; a malformed byte is taken as a code point of its own
+    static char32_t decode(const std::string& text, size_t& i) {
+        auto lead = static_cast<unsigned char>(text[i]);
+        size_t length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+        if (length == 1 || i + length > text.size()) {
+            ++i;
+            return lead;
+        }
+        char32_t codePoint = lead & (0x7F >> length);
+        for (size_t k = 1; k < length; ++k) {
+            auto next = static_cast<unsigned char>(text[i + k]);
+            if ((next & 0xC0) != 0x80) {
+                ++i;
+                return lead;
+            }
+            codePoint = codePoint << 6 | (next & 0x3F);
+        }
+        i += length;
+        return codePoint;
+    }
+
+    // Levenshtein distance of a and b if it is at most bound, otherwise bound + 1
+    // Stops as soon as a whole row of the table exceeds the bound; rows of words that fit in kRowCapacity are
+    // kept on the stack, since this runs for every candidate term
+    static size_t boundedLevenshtein(const std::u32string& a, const std::u32string& b, size_t bound) {
+        auto lengthDifference = a.size() > b.size() ? a.size() - b.size() : b.size() - a.size();
+        if (lengthDifference > bound) {
+            return bound + 1;
+        }
+        size_t rows[2][kRowCapacity];
+        std::vector<size_t> heapRows;
+        size_t* previous = rows[0];
+        size_t* current = rows[1];
+        if (b.size() + 1 > kRowCapacity) {
+            heapRows.resize(2 * (b.size() + 1));
+            previous = heapRows.data();
+            current = heapRows.data() + b.size() + 1;
+        }
+        for (size_t j = 0; j <= b.size(); ++j) {
+            previous[j] = j;
+        }
+        for (size_t i = 1; i <= a.size(); ++i) {
+            current[0] = i;
+            auto rowMinimum = current[0];
+            for (size_t j = 1; j <= b.size(); ++j) {
+                auto substitution = previous[j - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+                current[j] = std::min({previous[j] + 1, current[j - 1] + 1, substitution});
+                rowMinimum = std::min(rowMinimum, current[j]);
+            }
+            if (rowMinimum > bound) {
+                return bound + 1;
+            }
+            std::swap(previous, current);
+        }
+        return std::min(previous[b.size()], bound + 1);
+    }
+};
@@ -6,81 +6,707 @@
 
 #include "dto/ContactDto.hpp"
 #include "repository/ContactRepository.hpp"
+#include "repository/ContactSnapshot.hpp"
+#include "repository/PhoneIndex.hpp"
+#include "service/HexNumber.hpp"
+#include "service/ServiceResult.hpp"
+#include <charconv>
+#include <cstdio>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <vector>
-#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// One page of a keyset-paginated listing
+// Contacts with id greater than afterId, at most limit of them (0 - no limit), read from snapshot
+struct ContactPage {
+    std::shared_ptr<const ContactSnapshot> snapshot;
+    // Walk the snapshot from after this id, in descending id order if descending (see ContactSnapshot::Cursor)
+    int64_t afterId = std::numeric_limits<int64_t>::min();
+    bool descending = false;
+    size_t limit = 0;
+    // Opaque cursor of the next page, nullptr on the last page
+    oatpp::String nextCursor;
+};
+
+// Order of a listing (?sort=id|name|phone&order=asc|desc)
+struct ListOrder {
+    ContactRepository::SortKey key = ContactRepository::SortKey::Id;
+    bool descending = false;
+};
+
+// One delta of a delta sync: the changes after the requested since and the since of the next delta
+struct ContactDelta {
+    ContactRepository::ChangeSet changes;
+    oatpp::String next;
+};
+
+// Outcome of one item of a batch request
+// On failure contact is nullptr and error holds what a single-item request would have failed with
+struct BatchOutcome {
+    oatpp::Int64 id;
+    oatpp::Object<ContactDto> contact;
+    std::optional<ServiceError> error;
+
+    bool ok() const {
+        return !error;
+    }
+};
 
 // Service layer for delegating repository work before API level (Controller)
 // Here data validity is checked before passing them to the repository
 // So that the Endpoint interface in Controller is not cluttered with data validation logic
 // And connection with the low-level CRUD operations layer (Repository)
+//
+// Expected failures are returned as ServiceResult errors with a typed ErrorCode, never thrown
 class ContactService {
 public:
+    static constexpr int64_t kMaxPageSize = 1000;
+    static constexpr int64_t kDefaultSearchLimit = 20;
+    static constexpr size_t kMinPhoneDigits = 3;
+    static constexpr size_t kMaxBatchSize = 10000;
+    // Longer fuzzy queries are rejected: every query word is compared with every word of each candidate
+    static constexpr size_t kMaxFuzzyQueryLength = 128;
+    // Version decodeSyncToken reports for a token of another server run
+    static constexpr uint64_t kForeignEpoch = std::numeric_limits<uint64_t>::max();
+
     explicit ContactService(const std::shared_ptr<ContactRepository>& repository)
         : repository_(repository) {}
 
-    oatpp::Object<ContactDto> createContact(const oatpp::Object<ContactDto>& contact) {
-        validateContact(contact, false);
-
-        if (contact->id && *contact->id < 0) {
-            throw std::runtime_error("Invalid ID: ID must be positive or zero");
+    ServiceResult<oatpp::Object<ContactDto>> createContact(const oatpp::Object<ContactDto>& contact) {
+        if (auto error = validateNewContact(contact)) {
+            return std::move(*error);
         }
-        
-        auto result = repository_->create(contact);
+
+        ContactRepository::Conflict conflict;
+        auto result = repository_->create(contact, &conflict);
         if (!result) {
-            throw std::runtime_error("Failed to create contact: ID already exists");
+            return createConflictError(conflict);
         }
         return result;
     }
 
-    oatpp::Object<ContactDto> getContactById(oatpp::Int64 id) {
-        if (id <= 0) {
-            throw std::runtime_error("Invalid ID");
+    // The contact's version is reported through version if given
+    ServiceResult<oatpp::Object<ContactDto>> getContactById(oatpp::Int64 id, uint64_t* version = nullptr) {
+        if (!id || *id <= 0) {
+            return ServiceError::invalid("Invalid ID");
         }
-        auto result = repository_->getById(id);
+        auto result = repository_->getById(id, version);
         if (!result) {
-            throw std::runtime_error("Contact not found");
+            return ServiceError::notFound();
         }
         return result;
     }
 
+    // Versions for conditional requests, compared without building DTOs (see ContactRepository::versionOf)
+    // nullopt for an invalid or unknown id, which getContactById then reports
+    std::optional<uint64_t> getContactVersion(oatpp::Int64 id) {
+        if (!id || *id <= 0) {
+            return std::nullopt;
+        }
+        return repository_->versionOf(*id);
+    }
+
+    // Changes on every write to any contact
+    uint64_t getDirectoryVersion() {
+        return repository_->version();
+    }
+
+    uint64_t getVersionEpoch() {
+        return repository_->epoch();
+    }
+
     std::vector<oatpp::Object<ContactDto>> getAllContacts() {
         return repository_->getAll();
     }
 
-    oatpp::Object<ContactDto> updateContact(const oatpp::Object<ContactDto>& contact) {
-        validateContact(contact, true);
-        auto result = repository_->update(contact);
+    // Listing ordered by id; without limit the page spans the whole directory
+    // offset skips contacts after the cursor; the cursor of a descending listing only continues a descending one
+    // The snapshot is taken in O(shards) even after writes (it shares the shards' record pages), so a page costs
+    // O(shards * log n + offset + limit) whatever the directory size
+    ServiceResult<ContactPage> getContactsPage(const oatpp::String& cursor, oatpp::Int64 limit,
+                                               oatpp::Int64 offset = nullptr, bool descending = false) {
+        ContactPage page;
+        page.descending = descending;
+        if (descending) {
+            page.afterId = std::numeric_limits<int64_t>::max();
+        }
+        if (cursor) {
+            auto afterId = decodeCursor(cursor, descending);
+            if (!afterId) {
+                return ServiceError::invalid("Invalid cursor");
+            }
+            page.afterId = *afterId;
+        }
+        if (limit) {
+            auto pageLimit = validateLimit(limit, kMaxPageSize);
+            if (!pageLimit) {
+                return pageLimit.error();
+            }
+            page.limit = *pageLimit;
+        }
+        auto skip = validateOffset(offset);
+        if (!skip) {
+            return skip.error();
+        }
+        page.snapshot = repository_->snapshot();
+
+        if (page.limit > 0 || *skip > 0) {
+            // Walk the skipped and the page ids once, without building DTOs, to find out where the page and the
+            // next one start
+            ContactSnapshot::Cursor walker(*page.snapshot, page.afterId, descending);
+            for (size_t i = 0; i < *skip; ++i) {
+                auto id = walker.nextId();
+                if (!id) {
+                    break;
+                }
+                page.afterId = *id;
+            }
+            std::optional<int64_t> last;
+            for (size_t i = 0; i < page.limit; ++i) {
+                auto id = walker.nextId();
+                if (!id) {
+                    break;
+                }
+                last = id;
+            }
+            if (last && walker.nextId()) {
+                page.nextCursor = encodeCursor(*last, descending);
+            }
+        }
+        return page;
+    }
+
+    // One page of the listing in name or phone order (id order is getContactsPage), offset contacts in
+    // Unlike the streamed id listing the page is bounded: limit defaults to and is capped at kMaxPageSize
+    ServiceResult<std::vector<oatpp::Object<ContactDto>>> getSortedContacts(const ListOrder& order,
+                                                                           oatpp::Int64 offset, oatpp::Int64 limit) {
+        auto pageLimit = validateLimit(limit, kMaxPageSize);
+        if (!pageLimit) {
+            return pageLimit.error();
+        }
+        auto skip = validateOffset(offset);
+        if (!skip) {
+            return skip.error();
+        }
+        return repository_->sortedPage(order.key, order.descending, *skip, *pageLimit);
+    }
+
+    static ServiceResult<ListOrder> parseListOrder(const oatpp::String& sort, const oatpp::String& order) {
+        ListOrder result;
+        if (sort && *sort == "name") {
+            result.key = ContactRepository::SortKey::Name;
+        } else if (sort && *sort == "phone") {
+            result.key = ContactRepository::SortKey::Phone;
+        } else if (sort && *sort != "id") {
+            return ServiceError::invalid("Invalid sort: must be id, name or phone");
+        }
+        if (order && *order != "asc" && *order != "desc") {
+            return ServiceError::invalid("Invalid order: must be asc or desc");
+        }
+        result.descending = order && *order == "desc";
+        return result;
+    }
+
+    // Checks the cursor, limit and offset of a listing the way getContactsPage and getSortedContacts do, without
+    // reading anything, so that a conditional request is only answered Not Modified when it is valid
+    static std::optional<ServiceError> validatePage(const oatpp::String& cursor, const oatpp::Int64& limit,
+                                                    const oatpp::Int64& offset, bool descending) {
+        if (cursor && !decodeCursor(cursor, descending)) {
+            return ServiceError::invalid("Invalid cursor");
+        }
+        auto pageLimit = validateLimit(limit, kMaxPageSize);
+        if (!pageLimit) {
+            return pageLimit.error();
+        }
+        auto skip = validateOffset(offset);
+        if (!skip) {
+            return skip.error();
+        }
+        return std::nullopt;
+    }
+
+    // Delta sync: since is "0" for a full sync or the next token of the previous delta
+    // A token of another server run or one older than the kept removals is Gone, and the client starts over
+    ServiceResult<ContactDelta> getChangesSince(const oatpp::String& since, oatpp::Int64 limit) {
+        if (!since || since->empty()) {
+            return ServiceError::invalid("Since is required");
+        }
+        auto version = *since == "0" ? std::optional<uint64_t>(0) : decodeSyncToken(since);
+        if (!version) {
+            return ServiceError::invalid("Invalid since");
+        }
+        if (limit && *version == 0) {
+            return ServiceError::invalid("Invalid limit: a full sync (since=0) is not paginated");
+        }
+        auto deltaLimit = validateLimit(limit, 0);
+        if (!deltaLimit) {
+            return deltaLimit.error();
+        }
+        auto changes = *version == kForeignEpoch ? std::nullopt : repository_->changesSince(*version, *deltaLimit);
+        if (!changes) {
+            return ServiceError::gone("Sync token expired: start over with since=0");
+        }
+        ContactDelta delta;
+        delta.next = encodeSyncToken(changes->version);
+        delta.changes = std::move(*changes);
+        return delta;
+    }
+
+    // The prefix is a query string value as sent, percent-encoded ("John%20Sm", "%D0%98%D0%B2")
+    ServiceResult<std::vector<oatpp::Object<ContactDto>>> searchByNamePrefix(const oatpp::String& namePrefix,
+                                                                            oatpp::Int64 limit) {
+        if (!namePrefix || namePrefix->empty()) {
+            return ServiceError::invalid("Name prefix is required");
+        }
+        auto prefix = decodeQueryValue(*namePrefix);
+        if (!prefix) {
+            return ServiceError::invalid("Invalid name prefix");
+        }
+        auto searchLimit = validateLimit(limit, kDefaultSearchLimit);
+        if (!searchLimit) {
+            return searchLimit.error();
+        }
+        return repository_->findByNamePrefix(*prefix, *searchLimit);
+    }
+
+    // Typo-tolerant name search: each query word may be a few edits away from a word of the name
+    // (none in words of up to two letters, one up to five, two beyond), best matches first
+    // The query is percent-encoded like the prefix of searchByNamePrefix
+    ServiceResult<std::vector<oatpp::Object<ContactDto>>> searchByNameFuzzy(const oatpp::String& encodedQuery,
+                                                                           oatpp::Int64 limit) {
+        auto query = encodedQuery ? decodeQueryValue(*encodedQuery) : std::optional<std::string>();
+        if (encodedQuery && !query) {
+            return ServiceError::invalid("Invalid query");
+        }
+        if (!query || query->find_first_not_of(" \t") == std::string::npos) {
+            return ServiceError::invalid("Query is required");
+        }
+        if (query->size() > kMaxFuzzyQueryLength) {
+            return ServiceError::invalid("Query is too long");
+        }
+        auto searchLimit = validateLimit(limit, kDefaultSearchLimit);
+        if (!searchLimit) {
+            return searchLimit.error();
+        }
+        return repository_->findByNameFuzzy(*query, *searchLimit);
+    }
+
+    // Exact phone lookup, the number may be given in any accepted notation
+    ServiceResult<std::vector<oatpp::Object<ContactDto>>> findByPhone(const oatpp::String& phone, oatpp::Int64 limit) {
+        auto key = parsePhoneQuery(phone, kMinPhoneDigits);
+        auto searchLimit = validateLimit(limit, kMaxPageSize);
+        if (!key || !searchLimit) {
+            return !key ? key.error() : searchLimit.error();
+        }
+        return repository_->findByPhone(*key, *searchLimit);
+    }
+
+    // Prefix (country / area code) lookup, ordered by number
+    ServiceResult<std::vector<oatpp::Object<ContactDto>>> findByPhonePrefix(const oatpp::String& prefix,
+                                                                           oatpp::Int64 limit) {
+        auto key = parsePhoneQuery(prefix, 1);
+        auto searchLimit = validateLimit(limit, kDefaultSearchLimit);
+        if (!key || !searchLimit) {
+            return !key ? key.error() : searchLimit.error();
+        }
+        return repository_->findByPhonePrefix(*key, *searchLimit);
+    }
+
+    ServiceResult<oatpp::Object<ContactDto>> updateContact(const oatpp::Object<ContactDto>& contact) {
+        if (auto error = validateContact(contact, true)) {
+            return std::move(*error);
+        }
+        ContactRepository::Conflict conflict;
+        auto result = repository_->update(contact, &conflict);
+        if (!result) {
+            return updateConflictError(conflict);
+        }
+        return result;
+    }
+
+    // Only the non-null fields of changes are validated and applied; an id in the body is ignored
+    // expectedVersion makes the patch conditional (see ContactRepository::patch), the new version is
+    // reported through version if given
+    ServiceResult<oatpp::Object<ContactDto>> patchContact(oatpp::Int64 id, const oatpp::Object<ContactDto>& changes,
+                                                          std::optional<uint64_t> expectedVersion,
+                                                          uint64_t* version = nullptr) {
+        if (!id || *id <= 0) {
+            return ServiceError::invalid("Invalid ID");
+        }
+        if (auto error = validateChanges(changes)) {
+            return std::move(*error);
+        }
+        ContactRepository::Conflict conflict;
+        auto result = repository_->patch(*id, changes, expectedVersion, &conflict, version);
         if (!result) {
-            throw std::runtime_error("Contact not found");
+            if (conflict == ContactRepository::Conflict::VersionMismatch) {
+                return ServiceError::preconditionFailed();
+            }
+            return updateConflictError(conflict);
         }
         return result;
     }
 
-    bool deleteContact(oatpp::Int64 id) {
-        if (id <= 0) {
-            throw std::runtime_error("Invalid ID");
+    ServiceResult<void> deleteContact(oatpp::Int64 id) {
+        if (!id || *id <= 0) {
+            return ServiceError::invalid("Invalid ID");
+        }
+        if (!repository_->remove(id)) {
+            return ServiceError::notFound();
+        }
+        return {};
+    }
+
+    // Batch variants: all items are validated in one pass and the valid ones are written together;
+    // each item fails or succeeds on its own, with the same rules as the single-item calls
+    ServiceResult<std::vector<BatchOutcome>> createContacts(const std::vector<oatpp::Object<ContactDto>>& contacts) {
+        if (auto error = validateBatchSize(contacts.size())) {
+            return std::move(*error);
+        }
+        std::vector<BatchOutcome> outcomes(contacts.size());
+        std::vector<oatpp::Object<ContactDto>> accepted;
+        std::vector<size_t> positions;
+        for (size_t i = 0; i < contacts.size(); ++i) {
+            if (auto error = validateNewContact(contacts[i])) {
+                outcomes[i].error = std::move(error);
+                continue;
+            }
+            outcomes[i].id = contacts[i]->id;
+            accepted.push_back(contacts[i]);
+            positions.push_back(i);
         }
-        return repository_->remove(id);
+
+        auto results = repository_->createBatch(accepted);
+        for (size_t k = 0; k < results.size(); ++k) {
+            auto& outcome = outcomes[positions[k]];
+            if (results[k].contact) {
+                outcome.contact = results[k].contact;
+                outcome.id = results[k].contact->id;
+            } else {
+                outcome.error = createConflictError(results[k].conflict);
+            }
+        }
+        return outcomes;
+    }
+
+    ServiceResult<std::vector<BatchOutcome>> updateContacts(const std::vector<oatpp::Object<ContactDto>>& contacts) {
+        if (auto error = validateBatchSize(contacts.size())) {
+            return std::move(*error);
+        }
+        std::vector<BatchOutcome> outcomes(contacts.size());
+        std::vector<oatpp::Object<ContactDto>> accepted;
+        std::vector<size_t> positions;
+        for (size_t i = 0; i < contacts.size(); ++i) {
+            if (contacts[i]) {
+                outcomes[i].id = contacts[i]->id;
+            }
+            if (auto error = validateContact(contacts[i], true)) {
+                outcomes[i].error = std::move(error);
+                continue;
+            }
+            accepted.push_back(contacts[i]);
+            positions.push_back(i);
+        }
+
+        auto results = repository_->updateBatch(accepted);
+        for (size_t k = 0; k < results.size(); ++k) {
+            auto& outcome = outcomes[positions[k]];
+            if (results[k].contact) {
+                outcome.contact = results[k].contact;
+            } else {
+                outcome.error = updateConflictError(results[k].conflict);
+            }
+        }
+        return outcomes;
+    }
+
+    ServiceResult<std::vector<BatchOutcome>> deleteContacts(const std::vector<oatpp::Int64>& ids) {
+        if (auto error = validateBatchSize(ids.size())) {
+            return std::move(*error);
+        }
+        std::vector<BatchOutcome> outcomes(ids.size());
+        std::vector<int64_t> accepted;
+        std::vector<size_t> positions;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            outcomes[i].id = ids[i];
+            if (!ids[i] || *ids[i] <= 0) {
+                outcomes[i].error = ServiceError::invalid("Invalid ID");
+                continue;
+            }
+            accepted.push_back(*ids[i]);
+            positions.push_back(i);
+        }
+
+        auto removed = repository_->removeBatch(accepted);
+        for (size_t k = 0; k < removed.size(); ++k) {
+            if (!removed[k]) {
+                outcomes[positions[k]].error = ServiceError::notFound();
+            }
+        }
+        return outcomes;
+    }
+
+    // Contacts with the given comma-separated ids, in the order requested; unknown ids are skipped
+    ServiceResult<std::vector<oatpp::Object<ContactDto>>> getContactsByIds(const oatpp::String& ids) {
+        if (!ids || ids->empty()) {
+            return ServiceError::invalid("Invalid ids: expected comma-separated contact IDs");
+        }
+        std::vector<int64_t> parsed;
+        const std::string& value = *ids;
+        size_t start = 0;
+        while (start <= value.size()) {
+            auto end = value.find(',', start);
+            if (end == std::string::npos) {
+                end = value.size();
+            }
+            auto text = value.substr(start, end - start);
+            auto id = parseId(text);
+            if (!id) {
+                return ServiceError::invalid("Invalid ids: '" + text + "' is not a valid contact ID");
+            }
+            parsed.push_back(*id);
+            start = end + 1;
+        }
+        if (auto error = validateBatchSize(parsed.size())) {
+            return std::move(*error);
+        }
+
+        std::vector<oatpp::Object<ContactDto>> result;
+        result.reserve(parsed.size());
+        for (auto& contact : repository_->getByIds(parsed)) {
+            if (contact) {
+                result.push_back(std::move(contact));
+            }
+        }
+        return result;
     }
 private:
     std::shared_ptr<ContactRepository> repository_;
 
-    void validateContact(const oatpp::Object<ContactDto>& contact, bool requiredId) {
+    static std::optional<ServiceError> validateBatchSize(size_t size) {
+        if (size == 0 || size > kMaxBatchSize) {
+            return ServiceError::invalid("Invalid batch: expected 1 to " + std::to_string(kMaxBatchSize) + " items");
+        }
+        return std::nullopt;
+    }
+
+    // The whole token has to be a positive number in plain digits: " 5", "+6" or "7 " is not an id
+    static std::optional<int64_t> parseId(const std::string& text) {
+        int64_t id = 0;
+        auto end = text.data() + text.size();
+        auto result = std::from_chars(text.data(), end, id);
+        if (text.empty() || result.ec != std::errc() || result.ptr != end || id <= 0) {
+            return std::nullopt;
+        }
+        return id;
+    }
+
+    static ServiceError createConflictError(ContactRepository::Conflict conflict) {
+        if (conflict == ContactRepository::Conflict::DuplicatePhone) {
+            return ServiceError::conflict("Failed to create contact: phone already exists");
+        }
+        return ServiceError::conflict("Failed to create contact: ID already exists");
+    }
+
+    static ServiceError updateConflictError(ContactRepository::Conflict conflict) {
+        if (conflict == ContactRepository::Conflict::DuplicatePhone) {
+            return ServiceError::conflict("Failed to update contact: phone already exists");
+        }
+        return ServiceError::notFound();
+    }
+
+    static ServiceResult<PhoneKey> parsePhoneQuery(const oatpp::String& phone, size_t minDigits) {
+        if (!phone || phone->empty()) {
+            return ServiceError::invalid("Phone is required");
+        }
+        // A '+' sent unencoded decodes to a space, which finds the same number: the '+' of a phone is optional
+        // and spaces are separators, so "+7...", "%2B7...", "%2b7..." and " 7..." are one query
+        auto value = decodeQueryValue(*phone);
+        if (!value) {
+            return ServiceError::invalid("Invalid phone");
+        }
+        auto key = PhoneKey::parse(*value, minDigits);
+        if (!key) {
+            return ServiceError::invalid("Invalid phone");
+        }
+        return *key;
+    }
+
+    // A query string value as sent (application/x-www-form-urlencoded): "%XX" escapes in either case, '+' for
+    // a space; nullopt on a malformed escape
+    static std::optional<std::string> decodeQueryValue(const std::string& value) {
+        auto hexDigit = [](char c) {
+            return c >= '0' && c <= '9' ? c - '0'
+                 : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                 : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                 : -1;
+        };
+        std::string result;
+        result.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '+') {
+                result += ' ';
+            } else if (value[i] != '%') {
+                result += value[i];
+            } else {
+                auto high = i + 2 < value.size() ? hexDigit(value[i + 1]) : -1;
+                auto low = high >= 0 ? hexDigit(value[i + 2]) : -1;
+                if (low < 0) {
+                    return std::nullopt;
+                }
+                result += static_cast<char>(high << 4 | low);
+                i += 2;
+            }
+        }
+        return result;
+    }
+
+    static ServiceResult<size_t> validateOffset(const oatpp::Int64& offset) {
+        if (!offset) {
+            return static_cast<size_t>(0);
+        }
+        if (*offset < 0) {
+            return ServiceError::invalid("Invalid offset: must not be negative");
+        }
+        return static_cast<size_t>(*offset);
+    }
+
+    static ServiceResult<size_t> validateLimit(const oatpp::Int64& limit, int64_t defaultLimit) {
+        if (!limit) {
+            return static_cast<size_t>(defaultLimit);
+        }
+        if (*limit <= 0 || *limit > kMaxPageSize) {
+            return ServiceError::invalid("Invalid limit: must be between 1 and " + std::to_string(kMaxPageSize));
+        }
+        return static_cast<size_t>(*limit);
+    }
+
+    // Cursor format: "c1" (ascending) or "d1" (descending) + 16 hex digits of the last returned id;
+    // clients treat it as opaque
+    static oatpp::String encodeCursor(int64_t lastId, bool descending = false) {
+        char buffer[19];
+        std::snprintf(buffer, sizeof(buffer), "%s%016llx", descending ? "d1" : "c1",
+                      static_cast<unsigned long long>(static_cast<uint64_t>(lastId)));
+        return oatpp::String(buffer);
+    }
+
+    static std::optional<int64_t> decodeCursor(const oatpp::String& cursor, bool descending = false) {
+        const std::string& value = *cursor;
+        if (value.size() != 18 || value.compare(0, 2, descending ? "d1" : "c1") != 0) {
+            return std::nullopt;
+        }
+        uint64_t id = 0;
+        for (size_t i = 2; i < value.size(); ++i) {
+            char c = value[i];
+            id <<= 4;
+            if (c >= '0' && c <= '9') {
+                id |= static_cast<uint64_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                id |= static_cast<uint64_t>(c - 'a' + 10);
+            } else {
+                return std::nullopt;
+            }
+        }
+        return static_cast<int64_t>(id);
+    }
+
+    // Sync token format: "<epoch hex>-<version hex>", bound to the server run like entity tags
+    oatpp::String encodeSyncToken(uint64_t version) {
+        char buffer[40];
+        std::snprintf(buffer, sizeof(buffer), "%llx-%llx", static_cast<unsigned long long>(repository_->epoch()),
+                      static_cast<unsigned long long>(version));
+        return oatpp::String(buffer);
+    }
+
+    // The token's version, kForeignEpoch for a well-formed token of another server run
+    std::optional<uint64_t> decodeSyncToken(const oatpp::String& token) {
+        std::string_view value = *token;
+        auto dash = value.find('-');
+        uint64_t epoch = 0;
+        uint64_t version = 0;
+        if (dash == std::string_view::npos || !HexNumber::parse(value.substr(0, dash), epoch) ||
+            !HexNumber::parse(value.substr(dash + 1), version) || version == 0 || version == kForeignEpoch) {
+            return std::nullopt;
+        }
+        return epoch == repository_->epoch() ? version : kForeignEpoch;
+    }
+
+    // Validation returns the first problem found, or nullopt for a valid contact
+    std::optional<ServiceError> validateNewContact(const oatpp::Object<ContactDto>& contact) {
+        if (auto error = validateContact(contact, false)) {
+            return error;
+        }
+
+        if (contact->id && *contact->id < 0) {
+            return ServiceError::invalid("Invalid ID: ID must be positive or zero");
+        }
+        return std::nullopt;
+    }
+
+    std::optional<ServiceError> validateContact(const oatpp::Object<ContactDto>& contact, bool requiredId) {
+        if (!contact) {
+            return ServiceError::invalid("Contact is required");
+        }
+
         if (requiredId && (!contact->id || *contact->id <= 0)) {
-            throw std::runtime_error("Valid ID is required");
+            return ServiceError::invalid("Valid ID is required");
         }
 
         if (!contact->name || contact->name->empty()) {
-            throw std::runtime_error("Name is required");
+            return ServiceError::invalid("Name is required");
         }
 
         if (!contact->phone || contact->phone->empty()) {
-            throw std::runtime_error("Phone is required");
+            return ServiceError::invalid("Phone is required");
+        }
+
+        if (auto error = normalizePhone(contact)) {
+            return error;
         }
 
         if (!contact->address || contact->address->empty()) {
-            throw std::runtime_error("Address is required");
+            return ServiceError::invalid("Address is required");
+        }
+        return std::nullopt;
+    }
+
+    // A field given in a patch must be valid on its own; a patch that changes nothing is rejected
+    std::optional<ServiceError> validateChanges(const oatpp::Object<ContactDto>& changes) {
+        if (!changes) {
+            return ServiceError::invalid("Contact is required");
+        }
+        if (!changes->name && !changes->phone && !changes->address) {
+            return ServiceError::invalid("Nothing to update: expected name, phone or address");
+        }
+        if (changes->name && changes->name->empty()) {
+            return ServiceError::invalid("Name must not be empty");
+        }
+        if (changes->phone) {
+            if (changes->phone->empty()) {
+                return ServiceError::invalid("Phone must not be empty");
+            }
+            if (auto error = normalizePhone(changes)) {
+                return error;
+            }
+        }
+        if (changes->address && changes->address->empty()) {
+            return ServiceError::invalid("Address must not be empty");
+        }
+        return std::nullopt;
+    }
+
+    // Phones are stored in canonical "+<digits>" form, which is also what the phone index keys on
+    static std::optional<ServiceError> normalizePhone(const oatpp::Object<ContactDto>& contact) {
+        auto phone = PhoneKey::parse(*contact->phone, kMinPhoneDigits);
+        if (!phone) {
+            return ServiceError::invalid("Invalid phone: expected " + std::to_string(kMinPhoneDigits) + "-" +
+                                         std::to_string(PhoneKey::kMaxDigits) +
+                                         " digits with optional '+', spaces, dashes, dots or parentheses");
         }
+        contact->phone = phone->toE164();
+        return std::nullopt;
     }
 };
\ No newline at end of file
@@ -0,0 +1,22 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+// Hex numbers of the tokens the server hands out: entity tags, sync tokens and change event ids
+class HexNumber {
+public:
+    // All of digits as one 64-bit number in lowercase hex, as the server writes them; false when empty, malformed
+    // or out of range. Tags are compared as strings elsewhere, so "2A" is not taken for "2a" here either
+    static bool parse(std::string_view digits, uint64_t& value) {
+        auto end = digits.data() + digits.size();
+        auto result = std::from_chars(digits.data(), end, value, 16);
+        return !digits.empty() && result.ec == std::errc() && result.ptr == end &&
+               digits.find_first_of("ABCDEF") == std::string_view::npos;
+    }
+};
@@ -0,0 +1,137 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+
+// Kind of an expected failure of a Service call, mapped to an HTTP status by ApiErrorHandler::statusOf
+enum class ErrorCode {
+    // Malformed or missing input (400)
+    InvalidArgument,
+    // No contact with the requested id (404)
+    NotFound,
+    // Uniqueness violated: duplicate id or phone (400, as before typed codes were introduced)
+    Conflict,
+    // A conditional write whose expected version is no longer current (412)
+    PreconditionFailed,
+    // A resource the request refers to no longer exists and won't come back, e.g. an expired sync token (410)
+    Gone
+};
+
+// An expected failure: its code and the message sent as ErrorDto::details
+struct ServiceError {
+    ErrorCode code;
+    std::string message;
+
+    static ServiceError invalid(std::string message) {
+        return {ErrorCode::InvalidArgument, std::move(message)};
+    }
+
+    static ServiceError notFound(std::string message = "Contact not found") {
+        return {ErrorCode::NotFound, std::move(message)};
+    }
+
+    static ServiceError conflict(std::string message) {
+        return {ErrorCode::Conflict, std::move(message)};
+    }
+
+    static ServiceError preconditionFailed(std::string message = "Contact has been modified") {
+        return {ErrorCode::PreconditionFailed, std::move(message)};
+    }
+
+    static ServiceError gone(std::string message) {
+        return {ErrorCode::Gone, std::move(message)};
+    }
+};
+
+// Value of a Service call or the ServiceError it failed with
+// Expected failures (validation, unknown ids, conflicts) travel as values instead of exceptions, which are
+// left for unexpected ones such as a failed journal write. value() on a failed result throws the error's
+// message, which ApiErrorHandler still classifies the old way.
+template<typename T>
+class ServiceResult {
+public:
+    ServiceResult(T value)
+        : state_(std::in_place_index<0>, std::move(value)) {}
+
+    ServiceResult(ServiceError error)
+        : state_(std::in_place_index<1>, std::move(error)) {}
+
+    bool ok() const {
+        return state_.index() == 0;
+    }
+
+    explicit operator bool() const {
+        return ok();
+    }
+
+    T& value() {
+        check();
+        return std::get<0>(state_);
+    }
+
+    const T& value() const {
+        check();
+        return std::get<0>(state_);
+    }
+
+    T* operator->() {
+        return &value();
+    }
+
+    const T* operator->() const {
+        return &value();
+    }
+
+    T& operator*() {
+        return value();
+    }
+
+    const T& operator*() const {
+        return value();
+    }
+
+    const ServiceError& error() const {
+        return std::get<1>(state_);
+    }
+
+private:
+    std::variant<T, ServiceError> state_;
+
+    void check() const {
+        if (!ok()) {
+            throw std::runtime_error(error().message);
+        }
+    }
+};
+
+// Result of a call that has no value on success
+template<>
+class ServiceResult<void> {
+public:
+    ServiceResult() = default;
+
+    ServiceResult(ServiceError error)
+        : error_(std::move(error)) {}
+
+    bool ok() const {
+        return !error_;
+    }
+
+    explicit operator bool() const {
+        return ok();
+    }
+
+    const ServiceError& error() const {
+        return *error_;
+    }
+
+private:
+    std::optional<ServiceError> error_;
+};
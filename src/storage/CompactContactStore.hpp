@@ -0,0 +1,322 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ContactDto.hpp"
+#include "repository/PhoneIndex.hpp"
+#include "storage/RecordPages.hpp"
+#include "storage/StringArena.hpp"
+#include "storage/StringPool.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <oatpp/core/Types.hpp>
+
+// Fixed-width record of a stored contact, the strings live in the owning store's StringArena
+struct ContactRecord {
+    int64_t id;
+    uint64_t name;     // StringArena reference
+    uint64_t phone;    // Inline PhoneKey (top bit set) or StringArena reference
+    uint64_t address;  // StringArena reference to the varint-encoded address components (see encodeAddress)
+    uint64_t version;  // Repository version of the last change, 0 for contents loaded from a snapshot file
+};
+
+// Compact storage of contacts for one repository shard
+// Records are kept in id order in copy-on-write pages (see RecordPages), which snapshots share by pointer;
+// strings are packed into an arena, canonical phones are stored inline as numbers and
+// addresses are dictionary-encoded by their ", "-separated components (cities, streets, ...), which hold
+// references to their StringPool entries until the record is replaced or erased.
+// DTOs are only built on the way out (materialize).
+// Not thread-safe: the repository shard lock serializes access.
+class CompactContactStore {
+public:
+    using Records = RecordPages<ContactRecord>;
+
+    struct MemoryUsage {
+        size_t records = 0;
+        size_t idIndex = 0;
+        size_t strings = 0;
+    };
+
+    explicit CompactContactStore(std::shared_ptr<StringPool> pool)
+        : pool_(std::move(pool))
+        , records_(std::make_shared<Records>()) {}
+
+    const ContactRecord* find(int64_t id) const {
+        return records_->find(id);
+    }
+
+    bool contains(int64_t id) const {
+        return find(id) != nullptr;
+    }
+
+    size_t size() const {
+        return records_->size();
+    }
+
+    // Stores a contact whose id is not present yet
+    void insert(const oatpp::Object<ContactDto>& contact, uint64_t version = 0) {
+        ContactRecord record{};
+        record.id = *contact->id;
+        record.version = version;
+        encodeFields(record, contact);
+        writableRecords().insert(record);
+    }
+
+    // Re-encodes the fields of an existing contact
+    bool replace(const oatpp::Object<ContactDto>& contact, uint64_t version = 0) {
+        if (!contains(*contact->id)) {
+            return false;
+        }
+        auto& record = *writableRecords().findWritable(*contact->id);
+        // Encoded before the old fields are released, so that unchanged address components keep their entries
+        auto old = record;
+        record.version = version;
+        encodeFields(record, contact);
+        releaseFields(old);
+        compactIfNeeded();
+        return true;
+    }
+
+    bool erase(int64_t id) {
+        auto* record = find(id);
+        if (!record) {
+            return false;
+        }
+        releaseFields(*record);
+        writableRecords().erase(id);
+        compactIfNeeded();
+        return true;
+    }
+
+    oatpp::Object<ContactDto> materialize(const ContactRecord& record) const {
+        return materialize(record, arena_.chunkList(), *pool_);
+    }
+
+    static oatpp::Object<ContactDto> materialize(const ContactRecord& record,
+                                                 const StringChunkList& chunks,
+                                                 const StringPool& pool) {
+        auto contact = ContactDto::createShared();
+        contact->id = record.id;
+        contact->name = decodeString(record.name, chunks);
+        contact->phone = decodePhone(record.phone, chunks);
+        contact->address = decodeAddress(record.address, chunks, pool);
+        return contact;
+    }
+
+    std::string nameOf(const ContactRecord& record) const {
+        if (record.name == StringArena::kNullRef) {
+            return {};
+        }
+        return std::string(arena_.read(record.name));
+    }
+
+    std::optional<PhoneKey> phoneKeyOf(const ContactRecord& record) const {
+        if (record.phone == StringArena::kNullRef) {
+            return std::nullopt;
+        }
+        if (record.phone & kInlinePhone) {
+            PhoneKey key;
+            key.digits = record.phone & kPhoneDigitsMask;
+            key.length = static_cast<uint8_t>((record.phone >> kPhoneLengthShift) & 0xF);
+            return key;
+        }
+        return PhoneKey::parse(std::string(arena_.read(record.phone)));
+    }
+
+    // The live records in id order, shared with snapshots: the store copies what it changes from now on
+    std::shared_ptr<const Records> records() const {
+        return records_;
+    }
+
+    // Strings referenced by the current records, shared with snapshots
+    std::shared_ptr<const StringChunkList> chunks() const {
+        return arena_.chunks();
+    }
+
+    const std::shared_ptr<StringPool>& pool() const {
+        return pool_;
+    }
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage;
+        usage.records = records_->recordBytes();
+        usage.idIndex = records_->directoryBytes();
+        usage.strings = arena_.capacityBytes();
+        return usage;
+    }
+
+private:
+    static constexpr uint64_t kInlinePhone = 1ull << 63;
+    static constexpr uint64_t kPhoneLengthShift = 50;
+    static constexpr uint64_t kPhoneDigitsMask = (1ull << kPhoneLengthShift) - 1;
+    static constexpr uint64_t kInlineComponent = 1;
+
+    std::shared_ptr<StringPool> pool_;
+    StringArena arena_;
+    std::shared_ptr<Records> records_;
+
+    // The records, copied first if a snapshot still shares them
+    Records& writableRecords() {
+        if (records_.use_count() != 1) {
+            records_ = std::make_shared<Records>(*records_);
+        } else {
+            // Pairs with the release of the last snapshot's reference, as in RecordPages
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *records_;
+    }
+
+    void encodeFields(ContactRecord& record, const oatpp::Object<ContactDto>& contact) {
+        record.name = contact->name ? arena_.append(*contact->name) : StringArena::kNullRef;
+        record.phone = encodePhone(contact->phone);
+        record.address = encodeAddress(contact->address);
+    }
+
+    void releaseFields(const ContactRecord& record) {
+        arena_.release(record.name);
+        if (!(record.phone & kInlinePhone)) {
+            arena_.release(record.phone);
+        }
+        if (record.address != StringArena::kNullRef) {
+            auto encoded = arena_.read(record.address);
+            size_t position = 0;
+            while (position < encoded.size()) {
+                auto tag = readVarint(encoded, position);
+                if (tag & kInlineComponent) {
+                    position += tag >> 1;
+                } else {
+                    pool_->release(tag >> 1);
+                }
+            }
+        }
+        arena_.release(record.address);
+    }
+
+    uint64_t encodePhone(const oatpp::String& phone) {
+        if (!phone) {
+            return StringArena::kNullRef;
+        }
+        // Canonical numbers (as produced by ContactService) fit into the record itself
+        auto key = PhoneKey::parse(*phone);
+        if (key && key->length > 0 && key->toE164() == *phone) {
+            return kInlinePhone | (static_cast<uint64_t>(key->length) << kPhoneLengthShift) | key->digits;
+        }
+        return arena_.append(*phone);
+    }
+
+    uint64_t encodeAddress(const oatpp::String& address) {
+        if (!address) {
+            return StringArena::kNullRef;
+        }
+        // Per component a varint tag: the pool id shifted left, or the length shifted left with the low bit set
+        // followed by the bytes, for a component the full pool could not take
+        std::string encoded;
+        std::string_view rest(*address);
+        while (true) {
+            auto separator = rest.find(kAddressSeparator);
+            auto component = rest.substr(0, separator);
+            auto id = pool_->intern(component);
+            if (id != StringPool::kNoId) {
+                appendVarint(encoded, static_cast<uint64_t>(id) << 1);
+            } else {
+                appendVarint(encoded, (static_cast<uint64_t>(component.size()) << 1) | kInlineComponent);
+                encoded += component;
+            }
+            if (separator == std::string_view::npos) {
+                break;
+            }
+            rest.remove_prefix(separator + kAddressSeparator.size());
+        }
+        return arena_.append(encoded);
+    }
+
+    static oatpp::String decodeString(uint64_t ref, const StringChunkList& chunks) {
+        if (ref == StringArena::kNullRef) {
+            return nullptr;
+        }
+        auto value = StringArena::read(chunks, ref);
+        return oatpp::String(value.data(), static_cast<v_buff_size>(value.size()));
+    }
+
+    static oatpp::String decodePhone(uint64_t phone, const StringChunkList& chunks) {
+        if (phone != StringArena::kNullRef && (phone & kInlinePhone)) {
+            PhoneKey key;
+            key.digits = phone & kPhoneDigitsMask;
+            key.length = static_cast<uint8_t>((phone >> kPhoneLengthShift) & 0xF);
+            return oatpp::String(key.toE164());
+        }
+        return decodeString(phone, chunks);
+    }
+
+    static oatpp::String decodeAddress(uint64_t ref, const StringChunkList& chunks, const StringPool& pool) {
+        if (ref == StringArena::kNullRef) {
+            return nullptr;
+        }
+        auto encoded = StringArena::read(chunks, ref);
+        std::string result;
+        size_t position = 0;
+        while (position < encoded.size()) {
+            if (position > 0) {
+                result += kAddressSeparator;
+            }
+            auto tag = readVarint(encoded, position);
+            if (tag & kInlineComponent) {
+                result += encoded.substr(position, tag >> 1);
+                position += tag >> 1;
+            } else {
+                result += pool.get(static_cast<uint32_t>(tag >> 1));
+            }
+        }
+        return oatpp::String(std::move(result));
+    }
+
+    static void appendVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    static uint64_t readVarint(std::string_view in, size_t& position) {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            auto byte = static_cast<uint8_t>(in[position++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+    }
+
+    // Moves live strings into a fresh arena once most of the old one is garbage
+    // Snapshots keep the old chunks alive for as long as they need them
+    void compactIfNeeded() {
+        if (!arena_.needsCompaction()) {
+            return;
+        }
+        StringArena fresh;
+        auto move = [this, &fresh](uint64_t& ref) {
+            if (ref != StringArena::kNullRef) {
+                ref = fresh.append(arena_.read(ref));
+            }
+        };
+        writableRecords().rewrite([&](ContactRecord& record) {
+            move(record.name);
+            if (!(record.phone & kInlinePhone)) {
+                move(record.phone);
+            }
+            move(record.address);
+        });
+        arena_ = std::move(fresh);
+    }
+
+    static constexpr std::string_view kAddressSeparator = ", ";
+};
@@ -0,0 +1,41 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320) for on-disk record checksums
+class Crc32 {
+public:
+    static uint32_t compute(const void* data, size_t size, uint32_t crc = 0) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        const auto& table = tableInstance();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+private:
+    static constexpr std::array<uint32_t, 256> makeTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                value = (value & 1) ? (value >> 1) ^ 0xEDB88320u : value >> 1;
+            }
+            table[i] = value;
+        }
+        return table;
+    }
+
+    static const std::array<uint32_t, 256>& tableInstance() {
+        static constexpr std::array<uint32_t, 256> table = makeTable();
+        return table;
+    }
+};
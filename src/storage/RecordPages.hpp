@@ -0,0 +1,236 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Records of one shard in id order, split into small pages that are replaced rather than modified once shared
+// A snapshot keeps a pointer to the whole set; the owner then copies the page directory on its next change and
+// each page on its first change after that, so a capture costs one pointer copy and a write O(page) plus, once
+// per capture, O(pages) pointer copies. Pages only referenced by the owner are changed in place.
+// Not thread-safe: the owner (CompactContactStore under the shard lock) serializes changes, shared copies
+// are only read.
+template<typename Record>
+class RecordPages {
+public:
+    static constexpr size_t kMaxPageSize = 128;
+
+    using Page = std::vector<Record>;
+
+    // Record position: page number and offset in the page; pageCount() and 0 past the last record
+    struct Position {
+        size_t page = 0;
+        size_t offset = 0;
+    };
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t pageCount() const {
+        return pages_.size();
+    }
+
+    const Page& page(size_t index) const {
+        return *pages_[index];
+    }
+
+    bool isEnd(const Position& position) const {
+        return position.page >= pages_.size();
+    }
+
+    const Record& at(const Position& position) const {
+        return (*pages_[position.page])[position.offset];
+    }
+
+    // Moves to the next record; position ends up at the end after the last one
+    void next(Position& position) const {
+        if (++position.offset == pages_[position.page]->size()) {
+            ++position.page;
+            position.offset = 0;
+        }
+    }
+
+    // Moves to the previous record; false (and position unchanged) at the first one
+    bool previous(Position& position) const {
+        if (position.offset > 0) {
+            --position.offset;
+            return true;
+        }
+        if (position.page == 0) {
+            return false;
+        }
+        --position.page;
+        position.offset = pages_[position.page]->size() - 1;
+        return true;
+    }
+
+    // First record with id not less than (lower) or greater than (upper) the given one
+    Position lowerBound(int64_t id) const {
+        return bound(id, [](const Record& record, int64_t value) { return record.id < value; });
+    }
+
+    Position upperBound(int64_t id) const {
+        return bound(id, [](const Record& record, int64_t value) { return record.id <= value; });
+    }
+
+    // Records after a position, in O(pages)
+    size_t countFrom(const Position& position) const {
+        if (isEnd(position)) {
+            return 0;
+        }
+        size_t count = pages_[position.page]->size() - position.offset;
+        for (auto i = position.page + 1; i < pages_.size(); ++i) {
+            count += pages_[i]->size();
+        }
+        return count;
+    }
+
+    const Record* find(int64_t id) const {
+        if (pages_.empty()) {
+            return nullptr;
+        }
+        const auto& records = *pages_[pageFor(id)];
+        auto it = lowerBoundIn(records, id);
+        return it != records.end() && it->id == id ? &*it : nullptr;
+    }
+
+    // The record of id, made private to the owner first; nullptr if absent
+    Record* findWritable(int64_t id) {
+        if (!find(id)) {
+            return nullptr;
+        }
+        auto index = pageFor(id);
+        auto& records = writablePage(index);
+        return &*lowerBoundIn(records, id);
+    }
+
+    // Adds a record whose id is not present yet
+    void insert(const Record& record) {
+        ++size_;
+        if (pages_.empty()) {
+            pages_.push_back(std::make_shared<Page>(1, record));
+            firstIds_.push_back(record.id);
+            return;
+        }
+        auto index = pageFor(record.id);
+        auto& records = writablePage(index);
+        auto it = records.insert(lowerBoundIn(records, record.id), record);
+        firstIds_[index] = records.front().id;
+        if (records.size() <= kMaxPageSize) {
+            return;
+        }
+        // Ids are mostly handed out in increasing order: a page full of them is left full, otherwise it is halved
+        auto appended = index + 1 == pages_.size() && it + 1 == records.end();
+        auto splitAt = appended ? records.size() - 1 : records.size() / 2;
+        auto tail = std::make_shared<Page>(records.begin() + static_cast<std::ptrdiff_t>(splitAt), records.end());
+        records.resize(splitAt);
+        firstIds_.insert(firstIds_.begin() + static_cast<std::ptrdiff_t>(index + 1), tail->front().id);
+        pages_.insert(pages_.begin() + static_cast<std::ptrdiff_t>(index + 1), std::move(tail));
+    }
+
+    bool erase(int64_t id) {
+        if (!find(id)) {
+            return false;
+        }
+        --size_;
+        auto index = pageFor(id);
+        auto& records = writablePage(index);
+        records.erase(lowerBoundIn(records, id));
+        if (records.empty()) {
+            pages_.erase(pages_.begin() + static_cast<std::ptrdiff_t>(index));
+            firstIds_.erase(firstIds_.begin() + static_cast<std::ptrdiff_t>(index));
+            return true;
+        }
+        firstIds_[index] = records.front().id;
+        // A sparse page is merged into its successor when both fit in half a page, so pages stay reasonably full
+        if (index + 1 < pages_.size() && records.size() + pages_[index + 1]->size() <= kMaxPageSize / 2) {
+            records.insert(records.end(), pages_[index + 1]->begin(), pages_[index + 1]->end());
+            pages_.erase(pages_.begin() + static_cast<std::ptrdiff_t>(index + 1));
+            firstIds_.erase(firstIds_.begin() + static_cast<std::ptrdiff_t>(index + 1));
+        }
+        return true;
+    }
+
+    // Calls change(record) for every record, in id order; ids must not change
+    template<typename Change>
+    void rewrite(Change&& change) {
+        for (size_t i = 0; i < pages_.size(); ++i) {
+            for (auto& record : writablePage(i)) {
+                change(record);
+            }
+        }
+    }
+
+    // Bytes of the pages (records) and of the directory
+    size_t recordBytes() const {
+        size_t result = 0;
+        for (const auto& page : pages_) {
+            result += page->capacity() * sizeof(Record);
+        }
+        return result;
+    }
+
+    size_t directoryBytes() const {
+        return pages_.capacity() * sizeof(std::shared_ptr<Page>) + firstIds_.capacity() * sizeof(int64_t);
+    }
+
+private:
+    std::vector<std::shared_ptr<Page>> pages_;
+    // First id of every page, searched instead of the pages themselves so a lookup touches one page
+    std::vector<int64_t> firstIds_;
+    size_t size_ = 0;
+
+    template<typename Before>
+    Position bound(int64_t id, Before before) const {
+        if (pages_.empty()) {
+            return Position{};
+        }
+        // Records before the bound's page all are before id, so it is id's page or the one after it
+        auto index = pageFor(id);
+        const auto& records = *pages_[index];
+        auto offset = std::partition_point(records.begin(), records.end(), [&](const Record& record) {
+            return before(record, id);
+        });
+        if (offset == records.end()) {
+            return Position{index + 1, 0};
+        }
+        return Position{index, static_cast<size_t>(offset - records.begin())};
+    }
+
+    // The page that holds id or would hold it: the last one starting at or before id, the first for smaller ids
+    size_t pageFor(int64_t id) const {
+        auto after = std::upper_bound(firstIds_.begin(), firstIds_.end(), id);
+        return after == firstIds_.begin() ? 0 : static_cast<size_t>(after - firstIds_.begin()) - 1;
+    }
+
+    static typename Page::iterator lowerBoundIn(Page& records, int64_t id) {
+        return std::partition_point(records.begin(), records.end(), [&](const Record& record) {
+            return record.id < id;
+        });
+    }
+
+    static typename Page::const_iterator lowerBoundIn(const Page& records, int64_t id) {
+        return std::partition_point(records.begin(), records.end(), [&](const Record& record) {
+            return record.id < id;
+        });
+    }
+
+    Page& writablePage(size_t index) {
+        auto& page = pages_[index];
+        if (page.use_count() != 1) {
+            page = std::make_shared<Page>(*page);
+        } else {
+            // Pairs with the release of the last other reference, so its reads are done before the page changes
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        return *page;
+    }
+};
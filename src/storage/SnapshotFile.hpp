@@ -0,0 +1,380 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ContactDto.hpp"
+#include "repository/ContactSnapshot.hpp"
+#include "storage/Crc32.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <oatpp/core/Types.hpp>
+
+// On-disk layout of a repository snapshot, all integers little-endian
+//
+// [header | record table | string heap | id index]
+// - record table: SnapshotRecord per contact, sorted by id
+// - string heap: raw bytes of names, phones and addresses, referenced by (offset, length)
+// - id index: open-addressing table of record ordinals + 1 (0 = empty), linear probing
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t recordSize;
+    uint64_t journalSequence;  // last journal record contained in the snapshot
+    uint64_t recordCount;
+    int64_t maxId;
+    uint64_t recordsOffset;
+    uint64_t heapOffset;
+    uint64_t heapSize;
+    uint64_t indexOffset;
+    uint64_t indexBuckets;
+    uint32_t reserved;
+    uint32_t headerCrc;        // CRC-32 of the header bytes before this field
+};
+
+struct SnapshotRecord {
+    static constexpr uint32_t kHasName = 1;
+    static constexpr uint32_t kHasPhone = 2;
+    static constexpr uint32_t kHasAddress = 4;
+
+    int64_t id;
+    uint64_t nameOffset;
+    uint64_t phoneOffset;
+    uint64_t addressOffset;
+    uint32_t nameLength;
+    uint32_t phoneLength;
+    uint32_t addressLength;
+    uint32_t flags;
+};
+
+static_assert(sizeof(SnapshotHeader) == 88, "snapshot header layout changed");
+static_assert(sizeof(SnapshotRecord) == 48, "snapshot record layout changed");
+
+// Read-only, memory-mapped snapshot file
+// open() only validates the header and maps the file; pages are read in by the OS as records are
+// touched, so a lookup right after startup costs one index probe and one record page.
+// The file is written once (write() goes through a temporary file and rename) and never modified.
+class SnapshotFile {
+public:
+    static constexpr char kMagic[8] = {'C', 'N', 'T', 'S', 'N', 'A', 'P', '\0'};
+    static constexpr uint32_t kFormatVersion = 1;
+
+    ~SnapshotFile() {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    // Returns nullptr if there is no snapshot at path; throws if the file is not a valid snapshot
+    static std::shared_ptr<SnapshotFile> open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            if (errno == ENOENT) {
+                return nullptr;
+            }
+            throw std::runtime_error("Failed to open snapshot " + path + ": " + std::strerror(errno));
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to open snapshot " + path + ": " + std::strerror(errno));
+        }
+        auto size = static_cast<size_t>(info.st_size);
+        if (size < sizeof(SnapshotHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Invalid snapshot " + path + ": file is truncated");
+        }
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Failed to map snapshot " + path + ": " + std::strerror(errno));
+        }
+
+        std::shared_ptr<SnapshotFile> file(new SnapshotFile(static_cast<const char*>(data), size));
+        file->validate(path);
+        return file;
+    }
+
+    // Writes the snapshot contents to path atomically: readers see either the old file or the complete new one
+    // Throws unless the new file is durable, its directory entry included, so a caller never drops the journal
+    // records it covers while a crash could still bring back the old file
+    static void write(const std::string& path, const ContactSnapshot& snapshot, uint64_t journalSequence) {
+        auto temporaryPath = path + ".tmp";
+        int fd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to write snapshot " + temporaryPath + ": " + std::strerror(errno));
+        }
+        try {
+            writeContents(fd, snapshot, journalSequence);
+            if (::fsync(fd) != 0) {
+                throw std::runtime_error(std::string("fsync: ") + std::strerror(errno));
+            }
+        } catch (const std::exception& e) {
+            ::close(fd);
+            ::unlink(temporaryPath.c_str());
+            throw std::runtime_error("Failed to write snapshot " + temporaryPath + ": " + e.what());
+        }
+        ::close(fd);
+
+        if (::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+            throw std::runtime_error("Failed to replace snapshot " + path + ": " + std::strerror(errno));
+        }
+        auto directoryError = syncDirectoryOf(path);
+        if (!directoryError.empty()) {
+            throw std::runtime_error("Failed to sync the directory of snapshot " + path + ": " + directoryError);
+        }
+    }
+
+    uint64_t journalSequence() const {
+        return header().journalSequence;
+    }
+
+    size_t size() const {
+        return static_cast<size_t>(header().recordCount);
+    }
+
+    int64_t maxId() const {
+        return header().maxId;
+    }
+
+    const SnapshotRecord& record(size_t ordinal) const {
+        return records_[ordinal];
+    }
+
+    const SnapshotRecord* find(int64_t id) const {
+        auto mask = buckets_ - 1;
+        for (auto bucket = hashOf(id) & mask;; bucket = (bucket + 1) & mask) {
+            auto entry = index_[bucket];
+            if (entry == 0) {
+                return nullptr;
+            }
+            const auto& candidate = records_[entry - 1];
+            if (candidate.id == id) {
+                return &candidate;
+            }
+        }
+    }
+
+    oatpp::Object<ContactDto> materialize(const SnapshotRecord& record) const {
+        auto contact = ContactDto::createShared();
+        contact->id = record.id;
+        contact->name = stringOf(record.nameOffset, record.nameLength, record.flags & SnapshotRecord::kHasName);
+        contact->phone = stringOf(record.phoneOffset, record.phoneLength, record.flags & SnapshotRecord::kHasPhone);
+        contact->address = stringOf(record.addressOffset, record.addressLength,
+                                    record.flags & SnapshotRecord::kHasAddress);
+        return contact;
+    }
+
+    // Hints the OS to read the record table and heap ahead, for a sequential pass over all records
+    void adviseSequential() const {
+        ::madvise(const_cast<char*>(data_), size_, MADV_SEQUENTIAL);
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    const SnapshotRecord* records_ = nullptr;
+    const char* heap_ = nullptr;
+    const uint32_t* index_ = nullptr;
+    uint64_t buckets_ = 0;
+
+    SnapshotFile(const char* data, size_t size)
+        : data_(data)
+        , size_(size) {}
+
+    const SnapshotHeader& header() const {
+        return *reinterpret_cast<const SnapshotHeader*>(data_);
+    }
+
+    static uint64_t hashOf(int64_t id) {
+        auto value = static_cast<uint64_t>(id) + 0x9E3779B97F4A7C15ull;
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+        return value ^ (value >> 31);
+    }
+
+    static uint32_t headerCrc(const SnapshotHeader& header) {
+        return Crc32::compute(&header, offsetof(SnapshotHeader, headerCrc));
+    }
+
+    void validate(const std::string& path) {
+        const auto& h = header();
+        auto fail = [&path](const char* reason) {
+            throw std::runtime_error("Invalid snapshot " + path + ": " + reason);
+        };
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0) {
+            fail("not a snapshot file");
+        }
+        if (headerCrc(h) != h.headerCrc) {
+            fail("header checksum mismatch");
+        }
+        if (h.formatVersion != kFormatVersion || h.recordSize != sizeof(SnapshotRecord)) {
+            fail("unsupported format version");
+        }
+        if (h.recordsOffset + h.recordCount * sizeof(SnapshotRecord) > h.heapOffset ||
+            h.heapOffset + h.heapSize > h.indexOffset ||
+            h.indexOffset + h.indexBuckets * sizeof(uint32_t) > size_ ||
+            h.indexBuckets == 0 || (h.indexBuckets & (h.indexBuckets - 1)) != 0 ||
+            h.indexBuckets <= h.recordCount) {
+            fail("section bounds do not match the file");
+        }
+        records_ = reinterpret_cast<const SnapshotRecord*>(data_ + h.recordsOffset);
+        heap_ = data_ + h.heapOffset;
+        index_ = reinterpret_cast<const uint32_t*>(data_ + h.indexOffset);
+        buckets_ = h.indexBuckets;
+    }
+
+    oatpp::String stringOf(uint64_t offset, uint32_t length, bool present) const {
+        if (!present) {
+            return nullptr;
+        }
+        if (offset + length > header().heapSize) {
+            throw std::runtime_error("Invalid snapshot: string outside of the heap");
+        }
+        return oatpp::String(heap_ + offset, static_cast<v_buff_size>(length));
+    }
+
+    // Buffered sequential writer at a fixed file position
+    class SectionWriter {
+    public:
+        SectionWriter(int fd, uint64_t position)
+            : fd_(fd)
+            , position_(position) {}
+
+        void append(const void* data, size_t size) {
+            buffer_.append(static_cast<const char*>(data), size);
+            if (buffer_.size() >= kBufferSize) {
+                flush();
+            }
+        }
+
+        void flush() {
+            size_t written = 0;
+            while (written < buffer_.size()) {
+                auto result = ::pwrite(fd_, buffer_.data() + written, buffer_.size() - written,
+                                       static_cast<off_t>(position_ + written));
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::runtime_error(std::strerror(errno));
+                }
+                written += static_cast<size_t>(result);
+            }
+            position_ += buffer_.size();
+            buffer_.clear();
+        }
+
+    private:
+        static constexpr size_t kBufferSize = 1 << 20;
+
+        int fd_;
+        uint64_t position_;
+        std::string buffer_;
+    };
+
+    static uint64_t alignTo8(uint64_t value) {
+        return (value + 7) & ~7ull;
+    }
+
+    static void writeContents(int fd, const ContactSnapshot& snapshot, uint64_t journalSequence) {
+        SnapshotHeader header{};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.formatVersion = kFormatVersion;
+        header.recordSize = sizeof(SnapshotRecord);
+        header.journalSequence = journalSequence;
+        header.recordCount = snapshot.size();
+        header.recordsOffset = alignTo8(sizeof(SnapshotHeader));
+        header.heapOffset = header.recordsOffset + header.recordCount * sizeof(SnapshotRecord);
+
+        // Buckets: power of two, at most half full
+        header.indexBuckets = 1;
+        while (header.indexBuckets < header.recordCount * 2 + 1) {
+            header.indexBuckets <<= 1;
+        }
+        std::vector<uint32_t> index(header.indexBuckets, 0);
+        auto mask = header.indexBuckets - 1;
+
+        SectionWriter records(fd, header.recordsOffset);
+        SectionWriter heap(fd, header.heapOffset);
+        uint64_t heapSize = 0;
+        int64_t maxId = 0;
+        uint32_t ordinal = 0;
+
+        auto appendString = [&heap, &heapSize](const oatpp::String& value, uint64_t& offset, uint32_t& length) {
+            offset = heapSize;
+            length = value ? static_cast<uint32_t>(value->size()) : 0;
+            if (length > 0) {
+                heap.append(value->data(), length);
+                heapSize += length;
+            }
+        };
+
+        ContactSnapshot::Cursor cursor(snapshot, std::numeric_limits<int64_t>::min());
+        while (auto contact = cursor.next()) {
+            SnapshotRecord record{};
+            record.id = *contact->id;
+            record.flags = (contact->name ? SnapshotRecord::kHasName : 0) |
+                           (contact->phone ? SnapshotRecord::kHasPhone : 0) |
+                           (contact->address ? SnapshotRecord::kHasAddress : 0);
+            appendString(contact->name, record.nameOffset, record.nameLength);
+            appendString(contact->phone, record.phoneOffset, record.phoneLength);
+            appendString(contact->address, record.addressOffset, record.addressLength);
+            records.append(&record, sizeof(record));
+
+            auto bucket = hashOf(record.id) & mask;
+            while (index[bucket] != 0) {
+                bucket = (bucket + 1) & mask;
+            }
+            index[bucket] = ++ordinal;
+            maxId = std::max(maxId, record.id);
+        }
+        records.flush();
+        heap.flush();
+
+        header.maxId = maxId;
+        header.heapSize = heapSize;
+        header.indexOffset = alignTo8(header.heapOffset + heapSize);
+        SectionWriter indexWriter(fd, header.indexOffset);
+        indexWriter.append(index.data(), index.size() * sizeof(uint32_t));
+        indexWriter.flush();
+
+        header.headerCrc = headerCrc(header);
+        SectionWriter headerWriter(fd, 0);
+        headerWriter.append(&header, sizeof(header));
+        headerWriter.flush();
+    }
+
+    // Error message of a failed open or fsync of the file's directory, empty on success
+    static std::string syncDirectoryOf(const std::string& path) {
+        auto slash = path.rfind('/');
+        auto directory = slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+        int fd = ::open(directory.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return std::strerror(errno);
+        }
+        std::string error;
+        if (::fsync(fd) != 0) {
+            error = std::strerror(errno);
+        }
+        ::close(fd);
+        return error;
+    }
+};
@@ -0,0 +1,143 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Fixed-capacity block of string bytes
+// Bytes below "used" never change once written, so readers holding the chunk can read them
+// while the owner keeps appending behind them
+struct StringChunk {
+    explicit StringChunk(size_t capacity)
+        : data(new char[capacity])
+        , capacity(capacity) {}
+
+    std::unique_ptr<char[]> data;
+    size_t capacity;
+    size_t used = 0;
+};
+
+using StringChunkList = std::vector<std::shared_ptr<StringChunk>>;
+
+// Append-only string storage in large chunks, addressed by 64-bit references
+// Reference layout: chunk index (23 bits) | offset in chunk (24 bits) | length (16 bits).
+// Strings of 0xFFFF bytes and longer keep their real length in 4 bytes in front of the data.
+// Not thread-safe: the owner (a repository shard) serializes writers. The chunk list is replaced,
+// never modified, when a chunk is added, so a copy of it stays valid for snapshot readers.
+class StringArena {
+public:
+    // Chunks start small and double up to kChunkSize, so that small repositories stay small
+    static constexpr size_t kInitialChunkSize = 4 << 10;
+    static constexpr size_t kChunkSize = 1 << 20;
+    static constexpr uint64_t kNullRef = ~0ull;
+
+    StringArena()
+        : chunks_(std::make_shared<StringChunkList>()) {}
+
+    uint64_t append(std::string_view value) {
+        bool longString = value.size() >= kLongLength;
+        size_t required = value.size() + (longString ? sizeof(uint32_t) : 0);
+        if (chunks_->empty() || chunks_->back()->capacity - chunks_->back()->used < required) {
+            addChunk(required);
+        }
+
+        auto& chunk = *chunks_->back();
+        auto offset = chunk.used;
+        if (longString) {
+            auto length = static_cast<uint32_t>(value.size());
+            std::memcpy(chunk.data.get() + chunk.used, &length, sizeof(length));
+            chunk.used += sizeof(length);
+        }
+        if (!value.empty()) {
+            std::memcpy(chunk.data.get() + chunk.used, value.data(), value.size());
+        }
+        chunk.used += value.size();
+        liveBytes_ += required;
+
+        return (static_cast<uint64_t>(chunks_->size() - 1) << 40) |
+               (static_cast<uint64_t>(offset) << 16) |
+               (longString ? kLongLength : value.size());
+    }
+
+    // Marks the bytes of a reference as garbage, they are reclaimed by compaction
+    void release(uint64_t ref) {
+        if (ref == kNullRef) {
+            return;
+        }
+        auto size = storedSize(*chunks_, ref);
+        liveBytes_ -= size;
+        deadBytes_ += size;
+    }
+
+    std::string_view read(uint64_t ref) const {
+        return read(*chunks_, ref);
+    }
+
+    static std::string_view read(const StringChunkList& chunks, uint64_t ref) {
+        const auto& chunk = *chunks[ref >> 40];
+        auto offset = static_cast<size_t>((ref >> 16) & 0xFFFFFF);
+        size_t length = ref & 0xFFFF;
+        if (length == kLongLength) {
+            uint32_t longLength;
+            std::memcpy(&longLength, chunk.data.get() + offset, sizeof(longLength));
+            return {chunk.data.get() + offset + sizeof(longLength), longLength};
+        }
+        return {chunk.data.get() + offset, length};
+    }
+
+    const StringChunkList& chunkList() const {
+        return *chunks_;
+    }
+
+    // Chunks referenced by the current strings, shared with snapshots
+    std::shared_ptr<const StringChunkList> chunks() const {
+        return chunks_;
+    }
+
+    // More garbage than live data and at least one chunk worth of it
+    bool needsCompaction() const {
+        return deadBytes_ > liveBytes_ && deadBytes_ >= kChunkSize;
+    }
+
+    size_t liveBytes() const {
+        return liveBytes_;
+    }
+
+    size_t capacityBytes() const {
+        size_t result = 0;
+        for (const auto& chunk : *chunks_) {
+            result += chunk->capacity;
+        }
+        return result + chunks_->capacity() * sizeof(std::shared_ptr<StringChunk>);
+    }
+
+private:
+    static constexpr size_t kLongLength = 0xFFFF;
+
+    std::shared_ptr<StringChunkList> chunks_;
+    size_t liveBytes_ = 0;
+    size_t deadBytes_ = 0;
+
+    static size_t storedSize(const StringChunkList& chunks, uint64_t ref) {
+        size_t length = ref & 0xFFFF;
+        if (length == kLongLength) {
+            return read(chunks, ref).size() + sizeof(uint32_t);
+        }
+        return length;
+    }
+
+    void addChunk(size_t required) {
+        // Copy-on-write: snapshots keep the list they captured
+        auto chunks = std::make_shared<StringChunkList>(*chunks_);
+        auto capacity = chunks_->empty() ? kInitialChunkSize : std::min(kChunkSize, chunks_->back()->capacity * 2);
+        chunks->push_back(std::make_shared<StringChunk>(std::max(capacity, required)));
+        chunks_ = chunks;
+    }
+};
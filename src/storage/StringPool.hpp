@@ -0,0 +1,198 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Dictionary that interns repeated strings (address components) into 32-bit ids
+// Entries are reference counted by the records using them; intern() and release() are serialized by a
+// mutex. get() takes no lock: entries live in fixed-size blocks that never move, and an id only reaches a
+// reader through a shard lock or a published snapshot, both of which order it after the entry was written.
+// An entry released by its last record is reused only after the readers that may still decode it are gone:
+// whoever reads records outside the shard locks (snapshots, delta sync) holds a pin(), and ids released while
+// a pin exists wait until every pin taken before the release is dropped.
+class StringPool {
+public:
+    static constexpr uint32_t kMaxEntries = 1u << 28;
+    // Returned by intern() when every id is taken, the caller keeps the string itself
+    static constexpr uint32_t kNoId = ~0u;
+
+    explicit StringPool(uint32_t capacity = kMaxEntries)
+        : capacity_(std::min(capacity, kMaxEntries))
+        , blockCount_((capacity_ + kBlockSize - 1) >> kBlockBits)
+        , blocks_(new std::atomic<std::string*>[blockCount_]())
+        , current_(std::make_shared<Epoch>(this)) {}
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // Takes a reference to the entry of value, adding it if needed
+    uint32_t intern(std::string_view value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = lookup_.find(value);
+        if (it != lookup_.end()) {
+            ++references_[it->second];
+            return it->second;
+        }
+
+        uint32_t id;
+        reclaimLocked();
+        if (!free_.empty()) {
+            id = free_.back();
+            free_.pop_back();
+        } else if (size_ < capacity_) {
+            id = size_++;
+            auto blockIndex = id >> kBlockBits;
+            if (!blocks_[blockIndex].load(std::memory_order_relaxed)) {
+                ownedBlocks_.emplace_back(new std::string[kBlockSize]);
+                blocks_[blockIndex].store(ownedBlocks_.back().get(), std::memory_order_release);
+            }
+            references_.push_back(0);
+        } else {
+            return kNoId;
+        }
+
+        auto& entry = slot(id);
+        entry.assign(value.data(), value.size());
+        bytes_ += heapBytes(entry);
+        references_[id] = 1;
+        // The entry never moves, so the key can point into it
+        lookup_.emplace(std::string_view(entry), id);
+        return id;
+    }
+
+    // Drops a reference taken by intern()
+    void release(uint32_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--references_[id] > 0) {
+            return;
+        }
+        lookup_.erase(std::string_view(slot(id)));
+        current_->retired.push_back(id);
+        reclaimLocked();
+    }
+
+    std::string_view get(uint32_t id) const {
+        const auto* block = blocks_[id >> kBlockBits].load(std::memory_order_acquire);
+        return block[id & kBlockMask];
+    }
+
+    // Keeps every id that is live now readable until the returned pointer is dropped
+    std::shared_ptr<const void> pin() {
+        // Declared before the lock: if the old epoch goes away here, it recycles after the unlock
+        std::shared_ptr<Epoch> previous;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!current_->retired.empty()) {
+            // Ids retired so far wait for the pins before this one only
+            previous = std::move(current_);
+            current_ = std::make_shared<Epoch>(this);
+            previous->next = current_;
+        }
+        return current_;
+    }
+
+    // Number of entries in use
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lookup_.size();
+    }
+
+    size_t memoryUsage() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return blockCount_ * sizeof(std::atomic<std::string*>) +
+               ownedBlocks_.size() * kBlockSize * sizeof(std::string) +
+               bytes_ +
+               references_.capacity() * sizeof(uint32_t) +
+               free_.capacity() * sizeof(uint32_t) +
+               lookup_.bucket_count() * sizeof(void*) +
+               lookup_.size() * (sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void*));
+    }
+
+private:
+    static constexpr uint32_t kBlockBits = 12;
+    static constexpr uint32_t kBlockSize = 1u << kBlockBits;
+    static constexpr uint32_t kBlockMask = kBlockSize - 1;
+    static constexpr size_t kInlineCapacity = 15;
+
+    // Ids released while the epoch was current; each epoch keeps the next one alive, so they are recycled once
+    // the pins of this and every older epoch are dropped
+    struct Epoch {
+        explicit Epoch(StringPool* pool)
+            : pool(pool) {}
+
+        ~Epoch() {
+            pool->recycle(retired);
+            // Later epochs are unlinked one by one, a long chain would overflow the stack destroyed recursively
+            auto following = std::move(next);
+            while (following && following.use_count() == 1) {
+                auto after = std::move(following->next);
+                following = std::move(after);
+            }
+        }
+
+        StringPool* pool;
+        std::vector<uint32_t> retired;
+        std::shared_ptr<Epoch> next;
+    };
+
+    uint32_t capacity_;
+    uint32_t blockCount_;
+    mutable std::mutex mutex_;
+    std::unique_ptr<std::atomic<std::string*>[]> blocks_;
+    std::vector<std::unique_ptr<std::string[]>> ownedBlocks_;
+    std::unordered_map<std::string_view, uint32_t> lookup_;
+    std::vector<uint32_t> references_;
+    std::vector<uint32_t> free_;
+    uint32_t size_ = 0;
+    size_t bytes_ = 0;
+    // Declared last, so that it is destroyed while the rest of the pool is still intact
+    std::shared_ptr<Epoch> current_;
+
+    std::string& slot(uint32_t id) const {
+        return blocks_[id >> kBlockBits].load(std::memory_order_relaxed)[id & kBlockMask];
+    }
+
+    static size_t heapBytes(const std::string& value) {
+        return value.capacity() > kInlineCapacity ? value.capacity() + 1 : 0;
+    }
+
+    void recycle(const std::vector<uint32_t>& ids) {
+        if (ids.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto id : ids) {
+            recycleLocked(id);
+        }
+    }
+
+    // The pool's own pointer is the only one to the current epoch: no pin can hold its ids any more
+    // (a pin is only taken under the mutex, and older epochs would hold a pointer too)
+    void reclaimLocked() {
+        if (current_.use_count() != 1 || current_->retired.empty()) {
+            return;
+        }
+        for (auto id : current_->retired) {
+            recycleLocked(id);
+        }
+        current_->retired.clear();
+    }
+
+    void recycleLocked(uint32_t id) {
+        // No reader holds the id any more, the string can go
+        auto& entry = slot(id);
+        bytes_ -= heapBytes(entry);
+        std::string().swap(entry);
+        free_.push_back(id);
+    }
+};
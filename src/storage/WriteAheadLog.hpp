@@ -0,0 +1,484 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ContactDto.hpp"
+#include "storage/Crc32.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include <oatpp/core/Types.hpp>
+
+// When a logged write counts as done
+enum class Durability {
+    None,      // handed to the OS (write), no fsync: survives a process crash, not a power loss
+    Batched,   // fsync'ed, concurrent writers share one fsync (group commit)
+    PerWrite   // fsync'ed one record at a time
+};
+
+inline std::optional<Durability> parseDurability(const std::string& value) {
+    if (value == "none") {
+        return Durability::None;
+    }
+    if (value == "batched") {
+        return Durability::Batched;
+    }
+    if (value == "per-write") {
+        return Durability::PerWrite;
+    }
+    return std::nullopt;
+}
+
+// One replayed change
+struct LogEntry {
+    enum class Op : uint8_t {
+        Put = 1,     // create or update, carries the whole contact
+        Remove = 2
+    };
+
+    Op op;
+    uint64_t sequence;
+    int64_t id;
+    oatpp::Object<ContactDto> contact;  // Put only
+};
+
+// Append-only journal of repository changes
+// Record layout (little-endian): payload length (4) | CRC-32 of payload (4) | payload, where
+// payload = op (1) | sequence (8) | id (8) [| name | phone | address], each string being
+// a presence byte, a 4-byte length and the bytes.
+//
+// Group commit: append() only encodes the record into the pending queue and returns its sequence
+// number; sync(sequence) then makes it durable. The first waiting writer becomes the leader,
+// writes everything pending with one write() and one fsync(), and wakes up the followers whose
+// records went out with it. Writers arriving while the leader syncs form the next batch.
+// After an I/O error the log fails for good: sync() throws for every record not yet durable and
+// checkWritable() rejects new writes; a torn record at the end is dropped on replay.
+//
+// Once a snapshot file covers the changes up to some sequence number, discardThrough() rewrites
+// the log without them (a new file renamed over the old one, then the directory is synced);
+// sequence numbers keep growing across rewrites and restarts.
+class WriteAheadLog {
+public:
+    WriteAheadLog(const std::string& path, Durability durability)
+        : path_(path)
+        , durability_(durability) {
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("Failed to open journal " + path + ": " + std::strerror(errno));
+        }
+    }
+
+    ~WriteAheadLog() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Visits all intact records in order and cuts off a torn or corrupt tail
+    // Must be called once before the first append; returns the number of records visited
+    // The visitor runs without the log's lock held, nothing can be appended before replay is over
+    size_t replay(const std::function<void(const LogEntry&)>& visitor) {
+        std::string data = readAll();
+
+        size_t offset = 0;
+        size_t count = 0;
+        uint64_t sequence = 0;
+        while (auto entry = decode(data, offset)) {
+            sequence = entry->sequence;
+            visitor(*entry);
+            ++count;
+        }
+        if (offset < data.size()) {
+            if (::ftruncate(fd_, static_cast<off_t>(offset)) != 0) {
+                throw std::runtime_error("Failed to truncate journal " + path_ + ": " + std::strerror(errno));
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        lastSequence_ = std::max(lastSequence_, sequence);
+        durableSequence_ = lastSequence_;
+        size_ = offset;
+        replayed_ = true;
+        return count;
+    }
+
+    // Continues numbering after a sequence recorded elsewhere (the snapshot file), in case the
+    // log no longer holds records up to it
+    void advanceSequence(uint64_t sequence) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lastSequence_ < sequence) {
+            lastSequence_ = sequence;
+            durableSequence_ = sequence;
+        }
+    }
+
+    // Drops records up to and including sequence, by copying the rest into a new file that replaces the log
+    // Appends keep going meanwhile; their flush waits until the new file is in place.
+    void discardThrough(uint64_t sequence) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        throwIfFailed();
+        flushed_.wait(lock, [this] { return !flushing_; });
+        // Holding the flush role keeps leaders from writing to the old file
+        flushing_ = true;
+        lock.unlock();
+
+        std::string error;
+        uint64_t keptBytes = 0;
+        int replacement = -1;
+        try {
+            std::string data = readAll();
+            std::string kept;
+            size_t offset = 0;
+            while (true) {
+                auto start = offset;
+                auto entry = decode(data, offset);
+                if (!entry) {
+                    break;
+                }
+                if (entry->sequence > sequence) {
+                    kept.append(data, start, offset - start);
+                }
+            }
+            replacement = rewrite(kept);
+            keptBytes = kept.size();
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        // Until the directory is synced, a crash can bring back the old file, without the records that
+        // will be appended to the new one; those are only flushed once this is done
+        auto directoryError = replacement >= 0 ? syncDirectory() : std::string();
+
+        lock.lock();
+        if (replacement >= 0) {
+            ::close(fd_);
+            fd_ = replacement;
+            size_ = keptBytes;
+        }
+        if (!directoryError.empty()) {
+            // The new file is in use already, but appending to it isn't safe
+            error_ = "sync of the journal directory: " + directoryError;
+            error = error_;
+        }
+        flushing_ = false;
+        flushed_.notify_all();
+        if (!error.empty()) {
+            throw std::runtime_error("Failed to compact journal " + path_ + ": " + error);
+        }
+    }
+
+    uint64_t appendPut(const oatpp::Object<ContactDto>& contact) {
+        std::string payload;
+        writeString(payload, contact->name);
+        writeString(payload, contact->phone);
+        writeString(payload, contact->address);
+        return append(LogEntry::Op::Put, *contact->id, payload);
+    }
+
+    uint64_t appendRemove(int64_t id) {
+        return append(LogEntry::Op::Remove, id, {});
+    }
+
+    // Blocks until the record with this sequence number (and all before it) is durable
+    void sync(uint64_t sequence) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (durableSequence_ < sequence) {
+            throwIfFailed();
+            if (flushing_) {
+                flushed_.wait(lock);
+                continue;
+            }
+
+            // Leader: take the batch and write it without holding the lock
+            flushing_ = true;
+            std::string batch;
+            uint64_t batchEnd = durableSequence_;
+            do {
+                batch += pending_.front().second;
+                batchEnd = pending_.front().first;
+                pending_.pop_front();
+            } while (!pending_.empty() && durability_ != Durability::PerWrite);
+
+            lock.unlock();
+            auto error = writeBatch(batch);
+            lock.lock();
+
+            flushing_ = false;
+            if (error.empty()) {
+                durableSequence_ = batchEnd;
+                size_ += batch.size();
+                ++flushCount_;
+            } else {
+                error_ = error;
+            }
+            flushed_.notify_all();
+        }
+    }
+
+    // Throws if an earlier I/O error has made the log unusable
+    void checkWritable() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        throwIfFailed();
+    }
+
+    Durability durability() const {
+        return durability_;
+    }
+
+    const std::string& path() const {
+        return path_;
+    }
+
+    uint64_t lastSequence() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lastSequence_;
+    }
+
+    // Bytes of intact records on disk
+    uint64_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    // Number of write batches handed to the OS (each followed by an fsync unless durability is None)
+    uint64_t flushCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return flushCount_;
+    }
+
+private:
+    static constexpr size_t kHeaderSize = 8;
+    static constexpr size_t kMinPayloadSize = 17;
+    // Larger lengths can only come from a corrupt header
+    static constexpr uint32_t kMaxPayloadSize = 64u << 20;
+
+    std::string path_;
+    Durability durability_;
+    int fd_ = -1;
+
+    std::mutex mutex_;
+    std::condition_variable flushed_;
+    std::deque<std::pair<uint64_t, std::string>> pending_;
+    uint64_t lastSequence_ = 0;
+    uint64_t durableSequence_ = 0;
+    uint64_t size_ = 0;
+    uint64_t flushCount_ = 0;
+    bool flushing_ = false;
+    bool replayed_ = false;
+    std::string error_;
+
+    uint64_t append(LogEntry::Op op, int64_t id, const std::string& fields) {
+        std::string payload;
+        payload.reserve(kMinPayloadSize + fields.size());
+        payload += static_cast<char>(op);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!replayed_) {
+            throw std::runtime_error("Journal " + path_ + " must be replayed before writing");
+        }
+        // No check for an earlier error: the caller has applied the change already and must get to
+        // sync(), which reports the error; the record is never written
+
+        auto sequence = ++lastSequence_;
+        writeInt(payload, sequence);
+        writeInt(payload, static_cast<uint64_t>(id));
+        payload += fields;
+
+        std::string record;
+        record.reserve(kHeaderSize + payload.size());
+        writeInt(record, static_cast<uint32_t>(payload.size()));
+        writeInt(record, Crc32::compute(payload.data(), payload.size()));
+        record += payload;
+        pending_.emplace_back(sequence, std::move(record));
+        return sequence;
+    }
+
+    void throwIfFailed() const {
+        if (!error_.empty()) {
+            throw std::runtime_error("Failed to write journal: " + error_);
+        }
+    }
+
+    // Returns an error description, empty on success
+    std::string writeBatch(const std::string& batch) {
+        size_t written = 0;
+        while (written < batch.size()) {
+            auto result = ::write(fd_, batch.data() + written, batch.size() - written);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return std::strerror(errno);
+            }
+            written += static_cast<size_t>(result);
+        }
+        if (durability_ != Durability::None && ::fsync(fd_) != 0) {
+            return std::strerror(errno);
+        }
+        return {};
+    }
+
+    // Writes the records to a temporary file, renames it over the log and returns the new descriptor
+    int rewrite(const std::string& records) {
+        auto temporaryPath = path_ + ".tmp";
+        int fd = ::open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (fd < 0) {
+            throw std::runtime_error(std::strerror(errno));
+        }
+        int original = fd_;
+        fd_ = fd;
+        auto error = writeBatch(records);
+        fd_ = original;
+        if (error.empty() && durability_ == Durability::None && ::fsync(fd) != 0) {
+            error = std::strerror(errno);
+        }
+        if (error.empty() && ::rename(temporaryPath.c_str(), path_.c_str()) != 0) {
+            error = std::strerror(errno);
+        }
+        if (!error.empty()) {
+            ::close(fd);
+            ::unlink(temporaryPath.c_str());
+            throw std::runtime_error(error);
+        }
+        return fd;
+    }
+
+    // Makes a rename of the log durable, as SnapshotFile does for its file; returns an error description
+    std::string syncDirectory() const {
+        auto slash = path_.rfind('/');
+        auto directory = slash == std::string::npos ? std::string(".") : path_.substr(0, slash);
+        int fd = ::open(directory.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return std::strerror(errno);
+        }
+        std::string error;
+        if (::fsync(fd) != 0) {
+            error = std::strerror(errno);
+        }
+        ::close(fd);
+        return error;
+    }
+
+    std::string readAll() {
+        std::string data;
+        char buffer[1 << 16];
+        off_t position = 0;
+        while (true) {
+            auto result = ::pread(fd_, buffer, sizeof(buffer), position);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::runtime_error("Failed to read journal " + path_ + ": " + std::strerror(errno));
+            }
+            if (result == 0) {
+                return data;
+            }
+            data.append(buffer, static_cast<size_t>(result));
+            position += result;
+        }
+    }
+
+    // Decodes the record at offset and advances past it; nullopt at the end or at a damaged record
+    static std::optional<LogEntry> decode(const std::string& data, size_t& offset) {
+        if (data.size() - offset < kHeaderSize) {
+            return std::nullopt;
+        }
+        auto length = readInt<uint32_t>(data, offset);
+        auto crc = readInt<uint32_t>(data, offset + 4);
+        if (length < kMinPayloadSize || length > kMaxPayloadSize || data.size() - offset - kHeaderSize < length) {
+            return std::nullopt;
+        }
+        const char* payload = data.data() + offset + kHeaderSize;
+        if (Crc32::compute(payload, length) != crc) {
+            return std::nullopt;
+        }
+
+        std::string_view fields(payload, length);
+        LogEntry entry;
+        entry.op = static_cast<LogEntry::Op>(fields[0]);
+        entry.sequence = readInt<uint64_t>(fields, 1);
+        entry.id = static_cast<int64_t>(readInt<uint64_t>(fields, 9));
+        size_t position = kMinPayloadSize;
+
+        if (entry.op == LogEntry::Op::Put) {
+            entry.contact = ContactDto::createShared();
+            entry.contact->id = entry.id;
+            auto name = readString(fields, position);
+            auto phone = readString(fields, position);
+            auto address = readString(fields, position);
+            if (!name || !phone || !address) {
+                return std::nullopt;
+            }
+            entry.contact->name = *name;
+            entry.contact->phone = *phone;
+            entry.contact->address = *address;
+        } else if (entry.op != LogEntry::Op::Remove) {
+            return std::nullopt;
+        }
+
+        offset += kHeaderSize + length;
+        return entry;
+    }
+
+    template<typename T>
+    static void writeInt(std::string& out, T value) {
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            out += static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+    }
+
+    template<typename T>
+    static T readInt(std::string_view in, size_t offset) {
+        T value = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            value |= static_cast<T>(static_cast<uint8_t>(in[offset + i])) << (8 * i);
+        }
+        return value;
+    }
+
+    static void writeString(std::string& out, const oatpp::String& value) {
+        out += static_cast<char>(value ? 1 : 0);
+        writeInt(out, static_cast<uint32_t>(value ? value->size() : 0));
+        if (value) {
+            out += *value;
+        }
+    }
+
+    // Outer nullopt: malformed; inner nullptr: the field was absent
+    static std::optional<oatpp::String> readString(std::string_view in, size_t& position) {
+        if (in.size() - position < 5) {
+            return std::nullopt;
+        }
+        bool present = in[position] != 0;
+        auto length = readInt<uint32_t>(in, position + 1);
+        position += 5;
+        if (in.size() - position < length) {
+            return std::nullopt;
+        }
+        oatpp::String result;
+        if (present) {
+            result = oatpp::String(in.data() + position, static_cast<v_buff_size>(length));
+        }
+        position += length;
+        return result;
+    }
+};
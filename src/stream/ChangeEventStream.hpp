@@ -0,0 +1,166 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ChangeDto.hpp"
+#include "repository/ChangeLog.hpp"
+#include "service/HexNumber.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <oatpp/core/base/Environment.hpp>
+#include <oatpp/core/data/stream/Stream.hpp>
+#include <oatpp/core/data/mapping/ObjectMapper.hpp>
+
+// Response body of GET /contacts/changes/stream: change log events as Server-Sent Events
+// Each event is one frame, "id: <epoch hex>-<sequence hex>" and "data: <ChangeEventDto JSON>", so an
+// EventSource that reconnects sends the last id back (Last-Event-ID) and resumes right after it.
+// A subscriber that resumes from an event the log no longer holds, an id of another server run, or one that
+// falls more than the log's capacity behind gets a "reset" event and continues from the newest change.
+// Events are read from the shared log in batches as the connection asks for more bytes, so a subscriber
+// buffers at most one batch; idle connections get a comment every kHeartbeatInterval, which also finds
+// clients that went away.
+class ChangeEventStream : public oatpp::data::stream::ReadCallback {
+public:
+    enum class Mode {
+        // read() waits for the next event: a thread-per-connection server
+        Blocking,
+        // read() must not block and asks the async executor to call it again after kPollInterval
+        Polling
+    };
+
+    static constexpr size_t kBatchEvents = 256;
+    static constexpr std::chrono::seconds kHeartbeatInterval{15};
+    static constexpr std::chrono::milliseconds kPollInterval{50};
+    static constexpr int kRetryMillis = 3000;
+
+    // lastEventId - id of the last event the subscriber has seen, nullptr to only get changes from now on
+    ChangeEventStream(std::shared_ptr<const ChangeLog> log,
+                      uint64_t epoch,
+                      const oatpp::String& lastEventId,
+                      std::shared_ptr<oatpp::data::mapping::ObjectMapper> objectMapper,
+                      Mode mode)
+        : log_(std::move(log))
+        , epoch_(epoch)
+        , after_(log_->lastSequence())
+        , objectMapper_(std::move(objectMapper))
+        , mode_(mode) {
+        // Tells EventSource how soon to reconnect after the connection drops
+        pending_ = "retry: " + std::to_string(kRetryMillis) + "\n\n";
+        if (lastEventId) {
+            if (auto sequence = parseEventId(*lastEventId, epoch_)) {
+                after_ = *sequence;
+            } else {
+                appendReset(after_);
+            }
+        }
+    }
+
+    v_io_size read(void* buffer, v_buff_size count, oatpp::async::Action& action) override {
+        if (offset_ > 0) {
+            pending_.erase(0, offset_);
+            offset_ = 0;
+        }
+        if (pending_.empty()) {
+            fill();
+        }
+        if (pending_.empty()) {
+            if (mode_ == Mode::Blocking) {
+                if (log_->waitAfter(after_, kHeartbeatInterval)) {
+                    fill();
+                }
+            } else {
+                auto now = oatpp::base::Environment::getMicroTickCount();
+                if (now - lastSent_ < std::chrono::microseconds(kHeartbeatInterval).count()) {
+                    action = oatpp::async::Action::createWaitRepeatAction(
+                        now + std::chrono::microseconds(kPollInterval).count());
+                    return oatpp::IOError::RETRY_READ;
+                }
+            }
+            if (pending_.empty()) {
+                pending_ = ": keep-alive\n\n";
+            }
+        }
+        if (mode_ == Mode::Polling) {
+            lastSent_ = oatpp::base::Environment::getMicroTickCount();
+        }
+
+        auto size = std::min(pending_.size(), static_cast<size_t>(count));
+        std::memcpy(buffer, pending_.data(), size);
+        offset_ = size;
+        return static_cast<v_io_size>(size);
+    }
+
+    // "<epoch hex>-<sequence hex>"; nullopt for a malformed id or one of another epoch
+    static std::optional<uint64_t> parseEventId(std::string_view id, uint64_t epoch) {
+        auto dash = id.find('-');
+        if (dash == std::string_view::npos) {
+            return std::nullopt;
+        }
+        uint64_t idEpoch = 0;
+        uint64_t sequence = 0;
+        if (!HexNumber::parse(id.substr(0, dash), idEpoch) || !HexNumber::parse(id.substr(dash + 1), sequence) || idEpoch != epoch) {
+            return std::nullopt;
+        }
+        return sequence;
+    }
+
+private:
+    std::shared_ptr<const ChangeLog> log_;
+    uint64_t epoch_;
+    uint64_t after_;
+    std::shared_ptr<oatpp::data::mapping::ObjectMapper> objectMapper_;
+    Mode mode_;
+
+    std::string pending_;
+    size_t offset_ = 0;
+    v_int64 lastSent_ = 0;
+
+    void fill() {
+        auto read = log_->readAfter(after_, kBatchEvents);
+        if (read.lagged) {
+            appendReset(read.last);
+            after_ = read.last;
+            return;
+        }
+        for (auto& event : read.events) {
+            auto dto = ChangeEventDto::createShared();
+            dto->sequence = event.sequence;
+            dto->id = event.change.id;
+            dto->version = event.change.version;
+            if (event.change.kind == ContactRepository::ContactChange::Kind::Put) {
+                dto->type = "put";
+                dto->contact = event.change.contact;
+            } else {
+                dto->type = "remove";
+            }
+            appendEvent(event.sequence, dto);
+            after_ = event.sequence;
+        }
+    }
+
+    void appendReset(uint64_t sequence) {
+        auto dto = ChangeEventDto::createShared();
+        dto->sequence = sequence;
+        dto->type = "reset";
+        appendEvent(sequence, dto);
+    }
+
+    void appendEvent(uint64_t sequence, const oatpp::Object<ChangeEventDto>& dto) {
+        char id[40];
+        std::snprintf(id, sizeof(id), "%llx-%llx", static_cast<unsigned long long>(epoch_),
+                      static_cast<unsigned long long>(sequence));
+        pending_ += "id: ";
+        pending_ += id;
+        pending_ += "\ndata: ";
+        pending_ += *objectMapper_->writeToString(dto);
+        pending_ += "\n\n";
+    }
+};
@@ -0,0 +1,92 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "cache/CompressedResponseCache.hpp"
+#include "codec/HttpCompression.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <oatpp/core/data/stream/Stream.hpp>
+#include <oatpp/web/protocol/http/outgoing/Body.hpp>
+
+// Response body that compresses another body while it is being sent (see CompressionInterceptor)
+// Used for bodies of unknown size, the streamed listings and exports: the source is read a block at a time as the
+// connection asks for more, so memory stays bounded as for the uncompressed stream. With a cache key the
+// compressed output is also collected and stored in the cache once the source ends; a body that outgrows the cache's
+// limit is no longer collected, and neither is one whose client went away before the end.
+class CompressingStream : public oatpp::data::stream::ReadCallback {
+public:
+    static constexpr size_t kInputBlock = 16 * 1024;
+
+    // cache may be nullptr, then nothing is collected
+    CompressingStream(std::shared_ptr<oatpp::web::protocol::http::outgoing::Body> source,
+                      ContentCoding coding,
+                      int level,
+                      std::shared_ptr<CompressedResponseCache> cache = nullptr,
+                      std::string cacheKey = {})
+        : source_(std::move(source))
+        , encoder_(coding, level)
+        , cache_(std::move(cache))
+        , cacheKey_(std::move(cacheKey)) {}
+
+    v_io_size read(void* buffer, v_buff_size count, oatpp::async::Action& action) override {
+        if (offset_ > 0) {
+            pending_.erase(0, offset_);
+            offset_ = 0;
+        }
+        char input[kInputBlock];
+        while (pending_.empty() && !finished_) {
+            auto read = source_->read(input, sizeof(input), action);
+            if (read > 0) {
+                encoder_.write({input, static_cast<size_t>(read)}, pending_);
+            } else if (read == 0) {
+                encoder_.finish(pending_);
+                finished_ = true;
+            } else {
+                // The source waits for something (async mode) or failed; the caller handles it as for the source
+                return read;
+            }
+            collect();
+        }
+        if (pending_.empty()) {
+            if (cache_) {
+                cache_->put(cacheKey_, oatpp::String(std::move(collected_)));
+                cache_.reset();
+            }
+            return 0;
+        }
+
+        auto size = std::min(pending_.size(), static_cast<size_t>(count));
+        std::memcpy(buffer, pending_.data(), size);
+        offset_ = size;
+        return static_cast<v_io_size>(size);
+    }
+
+private:
+    std::shared_ptr<oatpp::web::protocol::http::outgoing::Body> source_;
+    HttpCompression::Encoder encoder_;
+    std::shared_ptr<CompressedResponseCache> cache_;
+    std::string cacheKey_;
+
+    std::string pending_;
+    size_t offset_ = 0;
+    std::string collected_;
+    bool finished_ = false;
+
+    void collect() {
+        if (!cache_) {
+            return;
+        }
+        if (!cache_->fits(collected_.size() + pending_.size())) {
+            cache_.reset();
+            collected_.clear();
+            collected_.shrink_to_fit();
+            return;
+        }
+        collected_ += pending_;
+    }
+};
@@ -0,0 +1,206 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "dto/ContactDto.hpp"
+#include "network/BlockingTaskPool.hpp"
+#include "service/ContactService.hpp"
+#include <cstring>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <oatpp/core/data/stream/Stream.hpp>
+#include <oatpp/core/data/mapping/ObjectMapper.hpp>
+
+// Request body sink that imports NDJSON (one contact object per line) while the body is being received
+// Complete lines are parsed as they arrive and created through ContactService in batches, so memory is
+// bounded by the batch size and the longest line rather than the body size. Every line is validated
+// with the same rules as POST /contacts; a bad line is reported with its number and the import goes on.
+// With a BlockingTaskPool (async mode) full batches are created on the pool, and the body transfer waits for
+// them before it hands over the next chunk; finish() then has to be called from the pool as well.
+class ContactImporter : public oatpp::data::stream::WriteCallback,
+                        public std::enable_shared_from_this<ContactImporter> {
+public:
+    static constexpr size_t kBatchSize = 1000;
+    static constexpr size_t kMaxLineLength = 64 * 1024;
+    static constexpr size_t kMaxReportedErrors = 100;
+
+    struct LineError {
+        size_t line;
+        std::string message;
+    };
+
+    struct Summary {
+        size_t imported = 0;
+        size_t failed = 0;
+        // The first kMaxReportedErrors failures, in line order
+        std::vector<LineError> errors;
+    };
+
+    ContactImporter(std::shared_ptr<ContactService> service,
+                    std::shared_ptr<oatpp::data::mapping::ObjectMapper> objectMapper,
+                    std::shared_ptr<BlockingTaskPool> pool = nullptr)
+        : service_(std::move(service))
+        , objectMapper_(std::move(objectMapper))
+        , pool_(std::move(pool)) {}
+
+    v_io_size write(const void* data, v_buff_size count, oatpp::async::Action& action) override {
+        if (flushing_ && !flushing_->done()) {
+            action = flushing_->wait();
+            return oatpp::IOError::RETRY_WRITE;
+        }
+        if (flushing_) {
+            flushing_->rethrow();
+            flushing_.reset();
+        }
+        feed(static_cast<const char*>(data), static_cast<size_t>(count));
+        if (!ready_.empty()) {
+            // The chunk is taken; the transfer goes on once its batches are created
+            flushing_ = pool_->submit([self = shared_from_this()] {
+                for (auto& batch : self->ready_) {
+                    self->create(batch);
+                }
+                self->ready_.clear();
+            });
+            action = flushing_->wait();
+        }
+        return count;
+    }
+
+    void feed(const char* data, size_t size) {
+        const char* end = data + size;
+        while (data < end) {
+            auto* newline = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+            auto* chunkEnd = newline ? newline : end;
+            if (!skipping_) {
+                line_.append(data, static_cast<size_t>(chunkEnd - data));
+                if (line_.size() > kMaxLineLength) {
+                    // The rest of an overlong line is dropped as it arrives
+                    reportError(lineNumber_ + 1, "Invalid line: longer than " + std::to_string(kMaxLineLength) + " bytes");
+                    line_.clear();
+                    skipping_ = true;
+                }
+            }
+            if (!newline) {
+                break;
+            }
+            endLine();
+            data = newline + 1;
+        }
+    }
+
+    // Imports what is left after the body has ended and returns the totals
+    Summary finish() {
+        if (flushing_) {
+            flushing_->rethrow();
+        }
+        if (!line_.empty() || skipping_) {
+            endLine();
+        }
+        flush();
+        return summary_;
+    }
+
+private:
+    std::shared_ptr<ContactService> service_;
+    std::shared_ptr<oatpp::data::mapping::ObjectMapper> objectMapper_;
+    std::shared_ptr<BlockingTaskPool> pool_;
+
+    struct Batch {
+        std::vector<oatpp::Object<ContactDto>> contacts;
+        std::vector<size_t> lines;
+    };
+
+    std::string line_;
+    size_t lineNumber_ = 0;
+    bool skipping_ = false;
+
+    Batch batch_;
+    // Full batches waiting for the pool, and its call creating them
+    std::vector<Batch> ready_;
+    std::shared_ptr<BlockingTaskPool::Task> flushing_;
+    Summary summary_;
+
+    void endLine() {
+        ++lineNumber_;
+        if (skipping_) {
+            skipping_ = false;
+            return;
+        }
+        parseLine();
+        line_.clear();
+    }
+
+    void parseLine() {
+        if (!line_.empty() && line_.back() == '\r') {
+            line_.pop_back();
+        }
+        if (line_.find_first_not_of(" \t") == std::string::npos) {
+            return;
+        }
+
+        oatpp::Object<ContactDto> contact;
+        try {
+            contact = objectMapper_->readFromString<oatpp::Object<ContactDto>>(oatpp::String(line_));
+        } catch (const std::exception& e) {
+            reportError(lineNumber_, std::string("Invalid JSON: ") + e.what());
+            return;
+        }
+        if (!contact) {
+            reportError(lineNumber_, "Invalid JSON: expected a contact object");
+            return;
+        }
+        batch_.contacts.push_back(contact);
+        batch_.lines.push_back(lineNumber_);
+        if (batch_.contacts.size() >= kBatchSize) {
+            if (pool_) {
+                ready_.push_back(std::move(batch_));
+                batch_ = Batch();
+            } else {
+                flush();
+            }
+        }
+    }
+
+    void flush() {
+        if (batch_.contacts.empty()) {
+            return;
+        }
+        create(batch_);
+        batch_ = Batch();
+    }
+
+    void create(const Batch& batch) {
+        // A batch is never empty or larger than the service limit, so only its items can fail
+        auto outcomes = service_->createContacts(batch.contacts);
+        for (size_t i = 0; i < outcomes->size(); ++i) {
+            const auto& outcome = (*outcomes)[i];
+            if (outcome.ok()) {
+                ++summary_.imported;
+            } else {
+                reportError(batch.lines[i], outcome.error->message);
+            }
+        }
+    }
+
+    // Errors of a batch are reported when it is flushed, after parse errors of later lines;
+    // they are kept sorted so that the summary lists them in line order
+    void reportError(size_t line, std::string message) {
+        ++summary_.failed;
+        auto& errors = summary_.errors;
+        auto position = errors.end();
+        while (position != errors.begin() && std::prev(position)->line > line) {
+            --position;
+        }
+        if (errors.size() < kMaxReportedErrors) {
+            errors.insert(position, LineError{line, std::move(message)});
+        } else if (position != errors.end()) {
+            errors.insert(position, LineError{line, std::move(message)});
+            errors.pop_back();
+        }
+    }
+};
@@ -0,0 +1,122 @@
+//
+// Created by Marat on 22.11.25.
+//
+
+#pragma once
+
+#include "codec/ContactMessagePack.hpp"
+#include "dto/ContactDto.hpp"
+#include "repository/ContactSnapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <oatpp/core/data/stream/Stream.hpp>
+#include <oatpp/core/data/mapping/ObjectMapper.hpp>
+
+// Response body source that serializes a snapshot page as a JSON array while it is being written
+// The page is walked in ascending id order, or descending for ?order=desc
+// Contacts are encoded one by one as the connection asks for more bytes, so memory stays
+// bounded by the chunk size instead of growing with the directory
+// Also produces NDJSON and MessagePack arrays (see Format)
+class ContactJsonStream : public oatpp::data::stream::ReadCallback {
+public:
+    enum class Format {
+        // [{...},{...}]
+        Array,
+        // One object per line (NDJSON), each line terminated by '\n'
+        Lines,
+        // MessagePack array; its length is counted from the snapshot up front
+        MessagePack
+    };
+
+    ContactJsonStream(std::shared_ptr<const ContactSnapshot> snapshot,
+                      int64_t afterId,
+                      size_t limit,
+                      std::shared_ptr<oatpp::data::mapping::ObjectMapper> objectMapper,
+                      Format format = Format::Array,
+                      bool descending = false)
+        : snapshot_(std::move(snapshot))
+        , afterId_(afterId)
+        , descending_(descending)
+        , cursor_(*snapshot_, afterId, descending)
+        , remaining_(limit)
+        , unlimited_(limit == 0)
+        , objectMapper_(std::move(objectMapper))
+        , format_(format) {}
+
+    v_io_size read(void* buffer, v_buff_size count, oatpp::async::Action& action) override {
+        (void) action;
+        if (offset_ > 0) {
+            pending_.erase(0, offset_);
+            offset_ = 0;
+        }
+        while (pending_.size() < static_cast<size_t>(count) && !finished_) {
+            fill();
+        }
+
+        auto size = std::min(pending_.size(), static_cast<size_t>(count));
+        std::memcpy(buffer, pending_.data(), size);
+        offset_ = size;
+        return static_cast<v_io_size>(size);
+    }
+
+private:
+    std::shared_ptr<const ContactSnapshot> snapshot_;
+    int64_t afterId_;
+    bool descending_;
+    ContactSnapshot::Cursor cursor_;
+    size_t remaining_;
+    bool unlimited_;
+    std::shared_ptr<oatpp::data::mapping::ObjectMapper> objectMapper_;
+    Format format_;
+
+    std::string pending_;
+    size_t offset_ = 0;
+    bool started_ = false;
+    bool empty_ = true;
+    bool finished_ = false;
+
+    void fill() {
+        if (!started_) {
+            if (format_ == Format::Array) {
+                pending_ += '[';
+            } else if (format_ == Format::MessagePack) {
+                auto count = snapshot_->countAfter(afterId_, descending_);
+                MessagePackWriter(pending_).writeArrayHeader(unlimited_ ? count : std::min(count, remaining_));
+            }
+            started_ = true;
+            return;
+        }
+
+        oatpp::Object<ContactDto> contact;
+        if (unlimited_ || remaining_ > 0) {
+            contact = cursor_.next();
+        }
+        if (!contact) {
+            if (format_ == Format::Array) {
+                pending_ += ']';
+            }
+            finished_ = true;
+            return;
+        }
+
+        if (!empty_ && format_ == Format::Array) {
+            pending_ += ',';
+        }
+        empty_ = false;
+        if (format_ == Format::MessagePack) {
+            MessagePackWriter writer(pending_);
+            ContactMessagePack::write(writer, contact);
+        } else {
+            auto json = objectMapper_->writeToString(contact);
+            pending_.append(json->data(), json->size());
+        }
+        if (format_ == Format::Lines) {
+            pending_ += '\n';
+        }
+        if (!unlimited_) {
+            --remaining_;
+        }
+    }
+};
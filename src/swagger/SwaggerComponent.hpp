@@ -9,7 +9,7 @@
 #include <oatpp-swagger/Resources.hpp>
 
 // Swagger components configuration
-// Note: swaggerController is created in ContactComponent because it depends on ContactController
+// Note: swaggerController is created in ContactComponent because it depends on the contacts controller and server mode
 class SwaggerComponent {
 public:
 
@@ -4,10 +4,28 @@
 
 #pragma once
 
+#include "cache/CompressedResponseCache.hpp"
+#include "cache/ContactJsonCache.hpp"
+#include "codec/HttpCompression.hpp"
+#include "metrics/HttpMetrics.hpp"
+#include "metrics/LatencyHistogram.hpp"
+#include "metrics/MetricsExporter.hpp"
+#include "repository/Checkpointer.hpp"
 #include "repository/ContactRepository.hpp"
+#include "storage/RecordPages.hpp"
+#include "storage/SnapshotFile.hpp"
 #include "dto/ContactDto.hpp"
 #include <oatpp-test/UnitTest.hpp>
 #include <oatpp/core/base/Environment.hpp>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
 
 namespace test {
 
@@ -16,7 +34,7 @@ public:
     ContactRepositoryTest() : UnitTest("TEST[ContactRepositoryTest]") {}
 
     void onRun() override {
-        OATPP_LOGI(TAG, "  [1/10] Testing create contact...");
+        OATPP_LOGI(TAG, "  [1/29] Testing create contact...");
         // Test create contact
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -35,7 +53,7 @@ public:
             OATPP_ASSERT(created->address == "Test Address");
         }
 
-        OATPP_LOGI(TAG, "  [2/10] Testing getById...");
+        OATPP_LOGI(TAG, "  [2/29] Testing getById...");
         // Test getById
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -59,7 +77,7 @@ public:
             OATPP_ASSERT(retrieved->address == "Test Address 2");
         }
 
-        OATPP_LOGI(TAG, "  [3/10] Testing getById with non-existent ID...");
+        OATPP_LOGI(TAG, "  [3/29] Testing getById with non-existent ID...");
         // Test getById with non-existent ID
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -67,7 +85,7 @@ public:
             OATPP_ASSERT(retrieved == nullptr);
         }
 
-        OATPP_LOGI(TAG, "  [4/10] Testing getAll...");
+        OATPP_LOGI(TAG, "  [4/29] Testing getAll...");
         // Test getAll
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -75,7 +93,7 @@ public:
             OATPP_ASSERT(allContacts.size() >= 3); // At least seeded data
         }
 
-        OATPP_LOGI(TAG, "  [5/10] Testing update...");
+        OATPP_LOGI(TAG, "  [5/29] Testing update...");
         // Test update
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -105,7 +123,7 @@ public:
             OATPP_ASSERT(result->address == "Updated Address");
         }
 
-        OATPP_LOGI(TAG, "  [6/10] Testing update with non-existent ID...");
+        OATPP_LOGI(TAG, "  [6/29] Testing update with non-existent ID...");
         // Test update with non-existent ID
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -119,7 +137,7 @@ public:
             OATPP_ASSERT(result == nullptr);
         }
 
-        OATPP_LOGI(TAG, "  [7/10] Testing remove...");
+        OATPP_LOGI(TAG, "  [7/29] Testing remove...");
         // Test remove
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -141,7 +159,7 @@ public:
             OATPP_ASSERT(retrieved == nullptr);
         }
 
-        OATPP_LOGI(TAG, "  [8/10] Testing remove with non-existent ID...");
+        OATPP_LOGI(TAG, "  [8/29] Testing remove with non-existent ID...");
         // Test remove with non-existent ID
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -149,7 +167,7 @@ public:
             OATPP_ASSERT(!deleted);
         }
 
-        OATPP_LOGI(TAG, "  [9/10] Testing create with explicit ID...");
+        OATPP_LOGI(TAG, "  [9/29] Testing create with explicit ID...");
         // Test create with explicit ID
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -165,7 +183,7 @@ public:
             OATPP_ASSERT(*created->id == 100);
         }
 
-        OATPP_LOGI(TAG, "  [10/10] Testing create with duplicate ID...");
+        OATPP_LOGI(TAG, "  [10/29] Testing create with duplicate ID...");
         // Test create with duplicate ID
         {
             auto repository = std::make_shared<ContactRepository>();
@@ -187,8 +205,1421 @@ public:
             auto created2 = repository->create(contact2);
             OATPP_ASSERT(created2 == nullptr); // Should fail due to duplicate ID
         }
+
+        OATPP_LOGI(TAG, "  [11/29] Testing concurrent create and getById across shards...");
+        // Test concurrent create and getById across shards
+        {
+            auto repository = std::make_shared<ContactRepository>(4);
+            OATPP_ASSERT(repository->shardCount() == 4);
+
+            constexpr int kThreads = 4;
+            constexpr int kPerThread = 250;
+            std::vector<std::vector<int64_t>> ids(kThreads);
+            std::atomic<int> failures(0);
+            std::vector<std::thread> threads;
+
+            for (int t = 0; t < kThreads; ++t) {
+                threads.emplace_back([&, t] {
+                    for (int i = 0; i < kPerThread; ++i) {
+                        auto contact = ContactDto::createShared();
+                        // One thread mixes in descending explicit IDs to race with auto-generated ones
+                        if (t == 1 && i % 10 == 0) {
+                            contact->id = 1000000 - i;
+                        }
+                        contact->name = "Concurrent User";
+                        contact->phone = "+79990000000";
+                        contact->address = "Concurrent Address";
+
+                        auto created = repository->create(contact);
+                        if (!created || !repository->getById(created->id)) {
+                            ++failures;
+                            continue;
+                        }
+                        ids[t].push_back(*created->id);
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+
+            OATPP_ASSERT(failures == 0);
+            std::set<int64_t> unique;
+            for (const auto& threadIds : ids) {
+                unique.insert(threadIds.begin(), threadIds.end());
+            }
+            OATPP_ASSERT(unique.size() == kThreads * kPerThread);
+            OATPP_ASSERT(repository->getAll().size() == kThreads * kPerThread + 3);
+        }
+
+        OATPP_LOGI(TAG, "  [12/29] Testing snapshot isolation...");
+        // Test snapshot isolation
+        {
+            auto repository = std::make_shared<ContactRepository>();
+            auto before = repository->snapshot();
+            OATPP_ASSERT(before->size() == 3);
+            OATPP_ASSERT(repository->snapshot() == before); // No writes - same published view
+
+            auto contact = ContactDto::createShared();
+            contact->name = "Snapshot User";
+            contact->phone = "+79990000001";
+            contact->address = "Snapshot Address";
+            auto created = repository->create(contact);
+
+            auto renamed = ContactDto::createShared();
+            renamed->id = 1;
+            renamed->name = "Renamed";
+            renamed->phone = "+79991234567";
+            renamed->address = "Moscow, Lenin St., 1";
+            OATPP_ASSERT(repository->update(renamed) != nullptr);
+            OATPP_ASSERT(repository->remove(2));
+
+            // The old view is unaffected by later writes
+            std::vector<int64_t> beforeIds;
+            before->forEach([&beforeIds](const oatpp::Object<ContactDto>& c) {
+                beforeIds.push_back(*c->id);
+                if (*c->id == 1) {
+                    OATPP_ASSERT(c->name == "Ivan Ivanov");
+                }
+            });
+            OATPP_ASSERT((beforeIds == std::vector<int64_t>{1, 2, 3}));
+
+            auto after = repository->snapshot();
+            OATPP_ASSERT(after->version() > before->version());
+            std::vector<int64_t> afterIds;
+            after->forEach([&afterIds](const oatpp::Object<ContactDto>& c) {
+                afterIds.push_back(*c->id);
+                if (*c->id == 1) {
+                    OATPP_ASSERT(c->name == "Renamed");
+                }
+            });
+            OATPP_ASSERT((afterIds == std::vector<int64_t>{1, 3, *created->id}));
+        }
+        {
+            // A capture shares the records: after one write the next view differs from the last in a page or two
+            auto repository = std::make_shared<ContactRepository>(1);
+            for (int i = 0; i < 1000; ++i) {
+                auto contact = ContactDto::createShared();
+                contact->name = "Paged " + std::to_string(i);
+                repository->create(contact);
+            }
+            auto before = repository->snapshot();
+            auto original = repository->getById(500)->name;
+            auto renamed = ContactDto::createShared();
+            renamed->id = 500;
+            renamed->name = "Renamed";
+            OATPP_ASSERT(repository->update(renamed) != nullptr);
+            auto after = repository->snapshot();
+
+            const auto& oldPages = *before->shard(0)->records;
+            const auto& newPages = *after->shard(0)->records;
+            OATPP_ASSERT(oldPages.pageCount() == newPages.pageCount() && oldPages.pageCount() > 1);
+            size_t copied = 0;
+            for (size_t i = 0; i < oldPages.pageCount(); ++i) {
+                copied += &oldPages.page(i) != &newPages.page(i) ? 1 : 0;
+            }
+            OATPP_ASSERT(copied == 1);
+            OATPP_ASSERT(ContactSnapshot::Cursor(*before, 499).next()->name == original);
+            OATPP_ASSERT(ContactSnapshot::Cursor(*after, 499).next()->name == "Renamed");
+        }
+
+        OATPP_LOGI(TAG, "  [13/29] Testing findByNamePrefix...");
+        // Test findByNamePrefix
+        {
+            auto repository = std::make_shared<ContactRepository>();
+            for (const char* name : {"Anna Smirnova", "anton Petrov", "Boris Orlov", "Анна Кузнецова"}) {
+                auto contact = ContactDto::createShared();
+                contact->name = name;
+                contact->phone = "+79990000002";
+                contact->address = "Prefix Address";
+                OATPP_ASSERT(repository->create(contact) != nullptr);
+            }
+
+            auto found = repository->findByNamePrefix("AN", 10);
+            OATPP_ASSERT(found.size() == 2);
+            OATPP_ASSERT(found[0]->name == "Anna Smirnova");
+            OATPP_ASSERT(found[1]->name == "anton Petrov");
+            OATPP_ASSERT(repository->findByNamePrefix("an", 1).size() == 1);
+            OATPP_ASSERT(repository->findByNamePrefix("аННа", 10).size() == 1);
+            OATPP_ASSERT(repository->findByNamePrefix("Zed", 10).empty());
+
+            // Index follows update and remove
+            auto renamed = ContactDto::createShared();
+            renamed->id = found[1]->id;
+            renamed->name = "Zed Petrov";
+            renamed->phone = "+79990000002";
+            renamed->address = "Prefix Address";
+            OATPP_ASSERT(repository->update(renamed) != nullptr);
+            OATPP_ASSERT(repository->findByNamePrefix("an", 10).size() == 1);
+            OATPP_ASSERT(repository->findByNamePrefix("zed", 10).size() == 1);
+
+            OATPP_ASSERT(repository->remove(found[0]->id));
+            OATPP_ASSERT(repository->findByNamePrefix("an", 10).empty());
+        }
+
+        OATPP_LOGI(TAG, "  [14/29] Testing findByPhone and findByPhonePrefix...");
+        // Test findByPhone and findByPhonePrefix
+        {
+            auto repository = std::make_shared<ContactRepository>();
+            for (const char* phone : {"+74951112233", "+74959998877", "+74991234567", "+74951112233"}) {
+                auto contact = ContactDto::createShared();
+                contact->name = "Phone User";
+                contact->phone = phone;
+                contact->address = "Phone Address";
+                OATPP_ASSERT(repository->create(contact) != nullptr);
+            }
+
+            OATPP_ASSERT(repository->findByPhone(*PhoneKey::parse("+7 (495) 111-22-33"), 10).size() == 2);
+            OATPP_ASSERT(repository->findByPhone(*PhoneKey::parse("+7495111223"), 10).empty());
+
+            auto moscow = repository->findByPhonePrefix(*PhoneKey::parse("7495"), 10);
+            OATPP_ASSERT(moscow.size() == 3);
+            OATPP_ASSERT(moscow[0]->phone == "+74951112233");
+            OATPP_ASSERT(moscow[2]->phone == "+74959998877");
+            OATPP_ASSERT(repository->findByPhonePrefix(*PhoneKey::parse("7499"), 10).size() == 1);
+            OATPP_ASSERT(repository->findByPhonePrefix(*PhoneKey::parse("7"), 100).size() == 7); // With seeded data
+
+            // Index follows update
+            auto moved = ContactDto::createShared();
+            moved->id = moscow[2]->id;
+            moved->name = "Phone User";
+            moved->phone = "+74990000000";
+            moved->address = "Phone Address";
+            OATPP_ASSERT(repository->update(moved) != nullptr);
+            OATPP_ASSERT(repository->findByPhonePrefix(*PhoneKey::parse("7495"), 10).size() == 2);
+            OATPP_ASSERT(repository->findByPhonePrefix(*PhoneKey::parse("7499"), 10).size() == 2);
+        }
+
+        OATPP_LOGI(TAG, "  [15/29] Testing unique phone constraint...");
+        // Test unique phone constraint
+        {
+            auto repository = std::make_shared<ContactRepository>(ContactRepository::kDefaultShardCount, true);
+            OATPP_ASSERT(repository->uniquePhones());
+
+            auto contact = ContactDto::createShared();
+            contact->name = "Duplicate Phone";
+            contact->phone = "+79991234567"; // Seeded for contact 1
+            contact->address = "Some Address";
+
+            ContactRepository::Conflict conflict;
+            OATPP_ASSERT(repository->create(contact, &conflict) == nullptr);
+            OATPP_ASSERT(conflict == ContactRepository::Conflict::DuplicatePhone);
+
+            contact->phone = "+79990000003";
+            auto created = repository->create(contact, &conflict);
+            OATPP_ASSERT(created != nullptr);
+            OATPP_ASSERT(conflict == ContactRepository::Conflict::None);
+
+            // Keeping its own number is not a conflict, taking another contact's number is
+            OATPP_ASSERT(repository->update(created, &conflict) != nullptr);
+            created->phone = "+79997654321";
+            OATPP_ASSERT(repository->update(created, &conflict) == nullptr);
+            OATPP_ASSERT(conflict == ContactRepository::Conflict::DuplicatePhone);
+
+            // A removed contact frees its number
+            OATPP_ASSERT(repository->remove(2));
+            OATPP_ASSERT(repository->update(created, &conflict) != nullptr);
+        }
+
+        OATPP_LOGI(TAG, "  [16/29] Testing compact storage round trip...");
+        // Test compact storage round trip
+        {
+            auto repository = std::make_shared<ContactRepository>(4);
+
+            // Null and empty fields, a non-canonical phone and a name longer than the short length field
+            auto sparse = ContactDto::createShared();
+            sparse->name = "";
+            sparse->phone = nullptr;
+            sparse->address = nullptr;
+            auto sparseId = *repository->create(sparse)->id;
+
+            auto odd = ContactDto::createShared();
+            odd->name = std::string(70000, 'x');
+            odd->phone = "8 (800) 555-35-35";
+            odd->address = "Moscow, Tverskaya St., 7, apt. 12";
+            auto oddId = *repository->create(odd)->id;
+
+            auto readSparse = repository->getById(sparseId);
+            OATPP_ASSERT(readSparse->name == "");
+            OATPP_ASSERT(readSparse->phone == nullptr);
+            OATPP_ASSERT(readSparse->address == nullptr);
+
+            auto readOdd = repository->getById(oddId);
+            OATPP_ASSERT(readOdd->name->size() == 70000);
+            OATPP_ASSERT(readOdd->phone == "8 (800) 555-35-35");
+            OATPP_ASSERT(readOdd->address == "Moscow, Tverskaya St., 7, apt. 12");
+
+            // Address components shared with the seed data come back intact
+            OATPP_ASSERT(repository->getById(1)->address == "Moscow, Lenin St., 1");
+
+            // Rewriting a large contact many times leaves mostly garbage and triggers compaction;
+            // a snapshot taken before keeps reading the strings it captured
+            auto before = repository->snapshot();
+            for (int i = 0; i < 40; ++i) {
+                auto changed = ContactDto::createShared();
+                changed->id = oddId;
+                changed->name = std::string(70000, static_cast<char>('a' + i % 26));
+                changed->phone = "+74950000000";
+                changed->address = "Kazan, Bauman St., " + std::to_string(i);
+                OATPP_ASSERT(repository->update(changed) != nullptr);
+            }
+            auto after = repository->getById(oddId);
+            OATPP_ASSERT(*after->name == std::string(70000, static_cast<char>('a' + 39 % 26)));
+            OATPP_ASSERT(after->phone == "+74950000000");
+            OATPP_ASSERT(after->address == "Kazan, Bauman St., 39");
+            OATPP_ASSERT(repository->findByNamePrefix("n", 10).size() == 1);
+
+            bool seenOld = false;
+            before->forEach([&](const oatpp::Object<ContactDto>& contact) {
+                if (*contact->id == oddId) {
+                    seenOld = contact->name->size() == 70000 && (*contact->name)[0] == 'x' &&
+                              contact->phone == "8 (800) 555-35-35" &&
+                              contact->address == "Moscow, Tverskaya St., 7, apt. 12";
+                }
+            });
+            OATPP_ASSERT(seenOld);
+
+            // Address components are reference counted; a released entry is reused only once no pin can read it,
+            // and a full pool leaves the string to the record
+            {
+                StringPool pool(2);
+                auto moscow = pool.intern("Moscow");
+                OATPP_ASSERT(pool.intern("Moscow") == moscow);
+                auto kazan = pool.intern("Kazan");
+                OATPP_ASSERT(pool.intern("Samara") == StringPool::kNoId);
+                auto pin = pool.pin();
+                pool.release(kazan);
+                OATPP_ASSERT(pool.size() == 1);
+                OATPP_ASSERT(pool.intern("Samara") == StringPool::kNoId);
+                OATPP_ASSERT(pool.get(kazan) == "Kazan");
+                pin.reset();
+                OATPP_ASSERT(pool.intern("Samara") == kazan);
+                pool.release(moscow);
+                OATPP_ASSERT(pool.get(moscow) == "Moscow");
+                pool.release(moscow);
+                OATPP_ASSERT(pool.intern("Tula") == moscow);
+
+                CompactContactStore store(std::make_shared<StringPool>(1));
+                auto contact = ContactDto::createShared();
+                contact->id = 1;
+                contact->address = "Tula, Lenin St., 1";
+                store.insert(contact);
+                OATPP_ASSERT(store.materialize(*store.find(1))->address == "Tula, Lenin St., 1");
+                contact->address = "Tula, , Sovetskaya St., 2";
+                OATPP_ASSERT(store.replace(contact));
+                OATPP_ASSERT(store.materialize(*store.find(1))->address == "Tula, , Sovetskaya St., 2");
+                OATPP_ASSERT(store.pool()->size() == 1 && store.erase(1) && store.pool()->size() == 0);
+            }
+            {
+                struct Record {
+                    int64_t id;
+                    int value;
+                };
+                RecordPages<Record> pages;
+                for (int64_t id = 1; id <= 1000; ++id) {
+                    pages.insert(Record{id * 2, 0});
+                }
+                // Appended ids leave the pages full
+                OATPP_ASSERT(pages.size() == 1000 && pages.pageCount() == 8);
+                OATPP_ASSERT(pages.page(0).size() == RecordPages<Record>::kMaxPageSize);
+
+                // A copy shares every page; a change copies only the page it touches
+                auto held = pages;
+                pages.findWritable(2)->value = 1;
+                pages.insert(Record{3, 0});
+                OATPP_ASSERT(held.find(2)->value == 0 && !held.find(3) && pages.find(2)->value == 1);
+                OATPP_ASSERT(&held.page(0) != &pages.page(0) && &held.page(1) != &pages.page(1));
+                for (size_t i = 2; i < held.pageCount(); ++i) {
+                    OATPP_ASSERT(&held.page(i) == &pages.page(i + 1));
+                }
+
+                for (int64_t id = 2; id <= 1600; id += 2) {
+                    OATPP_ASSERT(pages.erase(id));
+                }
+                OATPP_ASSERT(!pages.erase(2) && pages.size() == 201);
+                // Sparse pages were merged, so the directory shrank along with the records
+                OATPP_ASSERT(pages.pageCount() <= 4);
+                std::vector<int64_t> ids;
+                for (RecordPages<Record>::Position position; !pages.isEnd(position); pages.next(position)) {
+                    ids.push_back(pages.at(position).id);
+                }
+                OATPP_ASSERT(ids.size() == 201 && ids.front() == 3 && ids[1] == 1602 && ids.back() == 2000);
+                OATPP_ASSERT(std::is_sorted(ids.begin(), ids.end()));
+
+                auto position = pages.lowerBound(1700);
+                OATPP_ASSERT(pages.at(position).id == 1700 && pages.countFrom(position) == 151);
+                OATPP_ASSERT(pages.at(pages.upperBound(1700)).id == 1702);
+                OATPP_ASSERT(pages.previous(position) && pages.at(position).id == 1698);
+                position = pages.lowerBound(3);
+                OATPP_ASSERT(!pages.previous(position) && pages.isEnd(pages.upperBound(2000)));
+                OATPP_ASSERT(held.size() == 1000 && held.find(1600) && held.countFrom(held.lowerBound(0)) == 1000);
+            }
+            {
+                auto churned = std::make_shared<ContactRepository>(4);
+                auto held = churned->snapshot();
+                auto contact = ContactDto::createShared();
+                contact->name = "Churn";
+                contact->address = "Street 0, House 0";
+                auto churnId = *churned->create(contact)->id;
+                for (int i = 1; i <= 1000; ++i) {
+                    contact->id = churnId;
+                    contact->address = "Street " + std::to_string(i) + ", House " + std::to_string(i);
+                    OATPP_ASSERT(churned->update(contact) != nullptr);
+                    if (i % 100 == 0) {
+                        churned->snapshot();
+                    }
+                }
+                OATPP_ASSERT(held->size() == 3);
+                OATPP_ASSERT(churned->getById(1)->address == "Moscow, Lenin St., 1");
+                held.reset();
+                auto churn = [&](int from, int to) {
+                    for (int i = from; i <= to; ++i) {
+                        contact->address = "Street " + std::to_string(i) + ", House " + std::to_string(i);
+                        OATPP_ASSERT(churned->update(contact) != nullptr);
+                    }
+                };
+                churn(1001, 2000);
+                auto dictionary = churned->memoryStats().dictionary;
+                churn(2001, 5000);
+                // Entries of the old addresses were reused, the dictionary didn't grow with the churn
+                OATPP_ASSERT(churned->memoryStats().dictionary <= dictionary);
+                OATPP_ASSERT(churned->getById(churnId)->address == "Street 5000, House 5000");
+            }
+
+            auto stats = repository->memoryStats();
+            OATPP_ASSERT(stats.contacts == 5);
+            OATPP_ASSERT(repository->size() == 5);
+            // Garbage was reclaimed: the arena holds well under half of the ~2.8 MB written
+            OATPP_ASSERT(stats.strings < 40 * 70000 / 2);
+            OATPP_ASSERT(stats.total() > stats.storage());
+        }
+
+        OATPP_LOGI(TAG, "  [17/29] Testing journal replay...");
+        // Test journal replay
+        {
+            auto path = journalPath("replay");
+            int64_t createdId;
+            {
+                auto log = std::make_shared<WriteAheadLog>(path, Durability::Batched);
+                auto repository = std::make_shared<ContactRepository>(4, false, log);
+                OATPP_ASSERT(repository->size() == 3); // Seeded into the empty journal
+
+                auto contact = ContactDto::createShared();
+                contact->name = "Journaled User";
+                contact->phone = "+79990000010";
+                contact->address = "Omsk, Mira Ave., 3";
+                createdId = *repository->create(contact)->id;
+
+                auto changed = repository->getById(1);
+                changed->name = "Ivan Renamed";
+                changed->address = nullptr;
+                OATPP_ASSERT(repository->update(changed) != nullptr);
+                OATPP_ASSERT(repository->remove(2));
+
+                // Concurrent writers share fsyncs
+                std::vector<std::thread> threads;
+                for (int t = 0; t < 4; ++t) {
+                    threads.emplace_back([repository, t]() {
+                        for (int i = 0; i < 25; ++i) {
+                            auto contact = ContactDto::createShared();
+                            contact->name = "Writer " + std::to_string(t);
+                            contact->phone = "+7999100" + std::to_string(t * 100 + i);
+                            contact->address = "Perm";
+                            repository->create(contact);
+                        }
+                    });
+                }
+                for (auto& thread : threads) {
+                    thread.join();
+                }
+                OATPP_ASSERT(log->lastSequence() == 3 + 3 + 100);
+                OATPP_ASSERT(log->flushCount() <= log->lastSequence());
+            }
+
+            // A new repository over the same journal sees every change and keeps allocating new ids
+            auto log = std::make_shared<WriteAheadLog>(path, Durability::Batched);
+            auto repository = std::make_shared<ContactRepository>(4, false, log);
+            OATPP_ASSERT(repository->size() == 3 + 1 - 1 + 100);
+            OATPP_ASSERT(repository->getById(2) == nullptr);
+            OATPP_ASSERT(repository->getById(1)->name == "Ivan Renamed");
+            OATPP_ASSERT(repository->getById(1)->address == nullptr);
+            OATPP_ASSERT(repository->getById(createdId)->address == "Omsk, Mira Ave., 3");
+            OATPP_ASSERT(repository->findByNamePrefix("writer 3", 100).size() == 25);
+            OATPP_ASSERT(repository->findByPhone(*PhoneKey::parse("+79990000010"), 10).size() == 1);
+
+            auto contact = ContactDto::createShared();
+            contact->name = "After Restart";
+            auto created = repository->create(contact);
+            OATPP_ASSERT(repository->findByNamePrefix("", 1000).size() == 104);
+            for (const auto& existing : repository->getAll()) {
+                OATPP_ASSERT(*existing->id <= *created->id);
+            }
+            std::filesystem::remove(path);
+        }
+
+        OATPP_LOGI(TAG, "  [18/29] Testing torn journal tail...");
+        // Test torn journal tail
+        {
+            auto path = journalPath("torn");
+            {
+                auto log = std::make_shared<WriteAheadLog>(path, Durability::PerWrite);
+                auto repository = std::make_shared<ContactRepository>(4, false, log);
+                OATPP_ASSERT(repository->remove(3));
+                OATPP_ASSERT(log->flushCount() == 4); // One fsync per record
+            }
+
+            // Cut the last record (the remove) in half, as a crash in the middle of a write would
+            auto fullSize = std::filesystem::file_size(path);
+            std::filesystem::resize_file(path, fullSize - 10);
+            {
+                auto log = std::make_shared<WriteAheadLog>(path, Durability::None);
+                auto repository = std::make_shared<ContactRepository>(4, false, log);
+                OATPP_ASSERT(repository->size() == 3);
+                OATPP_ASSERT(repository->getById(3) != nullptr);
+                OATPP_ASSERT(log->lastSequence() == 3);
+
+                // The torn bytes are gone, new records follow the last intact one
+                OATPP_ASSERT(repository->remove(1));
+            }
+            {
+                auto log = std::make_shared<WriteAheadLog>(path, Durability::None);
+                auto repository = std::make_shared<ContactRepository>(4, false, log);
+                OATPP_ASSERT(repository->size() == 2);
+                OATPP_ASSERT(repository->getById(1) == nullptr);
+                OATPP_ASSERT(repository->getById(3) != nullptr);
+            }
+            std::filesystem::remove(path);
+
+            // A failed journal write: the writer gets an error, the repository turns read-only and no
+            // snapshot file is written, so the change that was already visible is gone after a restart
+            auto failedPath = journalPath("failed");
+            auto snapshotPath = failedPath + ".snap";
+            {
+                auto log = std::make_shared<WriteAheadLog>(failedPath, Durability::Batched);
+                auto repository = std::make_shared<ContactRepository>(4, false, log);
+                Checkpointer checkpointer(repository, snapshotPath, std::chrono::seconds(0), 0);
+
+                // Writes past the current end of the file fail with EFBIG while the limit is lowered
+                ::rlimit original{};
+                OATPP_ASSERT(::getrlimit(RLIMIT_FSIZE, &original) == 0);
+                auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+                ::rlimit lowered = original;
+                lowered.rlim_cur = static_cast<rlim_t>(std::filesystem::file_size(failedPath));
+                OATPP_ASSERT(::setrlimit(RLIMIT_FSIZE, &lowered) == 0);
+
+                auto contact = ContactDto::createShared();
+                contact->name = "Lost User";
+                bool failed = false;
+                try {
+                    repository->create(contact);
+                } catch (const std::runtime_error&) {
+                    failed = true;
+                }
+                OATPP_ASSERT(::setrlimit(RLIMIT_FSIZE, &original) == 0);
+                std::signal(SIGXFSZ, previousHandler);
+                OATPP_ASSERT(failed);
+                // Applied before it was journaled, so readers already see it
+                OATPP_ASSERT(repository->findByNamePrefix("Lost", 10).size() == 1);
+
+                auto version = repository->version();
+                bool rejected = false;
+                try {
+                    repository->remove(1);
+                } catch (const std::runtime_error&) {
+                    rejected = true;
+                }
+                OATPP_ASSERT(rejected && repository->version() == version && repository->getById(1) != nullptr);
+
+                bool checkpointFailed = false;
+                try {
+                    checkpointer.checkpoint();
+                } catch (const std::runtime_error&) {
+                    checkpointFailed = true;
+                }
+                OATPP_ASSERT(checkpointFailed && !std::filesystem::exists(snapshotPath));
+            }
+            {
+                auto log = std::make_shared<WriteAheadLog>(failedPath, Durability::Batched);
+                auto repository = std::make_shared<ContactRepository>(4, false, log);
+                OATPP_ASSERT(repository->size() == 3);
+                OATPP_ASSERT(repository->findByNamePrefix("Lost", 10).empty());
+            }
+            std::filesystem::remove(failedPath);
+        }
+
+        OATPP_LOGI(TAG, "  [19/29] Testing snapshot file with journal tail...");
+        // Test snapshot file with journal tail
+        {
+            auto journal = journalPath("checkpoint");
+            auto snapshotPath = journal + ".snap";
+            {
+                auto log = std::make_shared<WriteAheadLog>(journal, Durability::None);
+                auto repository = std::make_shared<ContactRepository>(4, false, log);
+                for (int i = 0; i < 1000; ++i) {
+                    auto contact = ContactDto::createShared();
+                    contact->name = "Snapshot " + std::to_string(i);
+                    contact->phone = "+7912" + std::to_string(1000000 + i);
+                    contact->address = i % 2 ? oatpp::String("Samara, Lesnaya St., 4") : oatpp::String(nullptr);
+                    repository->create(contact);
+                }
+                auto journalBefore = log->size();
+
+                Checkpointer checkpointer(repository, snapshotPath, std::chrono::seconds(0), 0);
+                OATPP_ASSERT(checkpointer.checkpoint());
+                OATPP_ASSERT(!checkpointer.checkpoint()); // Nothing new to write
+                OATPP_ASSERT(log->size() == 0);            // Covered records are dropped
+                OATPP_ASSERT(journalBefore > 0);
+
+                // Journal tail after the snapshot: an update, a remove and a create
+                auto changed = repository->getById(1);
+                changed->name = "Tail Update";
+                OATPP_ASSERT(repository->update(changed) != nullptr);
+                OATPP_ASSERT(repository->remove(2));
+                auto contact = ContactDto::createShared();
+                contact->name = "Tail Create";
+                repository->create(contact);
+                OATPP_ASSERT(log->lastSequence() == 3 + 1000 + 3);
+            }
+
+            auto base = SnapshotFile::open(snapshotPath);
+            OATPP_ASSERT(base != nullptr);
+            OATPP_ASSERT(base->size() == 1003);
+            OATPP_ASSERT(base->journalSequence() == 1003);
+
+            auto log = std::make_shared<WriteAheadLog>(journal, Durability::None);
+            auto repository = std::make_shared<ContactRepository>(4, false, log, base);
+            base.reset();
+
+            // Point reads are answered right away, from the file or the replayed tail
+            OATPP_ASSERT(repository->getById(1)->name == "Tail Update");
+            OATPP_ASSERT(repository->getById(2) == nullptr);
+            OATPP_ASSERT(repository->getById(3)->address == "Kazan, Bauman St., 5");
+            auto fromFile = repository->getById(10);
+            OATPP_ASSERT(fromFile->name == "Snapshot 5");
+            OATPP_ASSERT(fromFile->address == "Samara, Lesnaya St., 4");
+
+            repository->waitHydrated();
+            OATPP_ASSERT(repository->size() == 1003);
+            OATPP_ASSERT(repository->findByNamePrefix("tail", 10).size() == 2);
+            OATPP_ASSERT(repository->findByPhonePrefix(*PhoneKey::parse("7912"), 2000).size() == 1000);
+            OATPP_ASSERT(repository->getById(11)->address == nullptr);
+
+            // Sequence numbers continue after the ones in the snapshot file and the journal
+            auto contact = ContactDto::createShared();
+            contact->name = "After Snapshot";
+            auto created = repository->create(contact);
+            OATPP_ASSERT(*created->id > 1006);
+            OATPP_ASSERT(log->lastSequence() == 1007);
+
+            // A checkpointer started on the snapshot file it would write has nothing to do
+            {
+                Checkpointer checkpointer(repository, snapshotPath, std::chrono::seconds(0), 0);
+                OATPP_ASSERT(checkpointer.checkpoint());
+            }
+            repository.reset();
+            log.reset();
+            {
+                auto reopenedLog = std::make_shared<WriteAheadLog>(journal, Durability::None);
+                auto reopened = std::make_shared<ContactRepository>(4, false, reopenedLog,
+                                                                    SnapshotFile::open(snapshotPath));
+                auto written = std::filesystem::last_write_time(snapshotPath);
+                Checkpointer checkpointer(reopened, snapshotPath, std::chrono::seconds(0), 0);
+                OATPP_ASSERT(!checkpointer.checkpoint());
+                OATPP_ASSERT(std::filesystem::last_write_time(snapshotPath) == written);
+                OATPP_ASSERT(reopened->getById(*created->id)->name == "After Snapshot");
+            }
+
+            std::filesystem::remove(journal);
+            std::filesystem::remove(snapshotPath);
+        }
+
+        OATPP_LOGI(TAG, "  [20/29] Testing writes before hydration...");
+        // Test writes before hydration
+        {
+            auto journal = journalPath("hydration");
+            auto snapshotPath = journal + ".snap";
+            {
+                auto log = std::make_shared<WriteAheadLog>(journal, Durability::None);
+                auto repository = std::make_shared<ContactRepository>(4, false, log);
+                for (int i = 0; i < 20000; ++i) {
+                    auto contact = ContactDto::createShared();
+                    contact->name = "Bulk " + std::to_string(i);
+                    contact->phone = "+7913" + std::to_string(1000000 + i);
+                    contact->address = "Ufa";
+                    repository->create(contact);
+                }
+                Checkpointer(repository, snapshotPath, std::chrono::seconds(0), 0).checkpoint();
+            }
+
+            // Changes race with the background copy; whichever comes first, the change must win
+            std::vector<int64_t> removed;
+            {
+                auto log = std::make_shared<WriteAheadLog>(journal, Durability::None);
+                auto repository = std::make_shared<ContactRepository>(4, false, log, SnapshotFile::open(snapshotPath));
+                for (int64_t id = 19000; id < 20000; id += 7) {
+                    auto changed = repository->getById(id);
+                    OATPP_ASSERT(changed != nullptr);
+                    changed->name = "Changed";
+                    OATPP_ASSERT(repository->update(changed) != nullptr);
+                    OATPP_ASSERT(repository->remove(id + 1));
+                    removed.push_back(id + 1);
+
+                    auto duplicate = ContactDto::createShared();
+                    duplicate->id = id + 2;
+                    duplicate->name = "Duplicate";
+                    OATPP_ASSERT(repository->create(duplicate) == nullptr);
+                }
+                repository->waitHydrated();
+                OATPP_ASSERT(repository->size() == 3 + 20000 - removed.size());
+                OATPP_ASSERT(repository->findByNamePrefix("changed", 1000).size() == removed.size());
+                OATPP_ASSERT(repository->findByNamePrefix("duplicate", 10).empty());
+                for (auto id : removed) {
+                    OATPP_ASSERT(repository->getById(id) == nullptr);
+                }
+            }
+
+            // The changes were journaled on top of the snapshot file
+            auto log = std::make_shared<WriteAheadLog>(journal, Durability::None);
+            auto repository = std::make_shared<ContactRepository>(4, false, log, SnapshotFile::open(snapshotPath));
+            repository->waitHydrated();
+            OATPP_ASSERT(repository->size() == 3 + 20000 - removed.size());
+            OATPP_ASSERT(repository->getById(19000)->name == "Changed");
+            OATPP_ASSERT(repository->getById(19001) == nullptr);
+
+            std::filesystem::remove(journal);
+            std::filesystem::remove(snapshotPath);
+        }
+
+        OATPP_LOGI(TAG, "  [21/29] Testing batch writes and multi-get...");
+        // Test batch writes: per-item conflicts, request order and one journal flush per batch
+        {
+            auto journal = journalPath("batch");
+            {
+                auto log = std::make_shared<WriteAheadLog>(journal, Durability::Batched);
+                auto repository = std::make_shared<ContactRepository>(4, true, log);
+                auto flushes = log->flushCount();
+
+                std::vector<oatpp::Object<ContactDto>> contacts;
+                for (int i = 0; i < 100; ++i) {
+                    auto contact = ContactDto::createShared();
+                    contact->name = "Batch " + std::to_string(i);
+                    contact->phone = "+7914" + std::to_string(1000000 + i);
+                    contact->address = "Omsk";
+                    contacts.push_back(contact);
+                }
+                contacts[10]->id = 1;                        // taken by test data
+                contacts[20]->id = 500;
+                contacts[21]->id = 500;                      // same id twice in one batch
+                contacts[30]->phone = contacts[31]->phone;   // same phone twice in one batch
+
+                auto created = repository->createBatch(contacts);
+                OATPP_ASSERT(created.size() == contacts.size());
+                OATPP_ASSERT(log->flushCount() == flushes + 1);
+                OATPP_ASSERT(created[10].contact == nullptr);
+                OATPP_ASSERT(created[10].conflict == ContactRepository::Conflict::DuplicateId);
+                OATPP_ASSERT(*created[20].contact->id == 500);
+                OATPP_ASSERT(created[21].conflict == ContactRepository::Conflict::DuplicateId);
+                OATPP_ASSERT((created[30].contact == nullptr) != (created[31].contact == nullptr));
+                OATPP_ASSERT(created[0].contact->name == "Batch 0");
+                OATPP_ASSERT(repository->size() == 3 + 97);
+
+                std::set<int64_t> ids;
+                for (auto& result : created) {
+                    if (result.contact) {
+                        ids.insert(*result.contact->id);
+                    }
+                }
+                OATPP_ASSERT(ids.size() == 97);
+
+                // Updates: one unknown id, one phone taken by another contact
+                std::vector<oatpp::Object<ContactDto>> updates;
+                for (int i = 0; i < 3; ++i) {
+                    auto contact = ContactDto::createShared();
+                    contact->id = created[i].contact->id;
+                    contact->name = "Updated " + std::to_string(i);
+                    contact->phone = created[i].contact->phone;
+                    contact->address = "Tomsk";
+                    updates.push_back(contact);
+                }
+                updates[1]->phone = "+79991234567";
+                updates[2]->id = 999999;
+                auto updated = repository->updateBatch(updates);
+                OATPP_ASSERT(updated[0].contact != nullptr);
+                OATPP_ASSERT(updated[1].conflict == ContactRepository::Conflict::DuplicatePhone);
+                OATPP_ASSERT(updated[2].conflict == ContactRepository::Conflict::NotFound);
+                OATPP_ASSERT(repository->getById(created[0].contact->id)->name == "Updated 0");
+                OATPP_ASSERT(repository->getById(created[1].contact->id)->name == "Batch 1");
+
+                // Multi-get keeps request order and leaves gaps for unknown ids
+                auto fetched = repository->getByIds({*created[5].contact->id, 999999, 2, *created[4].contact->id});
+                OATPP_ASSERT(fetched.size() == 4);
+                OATPP_ASSERT(fetched[0]->name == "Batch 5");
+                OATPP_ASSERT(fetched[1] == nullptr);
+                OATPP_ASSERT(fetched[2]->name == "Maria Petrova");
+                OATPP_ASSERT(fetched[3]->name == "Batch 4");
+
+                auto removed = repository->removeBatch({2, 999999, 2, *created[6].contact->id});
+                OATPP_ASSERT(removed[0] && !removed[1] && !removed[2] && removed[3]);
+                OATPP_ASSERT(repository->getById(2) == nullptr);
+                OATPP_ASSERT(repository->size() == 3 + 97 - 2);
+            }
+
+            // Every applied batch item was journaled
+            auto log = std::make_shared<WriteAheadLog>(journal, Durability::None);
+            ContactRepository repository(4, true, log);
+            OATPP_ASSERT(repository.size() == 3 + 97 - 2);
+            OATPP_ASSERT(repository.getById(500) != nullptr);
+            OATPP_ASSERT(repository.findByNamePrefix("updated", 10).size() == 1);
+            OATPP_ASSERT(repository.getById(2) == nullptr);
+
+            std::filesystem::remove(journal);
+        }
+
+        OATPP_LOGI(TAG, "  [22/29] Testing contact versions...");
+        // Test per-contact versions used for ETags
+        {
+            auto repository = std::make_shared<ContactRepository>();
+            auto contact = ContactDto::createShared();
+            contact->name = "Versioned";
+            contact->phone = "+79990001122";
+            contact->address = "Perm";
+            auto created = repository->create(contact);
+            auto createdVersion = repository->versionOf(*created->id);
+            OATPP_ASSERT(createdVersion && *createdVersion > 0);
+            OATPP_ASSERT(*createdVersion == repository->version());
+
+            uint64_t version = 0;
+            OATPP_ASSERT(repository->getById(created->id, &version) != nullptr);
+            OATPP_ASSERT(version == *createdVersion);
+
+            // A change to another contact leaves the version alone
+            auto other = repository->getById(1);
+            other->name = "Other Changed";
+            repository->update(other);
+            OATPP_ASSERT(repository->versionOf(*created->id) == createdVersion);
+
+            created->name = "Versioned Again";
+            repository->update(created);
+            auto updatedVersion = repository->versionOf(*created->id);
+            OATPP_ASSERT(*updatedVersion > *createdVersion);
+
+            OATPP_ASSERT(repository->remove(created->id));
+            OATPP_ASSERT(!repository->versionOf(*created->id));
+            OATPP_ASSERT(repository->create(created) != nullptr);
+            OATPP_ASSERT(*repository->versionOf(*created->id) > *updatedVersion);
+
+            // Contents loaded from a snapshot file keep version 0 through hydration
+            auto journal = journalPath("versions");
+            auto snapshotPath = journal + ".snap";
+            SnapshotFile::write(snapshotPath, *repository->snapshot(), 0);
+            ContactRepository restored(4, false, nullptr, SnapshotFile::open(snapshotPath));
+            OATPP_ASSERT(restored.versionOf(2) == std::optional<uint64_t>(0));
+            restored.waitHydrated();
+            OATPP_ASSERT(restored.versionOf(2) == std::optional<uint64_t>(0));
+            OATPP_ASSERT(restored.epoch() != repository->epoch());
+            std::filesystem::remove(snapshotPath);
+        }
+
+        OATPP_LOGI(TAG, "  [23/29] Testing change listeners and JSON cache...");
+        // Test change notifications and version-checked cache entries
+        {
+            auto repository = std::make_shared<ContactRepository>();
+            auto cache = std::make_shared<ContactJsonCache>(32);
+            std::vector<ContactRepository::ContactChange> changes;
+            repository->addChangeListener([&changes, cache](const ContactRepository::ContactChange& change) {
+                changes.push_back(change);
+                cache->invalidate(change.id);
+            });
+
+            auto version = *repository->versionOf(1);
+            cache->put(1, version, "{\"id\":1}");
+            OATPP_ASSERT(cache->find(1, version) == "{\"id\":1}");
+            OATPP_ASSERT(cache->find(1, version + 1) == nullptr);
+
+            auto contact = repository->getById(1);
+            contact->name = "Ivan Changed";
+            repository->update(contact);
+            OATPP_ASSERT(changes.size() == 1);
+            OATPP_ASSERT(changes[0].kind == ContactRepository::ContactChange::Kind::Put);
+            OATPP_ASSERT(changes[0].version == *repository->versionOf(1));
+            OATPP_ASSERT(changes[0].contact->name == "Ivan Changed");
+            OATPP_ASSERT(cache->find(1, version) == nullptr);
+
+            // An entry encoded from an older version does not replace a newer one
+            cache->put(2, 10, "new");
+            cache->put(2, 5, "old");
+            OATPP_ASSERT(cache->find(2, 10) == "new");
+            OATPP_ASSERT(repository->remove(2));
+            OATPP_ASSERT(changes.back().kind == ContactRepository::ContactChange::Kind::Remove);
+            OATPP_ASSERT(changes.back().contact == nullptr);
+            OATPP_ASSERT(cache->find(2, 10) == nullptr);
+
+            auto batch = ContactDto::createShared();
+            batch->name = "Batch Listener";
+            batch->phone = "+79990003344";
+            batch->address = "Kirov";
+            repository->createBatch({batch});
+            OATPP_ASSERT(changes.size() == 3);
+
+            // Least recently used entries are evicted past capacity
+            for (int64_t id = 1000; id < 1000 + 32 * 4; ++id) {
+                cache->put(id, 1, "x");
+            }
+            auto stats = cache->stats();
+            OATPP_ASSERT(stats.entries <= 32);
+            OATPP_ASSERT(stats.evictions > 0);
+            OATPP_ASSERT(stats.bytes == stats.entries);
+            OATPP_ASSERT(stats.hits == 2);
+            OATPP_ASSERT(stats.misses == 3);
+        }
+
+        OATPP_LOGI(TAG, "  [24/29] Testing latency histograms and metrics...");
+        // Test latency histograms and metrics
+        {
+            // Every value lands in a bucket whose upper bound is within 1/16 above it
+            for (uint64_t value : {0ull, 1ull, 15ull, 16ull, 17ull, 1000ull, 123456789ull, (1ull << 39) + 5}) {
+                auto bound = LatencyHistogram::upperBoundOf(LatencyHistogram::bucketOf(value));
+                OATPP_ASSERT(bound >= value);
+                OATPP_ASSERT(bound - value <= value / 16);
+            }
+            OATPP_ASSERT(LatencyHistogram::bucketOf(1ull << 62) == LatencyHistogram::kBucketCount - 1);
+
+            LatencyHistogram histogram;
+            for (uint64_t value = 1; value <= 1000; ++value) {
+                histogram.record(value * 1000);
+            }
+            auto snapshot = histogram.snapshot();
+            OATPP_ASSERT(snapshot.count == 1000);
+            OATPP_ASSERT(snapshot.sum == 500500000);
+            OATPP_ASSERT(snapshot.quantile(0.5) >= 500000 && snapshot.quantile(0.5) <= 500000 * 17 / 16);
+            OATPP_ASSERT(snapshot.quantile(0.99) >= 990000 && snapshot.quantile(0.99) <= 990000 * 17 / 16);
+            OATPP_ASSERT(snapshot.countAtOrBelow(0) == 0);
+            OATPP_ASSERT(snapshot.countAtOrBelow(1ull << 40) == 1000);
+            OATPP_ASSERT(HistogramSnapshot().quantile(0.5) == 0);
+
+            // Stripes written by several threads merge into one histogram
+            StripedHistogram striped(4);
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 8; ++t) {
+                threads.emplace_back([&striped] {
+                    for (uint64_t i = 0; i < 10000; ++i) {
+                        striped.record(100);
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            auto merged = striped.snapshot();
+            OATPP_ASSERT(merged.count == 80000);
+            OATPP_ASSERT(merged.sum == 8000000);
+            OATPP_ASSERT(merged.quantile(0.999) == LatencyHistogram::upperBoundOf(LatencyHistogram::bucketOf(100)));
+
+            // Endpoints are classified like the router matches them
+            using Endpoint = HttpMetrics::Endpoint;
+            OATPP_ASSERT(HttpMetrics::classify("GET", "/contacts?limit=10") == Endpoint::GetAllContacts);
+            OATPP_ASSERT(HttpMetrics::classify("POST", "/contacts") == Endpoint::CreateContact);
+            OATPP_ASSERT(HttpMetrics::classify("GET", "/contacts/search?name_prefix=a") == Endpoint::SearchContacts);
+            OATPP_ASSERT(HttpMetrics::classify("DELETE", "/contacts/batch") == Endpoint::DeleteContacts);
+            OATPP_ASSERT(HttpMetrics::classify("GET", "/contacts/changes/stream") == Endpoint::ChangeStream);
+            OATPP_ASSERT(HttpMetrics::classify("GET", "/contacts/42/stream") == Endpoint::Other);
+            OATPP_ASSERT(HttpMetrics::classify("GET", "/contacts/42") == Endpoint::GetContactById);
+            OATPP_ASSERT(HttpMetrics::classify("PUT", "/contacts/42/") == Endpoint::UpdateContact);
+            OATPP_ASSERT(HttpMetrics::classify("GET", "/metrics") == Endpoint::Metrics);
+            OATPP_ASSERT(HttpMetrics::classify("GET", "/swagger/ui") == Endpoint::Other);
+            OATPP_ASSERT(HttpMetrics::classify("PATCH", "/contacts/42") == Endpoint::PatchContact);
+            OATPP_ASSERT(HttpMetrics::classify("PATCH", "/contacts") == Endpoint::Other);
+
+            auto metrics = std::make_shared<HttpMetrics>();
+            metrics->record(Endpoint::GetContactById, 200, 50000);
+            metrics->record(Endpoint::GetContactById, 404, 20000);
+            metrics->record(Endpoint::GetContactById, 304, 10000);
+            OATPP_ASSERT(metrics->latency(Endpoint::GetContactById).count == 3);
+            OATPP_ASSERT(metrics->responses(Endpoint::GetContactById, 1) == 1);
+            OATPP_ASSERT(metrics->responses(Endpoint::GetContactById, 3) == 1);
+            OATPP_ASSERT(metrics->latency(Endpoint::CreateContact).count == 0);
+
+            // Lock times are sampled once enabled
+            auto repository = std::make_shared<ContactRepository>(4);
+            OATPP_ASSERT(repository->lockTimes() == nullptr);
+            repository->enableLockMetrics();
+            for (int i = 0; i < 200; ++i) {
+                auto contact = ContactDto::createShared();
+                contact->name = "Metered " + std::to_string(i);
+                contact->phone = "+7999100" + std::to_string(1000 + i);
+                contact->address = "Omsk";
+                repository->create(contact);
+            }
+            OATPP_ASSERT(repository->lockTimes()->wait.snapshot().count > 0);
+            OATPP_ASSERT(repository->lockTimes()->hold.snapshot().count > 0);
+
+            auto cache = std::make_shared<ContactJsonCache>(16);
+            cache->put(1, 1, "{}");
+            MetricsExporter exporter(metrics, repository, cache);
+            auto text = exporter.render();
+            auto contains = [&text](const std::string& line) {
+                return text.find(line) != std::string::npos;
+            };
+            OATPP_ASSERT(contains("contacts_http_requests_total{endpoint=\"getContactById\",status=\"2xx\"} 1\n"));
+            OATPP_ASSERT(contains("contacts_http_request_duration_seconds_bucket{endpoint=\"getContactById\",le=\"0.0001\"} 3\n"));
+            OATPP_ASSERT(contains("contacts_http_request_duration_seconds_count{endpoint=\"getContactById\"} 3\n"));
+            OATPP_ASSERT(contains("contacts_http_request_duration_seconds_count{endpoint=\"createContact\"} 0\n"));
+            OATPP_ASSERT(contains("contacts_http_request_duration_quantile_seconds{endpoint=\"getContactById\",quantile=\"0.5\"}"));
+            OATPP_ASSERT(contains("# TYPE contacts_repository_lock_wait_seconds histogram\n"));
+            OATPP_ASSERT(contains("contacts_repository_lock_hold_seconds_bucket{le=\"+Inf\"}"));
+            OATPP_ASSERT(contains("contacts_repository_contacts " + std::to_string(repository->size()) + "\n"));
+            OATPP_ASSERT(contains("contacts_repository_memory_bytes{component=\"records\"}"));
+            OATPP_ASSERT(contains("contacts_json_cache_entries 1\n"));
+        }
+
+        OATPP_LOGI(TAG, "  [25/29] Testing patch compare-and-swap...");
+        // Test that conditional patches from concurrent writers never overwrite each other
+        {
+            auto repository = std::make_shared<ContactRepository>(ContactRepository::kDefaultShardCount, true);
+            auto contact = ContactDto::createShared();
+            contact->name = "Counter";
+            contact->phone = "+79990002000";
+            contact->address = "0";
+            auto id = *repository->create(contact)->id;
+            auto other = ContactDto::createShared();
+            other->name = "Taken";
+            other->phone = "+79990002001";
+            other->address = "Omsk";
+            repository->create(other);
+
+            // Each thread increments the address as a read-modify-write retried on a version mismatch
+            constexpr int kThreads = 4;
+            constexpr int kIncrements = 200;
+            std::atomic<int> mismatches{0};
+            std::vector<std::thread> threads;
+            for (int t = 0; t < kThreads; ++t) {
+                threads.emplace_back([&] {
+                    for (int i = 0; i < kIncrements; ++i) {
+                        while (true) {
+                            uint64_t version = 0;
+                            auto current = repository->getById(id, &version);
+                            auto changes = ContactDto::createShared();
+                            changes->address = std::to_string(std::stoi(*current->address) + 1);
+                            ContactRepository::Conflict conflict;
+                            if (repository->patch(id, changes, version, &conflict)) {
+                                break;
+                            }
+                            OATPP_ASSERT(conflict == ContactRepository::Conflict::VersionMismatch);
+                            ++mismatches;
+                        }
+                    }
+                });
+            }
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            auto counted = repository->getById(id);
+            OATPP_ASSERT(*counted->address == std::to_string(kThreads * kIncrements));
+            OATPP_ASSERT(counted->name == "Counter");
+            OATPP_LOGI(TAG, "      %d version mismatches retried", mismatches.load());
+
+            // Only the given fields change, the indexes follow them
+            auto changes = ContactDto::createShared();
+            changes->name = "Renamed";
+            uint64_t version = 0;
+            auto patched = repository->patch(id, changes, std::nullopt, nullptr, &version);
+            OATPP_ASSERT(patched->phone == "+79990002000");
+            OATPP_ASSERT(repository->versionOf(id) == version);
+            OATPP_ASSERT(repository->findByNamePrefix("renamed", 10).size() == 1);
+            OATPP_ASSERT(repository->findByNamePrefix("counter", 10).empty());
+
+            ContactRepository::Conflict conflict;
+            auto taken = ContactDto::createShared();
+            taken->phone = "+79990002001";
+            OATPP_ASSERT(!repository->patch(id, taken, std::nullopt, &conflict));
+            OATPP_ASSERT(conflict == ContactRepository::Conflict::DuplicatePhone);
+            OATPP_ASSERT(!repository->patch(id + 100, taken, std::nullopt, &conflict));
+            OATPP_ASSERT(conflict == ContactRepository::Conflict::NotFound);
+            OATPP_ASSERT(repository->versionOf(id) == version);
+        }
+
+        OATPP_LOGI(TAG, "  [26/29] Testing delta sync...");
+        // Test that a delta holds exactly the contacts changed and removed after since
+        {
+            auto repository = std::make_shared<ContactRepository>();
+            auto full = repository->changesSince(0);
+            OATPP_ASSERT(full && full->contacts.size() == 3 && full->removed.empty() && !full->more);
+            OATPP_ASSERT(full->version == repository->version());
+            auto since = full->version;
+
+            auto contact = ContactDto::createShared();
+            contact->name = "Delta";
+            contact->phone = "+79990003000";
+            contact->address = "Sochi";
+            auto created = repository->create(contact);
+            auto renamed = repository->getById(1);
+            renamed->name = "Ivan Renamed";
+            repository->update(renamed);
+            renamed->name = "Ivan Renamed Twice";
+            repository->update(renamed);
+            repository->remove(2);
+            repository->remove(*created->id);
+
+            auto delta = repository->changesSince(since);
+            OATPP_ASSERT(delta && delta->version == repository->version() && !delta->more);
+            OATPP_ASSERT(delta->contacts.size() == 1 && delta->contacts[0]->name == "Ivan Renamed Twice");
+            OATPP_ASSERT(delta->removed.size() == 2);
+            OATPP_ASSERT(std::set<int64_t>(delta->removed.begin(), delta->removed.end()) ==
+                         std::set<int64_t>({2, *created->id}));
+            auto empty = repository->changesSince(delta->version);
+            OATPP_ASSERT(empty && empty->contacts.empty() && empty->removed.empty());
+            OATPP_ASSERT(empty->version == delta->version);
+            OATPP_ASSERT(!repository->changesSince(repository->version() + 1));
+
+            // A removed contact that is created again is a change, not a removal
+            auto restored = ContactDto::createShared();
+            restored->id = 2;
+            restored->name = "Maria Back";
+            restored->phone = "+79997654321";
+            restored->address = "Pskov";
+            repository->create(restored);
+            delta = repository->changesSince(since);
+            OATPP_ASSERT(delta->removed.size() == 1 && delta->removed[0] == *created->id);
+            OATPP_ASSERT(delta->contacts.size() == 2 && delta->contacts[1]->name == "Maria Back");
+
+            // Limited deltas, followed one after another, add up to the whole delta
+            std::set<int64_t> changed;
+            std::set<int64_t> removed;
+            auto next = since;
+            size_t deltas = 0;
+            while (true) {
+                auto part = repository->changesSince(next, 1);
+                OATPP_ASSERT(part && part->contacts.size() + part->removed.size() <= 1);
+                for (auto& item : part->contacts) {
+                    changed.insert(*item->id);
+                }
+                removed.insert(part->removed.begin(), part->removed.end());
+                next = part->version;
+                ++deltas;
+                if (!part->more) {
+                    break;
+                }
+            }
+            OATPP_ASSERT(changed == std::set<int64_t>({1, 2}) && removed == std::set<int64_t>({*created->id}));
+            OATPP_ASSERT(next == repository->version() && deltas == 4);
+
+            // Past the cap the oldest tombstones are compacted away and deltas from before them expire,
+            // while superseded entries are dropped and the log stays small
+            auto capped = std::make_shared<ContactRepository>(1);
+            capped->setMaxTombstones(100);
+            auto start = capped->version();
+            for (int i = 0; i < 3000; ++i) {
+                contact->id = nullptr;
+                contact->phone = "+7999100" + std::to_string(10000 + i);
+                auto item = capped->create(contact);
+                item->address = "Moved";
+                capped->update(item);
+                capped->remove(item->id);
+            }
+            OATPP_ASSERT(!capped->changesSince(start));
+            auto recent = capped->changesSince(capped->version() - 30);
+            OATPP_ASSERT(recent && recent->contacts.empty() && recent->removed.size() == 10);
+            OATPP_ASSERT(capped->memoryStats().modifications < 9000 * sizeof(ModificationLog::Entry));
+            OATPP_ASSERT(capped->changesSince(0)->contacts.size() == 3);
+        }
+
+        OATPP_LOGI(TAG, "  [27/29] Testing response compression...");
+        // Test content coding negotiation, that compressed bodies decode to the original and the compressed cache
+        {
+            auto preferred = HttpCompression::isSupported(ContentCoding::Zstd) ? ContentCoding::Zstd : ContentCoding::Gzip;
+            OATPP_ASSERT(HttpCompression::negotiate("") == ContentCoding::Identity);
+            OATPP_ASSERT(HttpCompression::negotiate("br") == ContentCoding::Identity);
+            OATPP_ASSERT(HttpCompression::negotiate("gzip, deflate") == ContentCoding::Gzip);
+            OATPP_ASSERT(HttpCompression::negotiate("deflate") == ContentCoding::Deflate);
+            OATPP_ASSERT(HttpCompression::negotiate("GZIP;q=0.5, deflate;q=0.8") == ContentCoding::Deflate);
+            OATPP_ASSERT(HttpCompression::negotiate("gzip;q=0, *") == (preferred == ContentCoding::Zstd
+                                                                          ? ContentCoding::Zstd : ContentCoding::Deflate));
+            OATPP_ASSERT(HttpCompression::negotiate("*;q=0") == ContentCoding::Identity);
+            OATPP_ASSERT(HttpCompression::negotiate("gzip, deflate, zstd") == preferred);
+
+            // Compressed copies get their own tags, which lead back to the one they were made from
+            OATPP_ASSERT(HttpCompression::entityTagOf("\"1f-2a\"", ContentCoding::Gzip) == "\"1f-2a-gzip\"");
+            OATPP_ASSERT(HttpCompression::entityTagOf("W/\"1f-2a-mp\"", ContentCoding::Zstd) == "W/\"1f-2a-mp-zstd\"");
+            OATPP_ASSERT(HttpCompression::entityTagOf("\"1f-2a\"", ContentCoding::Identity) == "\"1f-2a\"");
+            OATPP_ASSERT(HttpCompression::identityTagOf("\"1f-2a-deflate\"") == "\"1f-2a\"");
+            OATPP_ASSERT(HttpCompression::identityTagOf("\"1f-2a-mp-gzip\"") == "\"1f-2a-mp\"");
+            OATPP_ASSERT(HttpCompression::identityTagOf("\"1f-2a\"") == "\"1f-2a\"");
+            OATPP_ASSERT(HttpCompression::identityTagOf("\"-gzip\"") == "\"-gzip\"");
+
+            std::string body;
+            for (int i = 0; i < 20000; ++i) {
+                body += "{\"id\":" + std::to_string(i) + ",\"name\":\"Ivan Ivanov\",\"phone\":\"+79991234567\"},";
+            }
+            for (auto coding : {ContentCoding::Gzip, ContentCoding::Deflate}) {
+                // Streamed in uneven pieces, as a response body is read
+                HttpCompression::Encoder encoder(coding, 6);
+                std::string compressed;
+                for (size_t offset = 0; offset < body.size(); offset += 7777) {
+                    encoder.write(std::string_view(body).substr(offset, 7777), compressed);
+                }
+                encoder.finish(compressed);
+                OATPP_ASSERT(compressed.size() * 5 < body.size());
+                OATPP_ASSERT(compressed == HttpCompression::compress(body, coding, 6));
+
+                z_stream inflater{};
+                OATPP_ASSERT(inflateInit2(&inflater, coding == ContentCoding::Gzip ? 15 + 16 : 15) == Z_OK);
+                std::string decoded(body.size() + 1, '\0');
+                inflater.next_in = reinterpret_cast<Bytef*>(compressed.data());
+                inflater.avail_in = static_cast<uInt>(compressed.size());
+                inflater.next_out = reinterpret_cast<Bytef*>(decoded.data());
+                inflater.avail_out = static_cast<uInt>(decoded.size());
+                OATPP_ASSERT(inflate(&inflater, Z_FINISH) == Z_STREAM_END);
+                decoded.resize(inflater.total_out);
+                inflateEnd(&inflater);
+                OATPP_ASSERT(decoded == body);
+            }
+            OATPP_ASSERT(HttpCompression::compress(body, ContentCoding::Gzip, 1).size() >
+                         HttpCompression::compress(body, ContentCoding::Gzip, 9).size());
+
+            // Entries are found only for the same coding, target and tag, within the byte capacity
+            CompressedResponseCache cache(1000);
+            auto key = CompressedResponseCache::keyOf("gzip", "/contacts?limit=10", "\"a-1\"");
+            OATPP_ASSERT(!cache.find(key));
+            cache.put(key, oatpp::String(std::string(400, 'x')));
+            OATPP_ASSERT(cache.find(key)->size() == 400);
+            OATPP_ASSERT(!cache.find(CompressedResponseCache::keyOf("gzip", "/contacts?limit=10", "\"a-2\"")));
+            OATPP_ASSERT(!cache.find(CompressedResponseCache::keyOf("deflate", "/contacts?limit=10", "\"a-1\"")));
+            cache.put(CompressedResponseCache::keyOf("gzip", "/contacts", "\"a-1\""), oatpp::String(std::string(300, 'y')));
+            OATPP_ASSERT(!cache.fits(501));
+            cache.put(CompressedResponseCache::keyOf("gzip", "/contacts/export", "\"a-1\""), oatpp::String(std::string(501, 'z')));
+            auto stats = cache.stats();
+            OATPP_ASSERT(stats.entries == 2 && stats.bytes == 700);
+            // The least recently used entry makes room
+            cache.put(CompressedResponseCache::keyOf("gzip", "/contacts/export", "\"a-2\""), oatpp::String(std::string(400, 'z')));
+            OATPP_ASSERT(!cache.find(key) && cache.stats().bytes == 700);
+            OATPP_ASSERT(cache.stats().hits == 1);
+        }
+
+        OATPP_LOGI(TAG, "  [28/29] Testing fuzzy name search...");
+        // Test typo-tolerant matching, ranking and that the trigram index follows renames and removals
+        {
+            auto repository = std::make_shared<ContactRepository>();
+            auto add = [&](const char* name) {
+                auto contact = ContactDto::createShared();
+                contact->name = name;
+                contact->phone = "+79990000000";
+                return *repository->create(contact)->id;
+            };
+            auto names = [&](const std::string& query, size_t limit = 20) {
+                std::vector<std::string> result;
+                for (const auto& contact : repository->findByNameFuzzy(query, limit)) {
+                    result.push_back(*contact->name);
+                }
+                return result;
+            };
+            auto petrov = add("Sergey Petrov");
+            add("Ivan Petrovsky");
+            add("Дмитрий Кузнецов");
+
+            OATPP_ASSERT(TrigramIndex::maxDistanceFor(2) == 0 && TrigramIndex::maxDistanceFor(5) == 1);
+            auto query = TrigramIndex::compile("Petorv, Sergei");
+            OATPP_ASSERT(query.words.size() == 2 && query.maxDistances == std::vector<size_t>({2, 2}));
+            OATPP_ASSERT(TrigramIndex::distance(query, "Sergey Petrov") == 3u);
+            OATPP_ASSERT(!TrigramIndex::distance(query, "Sergey Ivanov"));
+
+            // One typo in a seeded name, case ignored
+            OATPP_ASSERT(names("sidorof") == std::vector<std::string>({"Alexey Sidorov"}));
+            OATPP_ASSERT((names("Ivan") == std::vector<std::string>({"Ivan Ivanov", "Ivan Petrovsky"})));
+            // "petrof" is one edit from "petrov", two from "petrova" and four from "petrovsky"
+            OATPP_ASSERT((names("Petrof") == std::vector<std::string>({"Sergey Petrov", "Maria Petrova"})));
+            OATPP_ASSERT(names("Petrof", 1) == std::vector<std::string>({"Sergey Petrov"}));
+            // Every query word has to match, in any order
+            OATPP_ASSERT(names("petrov sergy") == std::vector<std::string>({"Sergey Petrov"}));
+            OATPP_ASSERT(names("petrov olga").empty());
+            // Short words are matched exactly, Cyrillic is normalized as in the name index
+            OATPP_ASSERT(names("Iv").empty());
+            OATPP_ASSERT(names("КУЗНЕЦОФ") == std::vector<std::string>({"Дмитрий Кузнецов"}));
+            OATPP_ASSERT(names(" ,. ").empty());
+
+            auto renamed = ContactDto::createShared();
+            renamed->id = petrov;
+            renamed->name = "Sergey Smirnov";
+            renamed->phone = "+79990000000";
+            OATPP_ASSERT(repository->update(renamed) != nullptr);
+            OATPP_ASSERT(names("Petrof") == std::vector<std::string>({"Maria Petrova"}));
+            OATPP_ASSERT(names("smirnof") == std::vector<std::string>({"Sergey Smirnov"}));
+            OATPP_ASSERT(repository->remove(petrov));
+            OATPP_ASSERT(names("smirnof").empty());
+            OATPP_ASSERT(repository->memoryStats().trigramIndex > 0);
+
+            // Words shared by many names are one term; a term goes away with its last contact
+            TrigramIndex index;
+            index.insert("Anna Popova", 1);
+            index.insert("anna anna", 2);
+            index.insert("Anna-Maria", 3);
+            OATPP_ASSERT(index.termCount() == 3);
+            auto matches = index.search(TrigramIndex::compile("ana"), 10);
+            OATPP_ASSERT(matches.size() == 3 && matches[0].id == 1 && matches[0].distance == 1);
+            OATPP_ASSERT(index.search(TrigramIndex::compile("ana mari"), 10).size() == 1);
+            index.erase("Anna-Maria", 3);
+            OATPP_ASSERT(index.termCount() == 2 && index.search(TrigramIndex::compile("mari"), 10).empty());
+            index.erase("Anna Popova", 1);
+            index.erase("anna anna", 2);
+            OATPP_ASSERT(index.termCount() == 0 && index.search(TrigramIndex::compile("anna"), 10).empty());
+        }
+
+        OATPP_LOGI(TAG, "  [29/29] Testing sorted listing...");
+        // Test pages in id, name and phone order from the snapshot and the ordered indexes
+        {
+            auto repository = std::make_shared<ContactRepository>(4);
+            auto add = [&](const char* name, const char* phone) {
+                auto contact = ContactDto::createShared();
+                contact->name = name;
+                contact->phone = phone;
+                return *repository->create(contact)->id;
+            };
+            auto idsOf = [](const std::vector<oatpp::Object<ContactDto>>& contacts) {
+                std::vector<int64_t> ids;
+                for (const auto& contact : contacts) {
+                    ids.push_back(*contact->id);
+                }
+                return ids;
+            };
+            using SortKey = ContactRepository::SortKey;
+            // Seeded: 1 Ivan Ivanov, 2 Maria Petrova, 3 Alexey Sidorov
+            auto boris = add("boris", "+15550001111");
+            auto yana = add("Яна", "+79990000001");
+            auto anna = add("Anna", "+442071234567");
+
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Id, false, 0, 100)) ==
+                         std::vector<int64_t>({1, 2, 3, boris, yana, anna}));
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Id, true, 1, 3)) ==
+                         std::vector<int64_t>({yana, boris, 3}));
+            OATPP_ASSERT(repository->sortedPage(SortKey::Id, true, 6, 3).empty());
+
+            // Case-insensitive, Cyrillic after Latin
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Name, false, 0, 100)) ==
+                         std::vector<int64_t>({3, anna, boris, 1, 2, yana}));
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Name, true, 0, 2)) == std::vector<int64_t>({yana, 2}));
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Name, false, 2, 2)) == std::vector<int64_t>({boris, 1}));
+            OATPP_ASSERT(repository->sortedPage(SortKey::Name, false, 10, 2).empty());
+
+            // Seeded phones: +79991234567, +79997654321, +79995555555
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Phone, false, 0, 100)) ==
+                         std::vector<int64_t>({boris, anna, yana, 1, 3, 2}));
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Phone, true, 1, 2)) == std::vector<int64_t>({3, 1}));
+
+            // The indexes follow changes
+            auto renamed = ContactDto::createShared();
+            renamed->id = anna;
+            renamed->name = "Zoe";
+            renamed->phone = "+10000000000";
+            OATPP_ASSERT(repository->update(renamed) != nullptr);
+            OATPP_ASSERT(repository->remove(boris));
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Name, false, 0, 100)) ==
+                         std::vector<int64_t>({3, 1, 2, anna, yana}));
+            OATPP_ASSERT(idsOf(repository->sortedPage(SortKey::Phone, false, 0, 1)) == std::vector<int64_t>({anna}));
+
+            // The snapshot cursor walks either way from a given id
+            auto view = repository->snapshot();
+            ContactSnapshot::Cursor down(*view, yana, true);
+            OATPP_ASSERT(down.nextId() == 3 && down.nextId() == 2 && down.nextId() == 1 && !down.nextId());
+            OATPP_ASSERT(view->countAfter(yana, true) == 3 && view->countAfter(yana) == 1);
+
+            // Id pages are read straight from the shards' record pages, across page splits and merges
+            auto paged = std::make_shared<ContactRepository>(1);
+            std::set<int64_t> expected{1, 2, 3};
+            for (int i = 0; i < 1000; ++i) {
+                auto contact = ContactDto::createShared();
+                contact->name = "Paged";
+                expected.insert(*paged->create(contact)->id);
+            }
+            for (int64_t id = 100; id < 900; ++id) {
+                if (id % 3 != 0) {
+                    OATPP_ASSERT(paged->remove(id));
+                    expected.erase(id);
+                }
+            }
+            // Half of the removed ids come back, so the merged pages in the middle fill up and split again
+            for (int64_t id = 898; id >= 100; id -= 3) {
+                auto contact = ContactDto::createShared();
+                contact->id = id;
+                contact->name = "Paged";
+                OATPP_ASSERT(paged->create(contact) != nullptr);
+                expected.insert(id);
+            }
+            OATPP_ASSERT(paged->snapshot()->shard(0)->records->pageCount() > 4);
+            std::vector<int64_t> ascending(expected.begin(), expected.end());
+            std::vector<int64_t> descending(expected.rbegin(), expected.rend());
+            OATPP_ASSERT(idsOf(paged->sortedPage(SortKey::Id, false, 0, 10000)) == ascending);
+            for (size_t offset = 0; offset < ascending.size(); offset += 97) {
+                auto count = std::min<size_t>(150, ascending.size() - offset);
+                auto offsetAt = static_cast<std::ptrdiff_t>(offset);
+                auto countAt = static_cast<std::ptrdiff_t>(count);
+                OATPP_ASSERT(idsOf(paged->sortedPage(SortKey::Id, false, offset, 150)) ==
+                             std::vector<int64_t>(ascending.begin() + offsetAt, ascending.begin() + offsetAt + countAt));
+                OATPP_ASSERT(idsOf(paged->sortedPage(SortKey::Id, true, offset, 150)) ==
+                             std::vector<int64_t>(descending.begin() + offsetAt, descending.begin() + offsetAt + countAt));
+            }
+
+            // A page continues after its last entry even once that entry is gone
+            NameIndex names;
+            for (int64_t id = 1; id <= 5; ++id) {
+                names.insert("name " + std::to_string(id), id);
+            }
+            NameIndex::Key last;
+            OATPP_ASSERT(names.page(1, 2, false, &last) == std::vector<int64_t>({2, 3}));
+            names.erase("Name 3", 3);
+            OATPP_ASSERT(names.pageAfter(last, 5, false) == std::vector<int64_t>({4, 5}));
+            OATPP_ASSERT(names.pageAfter(last, 5, true) == std::vector<int64_t>({2, 1}));
+            PhoneIndex phones(false);
+            for (int64_t id = 1; id <= 4; ++id) {
+                phones.replace(std::nullopt, PhoneKey::parse("+7999000000" + std::to_string(id)), id);
+            }
+            PhoneIndex::Key lastPhone;
+            OATPP_ASSERT(phones.page(0, 2, true, &lastPhone) == std::vector<int64_t>({4, 3}));
+            phones.replace(PhoneKey::parse("+79990000003"), std::nullopt, 3);
+            OATPP_ASSERT(phones.pageAfter(lastPhone, 1, true) == std::vector<int64_t>({2}));
+
+            // Pages stay full while contacts are removed during the read: every removal is preceded by a creation
+            // sorting after all the others in the walk's direction, so more than a page is always left after any
+            // point of the walk, even when the reader is held up long enough for the whole directory to turn over
+            for (bool descending : {false, true}) {
+                auto churning = std::make_shared<ContactRepository>(4);
+                std::vector<int64_t> live;
+                int next = 0;
+                auto addChurn = [&] {
+                    auto key = descending ? 999999 - next : next;
+                    ++next;
+                    char name[32];
+                    std::snprintf(name, sizeof(name), "Churn %06d", key);
+                    auto contact = ContactDto::createShared();
+                    contact->name = name;
+                    contact->phone = "+7900" + std::to_string(1000000 + key);
+                    live.push_back(*churning->create(contact)->id);
+                };
+                for (int i = 0; i < 200; ++i) {
+                    addChurn();
+                }
+                std::atomic<bool> stop{false};
+                std::thread churn([&] {
+                    for (size_t removed = 0; !stop.load(); ++removed) {
+                        addChurn();
+                        churning->remove(live[removed]);
+                    }
+                });
+                for (int round = 0; round < 1000; ++round) {
+                    OATPP_ASSERT(churning->sortedPage(SortKey::Name, descending, 0, 50).size() == 50);
+                    OATPP_ASSERT(churning->sortedPage(SortKey::Phone, descending, 0, 50).size() == 50);
+                }
+                stop = true;
+                churn.join();
+            }
+        }
+    }
+
+private:
+    static std::string journalPath(const std::string& name) {
+        auto path = std::filesystem::temp_directory_path() /
+                    ("contacts_test_" + name + "_" + std::to_string(::getpid()) + ".wal");
+        std::filesystem::remove(path);
+        return path.string();
     }
 };
 
 }
-
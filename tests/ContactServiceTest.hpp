@@ -4,12 +4,27 @@
 
 #pragma once
 
+#include "codec/ContactMessagePack.hpp"
+#include "network/BlockingTaskPool.hpp"
 #include "service/ContactService.hpp"
+#include "service/HexNumber.hpp"
+#include "repository/ChangeLog.hpp"
 #include "repository/ContactRepository.hpp"
+#include "stream/ChangeEventStream.hpp"
+#include "stream/ContactImporter.hpp"
+#include "stream/ContactJsonStream.hpp"
 #include "dto/ContactDto.hpp"
 #include <oatpp-test/UnitTest.hpp>
 #include <oatpp/core/base/Environment.hpp>
+#include <oatpp/parser/json/mapping/ObjectMapper.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace test {
 
@@ -21,7 +36,7 @@ public:
         auto repository = std::make_shared<ContactRepository>();
         auto service = std::make_shared<ContactService>(repository);
 
-        OATPP_LOGI(TAG, "  [1/14] Testing create contact...");
+        OATPP_LOGI(TAG, "  [1/25] Testing create contact...");
         // Test create contact
         {
             auto contact = ContactDto::createShared();
@@ -29,59 +44,53 @@ public:
             contact->phone = "+79997777777";
             contact->address = "Service Test Address";
 
-            auto created = service->createContact(contact);
+            auto created = service->createContact(contact).value();
             OATPP_ASSERT(created != nullptr);
             OATPP_ASSERT(created->id != nullptr);
             OATPP_ASSERT(*created->id > 0);
             OATPP_ASSERT(created->name == "Service Test User");
         }
 
-        OATPP_LOGI(TAG, "  [2/14] Testing create contact with missing name...");
+        OATPP_LOGI(TAG, "  [2/25] Testing create contact with missing name...");
         // Test create contact with missing name
         {
             auto contact = ContactDto::createShared();
             contact->phone = "+79998888888";
             contact->address = "Test Address";
 
-            try {
-                service->createContact(contact);
-                OATPP_ASSERT(false); // Should throw
-            } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()).find("required") != std::string::npos);
-            }
+            auto failed = service->createContact(contact);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(failed.error().message.find("required") != std::string::npos);
         }
 
-        OATPP_LOGI(TAG, "  [3/14] Testing create contact with missing phone...");
+        OATPP_LOGI(TAG, "  [3/25] Testing create contact with missing phone...");
         // Test create contact with missing phone
         {
             auto contact = ContactDto::createShared();
             contact->name = "Test User";
             contact->address = "Test Address";
 
-            try {
-                service->createContact(contact);
-                OATPP_ASSERT(false); // Should throw
-            } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()).find("required") != std::string::npos);
-            }
+            auto failed = service->createContact(contact);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(failed.error().message.find("required") != std::string::npos);
         }
 
-        OATPP_LOGI(TAG, "  [4/14] Testing create contact with missing address...");
+        OATPP_LOGI(TAG, "  [4/25] Testing create contact with missing address...");
         // Test create contact with missing address
         {
             auto contact = ContactDto::createShared();
             contact->name = "Test User";
             contact->phone = "+79999999999";
 
-            try {
-                service->createContact(contact);
-                OATPP_ASSERT(false); // Should throw
-            } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()).find("required") != std::string::npos);
-            }
+            auto failed = service->createContact(contact);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(failed.error().message.find("required") != std::string::npos);
         }
 
-        OATPP_LOGI(TAG, "  [5/14] Testing getContactById...");
+        OATPP_LOGI(TAG, "  [5/25] Testing getContactById...");
         // Test getContactById
         {
             auto contact = ContactDto::createShared();
@@ -89,47 +98,43 @@ public:
             contact->phone = "+79991000000";
             contact->address = "Get By ID Address";
 
-            auto created = service->createContact(contact);
+            auto created = service->createContact(contact).value();
             OATPP_ASSERT(created->id != nullptr);
             auto id = *created->id;
 
-            auto retrieved = service->getContactById(id);
+            auto retrieved = service->getContactById(id).value();
             OATPP_ASSERT(retrieved != nullptr);
             OATPP_ASSERT(retrieved->id != nullptr);
             OATPP_ASSERT(*retrieved->id == id);
             OATPP_ASSERT(retrieved->name == "Get By ID Test");
         }
 
-        OATPP_LOGI(TAG, "  [6/14] Testing getContactById with invalid ID...");
+        OATPP_LOGI(TAG, "  [6/25] Testing getContactById with invalid ID...");
         // Test getContactById with invalid ID
         {
-            try {
-                service->getContactById(-1);
-                OATPP_ASSERT(false); // Should throw
-            } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()).find("Invalid ID") != std::string::npos);
-            }
+            auto failed = service->getContactById(-1);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(failed.error().message.find("Invalid ID") != std::string::npos);
         }
 
-        OATPP_LOGI(TAG, "  [7/14] Testing getContactById with non-existent ID...");
+        OATPP_LOGI(TAG, "  [7/25] Testing getContactById with non-existent ID...");
         // Test getContactById with non-existent ID
         {
-            try {
-                service->getContactById(99999);
-                OATPP_ASSERT(false); // Should throw
-            } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()) == "Contact not found");
-            }
+            auto failed = service->getContactById(99999);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::NotFound);
+            OATPP_ASSERT(failed.error().message == "Contact not found");
         }
 
-        OATPP_LOGI(TAG, "  [8/14] Testing getAllContacts...");
+        OATPP_LOGI(TAG, "  [8/25] Testing getAllContacts...");
         // Test getAllContacts
         {
             auto contacts = service->getAllContacts();
             OATPP_ASSERT(contacts.size() > 0);
         }
 
-        OATPP_LOGI(TAG, "  [9/14] Testing updateContact...");
+        OATPP_LOGI(TAG, "  [9/25] Testing updateContact...");
         // Test updateContact
         {
             auto contact = ContactDto::createShared();
@@ -137,7 +142,7 @@ public:
             contact->phone = "+79991111111";
             contact->address = "Original Address";
 
-            auto created = service->createContact(contact);
+            auto created = service->createContact(contact).value();
             OATPP_ASSERT(created->id != nullptr);
             auto id = *created->id;
 
@@ -147,7 +152,7 @@ public:
             updated->phone = "+79992222222";
             updated->address = "Updated Address";
 
-            auto result = service->updateContact(updated);
+            auto result = service->updateContact(updated).value();
             OATPP_ASSERT(result != nullptr);
             OATPP_ASSERT(result->id != nullptr);
             OATPP_ASSERT(*result->id == id);
@@ -155,7 +160,7 @@ public:
             OATPP_ASSERT(result->phone == "+79992222222");
         }
 
-        OATPP_LOGI(TAG, "  [10/14] Testing updateContact with invalid ID...");
+        OATPP_LOGI(TAG, "  [10/25] Testing updateContact with invalid ID...");
         // Test updateContact with invalid ID
         {
             auto contact = ContactDto::createShared();
@@ -164,16 +169,14 @@ public:
             contact->phone = "+79993333333";
             contact->address = "Test Address";
 
-            try {
-                service->updateContact(contact);
-                OATPP_ASSERT(false); // Should throw
-            } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()).find("required") != std::string::npos ||
-                            std::string(e.what()).find("Invalid ID") != std::string::npos);
-            }
+            auto failed = service->updateContact(contact);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(failed.error().message.find("required") != std::string::npos ||
+                            failed.error().message.find("Invalid ID") != std::string::npos);
         }
 
-        OATPP_LOGI(TAG, "  [11/14] Testing updateContact with non-existent ID...");
+        OATPP_LOGI(TAG, "  [11/25] Testing updateContact with non-existent ID...");
         // Test updateContact with non-existent ID
         {
             auto contact = ContactDto::createShared();
@@ -182,15 +185,13 @@ public:
             contact->phone = "+79994444444";
             contact->address = "Test Address";
 
-            try {
-                service->updateContact(contact);
-                OATPP_ASSERT(false); // Should throw
-            } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()) == "Contact not found");
-            }
+            auto failed = service->updateContact(contact);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::NotFound);
+            OATPP_ASSERT(failed.error().message == "Contact not found");
         }
 
-        OATPP_LOGI(TAG, "  [12/14] Testing deleteContact...");
+        OATPP_LOGI(TAG, "  [12/25] Testing deleteContact...");
         // Test deleteContact
         {
             auto contact = ContactDto::createShared();
@@ -198,39 +199,682 @@ public:
             contact->phone = "+79995555555";
             contact->address = "Delete Address";
 
-            auto created = service->createContact(contact);
+            auto created = service->createContact(contact).value();
             OATPP_ASSERT(created->id != nullptr);
             auto id = *created->id;
 
-            bool deleted = service->deleteContact(id);
-            OATPP_ASSERT(deleted);
+            OATPP_ASSERT(service->deleteContact(id).ok());
 
-            try {
-                service->getContactById(id);
-                OATPP_ASSERT(false); // Should throw
-            } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()) == "Contact not found");
-            }
+            auto failed = service->getContactById(id);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::NotFound);
+            OATPP_ASSERT(failed.error().message == "Contact not found");
         }
 
-        OATPP_LOGI(TAG, "  [13/14] Testing deleteContact with invalid ID...");
+        OATPP_LOGI(TAG, "  [13/25] Testing deleteContact with invalid ID...");
         // Test deleteContact with invalid ID
         {
+            auto failed = service->deleteContact(-1);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(failed.error().message.find("Invalid ID") != std::string::npos);
+        }
+
+        OATPP_LOGI(TAG, "  [14/25] Testing deleteContact with non-existent ID...");
+        // Test deleteContact with non-existent ID
+        {
+            auto deleted = service->deleteContact(99999);
+            OATPP_ASSERT(!deleted);
+            OATPP_ASSERT(deleted.error().code == ErrorCode::NotFound);
+        }
+
+        OATPP_LOGI(TAG, "  [15/25] Testing getContactsPage...");
+        // Test getContactsPage
+        {
+            auto total = service->getContactsPage(nullptr, nullptr).value();
+            OATPP_ASSERT(total.limit == 0);
+            OATPP_ASSERT(total.nextCursor == nullptr);
+
+            std::vector<int64_t> expected;
+            total.snapshot->forEach([&expected](const oatpp::Object<ContactDto>& contact) {
+                expected.push_back(*contact->id);
+            });
+            OATPP_ASSERT(expected.size() > 4);
+
+            // Walk the directory two contacts at a time
+            std::vector<int64_t> paged;
+            oatpp::String cursor;
+            int pages = 0;
+            do {
+                auto page = service->getContactsPage(cursor, 2).value();
+                ContactSnapshot::Cursor walker(*page.snapshot, page.afterId);
+                for (size_t i = 0; i < page.limit; ++i) {
+                    auto contact = walker.next();
+                    if (!contact) {
+                        break;
+                    }
+                    paged.push_back(*contact->id);
+                }
+                cursor = page.nextCursor;
+                ++pages;
+            } while (cursor);
+
+            OATPP_ASSERT(paged == expected);
+            OATPP_ASSERT(pages == static_cast<int>((expected.size() + 1) / 2));
+
+            // Descending, three at a time after skipping one; an ascending cursor doesn't continue it
+            std::vector<int64_t> reversed(expected.rbegin() + 1, expected.rend());
+            paged.clear();
+            cursor = nullptr;
+            do {
+                auto page = service->getContactsPage(cursor, 3, cursor ? oatpp::Int64() : oatpp::Int64(1), true).value();
+                ContactSnapshot::Cursor walker(*page.snapshot, page.afterId, page.descending);
+                for (size_t i = 0; i < page.limit; ++i) {
+                    auto id = walker.nextId();
+                    if (!id) {
+                        break;
+                    }
+                    paged.push_back(*id);
+                }
+                cursor = page.nextCursor;
+                OATPP_ASSERT(!cursor || !service->getContactsPage(cursor, 3));
+            } while (cursor);
+            OATPP_ASSERT(paged == reversed);
+
+            // A page after a write sees it, and its snapshot still shares the records of the untouched shards
+            auto before = service->getContactsPage(nullptr, 1).value();
+            auto original = service->getContactById(expected.front()).value();
+            auto renamed = ContactDto::createShared();
+            renamed->id = expected.front();
+            renamed->name = "Paged After Write";
+            renamed->phone = "+79990000100";
+            renamed->address = "Page St., 1";
+            OATPP_ASSERT(service->updateContact(renamed).ok());
+            auto after = service->getContactsPage(nullptr, 1).value();
+            OATPP_ASSERT(after.snapshot != before.snapshot);
+            OATPP_ASSERT(ContactSnapshot::Cursor(*after.snapshot, after.afterId).next()->name == "Paged After Write");
+            size_t shared = 0;
+            for (size_t i = 0; i < after.snapshot->shardCount(); ++i) {
+                shared += after.snapshot->shard(i)->records == before.snapshot->shard(i)->records ? 1 : 0;
+            }
+            OATPP_ASSERT(shared == after.snapshot->shardCount() - 1);
+            OATPP_ASSERT(service->updateContact(original).ok());
+            OATPP_ASSERT(service->getContactsPage(nullptr, nullptr, static_cast<int64_t>(-1)).error().message ==
+                         "Invalid offset: must not be negative");
+
+            auto byName = ContactService::parseListOrder("name", "desc").value();
+            OATPP_ASSERT(byName.key == ContactRepository::SortKey::Name && byName.descending);
+            OATPP_ASSERT(ContactService::parseListOrder(nullptr, nullptr)->key == ContactRepository::SortKey::Id);
+            OATPP_ASSERT(!ContactService::parseListOrder("email", nullptr));
+            OATPP_ASSERT(!ContactService::parseListOrder("id", "up"));
+            auto sorted = service->getSortedContacts(byName, nullptr, static_cast<int64_t>(2)).value();
+            OATPP_ASSERT(sorted.size() == 2);
+            OATPP_ASSERT(!service->getSortedContacts(byName, nullptr, static_cast<int64_t>(5000)));
+        }
+
+        OATPP_LOGI(TAG, "  [16/25] Testing getContactsPage with invalid cursor and limit...");
+        // Test getContactsPage with invalid cursor and limit
+        {
+            auto badCursor = service->getContactsPage("not-a-cursor", 10);
+            OATPP_ASSERT(!badCursor);
+            OATPP_ASSERT(badCursor.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(badCursor.error().message == "Invalid cursor");
+
+            for (auto limit : {static_cast<int64_t>(0), ContactService::kMaxPageSize + 1}) {
+                auto badLimit = service->getContactsPage(nullptr, limit);
+                OATPP_ASSERT(!badLimit);
+                OATPP_ASSERT(badLimit.error().code == ErrorCode::InvalidArgument);
+                OATPP_ASSERT(badLimit.error().message.find("Invalid limit") != std::string::npos);
+            }
+
+            // The same checks without a read, made before a conditional listing is compared with its tag
+            auto cursor = service->getContactsPage(nullptr, 1)->nextCursor;
+            OATPP_ASSERT(!ContactService::validatePage(cursor, 10, 5, false));
+            OATPP_ASSERT(!ContactService::validatePage(nullptr, nullptr, nullptr, true));
+            OATPP_ASSERT(ContactService::validatePage("not-a-cursor", nullptr, nullptr, false)->message ==
+                         "Invalid cursor");
+            // An ascending cursor doesn't continue a descending listing
+            OATPP_ASSERT(ContactService::validatePage(cursor, nullptr, nullptr, true));
+            OATPP_ASSERT(ContactService::validatePage(nullptr, ContactService::kMaxPageSize + 1, nullptr, false)
+                             ->message.find("Invalid limit") != std::string::npos);
+            OATPP_ASSERT(ContactService::validatePage(nullptr, nullptr, -1, false)->message.find("Invalid offset") !=
+                         std::string::npos);
+        }
+
+        OATPP_LOGI(TAG, "  [17/25] Testing name search...");
+        // Test searchByNamePrefix and searchByNameFuzzy
+        {
+            auto found = service->searchByNamePrefix("ivan", nullptr).value();
+            OATPP_ASSERT(found.size() == 1);
+            OATPP_ASSERT(found[0]->name == "Ivan Ivanov");
+
+            auto failed = service->searchByNamePrefix("", nullptr);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(failed.error().message.find("required") != std::string::npos);
+
+            auto fuzzy = service->searchByNameFuzzy("Ivan Ivanow", nullptr).value();
+            OATPP_ASSERT(fuzzy.size() == 1 && fuzzy[0]->name == "Ivan Ivanov");
+            OATPP_ASSERT(service->searchByNameFuzzy("  ", nullptr).error().message == "Query is required");
+            OATPP_ASSERT(service->searchByNameFuzzy(std::string(200, 'a'), nullptr).error().message ==
+                         "Query is too long");
+            OATPP_ASSERT(service->searchByNameFuzzy("ivan", static_cast<int64_t>(0)).error().code ==
+                         ErrorCode::InvalidArgument);
+
+            // Queries arrive percent-encoded: an encoded space, '+' for a space, and UTF-8 bytes of "Ив"
+            auto encoded = service->searchByNamePrefix("Ivan%20Iv", nullptr).value();
+            OATPP_ASSERT(encoded.size() == 1 && encoded[0]->name == "Ivan Ivanov");
+            OATPP_ASSERT(service->searchByNamePrefix("ivan+iv", nullptr)->size() == 1);
+            auto cyrillic = ContactDto::createShared();
+            cyrillic->name = "Иван Петров";
+            cyrillic->phone = "+79990000200";
+            cyrillic->address = "Tver, Lenin St., 2";
+            auto cyrillicId = *(*service->createContact(cyrillic))->id;
+            auto decoded = service->searchByNamePrefix("%D0%98%D0%B2", nullptr).value();
+            OATPP_ASSERT(decoded.size() == 1 && decoded[0]->name == "Иван Петров");
+            OATPP_ASSERT(service->searchByNamePrefix("%d0%b8%d0%b2", nullptr)->size() == 1);
+            // "Иван Петроф", one letter off
+            auto fuzzyCyrillic = service->searchByNameFuzzy(
+                "%D0%98%D0%B2%D0%B0%D0%BD%20%D0%9F%D0%B5%D1%82%D1%80%D0%BE%D1%84", nullptr).value();
+            OATPP_ASSERT(fuzzyCyrillic.size() == 1 && fuzzyCyrillic[0]->name == "Иван Петров");
+            auto fuzzyEncoded = service->searchByNameFuzzy("Ivan%20Ivanow", nullptr).value();
+            OATPP_ASSERT(fuzzyEncoded.size() == 1 && fuzzyEncoded[0]->name == "Ivan Ivanov");
+            for (const char* malformed : {"Iv%2", "Iv%zz", "%"}) {
+                auto prefixError = service->searchByNamePrefix(malformed, nullptr);
+                OATPP_ASSERT(!prefixError && prefixError.error().code == ErrorCode::InvalidArgument);
+                auto queryError = service->searchByNameFuzzy(malformed, nullptr);
+                OATPP_ASSERT(!queryError && queryError.error().code == ErrorCode::InvalidArgument);
+            }
+            OATPP_ASSERT(service->searchByNameFuzzy("%20%20", nullptr).error().message == "Query is required");
+            OATPP_ASSERT(service->deleteContact(cyrillicId).ok());
+        }
+
+        OATPP_LOGI(TAG, "  [18/25] Testing phone normalization and lookup...");
+        // Test phone normalization and lookup
+        {
+            auto contact = ContactDto::createShared();
+            contact->name = "Formatted Phone";
+            contact->phone = "+7 (812) 555-01-02";
+            contact->address = "Phone Address";
+
+            auto created = service->createContact(contact).value();
+            OATPP_ASSERT(created->phone == "+78125550102");
+
+            auto found = service->findByPhone("8 12 555 01 02", nullptr).value();
+            OATPP_ASSERT(found.empty()); // Different digits, no country code
+            found = service->findByPhone("%2B78125550102", nullptr).value();
+            OATPP_ASSERT(found.size() == 1);
+            OATPP_ASSERT(*found[0]->id == *created->id);
+            // The query value is URL-decoded: escapes in either case, '+' as sent or as a space
+            for (const char* query : {"%2b78125550102", "+78125550102", " 78125550102", "%2B7%20(812)%20555-01-02",
+                                      "+7+(812)+555%2d01%2D02"}) {
+                found = service->findByPhone(query, nullptr).value();
+                OATPP_ASSERT(found.size() == 1 && *found[0]->id == *created->id);
+            }
+            OATPP_ASSERT(service->findByPhonePrefix("%2B7812", nullptr).value().size() == 1);
+            for (const char* malformed : {"%2", "%2G78125550102", "78125550102%", "%41"}) {
+                OATPP_ASSERT(service->findByPhone(malformed, nullptr).error().message == "Invalid phone");
+            }
+            OATPP_ASSERT(service->findByPhonePrefix("7812", nullptr).value().size() == 1);
+
+            auto invalid = ContactDto::createShared();
+            invalid->name = "Invalid Phone";
+            invalid->phone = "call me maybe";
+            invalid->address = "Phone Address";
+            auto failed = service->createContact(invalid);
+            OATPP_ASSERT(!failed);
+            OATPP_ASSERT(failed.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(failed.error().message.find("Invalid phone") != std::string::npos);
+        }
+
+        OATPP_LOGI(TAG, "  [19/25] Testing batch create, update, delete and multi-get...");
+        // Test batch operations: invalid items fail on their own with single-request messages
+        {
+            std::vector<oatpp::Object<ContactDto>> contacts;
+            for (int i = 0; i < 3; ++i) {
+                auto contact = ContactDto::createShared();
+                contact->name = "Batch Service " + std::to_string(i);
+                contact->phone = "+7 (495) 000-00-0" + std::to_string(i);
+                contact->address = "Batch Address";
+                contacts.push_back(contact);
+            }
+            contacts[1]->name = "";
+            contacts.push_back(nullptr);
+
+            auto created = service->createContacts(contacts).value();
+            OATPP_ASSERT(created.size() == 4);
+            OATPP_ASSERT(created[0].ok() && created[2].ok());
+            OATPP_ASSERT(created[0].contact->phone == "+74950000000");
+            OATPP_ASSERT(created[1].error->message.find("Name is required") != std::string::npos);
+            OATPP_ASSERT(created[3].error->message.find("required") != std::string::npos);
+            OATPP_ASSERT(created[3].error->code == ErrorCode::InvalidArgument);
+
+            auto update = ContactDto::createShared();
+            update->id = created[0].id;
+            update->name = "Batch Service Updated";
+            update->phone = "+74950000000";
+            update->address = "Batch Address";
+            auto missing = ContactDto::createShared();
+            missing->id = 987654;
+            missing->name = "Missing";
+            missing->phone = "+74950000009";
+            missing->address = "Batch Address";
+            auto updated = service->updateContacts({update, missing}).value();
+            OATPP_ASSERT(updated[0].ok());
+            OATPP_ASSERT(updated[0].contact->name == "Batch Service Updated");
+            OATPP_ASSERT(updated[1].error->code == ErrorCode::NotFound);
+            OATPP_ASSERT(updated[1].error->message == "Contact not found");
+
+            auto fetched = service->getContactsByIds(oatpp::String(
+                std::to_string(*created[2].id) + ",987654," + std::to_string(*created[0].id))).value();
+            OATPP_ASSERT(fetched.size() == 2);
+            OATPP_ASSERT(*fetched[0]->id == *created[2].id);
+            OATPP_ASSERT(fetched[1]->name == "Batch Service Updated");
+
+            auto deleted = service->deleteContacts({created[0].id, oatpp::Int64(-1), oatpp::Int64(987654)}).value();
+            OATPP_ASSERT(deleted[0].ok());
+            OATPP_ASSERT(deleted[1].error->message == "Invalid ID");
+            OATPP_ASSERT(deleted[2].error->code == ErrorCode::NotFound);
+
+            auto badIds = service->getContactsByIds("1,abc");
+            OATPP_ASSERT(!badIds);
+            OATPP_ASSERT(badIds.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(badIds.error().message.find("Invalid ids") != std::string::npos);
+            // Every token is digits only
+            for (const char* ids : {"1, 2", " 1", "+1", "1 ", "-1", "0x1", "1,", "99999999999999999999"}) {
+                OATPP_ASSERT(service->getContactsByIds(ids).error().code == ErrorCode::InvalidArgument);
+            }
+            OATPP_ASSERT(service->getContactsByIds(" 5,+6").error().message ==
+                         "Invalid ids: ' 5' is not a valid contact ID");
+            auto emptyBatch = service->createContacts({});
+            OATPP_ASSERT(!emptyBatch);
+            OATPP_ASSERT(emptyBatch.error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(emptyBatch.error().message.find("Invalid batch") != std::string::npos);
+        }
+
+        OATPP_LOGI(TAG, "  [20/25] Testing NDJSON import and export...");
+        // Test NDJSON import fed in small pieces, with bad lines reported by number, and export line framing
+        {
+            auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+            std::string body;
+            for (int i = 0; i < 2500; ++i) {
+                body += R"({"name": "Imported )" + std::to_string(i) + R"(", "phone": "+7 383 )" +
+                        std::to_string(1000000 + i) + R"(", "address": "Novosibirsk"})" + "\n";
+            }
+            body += "not json\r\n";                                                  // line 2501
+            body += "\n";                                                             // blank, skipped
+            body += R"({"name": "No Phone", "address": "Novosibirsk"})" "\n";          // line 2503
+            body += "{\"name\": \"" + std::string(ContactImporter::kMaxLineLength, 'x') + "\"}\n"; // line 2504
+            body += R"({"id": 777001, "name": "Last", "phone": "+73830000001", "address": "Novosibirsk"})";
+
+            ContactImporter importer(service, objectMapper);
+            oatpp::async::Action action;
+            for (size_t offset = 0; offset < body.size(); offset += 4093) {
+                auto size = std::min<size_t>(4093, body.size() - offset);
+                OATPP_ASSERT(importer.write(body.data() + offset, static_cast<v_buff_size>(size), action) ==
+                             static_cast<v_io_size>(size));
+            }
+            auto summary = importer.finish();
+            OATPP_ASSERT(summary.imported == 2501);
+            OATPP_ASSERT(summary.failed == 3);
+            OATPP_ASSERT(summary.errors.size() == 3);
+            OATPP_ASSERT(summary.errors[0].line == 2501);
+            OATPP_ASSERT(summary.errors[0].message.find("Invalid JSON") == 0);
+            OATPP_ASSERT(summary.errors[1].line == 2503);
+            OATPP_ASSERT(summary.errors[1].message == "Phone is required");
+            OATPP_ASSERT(summary.errors[2].line == 2504);
+            OATPP_ASSERT(service->getContactById(777001).value()->name == "Last");
+            OATPP_ASSERT(service->findByPhone("+73831002499", nullptr).value().size() == 1);
+
+            // Async mode: full batches are created on a BlockingTaskPool, the transfer retries until they are
+            {
+                auto pool = std::make_shared<BlockingTaskPool>(2);
+                auto pooled = std::make_shared<ContactImporter>(service, objectMapper, pool);
+                std::string pooledBody;
+                for (int i = 0; i < 2500; ++i) {
+                    pooledBody += R"({"name": "Pooled )" + std::to_string(i) + R"(", "phone": "+7 384 )" +
+                                  std::to_string(1000000 + i) + R"(", "address": "Tomsk"})" + "\n";
+                }
+                size_t offset = 0;
+                size_t waits = 0;
+                auto write = [&](const char* data, size_t size) {
+                    while (true) {
+                        oatpp::async::Action wait;
+                        auto written = pooled->write(data, static_cast<v_buff_size>(size), wait);
+                        if (!wait.isNone()) {
+                            ++waits;
+                        }
+                        if (written != oatpp::IOError::RETRY_WRITE) {
+                            return static_cast<size_t>(written);
+                        }
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+                };
+                while (offset < pooledBody.size()) {
+                    offset += write(pooledBody.data() + offset, std::min<size_t>(4093, pooledBody.size() - offset));
+                }
+                write(nullptr, 0);
+                auto pooledSummary = pooled->finish();
+                OATPP_ASSERT(pooledSummary.imported == 2500 && pooledSummary.failed == 0);
+                OATPP_ASSERT(waits >= 2);
+                OATPP_ASSERT(service->findByPhone("+73841002499", nullptr).value().size() == 1);
+            }
+
+            // Export: one line per contact, no array brackets or separators
+            auto page = service->getContactsPage(nullptr, nullptr).value();
+            ContactJsonStream stream(page.snapshot, page.afterId, page.limit, objectMapper,
+                                     ContactJsonStream::Format::Lines);
+            std::string exported;
+            char buffer[1024];
+            while (true) {
+                auto read = stream.read(buffer, sizeof(buffer), action);
+                if (read <= 0) {
+                    break;
+                }
+                exported.append(buffer, static_cast<size_t>(read));
+            }
+            OATPP_ASSERT(static_cast<size_t>(std::count(exported.begin(), exported.end(), '\n')) == page.snapshot->size());
+            OATPP_ASSERT(exported.front() == '{' && exported.back() == '\n');
+        }
+        OATPP_LOGI(TAG, "  [21/25] Testing MessagePack codec, negotiation and list framing...");
+        // Test the MessagePack round trip of DTOs, strict decoding, Accept/Content-Type negotiation
+        // and the array framing of a streamed MessagePack listing
+        {
+            auto contact = ContactDto::createShared();
+            contact->id = 4294967296;
+            contact->name = "MessagePack " + std::string(40, 'n');
+            contact->phone = "+7 (913) 000-11-22";
+            auto encoded = ContactMessagePack::encode(contact);
+            OATPP_ASSERT(static_cast<uint8_t>(encoded->front()) == 0x84); // fixmap of 4 fields
+            auto decoded = ContactMessagePack::decodeContact(encoded);
+            OATPP_ASSERT(*decoded->id == 4294967296);
+            OATPP_ASSERT(decoded->name == contact->name);
+            OATPP_ASSERT(decoded->phone == contact->phone);
+            OATPP_ASSERT(!decoded->address);
+
+            auto list = oatpp::List<oatpp::Object<ContactDto>>::createShared();
+            list->push_back(contact);
+            list->push_back(ContactDto::createShared());
+            auto decodedList = ContactMessagePack::decodeContactList(ContactMessagePack::encode(list));
+            OATPP_ASSERT(decodedList->size() == 2);
+            OATPP_ASSERT(decodedList->back() && !decodedList->back()->name);
+
+            std::string ids;
+            MessagePackWriter writer(ids);
+            writer.writeArrayHeader(3);
+            writer.writeInt(-40);
+            writer.writeInt(70000);
+            writer.writeInt(INT64_MIN);
+            auto decodedIds = ContactMessagePack::decodeIdList(oatpp::String(ids));
+            OATPP_ASSERT(decodedIds->size() == 3);
+            OATPP_ASSERT(*decodedIds->front() == -40 && *decodedIds->back() == INT64_MIN);
+
+            // Malformed bodies are rejected; "Invalid ..." messages are answered with 400
+            std::string unknownField;
+            MessagePackWriter(unknownField).writeMapHeader(1);
+            MessagePackWriter(unknownField).writeString("email");
+            MessagePackWriter(unknownField).writeString("a@b.c");
+            for (const auto& bad : {std::string(), std::string("\x84\xa2id"), unknownField,
+                                    *encoded + "\xc0", std::string("\x91\xc0")}) {
+                try {
+                    ContactMessagePack::decodeContact(oatpp::String(bad));
+                    OATPP_ASSERT(false); // Should throw
+                } catch (const std::runtime_error& e) {
+                    OATPP_ASSERT(std::string(e.what()).find("Invalid MessagePack") == 0);
+                }
+            }
+
+            OATPP_ASSERT(ContactMessagePack::isMediaType("Application/MsgPack; charset=binary"));
+            OATPP_ASSERT(ContactMessagePack::isMediaType("application/x-msgpack"));
+            OATPP_ASSERT(!ContactMessagePack::isMediaType("application/json"));
+            OATPP_ASSERT(!ContactMessagePack::isMediaType(nullptr));
+            OATPP_ASSERT(ContactMessagePack::isAccepted("application/msgpack"));
+            OATPP_ASSERT(ContactMessagePack::isAccepted("application/msgpack, application/json"));
+            OATPP_ASSERT(ContactMessagePack::isAccepted("application/json;q=0.5, application/x-msgpack"));
+            OATPP_ASSERT(ContactMessagePack::isAccepted("application/msgpack, */*"));
+            OATPP_ASSERT(!ContactMessagePack::isAccepted("application/json, application/msgpack"));
+            OATPP_ASSERT(!ContactMessagePack::isAccepted("*/*"));
+            OATPP_ASSERT(!ContactMessagePack::isAccepted("application/msgpack;q=0, */*"));
+            OATPP_ASSERT(!ContactMessagePack::isAccepted(nullptr));
+
+            // Streamed listing: the array header counts exactly the contacts that follow
+            auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+            oatpp::async::Action action;
+            for (auto limit : {oatpp::Int64(nullptr), oatpp::Int64(7)}) {
+                auto page = service->getContactsPage(nullptr, limit).value();
+                ContactJsonStream stream(page.snapshot, page.afterId, page.limit, objectMapper,
+                                         ContactJsonStream::Format::MessagePack);
+                std::string body;
+                char buffer[1000];
+                while (true) {
+                    auto read = stream.read(buffer, sizeof(buffer), action);
+                    if (read <= 0) {
+                        break;
+                    }
+                    body.append(buffer, static_cast<size_t>(read));
+                }
+                auto contacts = ContactMessagePack::decodeContactList(oatpp::String(body));
+                OATPP_ASSERT(contacts->size() == (limit ? 7 : page.snapshot->size()));
+                OATPP_ASSERT(*contacts->front()->id < *(*std::next(contacts->begin()))->id);
+            }
+        }
+        OATPP_LOGI(TAG, "  [22/25] Testing typed error codes...");
+        // Test that expected failures come back as typed errors instead of exceptions
+        {
+            auto contact = ContactDto::createShared();
+            contact->id = 880001;
+            contact->name = "Typed Error";
+            contact->phone = "+79990880001";
+            contact->address = "Error Address";
+            OATPP_ASSERT(service->createContact(contact).ok());
+
+            auto duplicate = ContactDto::createShared();
+            duplicate->id = 880001;
+            duplicate->name = "Duplicate";
+            duplicate->phone = "+79990880002";
+            duplicate->address = "Error Address";
+            auto conflict = service->createContact(duplicate);
+            OATPP_ASSERT(!conflict);
+            OATPP_ASSERT(conflict.error().code == ErrorCode::Conflict);
+            OATPP_ASSERT(conflict.error().message == "Failed to create contact: ID already exists");
+
+            auto notFound = service->getContactById(880002);
+            OATPP_ASSERT(notFound.error().code == ErrorCode::NotFound);
+            auto invalid = service->searchByNamePrefix("typed", static_cast<int64_t>(-5));
+            OATPP_ASSERT(invalid.error().code == ErrorCode::InvalidArgument);
+            auto invalidPhone = service->findByPhone("12", nullptr);
+            OATPP_ASSERT(invalidPhone.error().message == "Invalid phone");
+
+            // value() of a failed result still reports the message as an exception
             try {
-                service->deleteContact(-1);
+                notFound.value();
                 OATPP_ASSERT(false); // Should throw
             } catch (const std::runtime_error& e) {
-                OATPP_ASSERT(std::string(e.what()).find("Invalid ID") != std::string::npos);
+                OATPP_ASSERT(std::string(e.what()) == "Contact not found");
             }
+            OATPP_ASSERT(ServiceResult<void>().ok());
         }
-
-        OATPP_LOGI(TAG, "  [14/14] Testing deleteContact with non-existent ID...");
-        // Test deleteContact with non-existent ID
+        OATPP_LOGI(TAG, "  [23/25] Testing patchContact with expected versions...");
+        // Test that a patch changes only the given fields and is applied only against the expected version
         {
-            bool deleted = service->deleteContact(99999);
-            OATPP_ASSERT(!deleted);
+            auto contact = ContactDto::createShared();
+            contact->id = 890001;
+            contact->name = "Patch Me";
+            contact->phone = "+79990890001";
+            contact->address = "Patch Address";
+            OATPP_ASSERT(service->createContact(contact).ok());
+            auto version = service->getContactVersion(890001);
+            OATPP_ASSERT(version);
+
+            auto changes = ContactDto::createShared();
+            changes->id = 12345;
+            changes->phone = "+7 (999) 089-00-02";
+            uint64_t patchedVersion = 0;
+            auto patched = service->patchContact(890001, changes, *version, &patchedVersion);
+            OATPP_ASSERT(patched.ok());
+            OATPP_ASSERT(*patched.value()->id == 890001);
+            OATPP_ASSERT(patched.value()->name == "Patch Me");
+            OATPP_ASSERT(patched.value()->phone == "+79990890002");
+            OATPP_ASSERT(patched.value()->address == "Patch Address");
+            OATPP_ASSERT(patchedVersion != *version);
+            OATPP_ASSERT(service->getContactVersion(890001) == patchedVersion);
+            OATPP_ASSERT(service->findByPhone("+79990890002", nullptr).value().size() == 1);
+            OATPP_ASSERT(service->findByPhone("+79990890001", nullptr).value().empty());
+
+            // A patch based on the old version loses the race and changes nothing
+            auto stale = ContactDto::createShared();
+            stale->name = "Stale";
+            auto failed = service->patchContact(890001, stale, *version);
+            OATPP_ASSERT(failed.error().code == ErrorCode::PreconditionFailed);
+            OATPP_ASSERT(service->getContactById(890001).value()->name == "Patch Me");
+            OATPP_ASSERT(service->getContactVersion(890001) == patchedVersion);
+
+            // Without an expected version the patch is unconditional
+            OATPP_ASSERT(service->patchContact(890001, stale, std::nullopt).ok());
+            OATPP_ASSERT(service->getContactById(890001).value()->name == "Stale");
+            OATPP_ASSERT(service->searchByNamePrefix("stale", nullptr).value().size() == 1);
+            OATPP_ASSERT(service->searchByNamePrefix("patch me", nullptr).value().empty());
+
+            // Given fields are validated
+            auto empty = ContactDto::createShared();
+            OATPP_ASSERT(service->patchContact(890001, empty, std::nullopt).error().code == ErrorCode::InvalidArgument);
+            empty->address = "";
+            OATPP_ASSERT(service->patchContact(890001, empty, std::nullopt).error().code == ErrorCode::InvalidArgument);
+            auto badPhone = ContactDto::createShared();
+            badPhone->phone = "12";
+            OATPP_ASSERT(service->patchContact(890001, badPhone, std::nullopt).error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(service->patchContact(890002, stale, std::nullopt).error().code == ErrorCode::NotFound);
+            OATPP_ASSERT(service->patchContact(-1, stale, std::nullopt).error().code == ErrorCode::InvalidArgument);
+        }
+        OATPP_LOGI(TAG, "  [24/25] Testing change log and event stream...");
+        // Test that changes reach subscribers in order, with resume and reset
+        {
+            auto feedRepository = std::make_shared<ContactRepository>();
+            auto feedService = std::make_shared<ContactService>(feedRepository);
+            auto changeLog = std::make_shared<ChangeLog>(4);
+            feedRepository->addChangeListener([changeLog](const ContactRepository::ContactChange& change) {
+                changeLog->append(change);
+            });
+            auto objectMapper = oatpp::parser::json::mapping::ObjectMapper::createShared();
+            auto epoch = feedService->getVersionEpoch();
+            auto eventId = [epoch](uint64_t sequence) {
+                char id[40];
+                std::snprintf(id, sizeof(id), "%llx-%llx", static_cast<unsigned long long>(epoch),
+                              static_cast<unsigned long long>(sequence));
+                return std::string(id);
+            };
+            // A polling stream asks to be called again once it has nothing more to send
+            auto readAll = [](ChangeEventStream& stream) {
+                std::string body;
+                char buffer[64];
+                oatpp::async::Action action;
+                while (true) {
+                    auto read = stream.read(buffer, sizeof(buffer), action);
+                    if (read == oatpp::IOError::RETRY_READ) {
+                        OATPP_ASSERT(!action.isNone());
+                        return body;
+                    }
+                    body.append(buffer, static_cast<size_t>(read));
+                }
+            };
+
+            // A subscriber without Last-Event-ID only gets changes made after it connected
+            auto contact = ContactDto::createShared();
+            contact->name = "Feed";
+            contact->phone = "+79990990001";
+            contact->address = "Tver";
+            auto created = feedService->createContact(contact).value();
+            ChangeEventStream live(changeLog, epoch, nullptr, objectMapper, ChangeEventStream::Mode::Polling);
+            created->address = "Tula";
+            OATPP_ASSERT(feedService->updateContact(created).ok());
+            OATPP_ASSERT(feedService->deleteContact(created->id).ok());
+            auto body = readAll(live);
+            OATPP_ASSERT(body.rfind("retry: 3000\n\n", 0) == 0);
+            OATPP_ASSERT(body.find("id: " + eventId(1) + "\n") == std::string::npos);
+            OATPP_ASSERT(body.find("id: " + eventId(2) + "\ndata: ") != std::string::npos);
+            OATPP_ASSERT(body.find("id: " + eventId(3) + "\ndata: ") > body.find("id: " + eventId(2)));
+
+            // Events keep the contents at the time of the change, not later edits of the caller's DTO
+            auto read = changeLog->readAfter(0, 10);
+            OATPP_ASSERT(!read.lagged && read.events.size() == 3 && read.last == 3);
+            OATPP_ASSERT(read.events[0].change.contact->address == "Tver");
+            OATPP_ASSERT(read.events[1].change.kind == ContactRepository::ContactChange::Kind::Put);
+            OATPP_ASSERT(read.events[2].change.kind == ContactRepository::ContactChange::Kind::Remove);
+            OATPP_ASSERT(!read.events[2].change.contact);
+            OATPP_ASSERT(changeLog->readAfter(1, 1).events.front().sequence == 2);
+
+            // Resuming replays what was missed; an id the log no longer holds, or of another run, is a reset
+            ChangeEventStream resumed(changeLog, epoch, eventId(2), objectMapper, ChangeEventStream::Mode::Polling);
+            body = readAll(resumed);
+            OATPP_ASSERT(body.find("id: " + eventId(2) + "\n") == std::string::npos);
+            OATPP_ASSERT(body.find("id: " + eventId(3) + "\n") != std::string::npos);
+            for (int i = 0; i < 4; ++i) {
+                contact->id = nullptr;
+                contact->phone = "+7999099001" + std::to_string(i);
+                OATPP_ASSERT(feedService->createContact(contact).ok());
+            }
+            OATPP_ASSERT(changeLog->firstSequence() == 4 && changeLog->lastSequence() == 7);
+            OATPP_ASSERT(changeLog->readAfter(2, 10).lagged);
+            OATPP_ASSERT(changeLog->readAfter(3, 10).events.size() == 4);
+            OATPP_ASSERT(changeLog->readAfter(8, 10).lagged);
+            ChangeEventStream lagged(changeLog, epoch, eventId(2), objectMapper, ChangeEventStream::Mode::Polling);
+            body = readAll(lagged);
+            OATPP_ASSERT(body.find("id: " + eventId(7) + "\ndata: ") != std::string::npos);
+            OATPP_ASSERT(body.find("id: " + eventId(4)) == std::string::npos);
+            OATPP_ASSERT(ChangeEventStream::parseEventId(eventId(7), epoch) == std::optional<uint64_t>(7));
+            OATPP_ASSERT(!ChangeEventStream::parseEventId(eventId(7), epoch + 1));
+            OATPP_ASSERT(!ChangeEventStream::parseEventId("7", epoch));
+
+            // A blocking subscriber wakes up for the next change
+            ChangeEventStream blocking(changeLog, epoch, nullptr, objectMapper, ChangeEventStream::Mode::Blocking);
+            char buffer[256];
+            oatpp::async::Action action;
+            OATPP_ASSERT(std::string(buffer, blocking.read(buffer, sizeof(buffer), action)) == "retry: 3000\n\n");
+            std::thread writer([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                feedService->deleteContact(7);
+            });
+            auto next = std::string(buffer, blocking.read(buffer, sizeof(buffer), action));
+            writer.join();
+            OATPP_ASSERT(next.rfind("id: " + eventId(8) + "\ndata: ", 0) == 0);
+        }
+        OATPP_LOGI(TAG, "  [25/25] Testing delta sync tokens...");
+        // Test that sync tokens chain deltas and that foreign or malformed ones are rejected
+        {
+            auto syncRepository = std::make_shared<ContactRepository>();
+            auto syncService = std::make_shared<ContactService>(syncRepository);
+            auto full = syncService->getChangesSince("0", nullptr);
+            OATPP_ASSERT(full.ok() && full->changes.contacts.size() == 3);
+
+            OATPP_ASSERT(syncService->deleteContact(3).ok());
+            auto delta = syncService->getChangesSince(full->next, nullptr);
+            OATPP_ASSERT(delta.ok() && delta->changes.contacts.empty());
+            OATPP_ASSERT(delta->changes.removed == std::vector<int64_t>({3}));
+            auto empty = syncService->getChangesSince(delta->next, 10);
+            OATPP_ASSERT(empty.ok() && empty->changes.removed.empty() && empty->next == delta->next);
+
+            // A token of another server run, or newer than any version, means starting over
+            auto token = std::string(*full->next);
+            char foreign[40];
+            std::snprintf(foreign, sizeof(foreign), "%llx-1",
+                          static_cast<unsigned long long>(syncService->getVersionEpoch() + 1));
+            OATPP_ASSERT(syncService->getChangesSince(foreign, nullptr).error().code == ErrorCode::Gone);
+            OATPP_ASSERT(syncService->getChangesSince((token + "0").c_str(), nullptr).error().code == ErrorCode::Gone);
+            for (const char* invalid : {"", "1", "x-1", "1-", "-1", "1-1-1"}) {
+                OATPP_ASSERT(syncService->getChangesSince(invalid, nullptr).error().code == ErrorCode::InvalidArgument);
+            }
+            OATPP_ASSERT(syncService->getChangesSince(nullptr, nullptr).error().code == ErrorCode::InvalidArgument);
+            // Tokens are written in lowercase hex and only read back that way
+            uint64_t value = 0;
+            OATPP_ASSERT(HexNumber::parse("ffffffffffffffff", value) && value == ~0ull);
+            OATPP_ASSERT(HexNumber::parse("2a", value) && value == 42);
+            for (const char* invalid : {"", "2A", "+2a", " 2a", "0x2a", "1ffffffffffffffff"}) {
+                OATPP_ASSERT(!HexNumber::parse(invalid, value));
+            }
+            OATPP_ASSERT(syncService->getChangesSince("0", 10).error().code == ErrorCode::InvalidArgument);
+            OATPP_ASSERT(syncService->getChangesSince(full->next, -1).error().code == ErrorCode::InvalidArgument);
         }
     }
 };
 
-}
\ No newline at end of file
+}